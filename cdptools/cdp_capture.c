@@ -0,0 +1,493 @@
+#include "cdp_capture.h"
+#include "../libcdp/platform/platform.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+/** The magic number of a pcap file with microsecond timestamps */
+#define CDP_PCAP_MAGIC_MICROSECONDS 0xA1B2C3D4
+
+/** The magic number of a pcap file with nanosecond timestamps */
+#define CDP_PCAP_MAGIC_NANOSECONDS 0xA1B23C4D
+
+/** The length of the pcap file header */
+#define CDP_PCAP_HEADER_LENGTH 24
+
+/** The length of a pcap record header */
+#define CDP_PCAP_RECORD_HEADER_LENGTH 16
+
+/** The pcapng block types which are read, every other block is skipped */
+#define CDP_PCAPNG_SECTION_HEADER_BLOCK 0x0A0D0D0A
+#define CDP_PCAPNG_INTERFACE_DESCRIPTION_BLOCK 1
+#define CDP_PCAPNG_PACKET_BLOCK 2
+#define CDP_PCAPNG_SIMPLE_PACKET_BLOCK 3
+#define CDP_PCAPNG_ENHANCED_PACKET_BLOCK 6
+
+/** The byte order magic of a pcapng section header */
+#define CDP_PCAPNG_BYTE_ORDER_MAGIC 0x1A2B3C4D
+
+/** The interface description option giving the timestamp resolution */
+#define CDP_PCAPNG_OPTION_TSRESOL 9
+
+/** The link types which can carry CDP */
+#define CDP_LINKTYPE_ETHERNET 1
+#define CDP_LINKTYPE_LINUX_SLL 113
+
+/** The length of a Linux cooked capture header */
+#define CDP_LINUX_SLL_HEADER_LENGTH 16
+
+/** Reads a 16 bit value in the byte order of the capture.
+  *  @param capture The capture object.
+  *  @param offset The offset of the value in the file.
+  *  @return The value.
+  */
+static uint16_t cdp_capture_get16(const struct cdp_capture *capture, size_t offset)
+{
+	uint16_t value;
+
+	memcpy(&value, capture->data + offset, sizeof(value));
+
+	return capture->swapped ? __builtin_bswap16(value) : value;
+}
+
+/** Reads a 32 bit value in the byte order of the capture.
+  *  @param capture The capture object.
+  *  @param offset The offset of the value in the file.
+  *  @return The value.
+  */
+static uint32_t cdp_capture_get32(const struct cdp_capture *capture, size_t offset)
+{
+	uint32_t value;
+
+	memcpy(&value, capture->data + offset, sizeof(value));
+
+	return capture->swapped ? __builtin_bswap32(value) : value;
+}
+
+/** Converts a timestamp counted in units per second to a timespec.
+  *  @param timestamp The timestamp.
+  *  @param resolution The number of units per second.
+  *  @return The timestamp as a timespec.
+  */
+static struct timespec cdp_capture_timestamp(uint64_t timestamp, uint64_t resolution)
+{
+	struct timespec result;
+	uint64_t fraction;
+
+	result.tv_sec = (time_t)(timestamp / resolution);
+	fraction = timestamp % resolution;
+
+	/* The product can't overflow below 2^32 units, finer resolutions are scaled down first */
+	if (resolution <= 0xFFFFFFFFULL)
+		result.tv_nsec = (long)(fraction * 1000000000ULL / resolution);
+	else
+		result.tv_nsec = (long)(fraction / (resolution / 1000000000ULL));
+
+	return result;
+}
+
+/** Recognizes a CDP frame and locates its payload.
+  *  @param link_type The link type of the interface the frame was captured on.
+  *  @param data The captured bytes.
+  *  @param length The number of captured bytes.
+  *  @param frame The frame to fill in, the interface and time are left alone.
+  *  @return true if the frame is a CDP frame.
+  */
+static bool cdp_capture_decode(uint16_t link_type, const uint8_t *data, size_t length, struct cdp_received_frame *frame)
+{
+	size_t offset;
+	size_t llc_length;
+	int tags;
+
+	if (link_type == CDP_LINKTYPE_LINUX_SLL)
+	{
+		/* Only 802.2 frames (protocol 0x0004) from a 6 byte link layer address carry CDP */
+		if (
+			length <= CDP_LINUX_SLL_HEADER_LENGTH + CDP_SNAP_HEADER_LENGTH ||
+			data[4] != 0 || data[5] != 6 ||
+			data[14] != 0x00 || data[15] != 0x04 ||
+			memcmp(data + CDP_LINUX_SLL_HEADER_LENGTH, cdp_snap_header, CDP_SNAP_HEADER_LENGTH) != 0
+		)
+			return false;
+
+		frame->source_mac = data + 6;
+		frame->payload = data + CDP_LINUX_SLL_HEADER_LENGTH + CDP_SNAP_HEADER_LENGTH;
+		frame->payload_length = length - (CDP_LINUX_SLL_HEADER_LENGTH + CDP_SNAP_HEADER_LENGTH);
+
+		return true;
+	}
+
+	if (link_type != CDP_LINKTYPE_ETHERNET || length <= CDP_ETHERNET_HEADER_LENGTH + CDP_SNAP_HEADER_LENGTH)
+		return false;
+
+	if (memcmp(data, cdp_multicast_address, sizeof(cdp_multicast_address)) != 0)
+		return false;
+
+	/* Captures from trunk ports may keep the 802.1Q or 802.1ad tags */
+	offset = 12;
+	for (tags = 0; tags < 2 && offset + 6 <= length; tags++)
+	{
+		if (!((data[offset] == 0x81 && data[offset + 1] == 0x00) || (data[offset] == 0x88 && data[offset + 1] == 0xA8)))
+			break;
+
+		offset += 4;
+	}
+
+	if (offset + 2 + CDP_SNAP_HEADER_LENGTH >= length)
+		return false;
+
+	/* An 802.3 length rather than an EtherType, it trims the padding of short frames */
+	llc_length = ((size_t)data[offset] << 8) | data[offset + 1];
+	if (llc_length > 1500 || llc_length <= CDP_SNAP_HEADER_LENGTH)
+		return false;
+
+	offset += 2;
+	if (memcmp(data + offset, cdp_snap_header, CDP_SNAP_HEADER_LENGTH) != 0)
+		return false;
+
+	if (length > offset + llc_length)
+		length = offset + llc_length;
+
+	frame->source_mac = data + 6;
+	frame->payload = data + offset + CDP_SNAP_HEADER_LENGTH;
+	frame->payload_length = length - (offset + CDP_SNAP_HEADER_LENGTH);
+
+	return true;
+}
+
+/** Reads the header of a pcap file.
+  *  @param capture The capture object.
+  *  @return 0 on success or a negative value on error.
+  */
+static int cdp_capture_read_pcap_header(struct cdp_capture *capture)
+{
+	uint32_t magic;
+
+	if (capture->size < CDP_PCAP_HEADER_LENGTH)
+	{
+		LOG_ERROR("cdp_capture_open: %s is too short for a pcap file\n", capture->path);
+		return -1;
+	}
+
+	memcpy(&magic, capture->data, sizeof(magic));
+	capture->swapped = (magic == __builtin_bswap32(CDP_PCAP_MAGIC_MICROSECONDS) || magic == __builtin_bswap32(CDP_PCAP_MAGIC_NANOSECONDS));
+
+	magic = cdp_capture_get32(capture, 0);
+	capture->format = CDP_CAPTURE_FORMAT_PCAP;
+	capture->resolutions[0] = (magic == CDP_PCAP_MAGIC_NANOSECONDS) ? 1000000000ULL : 1000000ULL;
+
+	/* The upper bits of the link type field may carry FCS information */
+	capture->link_types[0] = (uint16_t)(cdp_capture_get32(capture, 20) & 0xFFFF);
+	capture->interface_count = 1;
+	capture->position = CDP_PCAP_HEADER_LENGTH;
+
+	return 0;
+}
+
+/** Reads the next CDP frame of a pcap file.
+  *  @param capture The capture object.
+  *  @param frame The location to store the frame.
+  *  @return 1 if a frame was stored, 0 at the end of the file or a negative value on error.
+  */
+static int cdp_capture_next_pcap(struct cdp_capture *capture, struct cdp_received_frame *frame)
+{
+	uint64_t timestamp;
+	size_t record;
+	uint32_t captured;
+
+	while (capture->size - capture->position >= CDP_PCAP_RECORD_HEADER_LENGTH)
+	{
+		record = capture->position;
+		captured = cdp_capture_get32(capture, record + 8);
+
+		if (captured > capture->size - record - CDP_PCAP_RECORD_HEADER_LENGTH)
+		{
+			LOG_ERROR("cdp_capture_next: %s is truncated after %lu frames\n", capture->path, capture->frames);
+			capture->position = capture->size;
+			return 0;
+		}
+
+		capture->position = record + CDP_PCAP_RECORD_HEADER_LENGTH + captured;
+		capture->frames++;
+
+		if (!cdp_capture_decode(capture->link_types[0], capture->data + record + CDP_PCAP_RECORD_HEADER_LENGTH, captured, frame))
+			continue;
+
+		timestamp = (uint64_t)cdp_capture_get32(capture, record) * capture->resolutions[0] + cdp_capture_get32(capture, record + 4);
+
+		frame->ifindex = 0;
+		frame->received_at = cdp_capture_timestamp(timestamp, capture->resolutions[0]);
+
+		return 1;
+	}
+
+	return 0;
+}
+
+/** Reads the options of a pcapng interface description block for the timestamp resolution.
+  *  @param capture The capture object.
+  *  @param offset The offset of the first option.
+  *  @param end The offset of the end of the options.
+  *  @return The number of timestamp units per second.
+  */
+static uint64_t cdp_capture_read_tsresol(const struct cdp_capture *capture, size_t offset, size_t end)
+{
+	uint64_t result = 1000000ULL;
+	uint16_t code;
+	uint16_t length;
+	uint8_t value;
+	int exponent;
+
+	while (offset + 4 <= end)
+	{
+		code = cdp_capture_get16(capture, offset);
+		length = cdp_capture_get16(capture, offset + 2);
+
+		if (code == 0 || offset + 4 + length > end)
+			break;
+
+		if (code == CDP_PCAPNG_OPTION_TSRESOL && length >= 1)
+		{
+			/* A negative power of 10, or of 2 when the top bit is set */
+			value = capture->data[offset + 4];
+			result = 1;
+			for (exponent = 0; exponent < (value & 0x7F) && result <= 0xFFFFFFFFFFFFFFFULL; exponent++)
+				result *= (value & 0x80) != 0 ? 2 : 10;
+		}
+
+		offset += 4 + (((size_t)length + 3) & ~(size_t)3);
+	}
+
+	return result;
+}
+
+/** Reads the next CDP frame of a pcapng file.
+  *  @param capture The capture object.
+  *  @param frame The location to store the frame.
+  *  @return 1 if a frame was stored, 0 at the end of the file or a negative value on error.
+  */
+static int cdp_capture_next_pcapng(struct cdp_capture *capture, struct cdp_received_frame *frame)
+{
+	uint32_t type;
+	uint32_t length;
+	uint32_t magic;
+	uint32_t interface;
+	uint32_t captured;
+	uint64_t timestamp;
+	size_t block;
+	size_t data;
+
+	while (capture->size - capture->position >= 12)
+	{
+		block = capture->position;
+		memcpy(&type, capture->data + block, sizeof(type));
+
+		/* The byte order of a section is only known from its header, whose type is a palindrome */
+		if (type == CDP_PCAPNG_SECTION_HEADER_BLOCK)
+		{
+			memcpy(&magic, capture->data + block + 8, sizeof(magic));
+			if (magic != CDP_PCAPNG_BYTE_ORDER_MAGIC && magic != __builtin_bswap32(CDP_PCAPNG_BYTE_ORDER_MAGIC))
+			{
+				LOG_ERROR("cdp_capture_next: %s has an invalid section header\n", capture->path);
+				return -1;
+			}
+
+			capture->swapped = (magic != CDP_PCAPNG_BYTE_ORDER_MAGIC);
+			capture->interface_count = 0;
+		}
+		else
+			type = cdp_capture_get32(capture, block);
+
+		length = cdp_capture_get32(capture, block + 4);
+		if (length < 12 || (length & 3) != 0 || length > capture->size - block)
+		{
+			LOG_ERROR("cdp_capture_next: %s is truncated after %lu frames\n", capture->path, capture->frames);
+			capture->position = capture->size;
+			return 0;
+		}
+
+		capture->position = block + length;
+
+		switch (type)
+		{
+			case CDP_PCAPNG_INTERFACE_DESCRIPTION_BLOCK:
+				if (length < 20)
+					break;
+
+				if (capture->interface_count < CDP_CAPTURE_MAX_INTERFACES)
+				{
+					capture->link_types[capture->interface_count] = cdp_capture_get16(capture, block + 8);
+					capture->resolutions[capture->interface_count] = cdp_capture_read_tsresol(capture, block + 16, block + length - 4);
+				}
+
+				capture->interface_count++;
+				break;
+
+			case CDP_PCAPNG_ENHANCED_PACKET_BLOCK:
+			case CDP_PCAPNG_PACKET_BLOCK:
+				if (length < 32)
+					break;
+
+				capture->frames++;
+
+				/* The obsolete packet block has a 16 bit interface id followed by a drop count */
+				if (type == CDP_PCAPNG_PACKET_BLOCK)
+					interface = cdp_capture_get16(capture, block + 8);
+				else
+					interface = cdp_capture_get32(capture, block + 8);
+
+				captured = cdp_capture_get32(capture, block + 20);
+				data = block + 28;
+
+				if (interface >= capture->interface_count || interface >= CDP_CAPTURE_MAX_INTERFACES || captured > length - 32)
+					break;
+
+				if (!cdp_capture_decode(capture->link_types[interface], capture->data + data, captured, frame))
+					break;
+
+				timestamp = ((uint64_t)cdp_capture_get32(capture, block + 12) << 32) | cdp_capture_get32(capture, block + 16);
+
+				frame->ifindex = (int)interface;
+				frame->received_at = cdp_capture_timestamp(timestamp, capture->resolutions[interface]);
+				return 1;
+
+			case CDP_PCAPNG_SIMPLE_PACKET_BLOCK:
+				if (length < 16 || capture->interface_count == 0)
+					break;
+
+				capture->frames++;
+
+				/* Simple packet blocks belong to the first interface and have no timestamp */
+				captured = cdp_capture_get32(capture, block + 8);
+				if (captured > length - 16)
+					captured = length - 16;
+
+				if (!cdp_capture_decode(capture->link_types[0], capture->data + block + 12, captured, frame))
+					break;
+
+				frame->ifindex = 0;
+				frame->received_at.tv_sec = 0;
+				frame->received_at.tv_nsec = 0;
+				return 1;
+		}
+	}
+
+	return 0;
+}
+
+struct cdp_capture *cdp_capture_open(const char *path)
+{
+	struct cdp_capture *result;
+	struct stat status;
+	uint32_t magic;
+	void *data;
+	int fd;
+
+	if (path == NULL)
+	{
+		LOG_CRITICAL("cdp_capture_open: path is NULL\n");
+		return NULL;
+	}
+
+	fd = open(path, O_RDONLY | O_CLOEXEC);
+	if (fd < 0)
+	{
+		LOG_ERROR("cdp_capture_open: failed to open %s (%s)\n", path, strerror(errno));
+		return NULL;
+	}
+
+	if (fstat(fd, &status) < 0 || status.st_size < 12)
+	{
+		LOG_ERROR("cdp_capture_open: %s is not a capture file\n", path);
+		close(fd);
+		return NULL;
+	}
+
+	data = mmap(NULL, (size_t)status.st_size, PROT_READ, MAP_SHARED, fd, 0);
+	close(fd);
+
+	if (data == MAP_FAILED)
+	{
+		LOG_ERROR("cdp_capture_open: failed to map %s (%s)\n", path, strerror(errno));
+		return NULL;
+	}
+
+	/* The file is read once from start to end, so read ahead aggressively */
+	madvise(data, (size_t)status.st_size, MADV_SEQUENTIAL);
+
+	result = ALLOC_NEW(struct cdp_capture);
+	if (result == NULL)
+	{
+		LOG_CRITICAL("cdp_capture_open: failed to allocate memory for capture\n");
+		munmap(data, (size_t)status.st_size);
+		return NULL;
+	}
+
+	memset(result, 0, sizeof(struct cdp_capture));
+	result->path = path;
+	result->data = (const uint8_t *)data;
+	result->size = (size_t)status.st_size;
+
+	memcpy(&magic, result->data, sizeof(magic));
+
+	if (magic == CDP_PCAPNG_SECTION_HEADER_BLOCK)
+	{
+		/* The section header is read as the first block */
+		result->format = CDP_CAPTURE_FORMAT_PCAPNG;
+	}
+	else if (
+		magic == CDP_PCAP_MAGIC_MICROSECONDS || magic == __builtin_bswap32(CDP_PCAP_MAGIC_MICROSECONDS) ||
+		magic == CDP_PCAP_MAGIC_NANOSECONDS || magic == __builtin_bswap32(CDP_PCAP_MAGIC_NANOSECONDS)
+	)
+	{
+		if (cdp_capture_read_pcap_header(result) < 0)
+		{
+			cdp_capture_delete(result);
+			return NULL;
+		}
+	}
+	else
+	{
+		LOG_ERROR("cdp_capture_open: %s is neither a pcap nor a pcapng file\n", path);
+		cdp_capture_delete(result);
+		return NULL;
+	}
+
+	return result;
+}
+
+void cdp_capture_delete(struct cdp_capture *capture)
+{
+	if (capture == NULL)
+	{
+		LOG_CRITICAL("cdp_capture_delete: capture is NULL\n");
+		return;
+	}
+
+	munmap((void *)capture->data, capture->size);
+	FREE(capture);
+}
+
+int cdp_capture_next(struct cdp_capture *capture, struct cdp_received_frame *frame)
+{
+	if (capture == NULL)
+	{
+		LOG_CRITICAL("cdp_capture_next: capture is NULL\n");
+		return -1;
+	}
+
+	if (frame == NULL)
+	{
+		LOG_CRITICAL("cdp_capture_next: frame is NULL\n");
+		return -1;
+	}
+
+	if (capture->format == CDP_CAPTURE_FORMAT_PCAPNG)
+		return cdp_capture_next_pcapng(capture, frame);
+
+	return cdp_capture_next_pcap(capture, frame);
+}
@@ -0,0 +1,74 @@
+#ifndef CDP_CAPTURE_H
+#define CDP_CAPTURE_H
+
+#include "cdp_packet_socket.h"
+#include "../libcdp/platform/types.h"
+
+/** The maximum number of interfaces of a pcapng section whose link types are tracked */
+#define CDP_CAPTURE_MAX_INTERFACES 256
+
+/** The capture file formats which can be read */
+enum cdp_capture_format
+{
+	CDP_CAPTURE_FORMAT_PCAP,
+	CDP_CAPTURE_FORMAT_PCAPNG
+};
+
+/** A pcap or pcapng file mapped read only into memory. Frames are read sequentially and handed out
+  *  as pointers into the mapping, so nothing is copied and the file is never loaded into the heap.
+  *  The pointers stay valid until the capture is deleted.
+  */
+struct cdp_capture
+{
+	/** The name of the file, for messages */
+	const char *path;
+
+	/** The mapped file */
+	const uint8_t *data;
+
+	/** The size of the file */
+	size_t size;
+
+	/** The offset of the next record or block */
+	size_t position;
+
+	/** The format of the file */
+	enum cdp_capture_format format;
+
+	/** Whether the file (or the current pcapng section) was written in the opposite byte order */
+	bool swapped;
+
+	/** The link type of each interface, a pcap file has a single interface */
+	uint16_t link_types[CDP_CAPTURE_MAX_INTERFACES];
+
+	/** The number of timestamp units per second of each interface */
+	uint64_t resolutions[CDP_CAPTURE_MAX_INTERFACES];
+
+	/** The number of interfaces described so far in the current section */
+	uint32_t interface_count;
+
+	/** The number of frames read, CDP or not */
+	unsigned long frames;
+};
+
+/** Constructor, maps a capture file and reads its header.
+  *  @param path The file to open.
+  *  @return Either the new capture or NULL on error.
+  */
+struct cdp_capture *cdp_capture_open(const char *path);
+
+/** Destructor, unmaps the file.
+  *  @param capture The capture to delete.
+  */
+void cdp_capture_delete(struct cdp_capture *capture);
+
+/** Reads up to the next CDP frame, skipping every other frame. The frame carries the interface
+  *  number within the capture as its ifindex and the capture timestamp as its received time.
+  *  Ethernet frames with up to two VLAN tags and Linux cooked captures are recognized.
+  *  @param capture The capture object.
+  *  @param frame The location to store the frame, which points into the mapped file.
+  *  @return 1 if a frame was stored, 0 at the end of the file or a negative value on error.
+  */
+int cdp_capture_next(struct cdp_capture *capture, struct cdp_received_frame *frame);
+
+#endif
@@ -0,0 +1,1023 @@
+#include "cdp_daemon.h"
+#include "../libcdp/cdp_neighbor_record.h"
+#include "../libcdp/cdp_packet.h"
+#include "../libcdp/cdp_packet_parser.h"
+#include "../libcdp/platform/platform.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/epoll.h>
+#include <sys/resource.h>
+#include <sys/signalfd.h>
+#include <sys/stat.h>
+#include <sys/timerfd.h>
+#include <unistd.h>
+
+/** The interval between advertisements (seconds) */
+static const time_t cdp_daemon_transmit_interval = 60;
+
+/** How long to wait after a link or address change before advertising, so bursts coalesce (seconds) */
+static const time_t cdp_daemon_change_delay = 1;
+
+/** The number of frames the transmitter can batch into a single flush */
+static const unsigned int cdp_daemon_transmit_batch_size = 64;
+
+/** The number of neighbors the shared memory table can hold */
+static const uint32_t cdp_daemon_table_slots = 1024;
+
+/** The size of the string heap of the shared memory table */
+static const uint32_t cdp_daemon_table_heap_size = 256 * 1024;
+
+/** The minimum interval between publishing neighbors which were only refreshed (seconds) */
+static const time_t cdp_daemon_table_refresh_interval = 1;
+
+/** The largest state file which is loaded, anything bigger isn't a saved neighbor table */
+static const off_t cdp_daemon_state_max_size = 16 * 1024 * 1024;
+
+/** The maximum number of events returned by a single epoll_wait */
+#define CDP_DAEMON_MAX_EVENTS 8
+
+/** The event sources registered with epoll, stored in the event data */
+enum cdp_daemon_event_source
+{
+	CDP_DAEMON_EVENT_PACKET,
+	CDP_DAEMON_EVENT_URING,
+	CDP_DAEMON_EVENT_TIMER,
+	CDP_DAEMON_EVENT_LINK,
+	CDP_DAEMON_EVENT_SIGNAL,
+	CDP_DAEMON_EVENT_TABLE
+};
+
+/** Stores a received frame in the neighbor table.
+  *  @param context The daemon object.
+  *  @param frame The received frame.
+  */
+static void cdp_daemon_handle_frame(void *context, const struct cdp_received_frame *frame)
+{
+	struct cdp_daemon *daemon = (struct cdp_daemon *)context;
+
+	if (cdp_worker_store_frame(daemon->neighbors, daemon->interfaces, frame, daemon->verbose))
+		daemon->table_changed = true;
+	else
+		daemon->table_refresh_pending = true;
+
+	daemon->frames++;
+}
+
+/** Logs a single entry of the neighbor table.
+  *  @param neighbor The neighbor to log.
+  */
+static void cdp_daemon_log_entry(const struct cdp_neighbor *neighbor)
+{
+	struct stream_reader *reader;
+	struct cdp_packet *packet = NULL;
+
+	reader = stream_reader_new(neighbor->frame_buffer, neighbor->frame_buffer_length);
+	if (reader == NULL)
+		return;
+
+	if (cdp_parse_packet(reader, &packet) == 0 && packet != NULL)
+	{
+		LOG_INFORMATIONAL(
+			"cdp: neighbor %s on ifindex %d (port %s), hold time %d\n",
+			packet->device_id != NULL ? packet->device_id : "<unknown>",
+			neighbor->device_index,
+			packet->port_id != NULL ? packet->port_id : "<unknown>",
+			cdp_neighbor_get_hold_time(neighbor)
+		);
+	}
+
+	if (packet != NULL)
+		cdp_packet_delete(packet);
+
+	stream_reader_delete(reader);
+}
+
+/** Logs the whole neighbor table. With workers, the table is read from a merged snapshot of the
+  *  shards so that the listing is consistent while the workers keep running.
+  *  @param daemon The daemon object.
+  */
+static void cdp_daemon_dump_neighbors(struct cdp_daemon *daemon)
+{
+	const struct cdp_neighbor *neighbor;
+	struct cdp_neighbor *parsed;
+	struct stream_reader *reader;
+	uint8_t *snapshot;
+	ssize_t length;
+
+	if (daemon->workers == NULL)
+	{
+		for (neighbor = daemon->neighbors->head; neighbor != NULL; neighbor = neighbor->next)
+			cdp_daemon_log_entry(neighbor);
+
+		return;
+	}
+
+	length = cdp_worker_pool_snapshot(daemon->workers, &snapshot);
+	if (length <= 0)
+		return;
+
+	reader = stream_reader_new(snapshot, (size_t)length);
+	if (reader != NULL)
+	{
+		while (!stream_reader_at_end(reader) && cdp_neighbor_record_parse(reader, &parsed) == 0)
+		{
+			cdp_daemon_log_entry(parsed);
+			cdp_neighbor_delete(parsed);
+		}
+
+		stream_reader_delete(reader);
+	}
+
+	FREE_ARRAY(snapshot);
+}
+
+/** Publishes the neighbors owned by the workers in the shared memory table.
+  *  @param daemon The daemon object.
+  *  @param now The time to record as the time of the update.
+  */
+static void cdp_daemon_publish_snapshot(struct cdp_daemon *daemon, struct timespec now)
+{
+	struct cdp_neighbor_list *neighbors;
+	struct cdp_neighbor *parsed;
+	struct stream_reader *reader;
+	uint8_t *snapshot;
+	ssize_t length;
+
+	length = cdp_worker_pool_snapshot(daemon->workers, &snapshot);
+	if (length < 0)
+		return;
+
+	neighbors = cdp_neighbor_list_new();
+	if (neighbors == NULL)
+	{
+		FREE_ARRAY(snapshot);
+		return;
+	}
+
+	reader = length > 0 ? stream_reader_new(snapshot, (size_t)length) : NULL;
+	if (reader != NULL)
+	{
+		while (!stream_reader_at_end(reader) && cdp_neighbor_record_parse(reader, &parsed) == 0)
+			cdp_neighbor_list_append(neighbors, parsed);
+
+		stream_reader_delete(reader);
+	}
+
+	cdp_shm_table_writer_publish(daemon->table, neighbors, now);
+
+	cdp_neighbor_list_clean_and_delete(neighbors);
+
+	if (snapshot != NULL)
+		FREE_ARRAY(snapshot);
+}
+
+/** Publishes the neighbor table in the shared memory table if it changed. Refreshes alone are
+  *  published at most once per cdp_daemon_table_refresh_interval so that the received times stay
+  *  current without copying the table for every frame.
+  *  @param daemon The daemon object.
+  */
+static void cdp_daemon_update_table(struct cdp_daemon *daemon)
+{
+	struct timespec monotonic;
+	struct timespec now;
+
+	if (daemon->table == NULL)
+		return;
+
+	clock_gettime(CLOCK_MONOTONIC, &monotonic);
+
+	if (
+		!daemon->table_changed &&
+		!(daemon->table_refresh_pending && monotonic.tv_sec >= daemon->table_published_at + cdp_daemon_table_refresh_interval)
+	)
+		return;
+
+	clock_gettime(CLOCK_REALTIME, &now);
+
+	if (daemon->workers != NULL)
+		cdp_daemon_publish_snapshot(daemon, now);
+	else
+		cdp_shm_table_writer_publish(daemon->table, daemon->neighbors, now);
+
+	daemon->table_changed = false;
+	daemon->table_refresh_pending = false;
+	daemon->table_published_at = monotonic.tv_sec;
+}
+
+/** Reads a whole file into memory.
+  *  @param path The file to read.
+  *  @param result The location to store the newly allocated contents, to be released with FREE_ARRAY.
+  *  @return The length of the file, 0 if it doesn't exist or a negative value on error.
+  */
+static ssize_t cdp_daemon_read_file(const char *path, uint8_t **result)
+{
+	struct stat status;
+	uint8_t *buffer;
+	size_t length;
+	size_t position = 0;
+	ssize_t count;
+	int fd;
+
+	*result = NULL;
+
+	fd = open(path, O_RDONLY | O_CLOEXEC);
+	if (fd < 0)
+	{
+		if (errno == ENOENT)
+			return 0;
+
+		LOG_ERROR("cdp_daemon_read_file: failed to open %s (%s)\n", path, strerror(errno));
+		return -1;
+	}
+
+	if (fstat(fd, &status) < 0 || status.st_size > cdp_daemon_state_max_size)
+	{
+		LOG_ERROR("cdp_daemon_read_file: %s is not a neighbor table\n", path);
+		close(fd);
+		return -1;
+	}
+
+	length = (size_t)status.st_size;
+	if (length == 0)
+	{
+		close(fd);
+		return 0;
+	}
+
+	buffer = ALLOC_NEW_ARRAY(uint8_t, length);
+	if (buffer == NULL)
+	{
+		LOG_CRITICAL("cdp_daemon_read_file: failed to allocate memory for %s\n", path);
+		close(fd);
+		return -1;
+	}
+
+	while (position < length)
+	{
+		count = read(fd, buffer + position, length - position);
+		if (count < 0 && errno == EINTR)
+			continue;
+
+		if (count <= 0)
+		{
+			LOG_ERROR("cdp_daemon_read_file: failed to read %s\n", path);
+			FREE_ARRAY(buffer);
+			close(fd);
+			return -1;
+		}
+
+		position += (size_t)count;
+	}
+
+	close(fd);
+
+	*result = buffer;
+
+	return (ssize_t)length;
+}
+
+/** Replaces a file with new contents. The contents are written under another name and renamed
+  *  into place, so a crash while saving leaves the previous file intact.
+  *  @param path The file to replace.
+  *  @param data The new contents.
+  *  @param length The length of the new contents.
+  *  @return 0 on success or a negative value on error.
+  */
+static int cdp_daemon_write_file(const char *path, const uint8_t *data, size_t length)
+{
+	char *temporary_path;
+	size_t path_length;
+	size_t position = 0;
+	ssize_t count;
+	int fd;
+
+	path_length = strlen(path);
+	temporary_path = ALLOC_NEW_ARRAY(char, path_length + 5);
+	if (temporary_path == NULL)
+	{
+		LOG_CRITICAL("cdp_daemon_write_file: failed to allocate memory for path\n");
+		return -1;
+	}
+
+	COPY_MEMORY(path, temporary_path, path_length);
+	COPY_MEMORY(".new", temporary_path + path_length, 5);
+
+	fd = open(temporary_path, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+	if (fd < 0)
+	{
+		LOG_ERROR("cdp_daemon_write_file: failed to create %s (%s)\n", temporary_path, strerror(errno));
+		FREE_ARRAY(temporary_path);
+		return -1;
+	}
+
+	while (position < length)
+	{
+		count = write(fd, data + position, length - position);
+		if (count < 0 && errno == EINTR)
+			continue;
+
+		if (count <= 0)
+			break;
+
+		position += (size_t)count;
+	}
+
+	if (position < length || fsync(fd) < 0)
+	{
+		LOG_ERROR("cdp_daemon_write_file: failed to write %s (%s)\n", temporary_path, strerror(errno));
+		close(fd);
+		unlink(temporary_path);
+		FREE_ARRAY(temporary_path);
+		return -1;
+	}
+
+	close(fd);
+
+	if (rename(temporary_path, path) < 0)
+	{
+		LOG_ERROR("cdp_daemon_write_file: failed to rename %s (%s)\n", temporary_path, strerror(errno));
+		unlink(temporary_path);
+		FREE_ARRAY(temporary_path);
+		return -1;
+	}
+
+	FREE_ARRAY(temporary_path);
+
+	return 0;
+}
+
+/** Loads the neighbors saved by a previous instance so that consumers see the table again as soon
+  *  as the daemon starts rather than a hold time later. Neighbors whose hold time ran out while the
+  *  daemon was down and neighbors of interfaces which no longer exist are dropped. This must be
+  *  called before the workers are started.
+  *  @param daemon The daemon object.
+  */
+static void cdp_daemon_load_state(struct cdp_daemon *daemon)
+{
+	struct cdp_neighbor_list *loaded;
+	struct cdp_neighbor_list *restored;
+	struct cdp_neighbor *neighbor;
+	const struct cdp_interface *interface;
+	struct stream_reader *reader;
+	struct timespec now;
+	uint8_t *buffer;
+	ssize_t length;
+	int count;
+
+	length = cdp_daemon_read_file(daemon->state_path, &buffer);
+	if (length <= 0)
+		return;
+
+	loaded = cdp_neighbor_list_new();
+	reader = stream_reader_new(buffer, (size_t)length);
+	if (loaded == NULL || reader == NULL)
+	{
+		if (loaded != NULL)
+			cdp_neighbor_list_delete(loaded);
+
+		FREE_ARRAY(buffer);
+		return;
+	}
+
+	/* A damaged file still yields the neighbors before the damage */
+	clock_gettime(CLOCK_REALTIME, &now);
+	if (cdp_neighbor_record_parse_list(reader, now, loaded) < 0)
+		LOG_ERROR("cdp_daemon_load_state: %s is damaged, loading what could be read\n", daemon->state_path);
+
+	stream_reader_delete(reader);
+	FREE_ARRAY(buffer);
+
+	/* Neighbors of interfaces which are gone are dropped. When the workers own the table, the
+	 * others go back to the end of the loaded list.
+	 */
+	restored = daemon->neighbors != NULL ? daemon->neighbors : loaded;
+	count = loaded->count;
+	while (count-- > 0)
+	{
+		neighbor = cdp_neighbor_list_take_first(loaded);
+
+		interface = cdp_interface_list_get_by_index(daemon->interfaces, neighbor->device_index);
+		if (interface == NULL || cdp_neighbor_list_append(restored, neighbor) < 0)
+			cdp_neighbor_delete(neighbor);
+	}
+
+	count = daemon->workers != NULL ? cdp_worker_pool_restore(daemon->workers, loaded) : daemon->neighbors->count;
+	cdp_neighbor_list_clean_and_delete(loaded);
+
+	if (count > 0)
+	{
+		LOG_INFORMATIONAL("cdp: restored %d neighbors from %s\n", count, daemon->state_path);
+		daemon->table_changed = true;
+	}
+}
+
+/** Saves the neighbor table for the next instance to load.
+  *  @param daemon The daemon object.
+  */
+static void cdp_daemon_save_state(struct cdp_daemon *daemon)
+{
+	uint8_t *buffer = NULL;
+	ssize_t length;
+
+	if (daemon->workers != NULL)
+		length = cdp_worker_pool_snapshot(daemon->workers, &buffer);
+	else
+	{
+		length = cdp_neighbor_record_list_length(daemon->neighbors);
+		if (length > 0)
+		{
+			buffer = ALLOC_NEW_ARRAY(uint8_t, length);
+			if (buffer == NULL)
+				length = -1;
+			else
+				length = cdp_neighbor_record_serialize_list(daemon->neighbors, buffer, (size_t)length);
+		}
+	}
+
+	/* An empty table is saved too so that an older table isn't loaded next time */
+	if (length < 0 || cdp_daemon_write_file(daemon->state_path, buffer, (size_t)length) < 0)
+		LOG_ERROR("cdp_daemon_save_state: failed to save the neighbor table to %s\n", daemon->state_path);
+
+	if (buffer != NULL)
+		FREE_ARRAY(buffer);
+}
+
+/** Subscribes an interface to the CDP multicast MAC address on whichever sockets receive frames.
+  *  @param daemon The daemon object.
+  *  @param interface The interface to subscribe.
+  */
+static void cdp_daemon_join(struct cdp_daemon *daemon, const struct cdp_interface *interface)
+{
+	int rc;
+
+	if (daemon->workers != NULL)
+		rc = cdp_worker_pool_join(daemon->workers, interface->index);
+	else if (daemon->uring != NULL)
+		rc = cdp_packet_socket_join(daemon->uring->socket, interface->index);
+	else
+		rc = cdp_packet_socket_join(daemon->socket, interface->index);
+
+	if (rc == 0)
+		LOG_INFORMATIONAL("cdp: listening on %s\n", interface->name);
+}
+
+/** Enumerates the interfaces again so that addresses and interfaces which appeared since the last
+  *  enumeration are picked up. New interfaces are joined to the CDP multicast group.
+  *  @param daemon The daemon object.
+  *  @return 0 on success or a negative value on error.
+  */
+static int cdp_daemon_refresh_interfaces(struct cdp_daemon *daemon)
+{
+	struct cdp_interface_list *interfaces;
+	size_t i;
+
+	interfaces = cdp_interface_list_new();
+	if (interfaces == NULL)
+		return -1;
+
+	for (i = 0; i < interfaces->count; i++)
+	{
+		if (cdp_interface_list_get_by_index(daemon->interfaces, interfaces->items[i].index) == NULL)
+			cdp_daemon_join(daemon, &interfaces->items[i]);
+	}
+
+	cdp_interface_list_delete(daemon->interfaces);
+	daemon->interfaces = interfaces;
+
+	if (daemon->workers != NULL)
+		return cdp_worker_pool_refresh_interfaces(daemon->workers);
+
+	return 0;
+}
+
+/** Queues an advertisement for every interface which is up and has an address, then sends them
+  *  all as a single batch.
+  *  @param daemon The daemon object.
+  *  @return The number of frames sent or a negative value on error.
+  */
+static int cdp_daemon_transmit(struct cdp_daemon *daemon)
+{
+	const unsigned int required_flags = IFF_UP | IFF_RUNNING;
+	size_t i;
+	int rc;
+
+	for (i = 0; i < daemon->interfaces->count; i++)
+	{
+		const struct cdp_interface *interface = &daemon->interfaces->items[i];
+
+		if ((interface->flags & required_flags) != required_flags || interface->addresses == NULL)
+			continue;
+
+		/* Frames sent through io_uring stay in the arena until sent, so the queue can't be flushed early */
+		if (daemon->uring != NULL && daemon->transmitter->queued == daemon->transmitter->capacity)
+		{
+			LOG_ERROR("cdp_daemon_transmit: more interfaces than fit in a single batch, skipping %s\n", interface->name);
+			continue;
+		}
+
+		cdp_transmitter_queue(daemon->transmitter, interface);
+	}
+
+	if (daemon->uring != NULL)
+	{
+		rc = cdp_uring_socket_send(daemon->uring);
+		cdp_transmitter_clear(daemon->transmitter);
+	}
+	else
+	{
+		rc = cdp_transmitter_flush(daemon->transmitter);
+	}
+
+	if (daemon->verbose && rc >= 0)
+		LOG_INFORMATIONAL("cdp: sent %d advertisements\n", rc);
+
+	return rc;
+}
+
+/** Logs the system calls and CPU time the event loop spent per frame, to compare the receive backends.
+  *  @param daemon The daemon object.
+  */
+static void cdp_daemon_log_costs(struct cdp_daemon *daemon)
+{
+	struct rusage usage;
+	unsigned long system_calls = daemon->system_calls;
+	double cpu_ms;
+
+	if (daemon->frames == 0 || getrusage(RUSAGE_SELF, &usage) < 0)
+		return;
+
+	if (daemon->transmitter != NULL)
+		system_calls += daemon->transmitter->system_calls;
+
+	if (daemon->uring != NULL)
+		system_calls += daemon->uring->system_calls;
+
+	cpu_ms =
+		(usage.ru_utime.tv_sec + usage.ru_stime.tv_sec) * 1000.0 +
+		(usage.ru_utime.tv_usec + usage.ru_stime.tv_usec) / 1000.0;
+
+	LOG_INFORMATIONAL(
+		"cdp: %s backend, %.3f system calls per frame, %.1f ms CPU per 100k frames\n",
+		daemon->uring != NULL ? "io_uring" : "epoll",
+		(double)system_calls / daemon->frames,
+		cpu_ms * 100000.0 / daemon->frames
+	);
+}
+
+/** Releases everything held by the daemon.
+  *  @param daemon The daemon object.
+  */
+static void cdp_daemon_cleanup(struct cdp_daemon *daemon)
+{
+	struct cdp_packet_socket *socket = daemon->uring != NULL ? daemon->uring->socket : daemon->socket;
+	unsigned int received;
+	unsigned int dropped;
+
+	if (daemon->verbose && socket != NULL && cdp_packet_socket_get_statistics(socket, &received, &dropped) == 0)
+	{
+		LOG_INFORMATIONAL("cdp: processed %lu frames, %u dropped by the kernel\n", daemon->frames, dropped);
+		cdp_daemon_log_costs(daemon);
+	}
+
+	if (daemon->table != NULL)
+		cdp_shm_table_writer_delete(daemon->table);
+
+	if (daemon->neighbors != NULL)
+		cdp_neighbor_list_clean_and_delete(daemon->neighbors);
+
+	if (daemon->link_monitor != NULL)
+		cdp_link_monitor_delete(daemon->link_monitor);
+
+	if (daemon->timer_fd >= 0)
+		close(daemon->timer_fd);
+
+	if (daemon->signal_fd >= 0)
+		close(daemon->signal_fd);
+
+	if (daemon->epoll_fd >= 0)
+		close(daemon->epoll_fd);
+
+	if (daemon->workers != NULL)
+		cdp_worker_pool_delete(daemon->workers);
+
+	if (daemon->uring != NULL)
+		cdp_uring_socket_delete(daemon->uring);
+
+	if (daemon->socket != NULL)
+		cdp_packet_socket_delete(daemon->socket);
+
+	/* Deleted after the io_uring socket which may still be sending from its arena */
+	if (daemon->transmitter != NULL)
+		cdp_transmitter_delete(daemon->transmitter);
+
+	if (daemon->interfaces != NULL)
+		cdp_interface_list_delete(daemon->interfaces);
+}
+
+/** Registers a file descriptor with the daemon's epoll instance.
+  *  @param daemon The daemon object.
+  *  @param fd The file descriptor to watch for input.
+  *  @param source The source to report in the event.
+  *  @return 0 on success or a negative value on error.
+  */
+static int cdp_daemon_watch(struct cdp_daemon *daemon, int fd, enum cdp_daemon_event_source source)
+{
+	struct epoll_event event;
+
+	memset(&event, 0, sizeof(event));
+	event.events = EPOLLIN;
+	event.data.u32 = source;
+
+	if (epoll_ctl(daemon->epoll_fd, EPOLL_CTL_ADD, fd, &event) < 0)
+	{
+		LOG_ERROR("cdp_daemon_watch: failed to add a descriptor to epoll (%s)\n", strerror(errno));
+		return -1;
+	}
+
+	return 0;
+}
+
+/** Opens the sockets, joins the CDP multicast group on every interface and registers every event
+  *  source with epoll. With more than one worker the frames are received by the worker threads
+  *  instead of the event loop. With the io_uring backend the ring is registered instead of the
+  *  packet socket. SIGINT, SIGTERM and SIGUSR1 are blocked and delivered through a signalfd.
+  *  @param daemon The daemon object.
+  *  @return 0 on success or a negative value on error.
+  */
+static int cdp_daemon_start(struct cdp_daemon *daemon)
+{
+	sigset_t signals;
+	size_t i;
+
+	daemon->interfaces = cdp_interface_list_new();
+	if (daemon->interfaces == NULL)
+		return -1;
+
+	/* The signals must be blocked before the worker threads inherit the signal mask */
+	sigemptyset(&signals);
+	sigaddset(&signals, SIGINT);
+	sigaddset(&signals, SIGTERM);
+	sigaddset(&signals, SIGUSR1);
+
+	if (pthread_sigmask(SIG_BLOCK, &signals, NULL) != 0)
+	{
+		LOG_ERROR("cdp_daemon_start: failed to block signals\n");
+		return -1;
+	}
+
+	/* The io_uring socket sends from the transmitter's arena, so the transmitter comes first */
+	if (!daemon->listen_only)
+	{
+		daemon->transmitter = cdp_transmitter_new(cdp_daemon_transmit_batch_size);
+		if (daemon->transmitter == NULL)
+			return -1;
+	}
+
+	if (daemon->worker_count > 1)
+	{
+		daemon->workers = cdp_worker_pool_new(daemon->worker_count, daemon->verbose);
+		if (daemon->workers == NULL)
+			return -1;
+	}
+	else
+	{
+		if (daemon->use_uring)
+			daemon->uring = cdp_uring_socket_new(daemon->transmitter);
+		else
+			daemon->socket = cdp_packet_socket_new();
+
+		if (daemon->uring == NULL && daemon->socket == NULL)
+			return -1;
+
+		daemon->neighbors = cdp_neighbor_list_new();
+		if (daemon->neighbors == NULL)
+			return -1;
+	}
+
+	for (i = 0; i < daemon->interfaces->count; i++)
+		cdp_daemon_join(daemon, &daemon->interfaces->items[i]);
+
+	if (daemon->state_path != NULL)
+		cdp_daemon_load_state(daemon);
+
+	if (daemon->workers != NULL && cdp_worker_pool_start(daemon->workers) < 0)
+		return -1;
+
+	daemon->link_monitor = cdp_link_monitor_new();
+	if (daemon->link_monitor == NULL)
+		return -1;
+
+	daemon->timer_fd = timerfd_create(CLOCK_MONOTONIC, TFD_CLOEXEC | TFD_NONBLOCK);
+	if (daemon->timer_fd < 0)
+	{
+		LOG_ERROR("cdp_daemon_start: failed to create timerfd (%s)\n", strerror(errno));
+		return -1;
+	}
+
+	daemon->signal_fd = signalfd(-1, &signals, SFD_CLOEXEC | SFD_NONBLOCK);
+	if (daemon->signal_fd < 0)
+	{
+		LOG_ERROR("cdp_daemon_start: failed to create signalfd (%s)\n", strerror(errno));
+		return -1;
+	}
+
+	daemon->epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+	if (daemon->epoll_fd < 0)
+	{
+		LOG_ERROR("cdp_daemon_start: failed to create epoll instance (%s)\n", strerror(errno));
+		return -1;
+	}
+
+	if (daemon->socket != NULL && cdp_daemon_watch(daemon, daemon->socket->fd, CDP_DAEMON_EVENT_PACKET) < 0)
+		return -1;
+
+	if (daemon->uring != NULL && cdp_daemon_watch(daemon, daemon->uring->ring.fd, CDP_DAEMON_EVENT_URING) < 0)
+		return -1;
+
+	/* Readers only lose the table, the daemon works without it */
+	daemon->table = cdp_shm_table_writer_create(daemon->table_path, cdp_daemon_table_slots, cdp_daemon_table_heap_size);
+	if (daemon->table == NULL)
+		LOG_ERROR("cdp_daemon_start: failed to create the shared memory table %s\n", daemon->table_path);
+
+	if (daemon->table != NULL && daemon->workers != NULL && cdp_daemon_watch(daemon, daemon->workers->changed_fd, CDP_DAEMON_EVENT_TABLE) < 0)
+		return -1;
+
+	if (
+		cdp_daemon_watch(daemon, daemon->timer_fd, CDP_DAEMON_EVENT_TIMER) < 0 ||
+		cdp_daemon_watch(daemon, daemon->link_monitor->fd, CDP_DAEMON_EVENT_LINK) < 0 ||
+		cdp_daemon_watch(daemon, daemon->signal_fd, CDP_DAEMON_EVENT_SIGNAL) < 0
+	)
+		return -1;
+
+	/* Advertise immediately on start */
+	clock_gettime(CLOCK_MONOTONIC, &daemon->next_transmit);
+
+	return 0;
+}
+
+/** Arms the timer for whichever comes first of the next advertisement, the next neighbor expiry
+  *  and a pending refresh of the shared memory table. The timer is disarmed when none of them is
+  *  pending so that an idle daemon never wakes up.
+  *  @param daemon The daemon object.
+  *  @return 0 on success or a negative value on error.
+  */
+static int cdp_daemon_arm_timer(struct cdp_daemon *daemon)
+{
+	struct itimerspec timer;
+	struct timespec now;
+	struct timespec expiry;
+	bool armed = false;
+	time_t delay = 0;
+
+	memset(&timer, 0, sizeof(timer));
+
+	if (daemon->transmitter != NULL)
+	{
+		clock_gettime(CLOCK_MONOTONIC, &now);
+		delay = daemon->next_transmit.tv_sec - now.tv_sec;
+		armed = true;
+	}
+
+	/* Neighbor times are wall clock times, so the expiry is converted to a relative delay */
+	if (daemon->neighbors != NULL && cdp_neighbor_list_get_next_expiry(daemon->neighbors, &expiry) > 0)
+	{
+		clock_gettime(CLOCK_REALTIME, &now);
+		if (!armed || expiry.tv_sec - now.tv_sec < delay)
+			delay = expiry.tv_sec - now.tv_sec;
+		armed = true;
+	}
+
+	if (daemon->table != NULL && daemon->table_refresh_pending)
+	{
+		clock_gettime(CLOCK_MONOTONIC, &now);
+		if (!armed || daemon->table_published_at + cdp_daemon_table_refresh_interval - now.tv_sec < delay)
+			delay = daemon->table_published_at + cdp_daemon_table_refresh_interval - now.tv_sec;
+		armed = true;
+	}
+
+	if (armed)
+	{
+		/* A zero it_value disarms the timer, so overdue deadlines fire as soon as possible */
+		if (delay > 0)
+			timer.it_value.tv_sec = delay;
+		else
+			timer.it_value.tv_nsec = 1;
+	}
+
+	if (timerfd_settime(daemon->timer_fd, 0, &timer, NULL) < 0)
+	{
+		LOG_ERROR("cdp_daemon_arm_timer: failed to arm the timer (%s)\n", strerror(errno));
+		return -1;
+	}
+
+	return 0;
+}
+
+/** Handles a link or address change by enumerating the interfaces again and bringing the next
+  *  advertisement forward so that neighbors learn about new addresses promptly.
+  *  @param daemon The daemon object.
+  */
+static void cdp_daemon_handle_link_change(struct cdp_daemon *daemon)
+{
+	struct timespec now;
+
+	if (cdp_link_monitor_drain(daemon->link_monitor) <= 0)
+		return;
+
+	if (cdp_daemon_refresh_interfaces(daemon) < 0)
+		LOG_ERROR("cdp_daemon_handle_link_change: failed to refresh the interface list\n");
+
+	if (daemon->transmitter == NULL)
+		return;
+
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	if (daemon->next_transmit.tv_sec > now.tv_sec + cdp_daemon_change_delay)
+		daemon->next_transmit.tv_sec = now.tv_sec + cdp_daemon_change_delay;
+}
+
+/** Purges expired neighbors and sends the advertisements if they're due.
+  *  @param daemon The daemon object.
+  */
+static void cdp_daemon_handle_deadlines(struct cdp_daemon *daemon)
+{
+	struct timespec now;
+	int count;
+
+	/* Workers purge their own shards */
+	if (daemon->neighbors != NULL)
+	{
+		count = daemon->neighbors->count;
+		clock_gettime(CLOCK_REALTIME, &now);
+		cdp_neighbor_list_purge_expired_neighbors(daemon->neighbors, now);
+
+		if (daemon->neighbors->count != count)
+			daemon->table_changed = true;
+	}
+
+	if (daemon->transmitter == NULL)
+		return;
+
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	if (now.tv_sec < daemon->next_transmit.tv_sec)
+		return;
+
+	/* The previous advertisements are still in the arena, try again once they complete */
+	if (daemon->uring != NULL && daemon->uring->sends_in_flight > 0)
+		return;
+
+	daemon->next_transmit.tv_sec = now.tv_sec + cdp_daemon_transmit_interval;
+
+	if (cdp_daemon_refresh_interfaces(daemon) < 0)
+		LOG_ERROR("cdp_daemon_handle_deadlines: failed to refresh the interface list\n");
+
+	cdp_daemon_transmit(daemon);
+}
+
+/** Runs the event loop until SIGINT or SIGTERM is received, SIGUSR1 logs the neighbor table. The
+  *  daemon sleeps in epoll_wait until a frame, a deadline, a link change or a signal arrives.
+  *  @param daemon The daemon object.
+  *  @return 0 on success or a negative value on error.
+  */
+static int cdp_daemon_run(struct cdp_daemon *daemon)
+{
+	struct epoll_event events[CDP_DAEMON_MAX_EVENTS];
+	struct signalfd_siginfo signal_info;
+	uint64_t counter;
+	bool running = true;
+	int count;
+	int i;
+
+	while (running)
+	{
+		cdp_daemon_handle_deadlines(daemon);
+		cdp_daemon_update_table(daemon);
+
+		if (cdp_daemon_arm_timer(daemon) < 0)
+			return -1;
+
+		count = epoll_wait(daemon->epoll_fd, events, CDP_DAEMON_MAX_EVENTS, -1);
+		daemon->system_calls++;
+		if (count < 0)
+		{
+			if (errno == EINTR)
+				continue;
+
+			LOG_ERROR("cdp_daemon_run: epoll_wait failed (%s)\n", strerror(errno));
+			return -1;
+		}
+
+		for (i = 0; i < count; i++)
+		{
+			switch (events[i].data.u32)
+			{
+				case CDP_DAEMON_EVENT_PACKET:
+					if (cdp_packet_socket_receive(daemon->socket, cdp_daemon_handle_frame, daemon) < 0)
+						return -1;
+					break;
+
+				case CDP_DAEMON_EVENT_URING:
+					if (cdp_uring_socket_receive(daemon->uring, cdp_daemon_handle_frame, daemon) < 0)
+						return -1;
+					break;
+
+				case CDP_DAEMON_EVENT_TIMER:
+					/* Only clears the readable state, the deadlines are checked at the top of the loop */
+					if (read(daemon->timer_fd, &counter, sizeof(counter)) < 0 && errno != EAGAIN)
+						LOG_ERROR("cdp_daemon_run: failed to read the timer (%s)\n", strerror(errno));
+					break;
+
+				case CDP_DAEMON_EVENT_TABLE:
+					/* The workers only signal, the snapshot is taken at the top of the loop */
+					if (read(daemon->workers->changed_fd, &counter, sizeof(counter)) == sizeof(counter))
+						daemon->table_changed = true;
+					break;
+
+				case CDP_DAEMON_EVENT_LINK:
+					cdp_daemon_handle_link_change(daemon);
+					break;
+
+				case CDP_DAEMON_EVENT_SIGNAL:
+					if (read(daemon->signal_fd, &signal_info, sizeof(signal_info)) != sizeof(signal_info))
+						break;
+
+					if (signal_info.ssi_signo == SIGUSR1)
+						cdp_daemon_dump_neighbors(daemon);
+					else
+						running = false;
+					break;
+			}
+		}
+	}
+
+	return 0;
+}
+
+/** Checks the name of a receive backend.
+  *  @param name The name given on the command line.
+  *  @return true if the name is "epoll" or "io_uring".
+  */
+static bool cdp_daemon_is_backend(const char *name)
+{
+	return strcmp(name, "epoll") == 0 || strcmp(name, "io_uring") == 0;
+}
+
+int cdp_daemon_main(int argc, char **argv)
+{
+	struct cdp_daemon daemon;
+	int rc;
+	int i;
+
+	memset(&daemon, 0, sizeof(daemon));
+	daemon.epoll_fd = -1;
+	daemon.timer_fd = -1;
+	daemon.signal_fd = -1;
+	daemon.table_path = CDP_SHM_TABLE_DEFAULT_PATH;
+	daemon.state_path = CDP_DAEMON_DEFAULT_STATE_PATH;
+
+	for (i = 1; i < argc; i++)
+	{
+		if (strcmp(argv[i], "-v") == 0 || strcmp(argv[i], "--verbose") == 0)
+			daemon.verbose = true;
+		else if (strcmp(argv[i], "-l") == 0 || strcmp(argv[i], "--listen-only") == 0)
+			daemon.listen_only = true;
+		else if ((strcmp(argv[i], "-w") == 0 || strcmp(argv[i], "--workers") == 0) && i + 1 < argc)
+			daemon.worker_count = (unsigned int)strtoul(argv[++i], NULL, 10);
+		else if ((strcmp(argv[i], "-b") == 0 || strcmp(argv[i], "--backend") == 0) && i + 1 < argc && cdp_daemon_is_backend(argv[i + 1]))
+			daemon.use_uring = (strcmp(argv[++i], "io_uring") == 0);
+		else if ((strcmp(argv[i], "-s") == 0 || strcmp(argv[i], "--shm") == 0) && i + 1 < argc)
+			daemon.table_path = argv[++i];
+		else if ((strcmp(argv[i], "-S") == 0 || strcmp(argv[i], "--state") == 0) && i + 1 < argc)
+			daemon.state_path = (strcmp(argv[++i], "none") == 0) ? NULL : argv[i];
+		else
+		{
+			LOG_ERROR("usage: cdptools daemon [-v|--verbose] [-l|--listen-only] [-w|--workers count] [-b|--backend epoll|io_uring] [-s|--shm path] [-S|--state path|none]\n");
+			return 1;
+		}
+	}
+
+	if (daemon.use_uring && daemon.worker_count > 1)
+	{
+		LOG_ERROR("cdp: the io_uring backend receives in the event loop and can't be combined with workers\n");
+		return 1;
+	}
+
+	if (cdp_daemon_start(&daemon) < 0)
+	{
+		LOG_CRITICAL("cdp: failed to start the daemon\n");
+		cdp_daemon_cleanup(&daemon);
+		return 1;
+	}
+
+	rc = cdp_daemon_run(&daemon);
+
+	if (daemon.state_path != NULL)
+		cdp_daemon_save_state(&daemon);
+
+	cdp_daemon_cleanup(&daemon);
+
+	return rc < 0 ? 1 : 0;
+}
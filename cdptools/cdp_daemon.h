@@ -0,0 +1,96 @@
+#ifndef CDP_DAEMON_H
+#define CDP_DAEMON_H
+
+#include "cdp_interface.h"
+#include "cdp_link_monitor.h"
+#include "cdp_packet_socket.h"
+#include "cdp_transmitter.h"
+#include "cdp_uring_socket.h"
+#include "cdp_worker.h"
+#include "../libcdp/cdp_neighbor.h"
+#include "../libcdp/cdp_shm_table.h"
+
+/** The file the daemon saves its neighbor table to on exit and loads it from on start */
+#define CDP_DAEMON_DEFAULT_STATE_PATH "/var/lib/cdp-neighbors"
+
+/** The state of the user mode CDP daemon */
+struct cdp_daemon
+{
+	/** The Ethernet interfaces of the system */
+	struct cdp_interface_list *interfaces;
+
+	/** The packet socket receiving CDP frames, NULL when workers receive them */
+	struct cdp_packet_socket *socket;
+
+	/** The io_uring socket receiving and sending CDP frames, NULL with the epoll backend */
+	struct cdp_uring_socket *uring;
+
+	/** The receive workers each owning a shard of the neighbor table, NULL with a single socket */
+	struct cdp_worker_pool *workers;
+
+	/** The number of receive workers requested, 0 or 1 receives in the event loop */
+	unsigned int worker_count;
+
+	/** The batched transmitter for advertisements or NULL when listening only */
+	struct cdp_transmitter *transmitter;
+
+	/** The netlink route socket reporting link and address changes */
+	struct cdp_link_monitor *link_monitor;
+
+	/** The epoll instance every event source is registered with */
+	int epoll_fd;
+
+	/** The timer for the next advertisement or neighbor expiry, whichever is first */
+	int timer_fd;
+
+	/** The signalfd receiving SIGINT and SIGTERM */
+	int signal_fd;
+
+	/** The neighbor table, NULL when workers own the table */
+	struct cdp_neighbor_list *neighbors;
+
+	/** The shared memory table the neighbors are published in or NULL if it couldn't be created */
+	struct cdp_shm_table_writer *table;
+
+	/** The file the shared memory table is published in */
+	const char *table_path;
+
+	/** The file the neighbor table is saved to on exit and loaded from on start or NULL */
+	const char *state_path;
+
+	/** Whether neighbors were added, changed or removed since the table was published */
+	bool table_changed;
+
+	/** Whether neighbors were refreshed by identical frames since the table was published */
+	bool table_refresh_pending;
+
+	/** The monotonic time the table was last published (seconds) */
+	time_t table_published_at;
+
+	/** The monotonic time at which the next advertisements are due */
+	struct timespec next_transmit;
+
+	/** The number of CDP frames processed by the event loop */
+	unsigned long frames;
+
+	/** The number of epoll_wait system calls made by the event loop */
+	unsigned long system_calls;
+
+	/** Whether to log every neighbor change */
+	bool verbose;
+
+	/** Whether to only listen and not advertise this host */
+	bool listen_only;
+
+	/** Whether to receive and send through io_uring instead of the TPACKET ring and sendmmsg */
+	bool use_uring;
+};
+
+/** Entry point of "cdptools daemon"
+  *  @param argc The number of arguments following the command name.
+  *  @param argv The arguments, argv[0] is the command name.
+  *  @return The process exit code.
+  */
+int cdp_daemon_main(int argc, char **argv);
+
+#endif
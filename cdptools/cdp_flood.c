@@ -0,0 +1,147 @@
+#include "cdp_flood.h"
+#include "cdp_interface.h"
+#include "cdp_transmitter.h"
+#include "../libcdp/platform/platform.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+/** The number of rounds in a row that may send nothing before flooding gives up */
+#define CDP_FLOOD_MAX_EMPTY_ROUNDS 100
+
+/** The time to wait after a round that sent nothing, for socket buffers to drain */
+#define CDP_FLOOD_BACKOFF_NANOSECONDS 10000000
+
+/** Queues one frame per synthetic source on each of the named interfaces.
+  *  @param transmitter The transmitter to queue the frames on.
+  *  @param interfaces The interfaces of the system.
+  *  @param names The names of the interfaces to flood.
+  *  @param name_count The number of names.
+  *  @param sources The number of source MAC addresses per interface.
+  *  @return 0 on success or a negative value on error.
+  */
+static int cdp_flood_queue_frames(
+	struct cdp_transmitter *transmitter,
+	const struct cdp_interface_list *interfaces,
+	char **names,
+	int name_count,
+	unsigned int sources
+)
+{
+	struct cdp_interface synthetic;
+	unsigned int source;
+	size_t i;
+	int n;
+
+	for (n = 0; n < name_count; n++)
+	{
+		for (i = 0; i < interfaces->count; i++)
+		{
+			if (strcmp(interfaces->items[i].name, names[n]) == 0)
+				break;
+		}
+
+		if (i == interfaces->count)
+		{
+			LOG_ERROR("cdp_flood: %s is not an Ethernet interface\n", names[n]);
+			return -1;
+		}
+
+		/* A locally administered MAC per source, each appears as a distinct neighbor */
+		synthetic = interfaces->items[i];
+		for (source = 0; source < sources; source++)
+		{
+			synthetic.mac[0] = 0x02;
+			synthetic.mac[3] = (uint8_t)n;
+			synthetic.mac[4] = (uint8_t)(source >> 8);
+			synthetic.mac[5] = (uint8_t)source;
+
+			if (cdp_transmitter_queue(transmitter, &synthetic) < 0)
+				return -1;
+		}
+	}
+
+	return 0;
+}
+
+int cdp_flood_main(int argc, char **argv)
+{
+	struct cdp_interface_list *interfaces;
+	struct cdp_transmitter *transmitter;
+	struct timespec started;
+	struct timespec finished;
+	unsigned long count = 1000000;
+	unsigned long sent = 0;
+	unsigned int sources = 16;
+	unsigned int empty_rounds = 0;
+	struct timespec backoff = { 0, CDP_FLOOD_BACKOFF_NANOSECONDS };
+	double elapsed;
+	int first_name;
+	int rc;
+
+	for (first_name = 1; first_name < argc; first_name++)
+	{
+		if (strcmp(argv[first_name], "-c") == 0 && first_name + 1 < argc)
+			count = strtoul(argv[++first_name], NULL, 10);
+		else if (strcmp(argv[first_name], "-s") == 0 && first_name + 1 < argc)
+			sources = (unsigned int)strtoul(argv[++first_name], NULL, 10);
+		else
+			break;
+	}
+
+	if (first_name == argc || sources == 0 || sources > 0xFFFF)
+	{
+		LOG_ERROR("usage: cdptools flood [-c frames] [-s sources per interface] interface...\n");
+		return 1;
+	}
+
+	interfaces = cdp_interface_list_new();
+	if (interfaces == NULL)
+		return 1;
+
+	transmitter = cdp_transmitter_new(sources * (unsigned int)(argc - first_name));
+	if (transmitter == NULL)
+	{
+		cdp_interface_list_delete(interfaces);
+		return 1;
+	}
+
+	rc = cdp_flood_queue_frames(transmitter, interfaces, argv + first_name, argc - first_name, sources);
+	cdp_interface_list_delete(interfaces);
+
+	clock_gettime(CLOCK_MONOTONIC, &started);
+
+	while (rc == 0 && sent < count)
+	{
+		rc = cdp_transmitter_send(transmitter);
+		if (rc < 0)
+			break;
+
+		/* Every frame of the round failed, either the socket buffers are full or the interfaces are down */
+		if (rc == 0)
+		{
+			if (++empty_rounds == CDP_FLOOD_MAX_EMPTY_ROUNDS)
+			{
+				LOG_ERROR("cdp_flood_main: no frame could be sent in %u rounds, giving up\n", empty_rounds);
+				rc = -1;
+				break;
+			}
+
+			nanosleep(&backoff, NULL);
+			continue;
+		}
+
+		empty_rounds = 0;
+		sent += (unsigned long)rc;
+		rc = 0;
+	}
+
+	clock_gettime(CLOCK_MONOTONIC, &finished);
+	cdp_transmitter_delete(transmitter);
+
+	elapsed = (double)(finished.tv_sec - started.tv_sec) + (double)(finished.tv_nsec - started.tv_nsec) / 1e9;
+	LOG_INFORMATIONAL("cdp: sent %lu frames in %.3f seconds (%.0f frames/s)\n", sent, elapsed, elapsed > 0 ? (double)sent / elapsed : 0.0);
+
+	return rc < 0 ? 1 : 0;
+}
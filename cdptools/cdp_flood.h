@@ -0,0 +1,13 @@
+#ifndef CDP_FLOOD_H
+#define CDP_FLOOD_H
+
+/** Entry point of "cdptools flood", a load generator which sends CDP advertisements from many
+  *  synthetic source MAC addresses as fast as possible. It's meant for benchmarking the daemon
+  *  over veth pairs and must never be pointed at a production network.
+  *  @param argc The number of arguments following the command name.
+  *  @param argv The arguments, argv[0] is the command name.
+  *  @return The process exit code.
+  */
+int cdp_flood_main(int argc, char **argv);
+
+#endif
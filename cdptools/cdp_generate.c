@@ -0,0 +1,739 @@
+#define _GNU_SOURCE
+
+#include "cdp_generate.h"
+#include "cdp_packet_socket.h"
+#include "cdp_transmitter.h"
+#include "../libcdp/cdp_packet.h"
+#include "../libcdp/ecdptlv.h"
+#include "../libcdp/ip_address_array.h"
+#include "../libcdp/stream_writer.h"
+#include "../libcdp/platform/platform.h"
+
+#include <errno.h>
+#include <net/if.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+/** The largest number of frames sent with a single sendmmsg call */
+#define CDP_GENERATE_BATCH_SIZE 64
+
+/** The rate the timestamps of a pcap file are spaced at when no rate is given */
+#define CDP_GENERATE_DEFAULT_PCAP_RATE 1000
+
+/** The port name formats the simulated neighbors pick from */
+static const char *cdp_generate_port_formats[] = { "GigabitEthernet1/0/%u", "TenGigabitEthernet1/1/%u", "FastEthernet0/%u", "Ethernet1/%u" };
+
+/** The platforms the simulated neighbors pick from */
+static const char *cdp_generate_platforms[] = { "cisco WS-C2960G-24TC-L", "cisco WS-C3850-48P", "cisco CSR1000V", "cisco N9K-C93180YC-EX" };
+
+/** The capabilities the simulated neighbors pick from */
+static const uint32_t cdp_generate_capabilities[] = {
+	CdpCapabilitySwitching | CdpCapabilityIGMP,
+	CdpCapabilityRouting | CdpCapabilitySwitching | CdpCapabilityIGMP,
+	CdpCapabilityRouting | CdpCapabilityIGMP,
+	CdpCapabilityHost
+};
+
+/** The ways a frame is made malformed */
+enum cdp_generate_malformation
+{
+	/** The frame ends in the middle of its last TLV */
+	CdpGenerateTruncated,
+
+	/** The first TLV claims to be shorter than its own header */
+	CdpGenerateShortTlv,
+
+	/** The checksum is wrong */
+	CdpGenerateBadChecksum,
+
+	/** The address count claims far more addresses than the TLV holds */
+	CdpGenerateAddressCount,
+
+	CdpGenerateMalformationCount
+};
+
+/** The options of a generator run */
+struct cdp_generate_options
+{
+	/** The number of simulated neighbors */
+	unsigned long neighbors;
+
+	/** The number of frames to send or write, the neighbors taking turns */
+	unsigned long count;
+
+	/** The target rate in frames per second, 0 for as fast as possible */
+	unsigned long rate;
+
+	/** The percentage of the neighbors whose frames are malformed */
+	unsigned int malformed;
+
+	/** The seed everything random is derived from */
+	uint64_t seed;
+
+	/** The pcap file to write instead of sending, or NULL */
+	const char *pcap;
+
+	/** The interface to send on, or NULL */
+	const char *interface;
+};
+
+/** The frames of the simulated neighbors, built once and stored back to back */
+struct cdp_generate_frames
+{
+	/** The frames, complete with their Ethernet and SNAP headers */
+	uint8_t *data;
+
+	/** The size of data in bytes */
+	size_t capacity;
+
+	/** The number of bytes of data in use */
+	size_t used;
+
+	/** The offset of each frame within data */
+	size_t *offsets;
+
+	/** The length of each frame */
+	uint16_t *lengths;
+
+	/** The number of frames */
+	unsigned long count;
+
+	/** The number of frames which were made malformed */
+	unsigned long malformed;
+};
+
+/** A xorshift64* generator, which is all the randomness a load test needs and repeats for a seed.
+  *  @param state The generator state, never 0.
+  *  @return The next random number.
+  */
+static uint64_t cdp_generate_random(uint64_t *state)
+{
+	*state ^= *state >> 12;
+	*state ^= *state << 25;
+	*state ^= *state >> 27;
+
+	return *state * 0x2545F4914F6CDD1DULL;
+}
+
+/** Picks a random number in a range.
+  *  @param state The generator state.
+  *  @param count The number of values to pick from.
+  *  @return A number from 0 to count - 1.
+  */
+static unsigned int cdp_generate_pick(uint64_t *state, unsigned int count)
+{
+	return (unsigned int)(cdp_generate_random(state) % count);
+}
+
+/** Builds the packet of a simulated neighbor.
+  *  @param index The index of the neighbor.
+  *  @param random The generator state.
+  *  @return The packet or NULL on error.
+  */
+static struct cdp_packet *cdp_generate_packet(unsigned long index, uint64_t *random)
+{
+	static const char filler[] = "Technical Support: http://www.cisco.com/techsupport\nCopyright (c) 1986-2012 by Cisco Systems, Inc.\n";
+	struct ip_address_array *addresses;
+	struct cdp_packet *packet;
+	char device_id[64];
+	char port_id[64];
+	char software_version[512];
+	uint8_t ipv6[16] = { 0x20, 0x01, 0x0D, 0xB8 };
+	unsigned int address_count;
+	unsigned int padding;
+	size_t length;
+	unsigned int i;
+
+	snprintf(device_id, sizeof(device_id), "sim%07lu.generated.test", index);
+	snprintf(port_id, sizeof(port_id), cdp_generate_port_formats[cdp_generate_pick(random, 4)], 1 + cdp_generate_pick(random, 48));
+
+	/* The version string is the TLV which varies the most in length between real devices */
+	length = (size_t)snprintf(
+		software_version,
+		sizeof(software_version),
+		"Cisco IOS Software, Version 15.%u(%u)SE%u, RELEASE SOFTWARE\n",
+		cdp_generate_pick(random, 10),
+		cdp_generate_pick(random, 4),
+		cdp_generate_pick(random, 12)
+	);
+	for (padding = cdp_generate_pick(random, 400); padding > 0 && length + 1 < sizeof(software_version); padding--, length++)
+		software_version[length] = filler[length % (sizeof(filler) - 1)];
+	software_version[length] = '\0';
+
+	address_count = 1 + cdp_generate_pick(random, 4);
+	addresses = ip_address_array_new(address_count);
+	if (addresses == NULL)
+	{
+		LOG_CRITICAL("cdp_generate_packet: failed to allocate the address array\n");
+		return NULL;
+	}
+
+	for (i = 0; i < address_count; i++)
+	{
+		if (cdp_generate_pick(random, 2) == 0)
+		{
+			ip_address_array_set_into_ipv4_uint32(addresses, i, htonl(0x0A000000 | (uint32_t)((index << 2) + i)));
+			continue;
+		}
+
+		ipv6[12] = (uint8_t)(index >> 16);
+		ipv6[13] = (uint8_t)(index >> 8);
+		ipv6[14] = (uint8_t)index;
+		ipv6[15] = (uint8_t)i;
+		ip_address_array_set_into_ipv6_raw(addresses, i, ipv6);
+	}
+
+	packet = cdp_packet_new_advertisement(port_id, device_id, cdp_generate_platforms[cdp_generate_pick(random, 4)], software_version, addresses);
+	ip_address_array_clear_and_delete(addresses);
+
+	if (packet == NULL)
+	{
+		LOG_ERROR("cdp_generate_packet: failed to build the packet of neighbor %lu\n", index);
+		return NULL;
+	}
+
+	if (cdp_packet_set_capabilities(packet, cdp_generate_capabilities[cdp_generate_pick(random, 4)]) < 0)
+	{
+		LOG_ERROR("cdp_generate_packet: failed to set the capabilities of neighbor %lu\n", index);
+		cdp_packet_delete(packet);
+		return NULL;
+	}
+
+	return packet;
+}
+
+/** Appends the optional TLVs cdp_packet_serialize doesn't write, each with an even chance, the way
+  *  switches add VTP, VLAN and trust TLVs which routers leave out.
+  *  @param payload The CDP frame.
+  *  @param length The length of the frame.
+  *  @param capacity The size of the buffer holding the frame.
+  *  @param random The generator state.
+  *  @return The new length of the frame or a negative value on error.
+  */
+static ssize_t cdp_generate_append_tlvs(uint8_t *payload, size_t length, size_t capacity, uint64_t *random)
+{
+	struct stream_writer *writer;
+	char vtp_domain[32];
+	ssize_t appended;
+	int rc = 0;
+
+	writer = stream_writer_new(payload + length, capacity - length);
+	if (writer == NULL)
+		return -1;
+
+	if (cdp_generate_pick(random, 2) == 0)
+	{
+		snprintf(vtp_domain, sizeof(vtp_domain), "sim-domain-%u", cdp_generate_pick(random, 16));
+		rc = stream_writer_put16(writer, CdpTlvVtpManagementDomain);
+		if (rc == 0)
+			rc = stream_writer_put16(writer, (uint16_t)(4 + strlen(vtp_domain)));
+		if (rc == 0)
+			rc = stream_writer_put_string(writer, vtp_domain);
+	}
+
+	if (rc == 0 && cdp_generate_pick(random, 2) == 0)
+	{
+		rc = stream_writer_put16(writer, CdpTlvNativeVlan);
+		if (rc == 0)
+			rc = stream_writer_put16(writer, 6);
+		if (rc == 0)
+			rc = stream_writer_put16(writer, (uint16_t)(1 + cdp_generate_pick(random, 4094)));
+	}
+
+	if (rc == 0 && cdp_generate_pick(random, 2) == 0)
+	{
+		rc = stream_writer_put16(writer, CdpTlvTrustBitmap);
+		if (rc == 0)
+			rc = stream_writer_put16(writer, 5);
+		if (rc == 0)
+			rc = stream_writer_put8(writer, 0);
+		if (rc == 0)
+			rc = stream_writer_put16(writer, CdpTlvUntrustedPortCoS);
+		if (rc == 0)
+			rc = stream_writer_put16(writer, 5);
+		if (rc == 0)
+			rc = stream_writer_put8(writer, 0);
+	}
+
+	appended = stream_writer_length(writer);
+	stream_writer_delete(writer);
+
+	if (rc < 0 || appended < 0)
+		return -1;
+
+	return (ssize_t)length + appended;
+}
+
+/** Finds a TLV within a CDP frame.
+  *  @param payload The CDP frame.
+  *  @param length The length of the frame.
+  *  @param type The type of the TLV.
+  *  @return The offset of the TLV or 0 if the frame doesn't have it.
+  */
+static size_t cdp_generate_find_tlv(const uint8_t *payload, size_t length, uint16_t type)
+{
+	size_t position = 4;
+	size_t tlv_length;
+
+	while (position + 4 <= length)
+	{
+		tlv_length = ((size_t)payload[position + 2] << 8) | payload[position + 3];
+		if (((payload[position] << 8) | payload[position + 1]) == type)
+			return position;
+
+		if (tlv_length < 4)
+			return 0;
+
+		position += tlv_length;
+	}
+
+	return 0;
+}
+
+/** Breaks a frame in one of the ways of enum cdp_generate_malformation. The checksum is computed
+  *  again afterwards, so only the frames meant to have a bad checksum fail checksum validation and the
+  *  others reach the parser.
+  *  @param payload The CDP frame.
+  *  @param length The length of the frame.
+  *  @param malformation How to break the frame.
+  *  @param random The generator state.
+  *  @return The new length of the frame.
+  */
+static size_t cdp_generate_malform(uint8_t *payload, size_t length, enum cdp_generate_malformation malformation, uint64_t *random)
+{
+	size_t position;
+
+	switch (malformation)
+	{
+		case CdpGenerateTruncated:
+			length -= 1 + cdp_generate_pick(random, 8);
+			break;
+
+		case CdpGenerateShortTlv:
+			payload[6] = 0;
+			payload[7] = 2;
+			break;
+
+		case CdpGenerateAddressCount:
+			position = cdp_generate_find_tlv(payload, length, CdpTlvAddresses);
+			if (position != 0)
+				memset(payload + position + 4, 0xFF, 4);
+			break;
+
+		default:
+			break;
+	}
+
+	return length;
+}
+
+/** Recomputes the checksum of a frame after it was altered in place.
+  *  @param payload The CDP frame.
+  *  @param length The length of the frame.
+  *  @return 0 on success or a negative value on error.
+  */
+static int cdp_generate_checksum(uint8_t *payload, size_t length)
+{
+	struct stream_writer *writer;
+	int rc;
+
+	payload[2] = 0;
+	payload[3] = 0;
+
+	writer = stream_writer_new(payload, length);
+	if (writer == NULL)
+		return -1;
+
+	rc = stream_writer_skip(writer, length);
+	if (rc == 0)
+		rc = stream_writer_inject_checksum(writer, 2);
+
+	stream_writer_delete(writer);
+	return rc;
+}
+
+/** Makes room for another frame in the frame store.
+  *  @param frames The frame store.
+  *  @return 0 on success or a negative value on error.
+  */
+static int cdp_generate_frames_reserve(struct cdp_generate_frames *frames)
+{
+	uint8_t *data;
+	size_t capacity;
+
+	if (frames->used + CDP_TRANSMITTER_MAX_FRAME_LENGTH <= frames->capacity)
+		return 0;
+
+	capacity = frames->capacity * 2 + CDP_TRANSMITTER_MAX_FRAME_LENGTH * 64;
+
+	data = ALLOC_NEW_ARRAY(uint8_t, capacity);
+	if (data == NULL)
+	{
+		LOG_CRITICAL("cdp_generate_frames_reserve: failed to allocate %zu bytes for the frames\n", capacity);
+		return -1;
+	}
+
+	if (frames->data != NULL)
+	{
+		memcpy(data, frames->data, frames->used);
+		FREE_ARRAY(frames->data);
+	}
+
+	frames->data = data;
+	frames->capacity = capacity;
+
+	return 0;
+}
+
+/** Destructor of the frame store.
+  *  @param frames The frame store to delete.
+  */
+static void cdp_generate_frames_delete(struct cdp_generate_frames *frames)
+{
+	if (frames == NULL)
+		return;
+
+	if (frames->data != NULL)
+		FREE_ARRAY(frames->data);
+
+	if (frames->offsets != NULL)
+		FREE_ARRAY(frames->offsets);
+
+	if (frames->lengths != NULL)
+		FREE_ARRAY(frames->lengths);
+
+	FREE(frames);
+}
+
+/** Constructor, builds the frames of every simulated neighbor.
+  *  @param options The options of the run.
+  *  @return The frame store or NULL on error.
+  */
+static struct cdp_generate_frames *cdp_generate_frames_new(const struct cdp_generate_options *options)
+{
+	enum cdp_generate_malformation malformation;
+	struct cdp_generate_frames *result;
+	struct cdp_packet *packet;
+	uint64_t random = options->seed;
+	uint8_t source_mac[6];
+	uint8_t *frame;
+	uint8_t *payload;
+	size_t capacity;
+	ssize_t length;
+	unsigned long i;
+
+	result = ALLOC_NEW(struct cdp_generate_frames);
+	if (result == NULL)
+	{
+		LOG_CRITICAL("cdp_generate_frames_new: failed to allocate the frame store\n");
+		return NULL;
+	}
+
+	memset(result, 0, sizeof(struct cdp_generate_frames));
+
+	result->offsets = ALLOC_NEW_ARRAY(size_t, options->neighbors);
+	result->lengths = ALLOC_NEW_ARRAY(uint16_t, options->neighbors);
+	if (result->offsets == NULL || result->lengths == NULL)
+	{
+		LOG_CRITICAL("cdp_generate_frames_new: failed to allocate the frame index\n");
+		cdp_generate_frames_delete(result);
+		return NULL;
+	}
+
+	capacity = CDP_TRANSMITTER_MAX_FRAME_LENGTH - CDP_ETHERNET_HEADER_LENGTH - CDP_SNAP_HEADER_LENGTH;
+
+	for (i = 0; i < options->neighbors; i++)
+	{
+		if (cdp_generate_frames_reserve(result) < 0)
+		{
+			cdp_generate_frames_delete(result);
+			return NULL;
+		}
+
+		frame = result->data + result->used;
+		payload = frame + CDP_ETHERNET_HEADER_LENGTH + CDP_SNAP_HEADER_LENGTH;
+
+		packet = cdp_generate_packet(i, &random);
+		if (packet == NULL)
+		{
+			cdp_generate_frames_delete(result);
+			return NULL;
+		}
+
+		length = cdp_packet_serialize(packet, payload, capacity);
+		cdp_packet_delete(packet);
+
+		if (length > 0)
+			length = cdp_generate_append_tlvs(payload, (size_t)length, capacity, &random);
+
+		if (length < 0)
+		{
+			LOG_ERROR("cdp_generate_frames_new: failed to serialize the frame of neighbor %lu (%s)\n", i, cdp_error_name((int)length));
+			cdp_generate_frames_delete(result);
+			return NULL;
+		}
+
+		if (cdp_generate_pick(&random, 100) < options->malformed)
+		{
+			malformation = (enum cdp_generate_malformation)cdp_generate_pick(&random, CdpGenerateMalformationCount);
+			length = (ssize_t)cdp_generate_malform(payload, (size_t)length, malformation, &random);
+			result->malformed++;
+		}
+		else
+		{
+			malformation = CdpGenerateMalformationCount;
+		}
+
+		if (cdp_generate_checksum(payload, (size_t)length) < 0)
+		{
+			LOG_ERROR("cdp_generate_frames_new: failed to compute the checksum of neighbor %lu\n", i);
+			cdp_generate_frames_delete(result);
+			return NULL;
+		}
+
+		if (malformation == CdpGenerateBadChecksum)
+			payload[2] ^= 0x5A;
+
+		/* Each neighbor sends from its own locally administered MAC */
+		source_mac[0] = 0x02;
+		source_mac[1] = 0xCD;
+		source_mac[2] = (uint8_t)(i >> 24);
+		source_mac[3] = (uint8_t)(i >> 16);
+		source_mac[4] = (uint8_t)(i >> 8);
+		source_mac[5] = (uint8_t)i;
+
+		result->offsets[i] = result->used;
+		result->lengths[i] = (uint16_t)cdp_transmitter_write_headers(frame, source_mac, (size_t)length);
+		result->used += result->lengths[i];
+		result->count++;
+	}
+
+	return result;
+}
+
+/** Writes the frames to a pcap file, with timestamps spaced at the target rate.
+  *  @param frames The frames of the neighbors.
+  *  @param options The options of the run.
+  *  @return The number of frames written or a negative value on error.
+  */
+static long cdp_generate_write_pcap(const struct cdp_generate_frames *frames, const struct cdp_generate_options *options)
+{
+	/* The classic pcap header, microsecond timestamps, 65535 byte snap length and Ethernet link type */
+	static const uint32_t header[6] = { 0xA1B2C3D4, 0x00040002, 0, 0, 65535, 1 };
+	unsigned long rate = options->rate != 0 ? options->rate : CDP_GENERATE_DEFAULT_PCAP_RATE;
+	struct timespec now;
+	uint32_t record[4];
+	uint64_t microseconds;
+	unsigned long written;
+	unsigned long index;
+	FILE *file;
+
+	file = fopen(options->pcap, "wb");
+	if (file == NULL)
+	{
+		LOG_ERROR("cdp_generate: failed to create %s (%s)\n", options->pcap, strerror(errno));
+		return -1;
+	}
+
+	clock_gettime(CLOCK_REALTIME, &now);
+
+	if (fwrite(header, sizeof(header), 1, file) != 1)
+	{
+		LOG_ERROR("cdp_generate: failed to write %s\n", options->pcap);
+		fclose(file);
+		return -1;
+	}
+
+	for (written = 0; written < options->count; written++)
+	{
+		index = written % frames->count;
+		microseconds = (uint64_t)now.tv_sec * 1000000 + (uint64_t)now.tv_nsec / 1000 + (uint64_t)written * 1000000 / rate;
+
+		record[0] = (uint32_t)(microseconds / 1000000);
+		record[1] = (uint32_t)(microseconds % 1000000);
+		record[2] = frames->lengths[index];
+		record[3] = frames->lengths[index];
+
+		if (fwrite(record, sizeof(record), 1, file) != 1 || fwrite(frames->data + frames->offsets[index], frames->lengths[index], 1, file) != 1)
+		{
+			LOG_ERROR("cdp_generate: failed to write %s\n", options->pcap);
+			fclose(file);
+			return -1;
+		}
+	}
+
+	if (fclose(file) != 0)
+	{
+		LOG_ERROR("cdp_generate: failed to write %s (%s)\n", options->pcap, strerror(errno));
+		return -1;
+	}
+
+	return (long)written;
+}
+
+/** Sends the frames on an interface in batches, sleeping between batches to hold the target rate.
+  *  @param frames The frames of the neighbors.
+  *  @param options The options of the run.
+  *  @return The number of frames sent or a negative value on error.
+  */
+static long cdp_generate_send(const struct cdp_generate_frames *frames, const struct cdp_generate_options *options)
+{
+	struct cdp_transmitter *transmitter;
+	struct timespec started;
+	struct timespec due;
+	unsigned long batch = CDP_GENERATE_BATCH_SIZE;
+	unsigned long queued = 0;
+	unsigned long sent = 0;
+	unsigned long index;
+	uint64_t offset_ns;
+	int ifindex;
+	int rc = 0;
+
+	ifindex = (int)if_nametoindex(options->interface);
+	if (ifindex == 0)
+	{
+		LOG_ERROR("cdp_generate: unknown interface %s\n", options->interface);
+		return -1;
+	}
+
+	/* Low rates are sent in smaller batches so the frames aren't bunched into bursts */
+	if (options->rate != 0 && options->rate / 100 < batch)
+		batch = options->rate / 100 > 0 ? options->rate / 100 : 1;
+
+	transmitter = cdp_transmitter_new((unsigned int)batch);
+	if (transmitter == NULL)
+		return -1;
+
+	clock_gettime(CLOCK_MONOTONIC, &started);
+
+	while (queued < options->count)
+	{
+		if (options->rate != 0)
+		{
+			offset_ns = (uint64_t)queued * 1000000000ULL / options->rate;
+			due.tv_sec = started.tv_sec + (time_t)(offset_ns / 1000000000ULL);
+			due.tv_nsec = started.tv_nsec + (long)(offset_ns % 1000000000ULL);
+			if (due.tv_nsec >= 1000000000L)
+			{
+				due.tv_sec++;
+				due.tv_nsec -= 1000000000L;
+			}
+
+			while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &due, NULL) == EINTR)
+				;
+		}
+
+		for (; queued < options->count && transmitter->queued < batch; queued++)
+		{
+			index = queued % frames->count;
+			rc = cdp_transmitter_queue_frame(transmitter, ifindex, frames->data + frames->offsets[index], frames->lengths[index]);
+			if (rc < 0)
+				break;
+		}
+
+		if (rc < 0)
+			break;
+
+		rc = cdp_transmitter_flush(transmitter);
+		if (rc < 0)
+			break;
+
+		sent += (unsigned long)rc;
+		rc = 0;
+	}
+
+	cdp_transmitter_delete(transmitter);
+
+	return rc < 0 ? -1 : (long)sent;
+}
+
+int cdp_generate_main(int argc, char **argv)
+{
+	struct cdp_generate_options options;
+	struct cdp_generate_frames *frames;
+	struct timespec started;
+	struct timespec finished;
+	double elapsed;
+	long done;
+	int i;
+
+	memset(&options, 0, sizeof(options));
+	options.neighbors = 1000;
+	options.seed = 1;
+
+	for (i = 1; i < argc; i++)
+	{
+		if (strcmp(argv[i], "-n") == 0 && i + 1 < argc)
+			options.neighbors = strtoul(argv[++i], NULL, 10);
+		else if (strcmp(argv[i], "-c") == 0 && i + 1 < argc)
+			options.count = strtoul(argv[++i], NULL, 10);
+		else if (strcmp(argv[i], "-r") == 0 && i + 1 < argc)
+			options.rate = strtoul(argv[++i], NULL, 10);
+		else if (strcmp(argv[i], "-m") == 0 && i + 1 < argc)
+			options.malformed = (unsigned int)strtoul(argv[++i], NULL, 10);
+		else if (strcmp(argv[i], "-S") == 0 && i + 1 < argc)
+			options.seed = strtoull(argv[++i], NULL, 10);
+		else if (strcmp(argv[i], "-w") == 0 && i + 1 < argc)
+			options.pcap = argv[++i];
+		else if (argv[i][0] != '-' && options.interface == NULL)
+			options.interface = argv[i];
+		else
+			break;
+	}
+
+	if (
+		i != argc ||
+		(options.interface == NULL) == (options.pcap == NULL) ||
+		options.neighbors == 0 ||
+		options.neighbors > 0xFFFFFFFFUL ||
+		options.malformed > 100
+	)
+	{
+		LOG_ERROR("usage: cdptools generate [-n neighbors] [-c frames] [-r frames/s] [-m malformed %%] [-S seed] (-w file.pcap | interface)\n");
+		return 1;
+	}
+
+	if (options.count == 0)
+		options.count = options.neighbors;
+
+	/* A seed of 0 would leave the generator stuck at 0 */
+	if (options.seed == 0)
+		options.seed = 1;
+
+	frames = cdp_generate_frames_new(&options);
+	if (frames == NULL)
+		return 1;
+
+	LOG_INFORMATIONAL(
+		"cdp: generated %lu neighbors, %lu malformed, %zu bytes of frames\n",
+		frames->count,
+		frames->malformed,
+		frames->used
+	);
+
+	clock_gettime(CLOCK_MONOTONIC, &started);
+
+	if (options.pcap != NULL)
+		done = cdp_generate_write_pcap(frames, &options);
+	else
+		done = cdp_generate_send(frames, &options);
+
+	clock_gettime(CLOCK_MONOTONIC, &finished);
+	cdp_generate_frames_delete(frames);
+
+	if (done < 0)
+		return 1;
+
+	elapsed = (double)(finished.tv_sec - started.tv_sec) + (double)(finished.tv_nsec - started.tv_nsec) / 1e9;
+	LOG_INFORMATIONAL(
+		"cdp: %s %ld frames in %.3f seconds (%.0f frames/s)\n",
+		options.pcap != NULL ? "wrote" : "sent",
+		done,
+		elapsed,
+		elapsed > 0 ? (double)done / elapsed : 0.0
+	);
+
+	return 0;
+}
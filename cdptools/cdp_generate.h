@@ -0,0 +1,15 @@
+#ifndef CDP_GENERATE_H
+#define CDP_GENERATE_H
+
+/** Entry point of "cdptools generate", a traffic generator which builds frames for a number of
+  *  simulated neighbors, each with its own device ID, port, addresses and mix of TLVs, and a share of
+  *  them malformed. The frames are sent on an interface at a target rate or written to a pcap file.
+  *  Everything is derived from a seed so that a run can be repeated exactly. It's meant for veth and
+  *  tap interfaces and must never be pointed at a production network.
+  *  @param argc The number of arguments following the command name.
+  *  @param argv The arguments, argv[0] is the command name.
+  *  @return The process exit code.
+  */
+int cdp_generate_main(int argc, char **argv);
+
+#endif
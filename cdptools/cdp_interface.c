@@ -0,0 +1,185 @@
+#include "cdp_interface.h"
+#include "../libcdp/platform/platform.h"
+
+#include <ifaddrs.h>
+#include <linux/if_arp.h>
+#include <linux/if_packet.h>
+#include <string.h>
+
+/** Tests whether an interface address entry describes a usable Ethernet interface.
+  *  @param entry The entry from getifaddrs.
+  *  @return true if CDP should run on the interface.
+  */
+static bool is_ethernet_link(const struct ifaddrs *entry)
+{
+	const struct sockaddr_ll *link;
+
+	if (entry->ifa_addr == NULL || entry->ifa_addr->sa_family != AF_PACKET)
+		return false;
+
+	if ((entry->ifa_flags & IFF_LOOPBACK) != 0)
+		return false;
+
+	link = (const struct sockaddr_ll *)entry->ifa_addr;
+
+	return link->sll_hatype == ARPHRD_ETHER && link->sll_halen == 6;
+}
+
+/** Collects the IPv4 and IPv6 addresses of an interface.
+  *  @param addresses The list returned by getifaddrs.
+  *  @param name The name of the interface.
+  *  @return The addresses, NULL if there are none or on error.
+  */
+static struct ip_address_array *get_interface_addresses(const struct ifaddrs *addresses, const char *name)
+{
+	const struct ifaddrs *entry;
+	struct ip_address_array *result;
+	size_t count = 0;
+	off_t index = 0;
+
+	for (entry = addresses; entry != NULL; entry = entry->ifa_next)
+	{
+		if (entry->ifa_addr == NULL || strcmp(entry->ifa_name, name) != 0)
+			continue;
+
+		if (entry->ifa_addr->sa_family == AF_INET || entry->ifa_addr->sa_family == AF_INET6)
+			count++;
+	}
+
+	if (count == 0)
+		return NULL;
+
+	result = ip_address_array_new(count);
+	if (result == NULL)
+	{
+		LOG_CRITICAL("get_interface_addresses: failed to allocate the address array\n");
+		return NULL;
+	}
+
+	for (entry = addresses; entry != NULL; entry = entry->ifa_next)
+	{
+		if (entry->ifa_addr == NULL || strcmp(entry->ifa_name, name) != 0)
+			continue;
+
+		if (entry->ifa_addr->sa_family != AF_INET && entry->ifa_addr->sa_family != AF_INET6)
+			continue;
+
+		if (ip_address_array_copy_into(result, index++, entry->ifa_addr) < 0)
+		{
+			LOG_CRITICAL("get_interface_addresses: failed to copy an address\n");
+			ip_address_array_clear_and_delete(result);
+			return NULL;
+		}
+	}
+
+	return result;
+}
+
+struct cdp_interface_list *cdp_interface_list_new(void)
+{
+	struct cdp_interface_list *result;
+	struct ifaddrs *addresses;
+	struct ifaddrs *entry;
+	size_t count = 0;
+
+	if (getifaddrs(&addresses) < 0)
+	{
+		LOG_ERROR("cdp_interface_list_new: failed to enumerate interfaces\n");
+		return NULL;
+	}
+
+	for (entry = addresses; entry != NULL; entry = entry->ifa_next)
+	{
+		if (is_ethernet_link(entry))
+			count++;
+	}
+
+	result = ALLOC_NEW(struct cdp_interface_list);
+	if (result == NULL)
+	{
+		LOG_CRITICAL("cdp_interface_list_new: failed to allocate memory for interface list\n");
+		freeifaddrs(addresses);
+		return NULL;
+	}
+
+	result->count = 0;
+	result->items = NULL;
+
+	if (count > 0)
+	{
+		result->items = ALLOC_NEW_ARRAY(struct cdp_interface, count);
+		if (result->items == NULL)
+		{
+			LOG_CRITICAL("cdp_interface_list_new: failed to allocate memory for interfaces\n");
+			FREE(result);
+			freeifaddrs(addresses);
+			return NULL;
+		}
+	}
+
+	for (entry = addresses; entry != NULL; entry = entry->ifa_next)
+	{
+		const struct sockaddr_ll *link;
+		struct cdp_interface *item;
+
+		if (!is_ethernet_link(entry))
+			continue;
+
+		link = (const struct sockaddr_ll *)entry->ifa_addr;
+		item = &result->items[result->count++];
+
+		memset(item, 0, sizeof(struct cdp_interface));
+		item->index = link->sll_ifindex;
+		strncpy(item->name, entry->ifa_name, IF_NAMESIZE - 1);
+		memcpy(item->mac, link->sll_addr, 6);
+		item->flags = entry->ifa_flags;
+		item->addresses = get_interface_addresses(addresses, entry->ifa_name);
+	}
+
+	freeifaddrs(addresses);
+
+	return result;
+}
+
+void cdp_interface_list_delete(struct cdp_interface_list *list)
+{
+	if (list == NULL)
+	{
+		LOG_CRITICAL("cdp_interface_list_delete: list is NULL\n");
+		return;
+	}
+
+	if (list->items != NULL)
+	{
+		size_t i;
+
+		for (i = 0; i < list->count; i++)
+		{
+			if (list->items[i].addresses != NULL)
+				ip_address_array_clear_and_delete(list->items[i].addresses);
+		}
+
+		FREE_ARRAY(list->items);
+	}
+
+	FREE(list);
+}
+
+const struct cdp_interface *cdp_interface_list_get_by_index(const struct cdp_interface_list *list, int index)
+{
+	size_t i;
+
+	if (list == NULL)
+	{
+		LOG_CRITICAL("cdp_interface_list_get_by_index: list is NULL\n");
+		return NULL;
+	}
+
+	for (i = 0; i < list->count; i++)
+	{
+		if (list->items[i].index == index)
+			return &list->items[i];
+	}
+
+	return NULL;
+}
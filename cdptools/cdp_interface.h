@@ -0,0 +1,56 @@
+#ifndef CDP_INTERFACE_H
+#define CDP_INTERFACE_H
+
+#include <net/if.h>
+
+#include "../libcdp/ip_address_array.h"
+#include "../libcdp/platform/types.h"
+
+/** An Ethernet interface on which CDP is sent and received */
+struct cdp_interface
+{
+	/** The interface index (ifindex) */
+	int index;
+
+	/** The name of the interface */
+	char name[IF_NAMESIZE];
+
+	/** The MAC address of the interface */
+	uint8_t mac[6];
+
+	/** The interface flags (IFF_UP, IFF_RUNNING, ...) */
+	unsigned int flags;
+
+	/** The IPv4 and IPv6 addresses of the interface or NULL if there are none */
+	struct ip_address_array *addresses;
+};
+
+/** The list of the Ethernet interfaces on the system */
+struct cdp_interface_list
+{
+	/** The interfaces */
+	struct cdp_interface *items;
+
+	/** The number of interfaces */
+	size_t count;
+};
+
+/** Constructor, enumerates the Ethernet interfaces of the system excluding loopback along with
+  *  their IP addresses.
+  *  @return Either the new list or NULL on error.
+  */
+struct cdp_interface_list *cdp_interface_list_new(void);
+
+/** Destructor
+  *  @param list The list to delete.
+  */
+void cdp_interface_list_delete(struct cdp_interface_list *list);
+
+/** Finds an interface by its interface index.
+  *  @param list The list to search.
+  *  @param index The interface index.
+  *  @return The interface or NULL if it's not in the list.
+  */
+const struct cdp_interface *cdp_interface_list_get_by_index(const struct cdp_interface_list *list, int index);
+
+#endif
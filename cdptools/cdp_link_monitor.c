@@ -0,0 +1,117 @@
+#include "cdp_link_monitor.h"
+#include "../libcdp/platform/platform.h"
+
+#include <errno.h>
+#include <linux/netlink.h>
+#include <linux/rtnetlink.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+/** The size of the buffer notifications are read into */
+#define CDP_LINK_MONITOR_BUFFER_SIZE 8192
+
+struct cdp_link_monitor *cdp_link_monitor_new(void)
+{
+	struct cdp_link_monitor *result;
+	struct sockaddr_nl address;
+
+	result = ALLOC_NEW(struct cdp_link_monitor);
+	if (result == NULL)
+	{
+		LOG_CRITICAL("cdp_link_monitor_new: failed to allocate memory for link monitor\n");
+		return NULL;
+	}
+
+	result->fd = socket(AF_NETLINK, SOCK_RAW | SOCK_CLOEXEC | SOCK_NONBLOCK, NETLINK_ROUTE);
+	if (result->fd < 0)
+	{
+		LOG_ERROR("cdp_link_monitor_new: failed to open netlink socket (%s)\n", strerror(errno));
+		FREE(result);
+		return NULL;
+	}
+
+	memset(&address, 0, sizeof(address));
+	address.nl_family = AF_NETLINK;
+	address.nl_groups = RTMGRP_LINK | RTMGRP_IPV4_IFADDR | RTMGRP_IPV6_IFADDR;
+
+	if (bind(result->fd, (struct sockaddr *)&address, sizeof(address)) < 0)
+	{
+		LOG_ERROR("cdp_link_monitor_new: failed to bind netlink socket (%s)\n", strerror(errno));
+		cdp_link_monitor_delete(result);
+		return NULL;
+	}
+
+	return result;
+}
+
+void cdp_link_monitor_delete(struct cdp_link_monitor *monitor)
+{
+	if (monitor == NULL)
+	{
+		LOG_CRITICAL("cdp_link_monitor_delete: monitor is NULL\n");
+		return;
+	}
+
+	close(monitor->fd);
+	FREE(monitor);
+}
+
+int cdp_link_monitor_drain(struct cdp_link_monitor *monitor)
+{
+	uint8_t buffer[CDP_LINK_MONITOR_BUFFER_SIZE];
+	const struct nlmsghdr *header;
+	ssize_t length;
+	int result = 0;
+
+	if (monitor == NULL)
+	{
+		LOG_CRITICAL("cdp_link_monitor_drain: monitor is NULL\n");
+		return -1;
+	}
+
+	for (;;)
+	{
+		length = recv(monitor->fd, buffer, sizeof(buffer), 0);
+		if (length < 0)
+		{
+			if (errno == EINTR)
+				continue;
+
+			if (errno == EAGAIN || errno == EWOULDBLOCK)
+				break;
+
+			/* Notifications were dropped, report a change so everything is enumerated again */
+			if (errno == ENOBUFS)
+			{
+				result++;
+				continue;
+			}
+
+			LOG_ERROR("cdp_link_monitor_drain: failed to read from netlink socket (%s)\n", strerror(errno));
+			return -1;
+		}
+
+		for (
+			header = (const struct nlmsghdr *)buffer;
+			NLMSG_OK(header, (size_t)length);
+			header = NLMSG_NEXT(header, length)
+		)
+		{
+			switch (header->nlmsg_type)
+			{
+				case RTM_NEWLINK:
+				case RTM_DELLINK:
+				case RTM_NEWADDR:
+				case RTM_DELADDR:
+					result++;
+					break;
+
+				default:
+					break;
+			}
+		}
+	}
+
+	return result;
+}
@@ -0,0 +1,30 @@
+#ifndef CDP_LINK_MONITOR_H
+#define CDP_LINK_MONITOR_H
+
+#include "../libcdp/platform/types.h"
+
+/** A netlink route socket subscribed to link and address changes */
+struct cdp_link_monitor
+{
+	/** The socket file descriptor, non-blocking */
+	int fd;
+};
+
+/** Constructor, opens the socket and joins the link, IPv4 and IPv6 address groups.
+  *  @return Either the new monitor or NULL on error.
+  */
+struct cdp_link_monitor *cdp_link_monitor_new(void);
+
+/** Destructor
+  *  @param monitor The monitor to close.
+  */
+void cdp_link_monitor_delete(struct cdp_link_monitor *monitor);
+
+/** Reads every pending notification. The notifications are only counted, the caller is expected
+  *  to enumerate the interfaces again when any arrived.
+  *  @param monitor The monitor object.
+  *  @return The number of link or address notifications read or a negative value on error.
+  */
+int cdp_link_monitor_drain(struct cdp_link_monitor *monitor);
+
+#endif
@@ -0,0 +1,79 @@
+#include "cdp_neighbors.h"
+#include "../libcdp/cdp_shm_table.h"
+#include "../libcdp/platform/platform.h"
+
+#include <arpa/inet.h>
+#include <time.h>
+
+/** Prints a single neighbor of the table.
+  *  @param reader The reader holding the copy of the table.
+  *  @param slot The neighbor.
+  *  @param now The current time.
+  */
+static void cdp_neighbors_print_slot(const struct cdp_shm_table_reader *reader, const struct cdp_shm_table_slot *slot, time_t now)
+{
+	char address[INET6_ADDRSTRLEN];
+	long remaining;
+	int i;
+
+	remaining = (long)(slot->received_at_seconds + slot->hold_time - now);
+	if (remaining < 0)
+		remaining = 0;
+
+	printf(
+		"%-12s %-32s %-24s %-20s %4ld",
+		cdp_shm_table_reader_get_string(reader, slot->interface_name),
+		cdp_shm_table_reader_get_string(reader, slot->device_id),
+		cdp_shm_table_reader_get_string(reader, slot->port_id),
+		cdp_shm_table_reader_get_string(reader, slot->platform),
+		remaining
+	);
+
+	for (i = 0; i < slot->address_count; i++)
+	{
+		if (inet_ntop(slot->address_versions[i] == 6 ? AF_INET6 : AF_INET, slot->addresses[i], address, sizeof(address)) != NULL)
+			printf(" %s", address);
+	}
+
+	printf("\n");
+}
+
+int cdp_neighbors_main(int argc, char **argv)
+{
+	struct cdp_shm_table_reader *reader;
+	const char *path = CDP_SHM_TABLE_DEFAULT_PATH;
+	int count;
+	int i;
+
+	if (argc > 2)
+	{
+		LOG_ERROR("usage: cdptools neighbors [path]\n");
+		return 1;
+	}
+
+	if (argc == 2)
+		path = argv[1];
+
+	reader = cdp_shm_table_reader_open(path);
+	if (reader == NULL)
+		return 1;
+
+	count = cdp_shm_table_reader_read(reader);
+	if (count < 0)
+	{
+		cdp_shm_table_reader_delete(reader);
+		return 1;
+	}
+
+	printf("%-12s %-32s %-24s %-20s %4s %s\n", "Interface", "Device ID", "Port ID", "Platform", "Hold", "Addresses");
+
+	for (i = 0; i < count; i++)
+		cdp_neighbors_print_slot(reader, cdp_shm_table_reader_get_slot(reader, (uint32_t)i), time(NULL));
+
+	if ((cdp_shm_table_reader_get_header(reader)->flags & CDP_SHM_TABLE_FLAG_TRUNCATED) != 0)
+		printf("The table is truncated, the daemon has more neighbors than it can publish\n");
+
+	cdp_shm_table_reader_delete(reader);
+
+	return 0;
+}
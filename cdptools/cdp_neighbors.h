@@ -0,0 +1,12 @@
+#ifndef CDP_NEIGHBORS_H
+#define CDP_NEIGHBORS_H
+
+/** Entry point of "cdptools neighbors", which lists the neighbor table published by the daemon in
+  *  shared memory. It maps the table and copies it without any system call per read.
+  *  @param argc The number of arguments following the command name.
+  *  @param argv The arguments, argv[0] is the command name.
+  *  @return The process exit code.
+  */
+int cdp_neighbors_main(int argc, char **argv);
+
+#endif
@@ -0,0 +1,403 @@
+#include "cdp_packet_socket.h"
+#include "../libcdp/platform/platform.h"
+
+#include <arpa/inet.h>
+#include <errno.h>
+#include <linux/filter.h>
+#include <linux/if_ether.h>
+#include <linux/if_packet.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+/** The size of each block in the receive ring */
+static const unsigned int cdp_ring_block_size = 1 << 16;
+
+/** The number of blocks in the receive ring */
+static const unsigned int cdp_ring_block_count = 8;
+
+/** The frame size hint for the receive ring, large enough for any CDP frame */
+static const unsigned int cdp_ring_frame_size = 2048;
+
+/** How long the kernel may hold a partially filled block before handing it over (ms) */
+static const unsigned int cdp_ring_block_timeout_ms = 10;
+
+const uint8_t cdp_multicast_address[6] = { 0x01, 0x00, 0x0C, 0xCC, 0xCC, 0xCC };
+
+const uint8_t cdp_snap_header[CDP_SNAP_HEADER_LENGTH] = { 0xAA, 0xAA, 0x03, 0x00, 0x00, 0x0C, 0x20, 0x00 };
+
+/** The multiplier of the hash which selects the fanout member of an interface */
+static const uint32_t cdp_fanout_multiplier = 0x9E3779B1;
+
+/** Classic BPF program accepting only 802.3 frames sent to 01:00:0C:CC:CC:CC which carry
+  *  802.2 LLC (AA AA 03) and SNAP with the Cisco OUI and the CDP protocol id (00 00 0C 20 00).
+  */
+static struct sock_filter cdp_filter_program[] = {
+	BPF_STMT(BPF_LD | BPF_W | BPF_ABS, 0),
+	BPF_JUMP(BPF_JMP | BPF_JEQ | BPF_K, 0x01000CCC, 0, 9),
+	BPF_STMT(BPF_LD | BPF_H | BPF_ABS, 4),
+	BPF_JUMP(BPF_JMP | BPF_JEQ | BPF_K, 0xCCCC, 0, 7),
+	BPF_STMT(BPF_LD | BPF_H | BPF_ABS, 12),
+	BPF_JUMP(BPF_JMP | BPF_JGT | BPF_K, 1500, 5, 0),
+	BPF_STMT(BPF_LD | BPF_W | BPF_ABS, 14),
+	BPF_JUMP(BPF_JMP | BPF_JEQ | BPF_K, 0xAAAA0300, 0, 3),
+	BPF_STMT(BPF_LD | BPF_W | BPF_ABS, 18),
+	BPF_JUMP(BPF_JMP | BPF_JEQ | BPF_K, 0x000C2000, 0, 1),
+	BPF_STMT(BPF_RET | BPF_K, 0xFFFF),
+	BPF_STMT(BPF_RET | BPF_K, 0),
+};
+
+/** Sets up the TPACKET_V3 receive ring of a socket and maps it.
+  *  @param socket The socket object, not yet bound.
+  *  @return 0 on success or a negative value on error.
+  */
+static int cdp_packet_socket_map_ring(struct cdp_packet_socket *socket)
+{
+	struct tpacket_req3 request;
+	int version = TPACKET_V3;
+
+	if (setsockopt(socket->fd, SOL_PACKET, PACKET_VERSION, &version, sizeof(version)) < 0)
+	{
+		LOG_ERROR("cdp_packet_socket_map_ring: failed to select TPACKET_V3 (%s)\n", strerror(errno));
+		return -1;
+	}
+
+	memset(&request, 0, sizeof(request));
+	request.tp_block_size = socket->block_size;
+	request.tp_block_nr = socket->block_count;
+	request.tp_frame_size = cdp_ring_frame_size;
+	request.tp_frame_nr = (socket->block_size * socket->block_count) / cdp_ring_frame_size;
+	request.tp_retire_blk_tov = cdp_ring_block_timeout_ms;
+
+	if (setsockopt(socket->fd, SOL_PACKET, PACKET_RX_RING, &request, sizeof(request)) < 0)
+	{
+		LOG_ERROR("cdp_packet_socket_map_ring: failed to set up the receive ring (%s)\n", strerror(errno));
+		return -1;
+	}
+
+	socket->ring_size = (size_t)socket->block_size * socket->block_count;
+	socket->ring = mmap(NULL, socket->ring_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_LOCKED, socket->fd, 0);
+	if (socket->ring == MAP_FAILED)
+	{
+		/* Locking may be refused by RLIMIT_MEMLOCK, the ring still works unlocked */
+		socket->ring = mmap(NULL, socket->ring_size, PROT_READ | PROT_WRITE, MAP_SHARED, socket->fd, 0);
+	}
+
+	if (socket->ring == MAP_FAILED)
+	{
+		LOG_ERROR("cdp_packet_socket_map_ring: failed to map the receive ring (%s)\n", strerror(errno));
+		socket->ring = NULL;
+		return -1;
+	}
+
+	return 0;
+}
+
+/** Lets the socket queue as much as the receive ring would hold, so that a socket without a ring
+  *  absorbs the same bursts. The default limit only holds about a hundred frames.
+  *  @param socket The socket object.
+  */
+static void cdp_packet_socket_grow_receive_buffer(struct cdp_packet_socket *socket)
+{
+	int size = (int)(socket->block_size * socket->block_count);
+
+	/* SO_RCVBUFFORCE ignores rmem_max but requires CAP_NET_ADMIN, SO_RCVBUF is capped by rmem_max */
+	if (setsockopt(socket->fd, SOL_SOCKET, SO_RCVBUFFORCE, &size, sizeof(size)) < 0)
+		setsockopt(socket->fd, SOL_SOCKET, SO_RCVBUF, &size, sizeof(size));
+}
+
+/** Opens a packet socket with the CDP filter attached and bound to every interface.
+  *  @param map_ring Whether to set up and map the TPACKET_V3 receive ring.
+  *  @return Either the new socket or NULL on error.
+  */
+static struct cdp_packet_socket *cdp_packet_socket_create(bool map_ring)
+{
+	struct cdp_packet_socket *result;
+	struct sock_fprog filter;
+	struct sockaddr_ll address;
+
+	result = ALLOC_NEW(struct cdp_packet_socket);
+	if (result == NULL)
+	{
+		LOG_CRITICAL("cdp_packet_socket_create: failed to allocate memory for packet socket\n");
+		return NULL;
+	}
+
+	result->ring = NULL;
+	result->ring_size = 0;
+	result->block_size = cdp_ring_block_size;
+	result->block_count = cdp_ring_block_count;
+	result->current_block = 0;
+
+	result->fd = socket(AF_PACKET, SOCK_RAW | SOCK_CLOEXEC, htons(ETH_P_802_2));
+	if (result->fd < 0)
+	{
+		LOG_ERROR("cdp_packet_socket_create: failed to open packet socket (%s)\n", strerror(errno));
+		FREE(result);
+		return NULL;
+	}
+
+	/* Attach the filter before binding so no unfiltered frames are queued */
+	filter.len = sizeof(cdp_filter_program) / sizeof(cdp_filter_program[0]);
+	filter.filter = cdp_filter_program;
+	if (setsockopt(result->fd, SOL_SOCKET, SO_ATTACH_FILTER, &filter, sizeof(filter)) < 0)
+	{
+		LOG_ERROR("cdp_packet_socket_create: failed to attach the CDP filter (%s)\n", strerror(errno));
+		cdp_packet_socket_delete(result);
+		return NULL;
+	}
+
+	if (map_ring && cdp_packet_socket_map_ring(result) < 0)
+	{
+		cdp_packet_socket_delete(result);
+		return NULL;
+	}
+
+	if (!map_ring)
+		cdp_packet_socket_grow_receive_buffer(result);
+
+	memset(&address, 0, sizeof(address));
+	address.sll_family = AF_PACKET;
+	address.sll_protocol = htons(ETH_P_802_2);
+	address.sll_ifindex = 0;
+
+	if (bind(result->fd, (struct sockaddr *)&address, sizeof(address)) < 0)
+	{
+		LOG_ERROR("cdp_packet_socket_create: failed to bind packet socket (%s)\n", strerror(errno));
+		cdp_packet_socket_delete(result);
+		return NULL;
+	}
+
+	return result;
+}
+
+struct cdp_packet_socket *cdp_packet_socket_new(void)
+{
+	return cdp_packet_socket_create(true);
+}
+
+struct cdp_packet_socket *cdp_packet_socket_new_unmapped(void)
+{
+	return cdp_packet_socket_create(false);
+}
+
+void cdp_packet_socket_delete(struct cdp_packet_socket *socket)
+{
+	if (socket == NULL)
+	{
+		LOG_CRITICAL("cdp_packet_socket_delete: socket is NULL\n");
+		return;
+	}
+
+	if (socket->ring != NULL)
+		munmap(socket->ring, socket->ring_size);
+
+	if (socket->fd >= 0)
+		close(socket->fd);
+
+	FREE(socket);
+}
+
+int cdp_packet_socket_join(struct cdp_packet_socket *socket, int ifindex)
+{
+	struct packet_mreq membership;
+
+	if (socket == NULL)
+	{
+		LOG_CRITICAL("cdp_packet_socket_join: socket is NULL\n");
+		return -1;
+	}
+
+	memset(&membership, 0, sizeof(membership));
+	membership.mr_ifindex = ifindex;
+	membership.mr_type = PACKET_MR_MULTICAST;
+	membership.mr_alen = sizeof(cdp_multicast_address);
+	memcpy(membership.mr_address, cdp_multicast_address, sizeof(cdp_multicast_address));
+
+	if (setsockopt(socket->fd, SOL_PACKET, PACKET_ADD_MEMBERSHIP, &membership, sizeof(membership)) < 0)
+	{
+		LOG_ERROR("cdp_packet_socket_join: failed to join the CDP multicast group on interface %d (%s)\n", ifindex, strerror(errno));
+		return -1;
+	}
+
+	return 0;
+}
+
+int cdp_packet_socket_join_fanout(struct cdp_packet_socket *socket, uint16_t group_id, unsigned int member_count)
+{
+	/* Selects the member from a multiplicative hash of the ifindex. A plain ifindex % member_count
+	 * would leave members idle when the indexes share a stride, as the two ends of veth pairs do.
+	 * This must match cdp_packet_socket_fanout_member.
+	 */
+	struct sock_filter program[] = {
+		BPF_STMT(BPF_LD | BPF_W | BPF_ABS, (uint32_t)(SKF_AD_OFF + SKF_AD_IFINDEX)),
+		BPF_STMT(BPF_ALU | BPF_MUL | BPF_K, cdp_fanout_multiplier),
+		BPF_STMT(BPF_ALU | BPF_RSH | BPF_K, 16),
+		BPF_STMT(BPF_ALU | BPF_MOD | BPF_K, member_count),
+		BPF_STMT(BPF_RET | BPF_A, 0),
+	};
+	struct sock_fprog selector;
+	int fanout;
+
+	if (socket == NULL)
+	{
+		LOG_CRITICAL("cdp_packet_socket_join_fanout: socket is NULL\n");
+		return -1;
+	}
+
+	if (member_count == 0)
+	{
+		LOG_CRITICAL("cdp_packet_socket_join_fanout: member_count must be at least 1\n");
+		return -1;
+	}
+
+	fanout = group_id | (PACKET_FANOUT_CBPF << 16);
+	if (setsockopt(socket->fd, SOL_PACKET, PACKET_FANOUT, &fanout, sizeof(fanout)) < 0)
+	{
+		LOG_ERROR("cdp_packet_socket_join_fanout: failed to join fanout group %d (%s)\n", (int)group_id, strerror(errno));
+		return -1;
+	}
+
+	selector.len = sizeof(program) / sizeof(program[0]);
+	selector.filter = program;
+
+	if (setsockopt(socket->fd, SOL_PACKET, PACKET_FANOUT_DATA, &selector, sizeof(selector)) < 0)
+	{
+		LOG_ERROR("cdp_packet_socket_join_fanout: failed to attach the fanout selector (%s)\n", strerror(errno));
+		return -1;
+	}
+
+	return 0;
+}
+
+unsigned int cdp_packet_socket_fanout_member(int ifindex, unsigned int member_count)
+{
+	if (member_count == 0)
+		return 0;
+
+	/* Classic BPF arithmetic is 32 bit */
+	return (((uint32_t)ifindex * cdp_fanout_multiplier) >> 16) % member_count;
+}
+
+int cdp_packet_socket_get_statistics(struct cdp_packet_socket *socket, unsigned int *received, unsigned int *dropped)
+{
+	struct tpacket_stats_v3 statistics;
+	socklen_t length = sizeof(statistics);
+
+	if (socket == NULL)
+	{
+		LOG_CRITICAL("cdp_packet_socket_get_statistics: socket is NULL\n");
+		return -1;
+	}
+
+	if (getsockopt(socket->fd, SOL_PACKET, PACKET_STATISTICS, &statistics, &length) < 0)
+	{
+		LOG_ERROR("cdp_packet_socket_get_statistics: failed to read the statistics (%s)\n", strerror(errno));
+		return -1;
+	}
+
+	*received = statistics.tp_packets;
+	*dropped = statistics.tp_drops;
+
+	return 0;
+}
+
+bool cdp_packet_socket_decode(const uint8_t *ethernet, size_t captured, const struct sockaddr_ll *link, struct cdp_received_frame *frame)
+{
+	size_t llc_length;
+
+	if (captured < CDP_ETHERNET_HEADER_LENGTH)
+		return false;
+
+	/* Short frames are padded, the 802.3 length field gives the real length of the LLC payload */
+	llc_length = ((size_t)ethernet[12] << 8) | ethernet[13];
+	if (captured > CDP_ETHERNET_HEADER_LENGTH + llc_length)
+		captured = CDP_ETHERNET_HEADER_LENGTH + llc_length;
+
+	/* Frames sent from this host are not neighbors */
+	if (captured <= CDP_ETHERNET_HEADER_LENGTH + CDP_SNAP_HEADER_LENGTH || link->sll_pkttype == PACKET_OUTGOING)
+		return false;
+
+	frame->ifindex = link->sll_ifindex;
+	frame->source_mac = ethernet + 6;
+	frame->payload = ethernet + CDP_ETHERNET_HEADER_LENGTH + CDP_SNAP_HEADER_LENGTH;
+	frame->payload_length = captured - (CDP_ETHERNET_HEADER_LENGTH + CDP_SNAP_HEADER_LENGTH);
+
+	return true;
+}
+
+/** Processes the frames of a single block handed over by the kernel.
+  *  @param block The block descriptor.
+  *  @param handler The function to call for each frame.
+  *  @param context The context to pass to the handler.
+  *  @return The number of CDP frames processed.
+  */
+static int cdp_packet_socket_process_block(struct tpacket_block_desc *block, cdp_frame_handler handler, void *context)
+{
+	struct tpacket3_hdr *header;
+	uint32_t packet_count = block->hdr.bh1.num_pkts;
+	uint32_t i;
+	int result = 0;
+
+	header = (struct tpacket3_hdr *)((uint8_t *)block + block->hdr.bh1.offset_to_first_pkt);
+
+	for (i = 0; i < packet_count; i++)
+	{
+		const uint8_t *ethernet = (const uint8_t *)header + header->tp_mac;
+		const struct sockaddr_ll *link;
+		struct cdp_received_frame frame;
+
+		/* The link layer address of the frame follows the frame header */
+		link = (const struct sockaddr_ll *)((const uint8_t *)header + TPACKET_ALIGN(sizeof(struct tpacket3_hdr)));
+
+		if (cdp_packet_socket_decode(ethernet, header->tp_snaplen, link, &frame))
+		{
+			frame.received_at.tv_sec = header->tp_sec;
+			frame.received_at.tv_nsec = header->tp_nsec;
+
+			handler(context, &frame);
+			result++;
+		}
+
+		header = (struct tpacket3_hdr *)((uint8_t *)header + header->tp_next_offset);
+	}
+
+	return result;
+}
+
+int cdp_packet_socket_receive(struct cdp_packet_socket *socket, cdp_frame_handler handler, void *context)
+{
+	int result = 0;
+
+	if (socket == NULL)
+	{
+		LOG_CRITICAL("cdp_packet_socket_receive: socket is NULL\n");
+		return -1;
+	}
+
+	if (handler == NULL)
+	{
+		LOG_CRITICAL("cdp_packet_socket_receive: handler is NULL\n");
+		return -1;
+	}
+
+	for (;;)
+	{
+		struct tpacket_block_desc *block;
+
+		block = (struct tpacket_block_desc *)(socket->ring + (size_t)socket->current_block * socket->block_size);
+
+		if ((__atomic_load_n(&block->hdr.bh1.block_status, __ATOMIC_ACQUIRE) & TP_STATUS_USER) == 0)
+			break;
+
+		result += cdp_packet_socket_process_block(block, handler, context);
+
+		/* Hand the block back to the kernel */
+		__atomic_store_n(&block->hdr.bh1.block_status, TP_STATUS_KERNEL, __ATOMIC_RELEASE);
+
+		socket->current_block = (socket->current_block + 1) % socket->block_count;
+	}
+
+	return result;
+}
@@ -0,0 +1,138 @@
+#ifndef CDP_PACKET_SOCKET_H
+#define CDP_PACKET_SOCKET_H
+
+#include <time.h>
+#include <linux/if_packet.h>
+
+#include "../libcdp/platform/types.h"
+
+/** The length of the Ethernet (802.3) header preceding the 802.2 LLC header */
+#define CDP_ETHERNET_HEADER_LENGTH 14
+
+/** The length of the 802.2 LLC and SNAP headers preceding the CDP frame */
+#define CDP_SNAP_HEADER_LENGTH 8
+
+/** The multicast MAC address to which CDP frames are sent */
+extern const uint8_t cdp_multicast_address[6];
+
+/** The 802.2 LLC header (DSAP, SSAP, control) followed by the SNAP OUI and protocol id of CDP */
+extern const uint8_t cdp_snap_header[CDP_SNAP_HEADER_LENGTH];
+
+/** A CDP frame received on a packet socket. The pointers reference the receive ring and are
+  *  only valid for the duration of the frame handler.
+  */
+struct cdp_received_frame
+{
+	/** The index of the interface the frame was received on */
+	int ifindex;
+
+	/** The MAC address of the sender (6 bytes) */
+	const uint8_t *source_mac;
+
+	/** The CDP frame starting at the CDP version, with the link layer headers removed */
+	const uint8_t *payload;
+
+	/** The length of the CDP frame in bytes */
+	size_t payload_length;
+
+	/** The time the frame was received */
+	struct timespec received_at;
+};
+
+/** Function called for each CDP frame received.
+  *  @param context The context passed to cdp_packet_socket_receive.
+  *  @param frame The received frame.
+  */
+typedef void (*cdp_frame_handler)(void *context, const struct cdp_received_frame *frame);
+
+/** An AF_PACKET socket filtered to CDP frames and receiving through a TPACKET_V3 mmap ring */
+struct cdp_packet_socket
+{
+	/** The socket file descriptor */
+	int fd;
+
+	/** The memory mapped receive ring */
+	uint8_t *ring;
+
+	/** The size of the receive ring in bytes */
+	size_t ring_size;
+
+	/** The size of each block in the ring in bytes */
+	unsigned int block_size;
+
+	/** The number of blocks in the ring */
+	unsigned int block_count;
+
+	/** The index of the next block to be returned by the kernel */
+	unsigned int current_block;
+};
+
+/** Constructor, opens the socket, attaches the CDP filter and maps the receive ring.
+  *  @return Either the new socket or NULL on error.
+  */
+struct cdp_packet_socket *cdp_packet_socket_new(void);
+
+/** Constructor for a socket without a receive ring, for callers which read the frames themselves,
+  *  for example through io_uring. cdp_packet_socket_receive must not be used with such a socket.
+  *  @return Either the new socket or NULL on error.
+  */
+struct cdp_packet_socket *cdp_packet_socket_new_unmapped(void);
+
+/** Destructor
+  *  @param socket The socket to close.
+  */
+void cdp_packet_socket_delete(struct cdp_packet_socket *socket);
+
+/** Subscribes an interface to the CDP multicast MAC address so the NIC will pass the frames up.
+  *  @param socket The socket object.
+  *  @param ifindex The interface index to subscribe.
+  *  @return 0 on success or a negative value on error.
+  */
+int cdp_packet_socket_join(struct cdp_packet_socket *socket, int ifindex);
+
+/** Adds the socket to a fanout group which distributes frames between its member sockets by the
+  *  index of the interface they were received on. Every frame of an interface therefore reaches the
+  *  same socket, which allows each member to own the neighbors of its interfaces exclusively.
+  *  @param socket The socket object.
+  *  @param group_id The fanout group identifier, shared by all members.
+  *  @param member_count The number of sockets in the group.
+  *  @return 0 on success or a negative value on error.
+  */
+int cdp_packet_socket_join_fanout(struct cdp_packet_socket *socket, uint16_t group_id, unsigned int member_count);
+
+/** Calculates which member of a fanout group receives the frames of an interface, the same way as
+  *  the selector attached by cdp_packet_socket_join_fanout.
+  *  @param ifindex The index of the interface.
+  *  @param member_count The number of sockets in the group.
+  *  @return The index of the member.
+  */
+unsigned int cdp_packet_socket_fanout_member(int ifindex, unsigned int member_count);
+
+/** Reads and resets the kernel's receive counters for the socket.
+  *  @param socket The socket object.
+  *  @param received The location to store the number of frames which passed the filter.
+  *  @param dropped The location to store the number of frames dropped because the ring was full.
+  *  @return 0 on success or a negative value on error.
+  */
+int cdp_packet_socket_get_statistics(struct cdp_packet_socket *socket, unsigned int *received, unsigned int *dropped);
+
+/** Decodes a frame received on a CDP packet socket, removing the link layer headers and padding.
+  *  The received_at time of the result is not set.
+  *  @param ethernet The frame starting with the Ethernet header.
+  *  @param captured The number of bytes captured.
+  *  @param link The link layer address the frame was received with.
+  *  @param frame The frame to populate.
+  *  @return true if the frame is a CDP frame from a neighbor, false if it should be ignored.
+  */
+bool cdp_packet_socket_decode(const uint8_t *ethernet, size_t captured, const struct sockaddr_ll *link, struct cdp_received_frame *frame);
+
+/** Processes every frame in the blocks which the kernel has handed over and returns the blocks
+  *  to the kernel. This does not block, poll the socket's file descriptor for POLLIN to wait.
+  *  @param socket The socket object.
+  *  @param handler The function to call for each frame.
+  *  @param context The context to pass to the handler.
+  *  @return The number of frames processed or a negative value on error.
+  */
+int cdp_packet_socket_receive(struct cdp_packet_socket *socket, cdp_frame_handler handler, void *context);
+
+#endif
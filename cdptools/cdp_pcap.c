@@ -0,0 +1,989 @@
+#include "cdp_pcap.h"
+#include "cdp_capture.h"
+#include "../libcdp/cdp_neighbor.h"
+#include "../libcdp/cdp_packet.h"
+#include "../libcdp/cdp_packet_parser.h"
+#include "../libcdp/cdp_string_pool.h"
+#include "../libcdp/platform/platform.h"
+
+#include <arpa/inet.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+/** The number of frames handed to a worker at a time */
+#define CDP_PCAP_BATCH_SIZE 1024
+
+/** The number of batches queued on a worker before the reader waits for it */
+static const unsigned int cdp_pcap_queue_depth = 16;
+
+/** The initial number of buckets of a worker's frame table, a power of 2 */
+static const size_t cdp_pcap_initial_buckets = 1024;
+
+/** The initial number of buckets of a worker's string pool */
+static const size_t cdp_pcap_initial_string_buckets = 256;
+
+/** The output formats */
+enum cdp_pcap_format
+{
+	CDP_PCAP_FORMAT_JSON,
+	CDP_PCAP_FORMAT_CSV
+};
+
+/** A CDP frame found in a capture, pointing into the mapped file */
+struct cdp_pcap_frame
+{
+	/** The MAC address of the sender (6 bytes) */
+	const uint8_t *source_mac;
+
+	/** The CDP frame starting at the CDP version */
+	const uint8_t *payload;
+
+	/** The length of the CDP frame */
+	size_t payload_length;
+
+	/** The capture timestamp */
+	struct timespec captured_at;
+};
+
+/** A set of frames handed from the reader to a worker */
+struct cdp_pcap_batch
+{
+	/** The next batch in the worker's queue */
+	struct cdp_pcap_batch *next;
+
+	/** The number of frames */
+	size_t count;
+
+	/** The frames */
+	struct cdp_pcap_frame frames[CDP_PCAP_BATCH_SIZE];
+};
+
+/** A distinct frame from a sender. Neighbors repeat the same frame every minute, so only the first
+  *  copy is parsed and the rest are counted.
+  */
+struct cdp_pcap_entry
+{
+	/** The next entry in the same bucket */
+	struct cdp_pcap_entry *next;
+
+	/** The hash of the sender and the frame */
+	uint32_t hash;
+
+	/** The first copy of the frame */
+	struct cdp_pcap_frame frame;
+
+	/** The parsed frame or NULL if the frame is malformed */
+	struct cdp_packet *packet;
+
+	/** The earliest capture time of the frame */
+	struct timespec first_seen;
+
+	/** The latest capture time of the frame */
+	struct timespec last_seen;
+
+	/** The number of copies of the frame */
+	unsigned long frames;
+};
+
+/** A neighbor, summarizing every distinct frame with the same sender, device ID and port ID */
+struct cdp_pcap_neighbor
+{
+	/** The most recently captured distinct frame of the neighbor */
+	const struct cdp_pcap_entry *latest;
+
+	/** The earliest capture time of any frame of the neighbor */
+	struct timespec first_seen;
+
+	/** The latest capture time of any frame of the neighbor */
+	struct timespec last_seen;
+
+	/** The number of frames of the neighbor */
+	unsigned long frames;
+};
+
+/** A worker thread. Frames are routed to workers by the sender's MAC address, so every frame of a
+  *  neighbor is handled by the same worker and the workers share nothing but their queues.
+  */
+struct cdp_pcap_worker
+{
+	/** The thread running the worker */
+	pthread_t thread;
+
+	/** Whether the thread was started */
+	bool started;
+
+	/** Protects the queue */
+	pthread_mutex_t lock;
+
+	/** Signalled when a batch is queued or the reader is done */
+	pthread_cond_t queued;
+
+	/** Signalled when a batch is taken from the queue */
+	pthread_cond_t taken;
+
+	/** The queued batches */
+	struct cdp_pcap_batch *head;
+	struct cdp_pcap_batch *tail;
+
+	/** The number of queued batches */
+	unsigned int queue_length;
+
+	/** Set when the reader has no more batches */
+	bool done;
+
+	/** The batch the reader is filling, only accessed by the reader */
+	struct cdp_pcap_batch *filling;
+
+	/** The hash table of distinct frames */
+	struct cdp_pcap_entry **buckets;
+
+	/** The number of buckets, a power of 2 */
+	size_t bucket_count;
+
+	/** The number of distinct frames */
+	size_t entry_count;
+
+	/** The strings of the parsed frames, one copy of each distinct platform, software version and so on */
+	struct cdp_string_pool *strings;
+
+	/** The neighbors found by the worker once it has finished */
+	struct cdp_pcap_neighbor *neighbors;
+
+	/** The number of neighbors */
+	size_t neighbor_count;
+
+	/** The number of distinct frames which failed to parse */
+	unsigned long malformed;
+};
+
+/** Compares two capture times.
+  *  @param a The first time.
+  *  @param b The second time.
+  *  @return A negative value, 0 or a positive value as a is before, equal to or after b.
+  */
+static int cdp_pcap_compare_times(const struct timespec *a, const struct timespec *b)
+{
+	if (a->tv_sec != b->tv_sec)
+		return a->tv_sec < b->tv_sec ? -1 : 1;
+
+	if (a->tv_nsec != b->tv_nsec)
+		return a->tv_nsec < b->tv_nsec ? -1 : 1;
+
+	return 0;
+}
+
+/** Compares two optional strings, NULL sorts first. Strings interned in the same pool are the same
+  *  string exactly when they are the same pointer.
+  *  @param a The first string.
+  *  @param b The second string.
+  *  @return A negative value, 0 or a positive value as a sorts before, equal to or after b.
+  */
+static int cdp_pcap_compare_strings(const char *a, const char *b)
+{
+	if (a == b)
+		return 0;
+
+	if (a == NULL || b == NULL)
+		return (a != NULL) - (b != NULL);
+
+	return strcmp(a, b);
+}
+
+/** qsort comparison of distinct frames by neighbor (device ID, port ID and sender) then capture time.
+  *  @param a The first entry pointer.
+  *  @param b The second entry pointer.
+  *  @return The order of the entries.
+  */
+static int cdp_pcap_compare_entries(const void *a, const void *b)
+{
+	const struct cdp_pcap_entry *first = *(const struct cdp_pcap_entry * const *)a;
+	const struct cdp_pcap_entry *second = *(const struct cdp_pcap_entry * const *)b;
+	int rc;
+
+	rc = cdp_pcap_compare_strings(first->packet->device_id, second->packet->device_id);
+	if (rc == 0)
+		rc = cdp_pcap_compare_strings(first->packet->port_id, second->packet->port_id);
+	if (rc == 0)
+		rc = memcmp(first->frame.source_mac, second->frame.source_mac, 6);
+	if (rc == 0)
+		rc = cdp_pcap_compare_times(&first->last_seen, &second->last_seen);
+
+	return rc;
+}
+
+/** qsort comparison of neighbors by device ID, port ID and sender.
+  *  @param a The first neighbor.
+  *  @param b The second neighbor.
+  *  @return The order of the neighbors.
+  */
+static int cdp_pcap_compare_neighbors(const void *a, const void *b)
+{
+	const struct cdp_pcap_entry *first = ((const struct cdp_pcap_neighbor *)a)->latest;
+	const struct cdp_pcap_entry *second = ((const struct cdp_pcap_neighbor *)b)->latest;
+
+	return cdp_pcap_compare_entries(&first, &second);
+}
+
+/** Checks whether two distinct frame entries describe the same neighbor.
+  *  @param a The first entry.
+  *  @param b The second entry.
+  *  @return true if the sender, device ID and port ID are the same.
+  */
+static bool cdp_pcap_same_neighbor(const struct cdp_pcap_entry *a, const struct cdp_pcap_entry *b)
+{
+	return
+		memcmp(a->frame.source_mac, b->frame.source_mac, 6) == 0 &&
+		cdp_pcap_compare_strings(a->packet->device_id, b->packet->device_id) == 0 &&
+		cdp_pcap_compare_strings(a->packet->port_id, b->packet->port_id) == 0;
+}
+
+/** Doubles the number of buckets of a worker's frame table.
+  *  @param worker The worker object.
+  *  @return 0 on success or a negative value on error.
+  */
+static int cdp_pcap_worker_grow(struct cdp_pcap_worker *worker)
+{
+	struct cdp_pcap_entry **buckets;
+	struct cdp_pcap_entry *entry;
+	struct cdp_pcap_entry *next;
+	size_t bucket_count = worker->bucket_count * 2;
+	size_t i;
+
+	buckets = ALLOC_NEW_ARRAY(struct cdp_pcap_entry *, bucket_count);
+	if (buckets == NULL)
+		return -1;
+
+	memset(buckets, 0, bucket_count * sizeof(struct cdp_pcap_entry *));
+
+	for (i = 0; i < worker->bucket_count; i++)
+	{
+		for (entry = worker->buckets[i]; entry != NULL; entry = next)
+		{
+			next = entry->next;
+			entry->next = buckets[entry->hash & (bucket_count - 1)];
+			buckets[entry->hash & (bucket_count - 1)] = entry;
+		}
+	}
+
+	FREE_ARRAY(worker->buckets);
+	worker->buckets = buckets;
+	worker->bucket_count = bucket_count;
+
+	return 0;
+}
+
+/** Counts a frame against its distinct copy, parsing it if it's the first copy.
+  *  @param worker The worker object.
+  *  @param frame The frame.
+  */
+static void cdp_pcap_worker_store(struct cdp_pcap_worker *worker, const struct cdp_pcap_frame *frame)
+{
+	struct cdp_pcap_entry *entry;
+	struct stream_reader *reader;
+	uint32_t hash;
+
+	hash = cdp_neighbor_hash_frame(frame->payload, frame->payload_length) ^ (cdp_neighbor_hash_frame(frame->source_mac, 6) * 16777619U);
+
+	for (entry = worker->buckets[hash & (worker->bucket_count - 1)]; entry != NULL; entry = entry->next)
+	{
+		if (
+			entry->hash == hash &&
+			entry->frame.payload_length == frame->payload_length &&
+			memcmp(entry->frame.source_mac, frame->source_mac, 6) == 0 &&
+			memcmp(entry->frame.payload, frame->payload, frame->payload_length) == 0
+		)
+		{
+			if (cdp_pcap_compare_times(&frame->captured_at, &entry->first_seen) < 0)
+				entry->first_seen = frame->captured_at;
+
+			if (cdp_pcap_compare_times(&frame->captured_at, &entry->last_seen) > 0)
+				entry->last_seen = frame->captured_at;
+
+			entry->frames++;
+			return;
+		}
+	}
+
+	if (worker->entry_count >= worker->bucket_count && cdp_pcap_worker_grow(worker) < 0)
+		LOG_ERROR("cdp_pcap_worker_store: failed to grow the frame table\n");
+
+	entry = ALLOC_NEW(struct cdp_pcap_entry);
+	if (entry == NULL)
+	{
+		LOG_CRITICAL("cdp_pcap_worker_store: failed to allocate memory for a frame\n");
+		return;
+	}
+
+	entry->hash = hash;
+	entry->frame = *frame;
+	entry->packet = NULL;
+	entry->first_seen = frame->captured_at;
+	entry->last_seen = frame->captured_at;
+	entry->frames = 1;
+
+	reader = stream_reader_new(frame->payload, frame->payload_length);
+	if (reader != NULL)
+	{
+		if (cdp_parse_packet_with_pool(reader, worker->strings, &entry->packet) < 0)
+			entry->packet = NULL;
+
+		stream_reader_delete(reader);
+	}
+
+	if (entry->packet == NULL)
+		worker->malformed++;
+
+	entry->next = worker->buckets[hash & (worker->bucket_count - 1)];
+	worker->buckets[hash & (worker->bucket_count - 1)] = entry;
+	worker->entry_count++;
+}
+
+/** Groups the worker's distinct frames into neighbors.
+  *  @param worker The worker object.
+  */
+static void cdp_pcap_worker_summarize(struct cdp_pcap_worker *worker)
+{
+	struct cdp_pcap_entry **entries;
+	struct cdp_pcap_entry *entry;
+	struct cdp_pcap_neighbor *neighbor = NULL;
+	size_t count = 0;
+	size_t i;
+
+	if (worker->entry_count == 0)
+		return;
+
+	entries = ALLOC_NEW_ARRAY(struct cdp_pcap_entry *, worker->entry_count);
+	worker->neighbors = ALLOC_NEW_ARRAY(struct cdp_pcap_neighbor, worker->entry_count);
+	if (entries == NULL || worker->neighbors == NULL)
+	{
+		LOG_CRITICAL("cdp_pcap_worker_summarize: failed to allocate memory for the neighbors\n");
+		if (entries != NULL)
+			FREE_ARRAY(entries);
+		return;
+	}
+
+	for (i = 0; i < worker->bucket_count; i++)
+	{
+		for (entry = worker->buckets[i]; entry != NULL; entry = entry->next)
+		{
+			if (entry->packet != NULL)
+				entries[count++] = entry;
+		}
+	}
+
+	/* Sorted by neighbor then time, the last entry of each run is the neighbor's latest frame */
+	qsort(entries, count, sizeof(struct cdp_pcap_entry *), cdp_pcap_compare_entries);
+
+	for (i = 0; i < count; i++)
+	{
+		if (neighbor == NULL || !cdp_pcap_same_neighbor(neighbor->latest, entries[i]))
+		{
+			neighbor = &worker->neighbors[worker->neighbor_count++];
+			neighbor->first_seen = entries[i]->first_seen;
+			neighbor->last_seen = entries[i]->last_seen;
+			neighbor->frames = 0;
+		}
+
+		neighbor->latest = entries[i];
+		neighbor->frames += entries[i]->frames;
+
+		if (cdp_pcap_compare_times(&entries[i]->first_seen, &neighbor->first_seen) < 0)
+			neighbor->first_seen = entries[i]->first_seen;
+
+		if (cdp_pcap_compare_times(&entries[i]->last_seen, &neighbor->last_seen) > 0)
+			neighbor->last_seen = entries[i]->last_seen;
+	}
+
+	FREE_ARRAY(entries);
+}
+
+/** The thread function of a worker, it processes batches until the reader is done.
+  *  @param argument The worker object.
+  *  @return NULL.
+  */
+static void *cdp_pcap_worker_run(void *argument)
+{
+	struct cdp_pcap_worker *worker = (struct cdp_pcap_worker *)argument;
+	struct cdp_pcap_batch *batch;
+	size_t i;
+
+	for (;;)
+	{
+		pthread_mutex_lock(&worker->lock);
+
+		while (worker->head == NULL && !worker->done)
+			pthread_cond_wait(&worker->queued, &worker->lock);
+
+		batch = worker->head;
+		if (batch != NULL)
+		{
+			worker->head = batch->next;
+			if (worker->head == NULL)
+				worker->tail = NULL;
+
+			worker->queue_length--;
+			pthread_cond_signal(&worker->taken);
+		}
+
+		pthread_mutex_unlock(&worker->lock);
+
+		if (batch == NULL)
+			break;
+
+		for (i = 0; i < batch->count; i++)
+			cdp_pcap_worker_store(worker, &batch->frames[i]);
+
+		FREE(batch);
+	}
+
+	cdp_pcap_worker_summarize(worker);
+
+	return NULL;
+}
+
+/** Queues the batch the reader filled for a worker, waiting while the worker is behind.
+  *  @param worker The worker object.
+  */
+static void cdp_pcap_worker_push(struct cdp_pcap_worker *worker)
+{
+	struct cdp_pcap_batch *batch = worker->filling;
+
+	if (batch == NULL || batch->count == 0)
+		return;
+
+	worker->filling = NULL;
+	batch->next = NULL;
+
+	pthread_mutex_lock(&worker->lock);
+
+	while (worker->queue_length >= cdp_pcap_queue_depth)
+		pthread_cond_wait(&worker->taken, &worker->lock);
+
+	if (worker->tail == NULL)
+		worker->head = batch;
+	else
+		worker->tail->next = batch;
+
+	worker->tail = batch;
+	worker->queue_length++;
+
+	pthread_cond_signal(&worker->queued);
+	pthread_mutex_unlock(&worker->lock);
+}
+
+/** Frees a worker's frames and neighbors.
+  *  @param worker The worker object.
+  */
+static void cdp_pcap_worker_clean(struct cdp_pcap_worker *worker)
+{
+	struct cdp_pcap_entry *entry;
+	struct cdp_pcap_entry *next;
+	size_t i;
+
+	if (worker->filling != NULL)
+		FREE(worker->filling);
+
+	for (i = 0; worker->buckets != NULL && i < worker->bucket_count; i++)
+	{
+		for (entry = worker->buckets[i]; entry != NULL; entry = next)
+		{
+			next = entry->next;
+			if (entry->packet != NULL)
+				cdp_packet_delete(entry->packet);
+			FREE(entry);
+		}
+	}
+
+	if (worker->buckets != NULL)
+		FREE_ARRAY(worker->buckets);
+
+	cdp_string_pool_delete(worker->strings);
+
+	if (worker->neighbors != NULL)
+		FREE_ARRAY(worker->neighbors);
+
+	pthread_cond_destroy(&worker->taken);
+	pthread_cond_destroy(&worker->queued);
+	pthread_mutex_destroy(&worker->lock);
+}
+
+/** Writes a string as a JSON string literal.
+  *  @param output The stream to write to.
+  *  @param value The string, NULL is written as null.
+  */
+static void cdp_pcap_print_json_string(FILE *output, const char *value)
+{
+	const unsigned char *c;
+
+	if (value == NULL)
+	{
+		fputs("null", output);
+		return;
+	}
+
+	fputc('"', output);
+
+	for (c = (const unsigned char *)value; *c != '\0'; c++)
+	{
+		if (*c == '"' || *c == '\\')
+			fprintf(output, "\\%c", *c);
+		else if (*c == '\n')
+			fputs("\\n", output);
+		else if (*c < 0x20)
+			fprintf(output, "\\u%04x", *c);
+		else
+			fputc(*c, output);
+	}
+
+	fputc('"', output);
+}
+
+/** Writes a string as a CSV field, quoted if it contains a separator, a quote or a line break.
+  *  @param output The stream to write to.
+  *  @param value The string, NULL is written as an empty field.
+  */
+static void cdp_pcap_print_csv_string(FILE *output, const char *value)
+{
+	const char *c;
+
+	if (value == NULL)
+		return;
+
+	if (strpbrk(value, ",\"\r\n") == NULL)
+	{
+		fputs(value, output);
+		return;
+	}
+
+	fputc('"', output);
+
+	for (c = value; *c != '\0'; c++)
+	{
+		if (*c == '"')
+			fputc('"', output);
+		fputc(*c, output);
+	}
+
+	fputc('"', output);
+}
+
+/** Formats the addresses of an address array separated by spaces.
+  *  @param array The addresses, may be NULL.
+  *  @param buffer The buffer to format into.
+  *  @param size The size of the buffer.
+  *  @param separator The string between two addresses.
+  *  @param quote The string around each address.
+  */
+static void cdp_pcap_format_addresses(const struct ip_address_array *array, char *buffer, size_t size, const char *separator, const char *quote)
+{
+	char address[INET6_ADDRSTRLEN];
+	const struct ip_address *item;
+	size_t length = 0;
+	size_t i;
+
+	buffer[0] = '\0';
+
+	for (i = 0; array != NULL && i < array->count && length < size; i++)
+	{
+		item = &array->addresses[i];
+		if (item->family != AF_INET && item->family != AF_INET6)
+			continue;
+
+		inet_ntop(item->family, item->octets, address, sizeof(address));
+
+		length += (size_t)snprintf(buffer + length, size - length, "%s%s%s%s", length > 0 ? separator : "", quote, address, quote);
+	}
+}
+
+/** Formats the capabilities bitmap as names.
+  *  @param capabilities The bitmap, may be NULL.
+  *  @param buffer The buffer to format into.
+  *  @param size The size of the buffer.
+  *  @param separator The string between two names.
+  *  @param quote The string around each name.
+  */
+static void cdp_pcap_format_capabilities(const uint32_t *capabilities, char *buffer, size_t size, const char *separator, const char *quote)
+{
+	static const struct { uint32_t mask; const char *name; } names[] = {
+		{ 0x01, "routing" },
+		{ 0x02, "transparentBridging" },
+		{ 0x04, "sourceRouteBridging" },
+		{ 0x08, "switching" },
+		{ 0x10, "host" },
+		{ 0x20, "igmp" },
+		{ 0x40, "repeater" },
+	};
+	size_t length = 0;
+	size_t i;
+
+	buffer[0] = '\0';
+
+	for (i = 0; capabilities != NULL && i < sizeof(names) / sizeof(names[0]) && length < size; i++)
+	{
+		if ((*capabilities & names[i].mask) != 0)
+			length += (size_t)snprintf(buffer + length, size - length, "%s%s%s%s", length > 0 ? separator : "", quote, names[i].name, quote);
+	}
+}
+
+/** Formats a capture time as an ISO 8601 UTC time.
+  *  @param time The time.
+  *  @param buffer The buffer to format into, at least 32 bytes.
+  */
+static void cdp_pcap_format_time(const struct timespec *time, char *buffer)
+{
+	struct tm broken_down;
+
+	if (gmtime_r(&time->tv_sec, &broken_down) == NULL || strftime(buffer, 32, "%Y-%m-%dT%H:%M:%S", &broken_down) == 0)
+	{
+		buffer[0] = '\0';
+		return;
+	}
+
+	snprintf(buffer + strlen(buffer), 32 - strlen(buffer), ".%06ldZ", time->tv_nsec / 1000);
+}
+
+/** Writes a neighbor in the output format.
+  *  @param output The stream to write to.
+  *  @param format The output format.
+  *  @param neighbor The neighbor.
+  */
+static void cdp_pcap_print_neighbor(FILE *output, enum cdp_pcap_format format, const struct cdp_pcap_neighbor *neighbor)
+{
+	const struct cdp_packet *packet = neighbor->latest->packet;
+	const uint8_t *mac = neighbor->latest->frame.source_mac;
+	char source_mac[18];
+	char addresses[1024];
+	char management_addresses[1024];
+	char capabilities[256];
+	char native_vlan[8];
+	char first_seen[32];
+	char last_seen[32];
+	const char *duplex;
+	bool json = (format == CDP_PCAP_FORMAT_JSON);
+
+	snprintf(source_mac, sizeof(source_mac), "%02x:%02x:%02x:%02x:%02x:%02x", mac[0], mac[1], mac[2], mac[3], mac[4], mac[5]);
+	cdp_pcap_format_addresses(packet->addresses, addresses, sizeof(addresses), json ? "," : " ", json ? "\"" : "");
+	cdp_pcap_format_addresses(packet->management_addresses, management_addresses, sizeof(management_addresses), json ? "," : " ", json ? "\"" : "");
+	cdp_pcap_format_capabilities(packet->capabilities, capabilities, sizeof(capabilities), json ? "," : " ", json ? "\"" : "");
+	cdp_pcap_format_time(&neighbor->first_seen, first_seen);
+	cdp_pcap_format_time(&neighbor->last_seen, last_seen);
+
+	if (packet->native_vlan != NULL)
+		snprintf(native_vlan, sizeof(native_vlan), "%u", (unsigned int)*packet->native_vlan);
+	else
+		snprintf(native_vlan, sizeof(native_vlan), "%s", json ? "null" : "");
+
+	duplex = packet->duplex == DuplexFull ? "full" : packet->duplex == DuplexHalf ? "half" : NULL;
+
+	if (json)
+	{
+		fprintf(output, "{\"sourceMac\":\"%s\",\"deviceId\":", source_mac);
+		cdp_pcap_print_json_string(output, packet->device_id);
+		fputs(",\"portId\":", output);
+		cdp_pcap_print_json_string(output, packet->port_id);
+		fputs(",\"platform\":", output);
+		cdp_pcap_print_json_string(output, packet->platform);
+		fputs(",\"softwareVersion\":", output);
+		cdp_pcap_print_json_string(output, packet->software_version);
+		fprintf(output, ",\"addresses\":[%s],\"managementAddresses\":[%s],\"capabilities\":[%s]", addresses, management_addresses, capabilities);
+		fprintf(output, ",\"nativeVlan\":%s,\"vtpDomain\":", native_vlan);
+		cdp_pcap_print_json_string(output, packet->vtp_management_domain);
+		fputs(",\"duplex\":", output);
+		cdp_pcap_print_json_string(output, duplex);
+		fprintf(
+			output,
+			",\"holdTime\":%u,\"firstSeen\":\"%s\",\"lastSeen\":\"%s\",\"frames\":%lu}\n",
+			(unsigned int)packet->cdp_ttl,
+			first_seen,
+			last_seen,
+			neighbor->frames
+		);
+	}
+	else
+	{
+		fprintf(output, "%s,", source_mac);
+		cdp_pcap_print_csv_string(output, packet->device_id);
+		fputc(',', output);
+		cdp_pcap_print_csv_string(output, packet->port_id);
+		fputc(',', output);
+		cdp_pcap_print_csv_string(output, packet->platform);
+		fputc(',', output);
+		cdp_pcap_print_csv_string(output, packet->software_version);
+		fprintf(output, ",%s,%s,%s,%s,", addresses, management_addresses, capabilities, native_vlan);
+		cdp_pcap_print_csv_string(output, packet->vtp_management_domain);
+		fputc(',', output);
+		cdp_pcap_print_csv_string(output, duplex);
+		fprintf(output, ",%u,%s,%s,%lu\n", (unsigned int)packet->cdp_ttl, first_seen, last_seen, neighbor->frames);
+	}
+}
+
+/** Writes every neighbor found by the workers, sorted by device ID and port ID.
+  *  @param workers The workers.
+  *  @param worker_count The number of workers.
+  *  @param format The output format.
+  *  @return The number of neighbors written or a negative value on error.
+  */
+static ssize_t cdp_pcap_print_neighbors(const struct cdp_pcap_worker *workers, unsigned int worker_count, enum cdp_pcap_format format)
+{
+	struct cdp_pcap_neighbor *neighbors;
+	size_t count = 0;
+	size_t i;
+	unsigned int w;
+
+	for (w = 0; w < worker_count; w++)
+		count += workers[w].neighbor_count;
+
+	if (format == CDP_PCAP_FORMAT_CSV)
+		printf("source_mac,device_id,port_id,platform,software_version,addresses,management_addresses,capabilities,native_vlan,vtp_domain,duplex,hold_time,first_seen,last_seen,frames\n");
+
+	if (count == 0)
+		return 0;
+
+	neighbors = ALLOC_NEW_ARRAY(struct cdp_pcap_neighbor, count);
+	if (neighbors == NULL)
+	{
+		LOG_CRITICAL("cdp_pcap_print_neighbors: failed to allocate memory for the neighbors\n");
+		return -1;
+	}
+
+	count = 0;
+	for (w = 0; w < worker_count; w++)
+	{
+		COPY_MEMORY(workers[w].neighbors, neighbors + count, workers[w].neighbor_count * sizeof(struct cdp_pcap_neighbor));
+		count += workers[w].neighbor_count;
+	}
+
+	qsort(neighbors, count, sizeof(struct cdp_pcap_neighbor), cdp_pcap_compare_neighbors);
+
+	for (i = 0; i < count; i++)
+		cdp_pcap_print_neighbor(stdout, format, &neighbors[i]);
+
+	FREE_ARRAY(neighbors);
+
+	return (ssize_t)count;
+}
+
+/** Scans the capture files and routes their CDP frames to the workers.
+  *  @param captures The location to store each opened capture, which must outlive the workers.
+  *  @param paths The files to scan.
+  *  @param path_count The number of files.
+  *  @param workers The workers.
+  *  @param worker_count The number of workers.
+  *  @param scanned The location to store the number of bytes scanned.
+  *  @param frames The location to store the number of CDP frames found.
+  *  @return 0 on success or a negative value on error.
+  */
+static int cdp_pcap_scan(
+	struct cdp_capture **captures,
+	char **paths,
+	int path_count,
+	struct cdp_pcap_worker *workers,
+	unsigned int worker_count,
+	size_t *scanned,
+	unsigned long *frames
+)
+{
+	struct cdp_received_frame frame;
+	struct cdp_pcap_worker *worker;
+	struct cdp_pcap_frame *item;
+	int rc = 0;
+	int i;
+
+	for (i = 0; i < path_count && rc == 0; i++)
+	{
+		captures[i] = cdp_capture_open(paths[i]);
+		if (captures[i] == NULL)
+			return -1;
+
+		while ((rc = cdp_capture_next(captures[i], &frame)) > 0)
+		{
+			worker = &workers[cdp_neighbor_hash_frame(frame.source_mac, 6) % worker_count];
+
+			if (worker->filling == NULL)
+			{
+				worker->filling = ALLOC_NEW(struct cdp_pcap_batch);
+				if (worker->filling == NULL)
+				{
+					LOG_CRITICAL("cdp_pcap_scan: failed to allocate memory for a batch\n");
+					return -1;
+				}
+
+				worker->filling->count = 0;
+			}
+
+			item = &worker->filling->frames[worker->filling->count++];
+			item->source_mac = frame.source_mac;
+			item->payload = frame.payload;
+			item->payload_length = frame.payload_length;
+			item->captured_at = frame.received_at;
+
+			if (worker->filling->count == CDP_PCAP_BATCH_SIZE)
+				cdp_pcap_worker_push(worker);
+
+			(*frames)++;
+		}
+
+		*scanned += captures[i]->size;
+	}
+
+	return rc;
+}
+
+int cdp_pcap_main(int argc, char **argv)
+{
+	enum cdp_pcap_format format = CDP_PCAP_FORMAT_JSON;
+	struct cdp_pcap_worker *workers;
+	struct cdp_capture **captures;
+	unsigned int worker_count = 0;
+	unsigned long frames = 0;
+	unsigned long malformed = 0;
+	size_t strings = 0;
+	size_t scanned = 0;
+	struct timespec started;
+	struct timespec finished;
+	double elapsed;
+	bool verbose = false;
+	ssize_t count;
+	int first_path;
+	int rc = 0;
+	int i;
+	unsigned int w;
+
+	for (i = 1; i < argc && argv[i][0] == '-'; i++)
+	{
+		if ((strcmp(argv[i], "-f") == 0 || strcmp(argv[i], "--format") == 0) && i + 1 < argc && strcmp(argv[i + 1], "json") == 0)
+			format = CDP_PCAP_FORMAT_JSON, i++;
+		else if ((strcmp(argv[i], "-f") == 0 || strcmp(argv[i], "--format") == 0) && i + 1 < argc && strcmp(argv[i + 1], "csv") == 0)
+			format = CDP_PCAP_FORMAT_CSV, i++;
+		else if ((strcmp(argv[i], "-j") == 0 || strcmp(argv[i], "--threads") == 0) && i + 1 < argc)
+			worker_count = (unsigned int)strtoul(argv[++i], NULL, 10);
+		else if (strcmp(argv[i], "-v") == 0 || strcmp(argv[i], "--verbose") == 0)
+			verbose = true;
+		else
+			break;
+	}
+
+	first_path = i;
+	if (first_path == argc || argv[first_path][0] == '-')
+	{
+		LOG_ERROR("usage: cdptools pcap [-f|--format json|csv] [-j|--threads count] [-v|--verbose] file...\n");
+		return 1;
+	}
+
+	if (worker_count == 0)
+	{
+		long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+		worker_count = cpus > 0 ? (unsigned int)cpus : 1;
+	}
+
+	workers = ALLOC_NEW_ARRAY(struct cdp_pcap_worker, worker_count);
+	captures = ALLOC_NEW_ARRAY(struct cdp_capture *, argc - first_path);
+	if (workers == NULL || captures == NULL)
+	{
+		LOG_CRITICAL("cdp_pcap_main: failed to allocate memory for the workers\n");
+		if (workers != NULL)
+			FREE_ARRAY(workers);
+		if (captures != NULL)
+			FREE_ARRAY(captures);
+		return 1;
+	}
+
+	memset(workers, 0, worker_count * sizeof(struct cdp_pcap_worker));
+	memset(captures, 0, (size_t)(argc - first_path) * sizeof(struct cdp_capture *));
+
+	clock_gettime(CLOCK_MONOTONIC, &started);
+
+	for (w = 0; w < worker_count; w++)
+	{
+		pthread_mutex_init(&workers[w].lock, NULL);
+		pthread_cond_init(&workers[w].queued, NULL);
+		pthread_cond_init(&workers[w].taken, NULL);
+
+		workers[w].bucket_count = cdp_pcap_initial_buckets;
+		workers[w].buckets = ALLOC_NEW_ARRAY(struct cdp_pcap_entry *, workers[w].bucket_count);
+		if (workers[w].buckets == NULL)
+		{
+			rc = -1;
+			continue;
+		}
+
+		memset(workers[w].buckets, 0, workers[w].bucket_count * sizeof(struct cdp_pcap_entry *));
+
+		workers[w].strings = cdp_string_pool_new(cdp_pcap_initial_string_buckets);
+		if (workers[w].strings == NULL)
+		{
+			rc = -1;
+			continue;
+		}
+
+		if (pthread_create(&workers[w].thread, NULL, cdp_pcap_worker_run, &workers[w]) != 0)
+		{
+			LOG_ERROR("cdp_pcap_main: failed to start worker %u\n", w);
+			rc = -1;
+			continue;
+		}
+
+		workers[w].started = true;
+	}
+
+	if (rc == 0)
+		rc = cdp_pcap_scan(captures, argv + first_path, argc - first_path, workers, worker_count, &scanned, &frames);
+
+	/* The workers finish the queued frames even after an error so that they can be joined */
+	for (w = 0; w < worker_count; w++)
+	{
+		if (rc == 0)
+			cdp_pcap_worker_push(&workers[w]);
+
+		pthread_mutex_lock(&workers[w].lock);
+		workers[w].done = true;
+		pthread_cond_signal(&workers[w].queued);
+		pthread_mutex_unlock(&workers[w].lock);
+
+		if (workers[w].started)
+			pthread_join(workers[w].thread, NULL);
+
+		malformed += workers[w].malformed;
+		strings += cdp_string_pool_count(workers[w].strings);
+	}
+
+	clock_gettime(CLOCK_MONOTONIC, &finished);
+
+	count = rc == 0 ? cdp_pcap_print_neighbors(workers, worker_count, format) : -1;
+
+	if (verbose && count >= 0)
+	{
+		elapsed = (double)(finished.tv_sec - started.tv_sec) + (double)(finished.tv_nsec - started.tv_nsec) / 1e9;
+
+		fprintf(
+			stderr,
+			"cdp: scanned %zu bytes in %.3f s (%.0f MB/s) with %u workers, %lu CDP frames, %zd neighbors, %lu malformed, %zu distinct strings\n",
+			scanned,
+			elapsed,
+			elapsed > 0 ? (double)scanned / elapsed / 1e6 : 0.0,
+			worker_count,
+			frames,
+			count,
+			malformed,
+			strings
+		);
+	}
+
+	for (w = 0; w < worker_count; w++)
+		cdp_pcap_worker_clean(&workers[w]);
+
+	for (i = 0; i < argc - first_path; i++)
+	{
+		if (captures[i] != NULL)
+			cdp_capture_delete(captures[i]);
+	}
+
+	FREE_ARRAY(captures);
+	FREE_ARRAY(workers);
+
+	return count < 0 ? 1 : 0;
+}
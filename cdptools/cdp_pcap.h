@@ -0,0 +1,14 @@
+#ifndef CDP_PCAP_H
+#define CDP_PCAP_H
+
+/** Entry point of "cdptools pcap", which extracts the CDP neighbors from pcap and pcapng capture
+  *  files. The files are mapped rather than read and scanned sequentially, while the CDP frames are
+  *  de-duplicated and parsed by a worker per CPU. Each distinct neighbor is written once as a JSON
+  *  line or a CSV row.
+  *  @param argc The number of arguments following the command name.
+  *  @param argv The arguments, argv[0] is the command name.
+  *  @return The process exit code.
+  */
+int cdp_pcap_main(int argc, char **argv);
+
+#endif
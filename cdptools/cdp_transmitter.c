@@ -0,0 +1,314 @@
+#define _GNU_SOURCE
+
+#include "cdp_transmitter.h"
+#include "cdp_packet_socket.h"
+#include "../libcdp/cdp_packet.h"
+#include "../libcdp/cdp_software_version_string.h"
+#include "../libcdp/platform/platform.h"
+
+#include <arpa/inet.h>
+#include <errno.h>
+#include <linux/if_ether.h>
+#include <string.h>
+#include <unistd.h>
+
+struct cdp_transmitter *cdp_transmitter_new(unsigned int capacity)
+{
+	struct cdp_transmitter *result;
+	size_t arena_size;
+
+	if (capacity == 0)
+	{
+		LOG_CRITICAL("cdp_transmitter_new: capacity must be at least 1\n");
+		return NULL;
+	}
+
+	result = ALLOC_NEW(struct cdp_transmitter);
+	if (result == NULL)
+	{
+		LOG_CRITICAL("cdp_transmitter_new: failed to allocate memory for transmitter\n");
+		return NULL;
+	}
+
+	memset(result, 0, sizeof(struct cdp_transmitter));
+	result->capacity = capacity;
+
+	/* Protocol 0 means the socket is never handed any received frames */
+	result->fd = socket(AF_PACKET, SOCK_RAW | SOCK_CLOEXEC, 0);
+	if (result->fd < 0)
+	{
+		LOG_ERROR("cdp_transmitter_new: failed to open packet socket (%s)\n", strerror(errno));
+		cdp_transmitter_delete(result);
+		return NULL;
+	}
+
+	arena_size = (size_t)capacity * CDP_TRANSMITTER_MAX_FRAME_LENGTH;
+
+	result->frames = ALLOC_NEW_ARRAY(uint8_t, arena_size);
+	result->messages = ALLOC_NEW_ARRAY(struct mmsghdr, capacity);
+	result->vectors = ALLOC_NEW_ARRAY(struct iovec, capacity);
+	result->destinations = ALLOC_NEW_ARRAY(struct sockaddr_ll, capacity);
+	if (result->frames == NULL || result->messages == NULL || result->vectors == NULL || result->destinations == NULL)
+	{
+		LOG_CRITICAL("cdp_transmitter_new: failed to allocate the transmit queue\n");
+		cdp_transmitter_delete(result);
+		return NULL;
+	}
+
+	if (generate_cdp_device_id_string(&result->device_id) < 0)
+	{
+		LOG_ERROR("cdp_transmitter_new: failed to generate the device ID\n");
+		cdp_transmitter_delete(result);
+		return NULL;
+	}
+
+	if (generate_cdp_software_version_string(&result->software_version) < 0)
+	{
+		LOG_ERROR("cdp_transmitter_new: failed to generate the software version\n");
+		cdp_transmitter_delete(result);
+		return NULL;
+	}
+
+	return result;
+}
+
+void cdp_transmitter_delete(struct cdp_transmitter *transmitter)
+{
+	if (transmitter == NULL)
+	{
+		LOG_CRITICAL("cdp_transmitter_delete: transmitter is NULL\n");
+		return;
+	}
+
+	if (transmitter->fd >= 0)
+		close(transmitter->fd);
+
+	if (transmitter->frames != NULL)
+		FREE_ARRAY(transmitter->frames);
+
+	if (transmitter->messages != NULL)
+		FREE_ARRAY(transmitter->messages);
+
+	if (transmitter->vectors != NULL)
+		FREE_ARRAY(transmitter->vectors);
+
+	if (transmitter->destinations != NULL)
+		FREE_ARRAY(transmitter->destinations);
+
+	if (transmitter->device_id != NULL)
+		FREE(transmitter->device_id);
+
+	if (transmitter->software_version != NULL)
+		FREE(transmitter->software_version);
+
+	FREE(transmitter);
+}
+
+/** Sets up the message for the frame built in the next free slot of the arena and queues it.
+  *  @param transmitter The transmitter object, with at least one free slot.
+  *  @param ifindex The interface index to send the frame on.
+  *  @param frame_length The length of the frame in bytes.
+  */
+static void cdp_transmitter_queue_message(struct cdp_transmitter *transmitter, int ifindex, size_t frame_length)
+{
+	struct sockaddr_ll *destination;
+	struct mmsghdr *message;
+	struct iovec *vector;
+
+	destination = &transmitter->destinations[transmitter->queued];
+	memset(destination, 0, sizeof(struct sockaddr_ll));
+	destination->sll_family = AF_PACKET;
+	destination->sll_protocol = htons(ETH_P_802_2);
+	destination->sll_ifindex = ifindex;
+	destination->sll_halen = 6;
+	memcpy(destination->sll_addr, cdp_multicast_address, 6);
+
+	vector = &transmitter->vectors[transmitter->queued];
+	vector->iov_base = transmitter->frames + (size_t)transmitter->queued * CDP_TRANSMITTER_MAX_FRAME_LENGTH;
+	vector->iov_len = frame_length;
+
+	message = &transmitter->messages[transmitter->queued];
+	memset(message, 0, sizeof(struct mmsghdr));
+	message->msg_hdr.msg_name = destination;
+	message->msg_hdr.msg_namelen = sizeof(struct sockaddr_ll);
+	message->msg_hdr.msg_iov = vector;
+	message->msg_hdr.msg_iovlen = 1;
+
+	transmitter->queued++;
+}
+
+size_t cdp_transmitter_write_headers(uint8_t *frame, const uint8_t *source_mac, size_t payload_length)
+{
+	/* 802.3 header, the type/length field holds the length of the LLC payload */
+	memcpy(frame, cdp_multicast_address, 6);
+	memcpy(frame + 6, source_mac, 6);
+	frame[12] = (uint8_t)((CDP_SNAP_HEADER_LENGTH + payload_length) >> 8);
+	frame[13] = (uint8_t)((CDP_SNAP_HEADER_LENGTH + payload_length) & 0xFF);
+	memcpy(frame + CDP_ETHERNET_HEADER_LENGTH, cdp_snap_header, CDP_SNAP_HEADER_LENGTH);
+
+	return CDP_ETHERNET_HEADER_LENGTH + CDP_SNAP_HEADER_LENGTH + payload_length;
+}
+
+int cdp_transmitter_queue(struct cdp_transmitter *transmitter, const struct cdp_interface *interface)
+{
+	struct cdp_packet *packet;
+	uint8_t *frame;
+	ssize_t payload_length;
+	ssize_t consumed;
+	size_t frame_length;
+
+	if (transmitter == NULL)
+	{
+		LOG_CRITICAL("cdp_transmitter_queue: transmitter is NULL\n");
+		return -1;
+	}
+
+	if (interface == NULL)
+	{
+		LOG_CRITICAL("cdp_transmitter_queue: interface is NULL\n");
+		return -1;
+	}
+
+	if (transmitter->queued == transmitter->capacity && cdp_transmitter_flush(transmitter) < 0)
+		return -1;
+
+	packet = cdp_packet_new_advertisement(
+		interface->name,
+		transmitter->device_id,
+		cdp_platform_string,
+		transmitter->software_version,
+		interface->addresses
+	);
+
+	if (packet == NULL)
+	{
+		LOG_ERROR("cdp_transmitter_queue: failed to generate the advertisement for %s\n", interface->name);
+		return -1;
+	}
+
+	payload_length = cdp_packet_serialized_size(packet);
+	if (payload_length < 1 || CDP_ETHERNET_HEADER_LENGTH + CDP_SNAP_HEADER_LENGTH + (size_t)payload_length > CDP_TRANSMITTER_MAX_FRAME_LENGTH)
+	{
+		LOG_ERROR("cdp_transmitter_queue: the advertisement for %s does not fit in a frame\n", interface->name);
+		cdp_packet_delete(packet);
+		return -1;
+	}
+
+	frame = transmitter->frames + (size_t)transmitter->queued * CDP_TRANSMITTER_MAX_FRAME_LENGTH;
+
+	consumed = cdp_packet_serialize(packet, frame + CDP_ETHERNET_HEADER_LENGTH + CDP_SNAP_HEADER_LENGTH, (size_t)payload_length);
+
+	cdp_packet_delete(packet);
+
+	if (consumed != payload_length)
+	{
+		LOG_ERROR("cdp_transmitter_queue: failed to serialize the advertisement for %s\n", interface->name);
+		return -1;
+	}
+
+	frame_length = cdp_transmitter_write_headers(frame, interface->mac, (size_t)payload_length);
+
+	cdp_transmitter_queue_message(transmitter, interface->index, frame_length);
+
+	return 0;
+}
+
+int cdp_transmitter_queue_frame(struct cdp_transmitter *transmitter, int ifindex, const uint8_t *frame, size_t length)
+{
+	if (transmitter == NULL)
+	{
+		LOG_CRITICAL("cdp_transmitter_queue_frame: transmitter is NULL\n");
+		return -1;
+	}
+
+	if (frame == NULL || length == 0 || length > CDP_TRANSMITTER_MAX_FRAME_LENGTH)
+	{
+		LOG_CRITICAL("cdp_transmitter_queue_frame: the frame is empty or too long\n");
+		return -1;
+	}
+
+	if (transmitter->queued == transmitter->capacity && cdp_transmitter_flush(transmitter) < 0)
+		return -1;
+
+	memcpy(transmitter->frames + (size_t)transmitter->queued * CDP_TRANSMITTER_MAX_FRAME_LENGTH, frame, length);
+
+	cdp_transmitter_queue_message(transmitter, ifindex, length);
+
+	return 0;
+}
+
+int cdp_transmitter_send(struct cdp_transmitter *transmitter)
+{
+	unsigned int position = 0;
+	unsigned int failed = 0;
+	int error;
+	int rc;
+
+	if (transmitter == NULL)
+	{
+		LOG_CRITICAL("cdp_transmitter_send: transmitter is NULL\n");
+		return -1;
+	}
+
+	while (position < transmitter->queued)
+	{
+		rc = sendmmsg(transmitter->fd, transmitter->messages + position, transmitter->queued - position, 0);
+		transmitter->system_calls++;
+		if (rc < 0)
+		{
+			error = errno;
+			if (error == EINTR)
+				continue;
+
+			/* A single interface going down while its frame is queued fails the message at the
+			 * head of the batch. Skip it so the remaining interfaces still get their frames.
+			 */
+			LOG_ERROR(
+				"cdp_transmitter_send: failed to send on ifindex %d (%s)\n",
+				transmitter->destinations[position].sll_ifindex,
+				strerror(error)
+			);
+
+			if (error == ENOBUFS || error == EAGAIN)
+			{
+				failed += transmitter->queued - position;
+				break;
+			}
+
+			failed++;
+			position++;
+			continue;
+		}
+
+		position += (unsigned int)rc;
+	}
+
+	return (int)(transmitter->queued - failed);
+}
+
+void cdp_transmitter_clear(struct cdp_transmitter *transmitter)
+{
+	if (transmitter == NULL)
+	{
+		LOG_CRITICAL("cdp_transmitter_clear: transmitter is NULL\n");
+		return;
+	}
+
+	transmitter->queued = 0;
+}
+
+int cdp_transmitter_flush(struct cdp_transmitter *transmitter)
+{
+	int rc;
+
+	if (transmitter == NULL)
+	{
+		LOG_CRITICAL("cdp_transmitter_flush: transmitter is NULL\n");
+		return -1;
+	}
+
+	rc = cdp_transmitter_send(transmitter);
+	transmitter->queued = 0;
+
+	return rc;
+}
@@ -0,0 +1,109 @@
+#ifndef CDP_TRANSMITTER_H
+#define CDP_TRANSMITTER_H
+
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <linux/if_packet.h>
+
+#include "cdp_interface.h"
+#include "../libcdp/platform/types.h"
+
+/** The largest Ethernet frame (without FCS) which can be queued */
+#define CDP_TRANSMITTER_MAX_FRAME_LENGTH 1514
+
+/** Queues complete CDP frames for a set of interfaces and sends them in a single sendmmsg call.
+  *  The frames are built in a preallocated arena so that a transmit tick performs no allocation
+  *  beyond what libcdp needs to construct each advertisement.
+  */
+struct cdp_transmitter
+{
+	/** The AF_PACKET socket used for transmission only */
+	int fd;
+
+	/** The maximum number of frames which can be queued */
+	unsigned int capacity;
+
+	/** The number of frames currently queued */
+	unsigned int queued;
+
+	/** The frame arena, capacity * CDP_TRANSMITTER_MAX_FRAME_LENGTH bytes */
+	uint8_t *frames;
+
+	/** The message headers passed to sendmmsg, one per queued frame */
+	struct mmsghdr *messages;
+
+	/** The I/O vectors of the messages, one per queued frame */
+	struct iovec *vectors;
+
+	/** The destination addresses of the messages, selecting the outgoing interface */
+	struct sockaddr_ll *destinations;
+
+	/** The device ID advertised on every interface */
+	char *device_id;
+
+	/** The software version advertised on every interface */
+	char *software_version;
+
+	/** The number of sendmmsg system calls made */
+	unsigned long system_calls;
+};
+
+/** Constructor, opens the transmit socket and allocates the frame arena.
+  *  @param capacity The number of frames which can be queued before the queue is flushed.
+  *  @return Either the new transmitter or NULL on error.
+  */
+struct cdp_transmitter *cdp_transmitter_new(unsigned int capacity);
+
+/** Destructor, frames still queued are discarded.
+  *  @param transmitter The transmitter to delete.
+  */
+void cdp_transmitter_delete(struct cdp_transmitter *transmitter);
+
+/** Writes the 802.3 header addressed to the CDP multicast MAC and the LLC/SNAP header in front of a
+  *  CDP payload.
+  *  @param frame The frame buffer, the payload must start CDP_ETHERNET_HEADER_LENGTH +
+  *               CDP_SNAP_HEADER_LENGTH bytes in.
+  *  @param source_mac The 6 byte source MAC address.
+  *  @param payload_length The length of the CDP payload.
+  *  @return The length of the whole frame.
+  */
+size_t cdp_transmitter_write_headers(uint8_t *frame, const uint8_t *source_mac, size_t payload_length);
+
+/** Builds the advertisement for an interface and queues it for transmission. If the queue is full
+  *  it is flushed first.
+  *  @param transmitter The transmitter object.
+  *  @param interface The interface to advertise on.
+  *  @return 0 on success or a negative value on error.
+  */
+int cdp_transmitter_queue(struct cdp_transmitter *transmitter, const struct cdp_interface *interface);
+
+/** Queues a frame which was built by the caller, complete with its Ethernet and SNAP headers. If the
+  *  queue is full it is flushed first.
+  *  @param transmitter The transmitter object.
+  *  @param ifindex The interface index to send the frame on.
+  *  @param frame The frame to copy into the queue.
+  *  @param length The length of the frame in bytes, at most CDP_TRANSMITTER_MAX_FRAME_LENGTH.
+  *  @return 0 on success or a negative value on error.
+  */
+int cdp_transmitter_queue_frame(struct cdp_transmitter *transmitter, int ifindex, const uint8_t *frame, size_t length);
+
+/** Sends every queued frame, batched into as few sendmmsg calls as the kernel accepts. The frames
+  *  stay queued so that they can be sent again.
+  *  @param transmitter The transmitter object.
+  *  @return The number of frames sent or a negative value on error.
+  */
+int cdp_transmitter_send(struct cdp_transmitter *transmitter);
+
+/** Empties the queue without sending, for frames which were sent by other means. The frames stay
+  *  in the arena until new frames are queued.
+  *  @param transmitter The transmitter object.
+  */
+void cdp_transmitter_clear(struct cdp_transmitter *transmitter);
+
+/** Sends every queued frame and empties the queue.
+  *  @param transmitter The transmitter object.
+  *  @return The number of frames sent or a negative value on error. The queue is emptied either way.
+  */
+int cdp_transmitter_flush(struct cdp_transmitter *transmitter);
+
+#endif
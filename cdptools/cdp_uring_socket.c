@@ -0,0 +1,583 @@
+#define _GNU_SOURCE
+
+#include "cdp_uring_socket.h"
+#include "../libcdp/platform/platform.h"
+
+#include <errno.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <time.h>
+#include <unistd.h>
+
+/** The number of submission queue entries */
+static const unsigned int cdp_uring_sq_entries = 256;
+
+/** The number of completion queue entries, a burst of frames completes one entry per frame */
+static const unsigned int cdp_uring_cq_entries = 4096;
+
+/** The number of provided receive buffers, must be a power of 2 */
+static const unsigned int cdp_uring_buffer_count = 256;
+
+/** The size of each provided receive buffer, large enough for the recvmsg header, the link layer
+  *  address and any CDP frame
+  */
+static const unsigned int cdp_uring_buffer_size = 2048;
+
+/** The provided buffer group used for the receive buffers */
+static const uint16_t cdp_uring_buffer_group = 0;
+
+/** user_data of the multishot receive */
+#define CDP_URING_RECEIVE 0ULL
+
+/** user_data flag of a send, the lower 32 bits hold the index of the frame in the transmitter */
+#define CDP_URING_SEND (1ULL << 32)
+
+/** Sets up an io_uring instance and maps its queues.
+  *  @param ring The ring to set up.
+  *  @return 0 on success or a negative value on error.
+  */
+static int cdp_uring_init(struct cdp_uring *ring)
+{
+	struct io_uring_params params;
+
+	memset(ring, 0, sizeof(struct cdp_uring));
+	memset(&params, 0, sizeof(params));
+	params.flags = IORING_SETUP_CQSIZE;
+	params.cq_entries = cdp_uring_cq_entries;
+
+	ring->fd = (int)syscall(__NR_io_uring_setup, cdp_uring_sq_entries, &params);
+	if (ring->fd < 0)
+	{
+		LOG_ERROR("cdp_uring_init: io_uring_setup failed (%s)\n", strerror(errno));
+		return -1;
+	}
+
+	ring->sq_ring_size = params.sq_off.array + params.sq_entries * sizeof(unsigned int);
+	ring->cq_ring_size = params.cq_off.cqes + params.cq_entries * sizeof(struct io_uring_cqe);
+
+	if ((params.features & IORING_FEAT_SINGLE_MMAP) != 0)
+	{
+		if (ring->cq_ring_size > ring->sq_ring_size)
+			ring->sq_ring_size = ring->cq_ring_size;
+
+		ring->cq_ring_size = 0;
+	}
+
+	ring->sq_ring = mmap(NULL, ring->sq_ring_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring->fd, IORING_OFF_SQ_RING);
+	if (ring->sq_ring == MAP_FAILED)
+	{
+		LOG_ERROR("cdp_uring_init: failed to map the submission queue (%s)\n", strerror(errno));
+		ring->sq_ring = NULL;
+		return -1;
+	}
+
+	if (ring->cq_ring_size == 0)
+	{
+		ring->cq_ring = ring->sq_ring;
+	}
+	else
+	{
+		ring->cq_ring = mmap(NULL, ring->cq_ring_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring->fd, IORING_OFF_CQ_RING);
+		if (ring->cq_ring == MAP_FAILED)
+		{
+			LOG_ERROR("cdp_uring_init: failed to map the completion queue (%s)\n", strerror(errno));
+			ring->cq_ring = NULL;
+			return -1;
+		}
+	}
+
+	ring->sqes_size = params.sq_entries * sizeof(struct io_uring_sqe);
+	ring->sqes = mmap(NULL, ring->sqes_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring->fd, IORING_OFF_SQES);
+	if (ring->sqes == MAP_FAILED)
+	{
+		LOG_ERROR("cdp_uring_init: failed to map the submission queue entries (%s)\n", strerror(errno));
+		ring->sqes = NULL;
+		return -1;
+	}
+
+	ring->sq_head = (unsigned int *)((uint8_t *)ring->sq_ring + params.sq_off.head);
+	ring->sq_tail = (unsigned int *)((uint8_t *)ring->sq_ring + params.sq_off.tail);
+	ring->sq_mask = (unsigned int *)((uint8_t *)ring->sq_ring + params.sq_off.ring_mask);
+	ring->sq_flags = (unsigned int *)((uint8_t *)ring->sq_ring + params.sq_off.flags);
+	ring->sq_array = (unsigned int *)((uint8_t *)ring->sq_ring + params.sq_off.array);
+	ring->sq_entries = params.sq_entries;
+	ring->sq_local_tail = *ring->sq_tail;
+
+	ring->cq_head = (unsigned int *)((uint8_t *)ring->cq_ring + params.cq_off.head);
+	ring->cq_tail = (unsigned int *)((uint8_t *)ring->cq_ring + params.cq_off.tail);
+	ring->cq_mask = (unsigned int *)((uint8_t *)ring->cq_ring + params.cq_off.ring_mask);
+	ring->cqes = (struct io_uring_cqe *)((uint8_t *)ring->cq_ring + params.cq_off.cqes);
+
+	return 0;
+}
+
+/** Unmaps the queues of an io_uring instance and closes it.
+  *  @param ring The ring to release.
+  */
+static void cdp_uring_exit(struct cdp_uring *ring)
+{
+	if (ring->sqes != NULL)
+		munmap(ring->sqes, ring->sqes_size);
+
+	if (ring->cq_ring != NULL && ring->cq_ring != ring->sq_ring)
+		munmap(ring->cq_ring, ring->cq_ring_size);
+
+	if (ring->sq_ring != NULL)
+		munmap(ring->sq_ring, ring->sq_ring_size);
+
+	if (ring->fd >= 0)
+		close(ring->fd);
+}
+
+/** Publishes the prepared submission queue entries and enters the kernel.
+  *  @param socket The socket object.
+  *  @param flags The io_uring_enter flags.
+  *  @return 0 on success or a negative value on error.
+  */
+static int cdp_uring_socket_enter(struct cdp_uring_socket *socket, unsigned int flags)
+{
+	struct cdp_uring *ring = &socket->ring;
+	unsigned int to_submit;
+	int rc;
+
+	to_submit = ring->sq_local_tail - *ring->sq_tail;
+	__atomic_store_n(ring->sq_tail, ring->sq_local_tail, __ATOMIC_RELEASE);
+
+	do
+	{
+		rc = (int)syscall(__NR_io_uring_enter, ring->fd, to_submit, 0, flags, NULL, 0);
+		socket->system_calls++;
+	} while (rc < 0 && errno == EINTR);
+
+	if (rc < 0)
+	{
+		LOG_ERROR("cdp_uring_socket_enter: io_uring_enter failed (%s)\n", strerror(errno));
+		return -1;
+	}
+
+	return 0;
+}
+
+/** Gets the next free submission queue entry, submitting the prepared ones if the queue is full.
+  *  @param socket The socket object.
+  *  @return The cleared entry or NULL on error.
+  */
+static struct io_uring_sqe *cdp_uring_socket_get_sqe(struct cdp_uring_socket *socket)
+{
+	struct cdp_uring *ring = &socket->ring;
+	struct io_uring_sqe *sqe;
+	unsigned int index;
+
+	if (ring->sq_local_tail - __atomic_load_n(ring->sq_head, __ATOMIC_ACQUIRE) >= ring->sq_entries)
+	{
+		if (cdp_uring_socket_enter(socket, 0) < 0)
+			return NULL;
+
+		if (ring->sq_local_tail - __atomic_load_n(ring->sq_head, __ATOMIC_ACQUIRE) >= ring->sq_entries)
+		{
+			LOG_ERROR("cdp_uring_socket_get_sqe: the submission queue is full\n");
+			return NULL;
+		}
+	}
+
+	index = ring->sq_local_tail & *ring->sq_mask;
+	sqe = &ring->sqes[index];
+	memset(sqe, 0, sizeof(struct io_uring_sqe));
+	ring->sq_array[index] = index;
+	ring->sq_local_tail++;
+
+	return sqe;
+}
+
+/** Hands a receive buffer (back) to the kernel.
+  *  @param socket The socket object.
+  *  @param buffer_id The index of the buffer.
+  */
+static void cdp_uring_socket_provide_buffer(struct cdp_uring_socket *socket, uint16_t buffer_id)
+{
+	struct io_uring_buf *buffer;
+	uint16_t tail = socket->buffer_ring->tail;
+
+	buffer = &socket->buffer_ring->bufs[tail & (cdp_uring_buffer_count - 1)];
+	buffer->addr = (uint64_t)(uintptr_t)(socket->buffers + (size_t)buffer_id * cdp_uring_buffer_size);
+	buffer->len = cdp_uring_buffer_size;
+	buffer->bid = buffer_id;
+
+	__atomic_store_n(&socket->buffer_ring->tail, (uint16_t)(tail + 1), __ATOMIC_RELEASE);
+}
+
+/** Prepares the multishot recvmsg which stays posted until the kernel runs out of buffers.
+  *  @param socket The socket object.
+  *  @return 0 on success or a negative value on error.
+  */
+static int cdp_uring_socket_prepare_receive(struct cdp_uring_socket *socket)
+{
+	struct io_uring_sqe *sqe;
+
+	sqe = cdp_uring_socket_get_sqe(socket);
+	if (sqe == NULL)
+		return -1;
+
+	sqe->opcode = IORING_OP_RECVMSG;
+	sqe->fd = socket->socket->fd;
+	sqe->addr = (uint64_t)(uintptr_t)&socket->receive_message;
+	sqe->len = 1;
+	sqe->ioprio = IORING_RECV_MULTISHOT;
+	sqe->flags = IOSQE_BUFFER_SELECT;
+	sqe->buf_group = cdp_uring_buffer_group;
+	sqe->user_data = CDP_URING_RECEIVE;
+
+	socket->receive_armed = true;
+
+	return 0;
+}
+
+/** Prepares the send of one frame queued on the transmitter.
+  *  @param socket The socket object.
+  *  @param index The index of the frame in the transmitter.
+  *  @return 0 on success or a negative value on error.
+  */
+static int cdp_uring_socket_prepare_send(struct cdp_uring_socket *socket, unsigned int index)
+{
+	struct cdp_transmitter *transmitter = socket->transmitter;
+	struct io_uring_sqe *sqe;
+
+	sqe = cdp_uring_socket_get_sqe(socket);
+	if (sqe == NULL)
+		return -1;
+
+	sqe->fd = socket->socket->fd;
+	sqe->user_data = CDP_URING_SEND | index;
+
+	if (socket->use_sendmsg)
+	{
+		sqe->opcode = IORING_OP_SENDMSG;
+		sqe->addr = (uint64_t)(uintptr_t)&transmitter->messages[index].msg_hdr;
+		sqe->len = 1;
+	}
+	else
+	{
+		/* Send straight from the arena to the link layer destination. Packet sockets don't support
+		 * zero copy, which is the only send taking registered buffers, so the kernel copies the
+		 * frame into its own buffer either way.
+		 */
+		sqe->opcode = IORING_OP_SEND;
+		sqe->addr = (uint64_t)(uintptr_t)transmitter->vectors[index].iov_base;
+		sqe->len = (uint32_t)transmitter->vectors[index].iov_len;
+		sqe->addr2 = (uint64_t)(uintptr_t)&transmitter->destinations[index];
+		sqe->addr_len = sizeof(struct sockaddr_ll);
+	}
+
+	socket->sends_in_flight++;
+
+	return 0;
+}
+
+/** Sets up the provided buffer ring and hands every receive buffer to the kernel.
+  *  @param socket The socket object.
+  *  @return 0 on success or a negative value on error.
+  */
+static int cdp_uring_socket_setup_buffers(struct cdp_uring_socket *socket)
+{
+	struct io_uring_buf_reg registration;
+	unsigned int i;
+
+	socket->buffer_ring_size = cdp_uring_buffer_count * sizeof(struct io_uring_buf);
+	socket->buffer_ring = mmap(NULL, socket->buffer_ring_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+	if (socket->buffer_ring == MAP_FAILED)
+	{
+		LOG_ERROR("cdp_uring_socket_setup_buffers: failed to allocate the buffer ring (%s)\n", strerror(errno));
+		socket->buffer_ring = NULL;
+		return -1;
+	}
+
+	socket->buffers_size = (size_t)cdp_uring_buffer_count * cdp_uring_buffer_size;
+	socket->buffers = mmap(NULL, socket->buffers_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+	if (socket->buffers == MAP_FAILED)
+	{
+		LOG_ERROR("cdp_uring_socket_setup_buffers: failed to allocate the receive buffers (%s)\n", strerror(errno));
+		socket->buffers = NULL;
+		return -1;
+	}
+
+	memset(&registration, 0, sizeof(registration));
+	registration.ring_addr = (uint64_t)(uintptr_t)socket->buffer_ring;
+	registration.ring_entries = cdp_uring_buffer_count;
+	registration.bgid = cdp_uring_buffer_group;
+
+	if (syscall(__NR_io_uring_register, socket->ring.fd, IORING_REGISTER_PBUF_RING, &registration, 1) < 0)
+	{
+		LOG_ERROR("cdp_uring_socket_setup_buffers: failed to register the buffer ring (%s)\n", strerror(errno));
+		return -1;
+	}
+
+	for (i = 0; i < cdp_uring_buffer_count; i++)
+		cdp_uring_socket_provide_buffer(socket, (uint16_t)i);
+
+	return 0;
+}
+
+struct cdp_uring_socket *cdp_uring_socket_new(struct cdp_transmitter *transmitter)
+{
+	struct cdp_uring_socket *result;
+
+	result = ALLOC_NEW(struct cdp_uring_socket);
+	if (result == NULL)
+	{
+		LOG_CRITICAL("cdp_uring_socket_new: failed to allocate memory for io_uring socket\n");
+		return NULL;
+	}
+
+	memset(result, 0, sizeof(struct cdp_uring_socket));
+	result->ring.fd = -1;
+
+	result->socket = cdp_packet_socket_new_unmapped();
+	if (result->socket == NULL)
+	{
+		cdp_uring_socket_delete(result);
+		return NULL;
+	}
+
+	if (cdp_uring_init(&result->ring) < 0 || cdp_uring_socket_setup_buffers(result) < 0)
+	{
+		cdp_uring_socket_delete(result);
+		return NULL;
+	}
+
+	result->transmitter = transmitter;
+
+	/* The link layer address is returned with every frame, there's no control data */
+	result->receive_message.msg_namelen = sizeof(struct sockaddr_ll);
+	result->receive_message.msg_controllen = 0;
+
+	if (cdp_uring_socket_prepare_receive(result) < 0 || cdp_uring_socket_enter(result, 0) < 0)
+	{
+		cdp_uring_socket_delete(result);
+		return NULL;
+	}
+
+	return result;
+}
+
+void cdp_uring_socket_delete(struct cdp_uring_socket *socket)
+{
+	if (socket == NULL)
+	{
+		LOG_CRITICAL("cdp_uring_socket_delete: socket is NULL\n");
+		return;
+	}
+
+	/* Closing the ring cancels the outstanding requests before the buffers are released */
+	cdp_uring_exit(&socket->ring);
+
+	if (socket->buffers != NULL)
+		munmap(socket->buffers, socket->buffers_size);
+
+	if (socket->buffer_ring != NULL)
+		munmap(socket->buffer_ring, socket->buffer_ring_size);
+
+	if (socket->socket != NULL)
+		cdp_packet_socket_delete(socket->socket);
+
+	FREE(socket);
+}
+
+/** Processes the completion of the multishot receive for one frame.
+  *  @param socket The socket object.
+  *  @param cqe The completion.
+  *  @param received_at The time to record for the frame.
+  *  @param handler The function to call for the frame.
+  *  @param context The context to pass to the handler.
+  *  @return 1 if a frame was passed to the handler, 0 otherwise.
+  */
+static int cdp_uring_socket_complete_receive(
+	struct cdp_uring_socket *socket,
+	const struct io_uring_cqe *cqe,
+	struct timespec received_at,
+	cdp_frame_handler handler,
+	void *context
+)
+{
+	const struct io_uring_recvmsg_out *header;
+	struct cdp_received_frame frame;
+	const uint8_t *buffer;
+	size_t payload_offset;
+	uint16_t buffer_id;
+	int result = 0;
+
+	if ((cqe->flags & IORING_CQE_F_MORE) == 0)
+		socket->receive_armed = false;
+
+	if (cqe->res < 0)
+	{
+		/* Running out of buffers only ends the multishot receive, it's posted again */
+		if (cqe->res != -ENOBUFS)
+			LOG_ERROR("cdp_uring_socket_complete_receive: receive failed (%s)\n", strerror(-cqe->res));
+
+		return 0;
+	}
+
+	if ((cqe->flags & IORING_CQE_F_BUFFER) == 0)
+		return 0;
+
+	buffer_id = (uint16_t)(cqe->flags >> IORING_CQE_BUFFER_SHIFT);
+	buffer = socket->buffers + (size_t)buffer_id * cdp_uring_buffer_size;
+	header = (const struct io_uring_recvmsg_out *)buffer;
+
+	/* The buffer holds the recvmsg header, the address, the control data and the frame */
+	payload_offset = sizeof(struct io_uring_recvmsg_out) + socket->receive_message.msg_namelen + socket->receive_message.msg_controllen;
+
+	if (
+		(size_t)cqe->res >= payload_offset &&
+		header->namelen >= sizeof(struct sockaddr_ll) &&
+		(header->flags & MSG_TRUNC) == 0 &&
+		cdp_packet_socket_decode(
+			buffer + payload_offset,
+			(size_t)cqe->res - payload_offset,
+			(const struct sockaddr_ll *)(buffer + sizeof(struct io_uring_recvmsg_out)),
+			&frame
+		)
+	)
+	{
+		frame.received_at = received_at;
+		handler(context, &frame);
+		result = 1;
+	}
+
+	cdp_uring_socket_provide_buffer(socket, buffer_id);
+
+	return result;
+}
+
+/** Processes the completion of a send. A kernel which doesn't accept a destination address with
+  *  IORING_OP_SEND fails the send, which is then repeated with sendmsg for this and every
+  *  later frame.
+  *  @param socket The socket object.
+  *  @param cqe The completion.
+  *  @return true if the send was prepared again and needs to be submitted.
+  */
+static bool cdp_uring_socket_complete_send(struct cdp_uring_socket *socket, const struct io_uring_cqe *cqe)
+{
+	unsigned int index = (unsigned int)(cqe->user_data & 0xFFFFFFFF);
+
+	socket->sends_in_flight--;
+
+	if (cqe->res >= 0)
+		return false;
+
+	if ((cqe->res == -EINVAL || cqe->res == -EOPNOTSUPP) && socket->transmitter != NULL && index < socket->transmitter->capacity)
+	{
+		if (!socket->use_sendmsg)
+			LOG_INFORMATIONAL("cdp: io_uring can't send on this socket (%d), falling back to sendmsg\n", cqe->res);
+
+		socket->use_sendmsg = true;
+
+		return cdp_uring_socket_prepare_send(socket, index) == 0;
+	}
+
+	LOG_ERROR("cdp_uring_socket_complete_send: send failed (%s)\n", strerror(-cqe->res));
+
+	return false;
+}
+
+int cdp_uring_socket_receive(struct cdp_uring_socket *socket, cdp_frame_handler handler, void *context)
+{
+	struct cdp_uring *ring;
+	struct timespec received_at;
+	unsigned int head;
+	unsigned int tail;
+	bool submit = false;
+	int result = 0;
+
+	if (socket == NULL)
+	{
+		LOG_CRITICAL("cdp_uring_socket_receive: socket is NULL\n");
+		return -1;
+	}
+
+	if (handler == NULL)
+	{
+		LOG_CRITICAL("cdp_uring_socket_receive: handler is NULL\n");
+		return -1;
+	}
+
+	ring = &socket->ring;
+
+	/* Completions which didn't fit in the queue are only moved into it by entering the kernel */
+	if ((__atomic_load_n(ring->sq_flags, __ATOMIC_ACQUIRE) & IORING_SQ_CQ_OVERFLOW) != 0)
+		cdp_uring_socket_enter(socket, IORING_ENTER_GETEVENTS);
+
+	clock_gettime(CLOCK_REALTIME, &received_at);
+
+	head = *ring->cq_head;
+	tail = __atomic_load_n(ring->cq_tail, __ATOMIC_ACQUIRE);
+
+	while (head != tail)
+	{
+		const struct io_uring_cqe *cqe = &ring->cqes[head & *ring->cq_mask];
+
+		if ((cqe->user_data & CDP_URING_SEND) != 0)
+			submit |= cdp_uring_socket_complete_send(socket, cqe);
+		else
+			result += cdp_uring_socket_complete_receive(socket, cqe, received_at, handler, context);
+
+		head++;
+
+		/* Pick up completions which arrived while processing */
+		if (head == tail)
+		{
+			__atomic_store_n(ring->cq_head, head, __ATOMIC_RELEASE);
+			tail = __atomic_load_n(ring->cq_tail, __ATOMIC_ACQUIRE);
+		}
+	}
+
+	__atomic_store_n(ring->cq_head, head, __ATOMIC_RELEASE);
+
+	if (!socket->receive_armed)
+	{
+		if (cdp_uring_socket_prepare_receive(socket) < 0)
+			return -1;
+
+		submit = true;
+	}
+
+	if (submit && cdp_uring_socket_enter(socket, 0) < 0)
+		return -1;
+
+	return result;
+}
+
+int cdp_uring_socket_send(struct cdp_uring_socket *socket)
+{
+	unsigned int i;
+
+	if (socket == NULL)
+	{
+		LOG_CRITICAL("cdp_uring_socket_send: socket is NULL\n");
+		return -1;
+	}
+
+	if (socket->transmitter == NULL)
+	{
+		LOG_CRITICAL("cdp_uring_socket_send: the socket has no transmitter\n");
+		return -1;
+	}
+
+	if (socket->sends_in_flight > 0)
+	{
+		LOG_ERROR("cdp_uring_socket_send: the previous frames are still being sent\n");
+		return -1;
+	}
+
+	for (i = 0; i < socket->transmitter->queued; i++)
+	{
+		if (cdp_uring_socket_prepare_send(socket, i) < 0)
+			return -1;
+	}
+
+	if (i > 0 && cdp_uring_socket_enter(socket, 0) < 0)
+		return -1;
+
+	return (int)i;
+}
@@ -0,0 +1,127 @@
+#ifndef CDP_URING_SOCKET_H
+#define CDP_URING_SOCKET_H
+
+#include <linux/io_uring.h>
+#include <sys/socket.h>
+
+#include "cdp_packet_socket.h"
+#include "cdp_transmitter.h"
+
+/** The submission and completion queues of an io_uring instance, mapped into this process */
+struct cdp_uring
+{
+	/** The io_uring file descriptor, readable when completions are pending */
+	int fd;
+
+	/** The mapped submission queue ring */
+	void *sq_ring;
+
+	/** The size of the submission queue ring mapping */
+	size_t sq_ring_size;
+
+	/** The mapped completion queue ring, may be the same mapping as sq_ring */
+	void *cq_ring;
+
+	/** The size of the completion queue ring mapping */
+	size_t cq_ring_size;
+
+	/** The mapped submission queue entries */
+	struct io_uring_sqe *sqes;
+
+	/** The size of the submission queue entries mapping */
+	size_t sqes_size;
+
+	/** Pointers into the submission queue ring */
+	unsigned int *sq_head;
+	unsigned int *sq_tail;
+	unsigned int *sq_mask;
+	unsigned int *sq_flags;
+	unsigned int *sq_array;
+
+	/** The number of submission queue entries */
+	unsigned int sq_entries;
+
+	/** The tail including entries prepared but not yet published to the kernel */
+	unsigned int sq_local_tail;
+
+	/** Pointers into the completion queue ring */
+	unsigned int *cq_head;
+	unsigned int *cq_tail;
+	unsigned int *cq_mask;
+	struct io_uring_cqe *cqes;
+};
+
+/** A CDP packet socket whose frames are received and sent through io_uring.
+  *  A multishot recvmsg is kept posted on the socket. The kernel picks a buffer for every frame
+  *  from a ring of provided buffers, so frames land in preallocated memory and libcdp parses them
+  *  in place. Advertisements are sent directly from the transmitter's frame arena, a whole batch
+  *  with a single system call.
+  */
+struct cdp_uring_socket
+{
+	/** The io_uring instance */
+	struct cdp_uring ring;
+
+	/** The packet socket, without a TPACKET ring */
+	struct cdp_packet_socket *socket;
+
+	/** The provided buffer ring shared with the kernel */
+	struct io_uring_buf_ring *buffer_ring;
+
+	/** The size of the provided buffer ring mapping */
+	size_t buffer_ring_size;
+
+	/** The receive buffers handed to the kernel through the buffer ring */
+	uint8_t *buffers;
+
+	/** The size of the receive buffer mapping */
+	size_t buffers_size;
+
+	/** The message header describing the layout of the multishot recvmsg buffers */
+	struct msghdr receive_message;
+
+	/** Whether the multishot recvmsg is currently posted */
+	bool receive_armed;
+
+	/** The transmitter whose frames are sent, or NULL */
+	struct cdp_transmitter *transmitter;
+
+	/** The number of sends submitted which haven't completed */
+	unsigned int sends_in_flight;
+
+	/** Set when the kernel can't send to an address with IORING_OP_SEND, sendmsg is used instead */
+	bool use_sendmsg;
+
+	/** The number of io_uring_enter system calls made */
+	unsigned long system_calls;
+};
+
+/** Constructor, opens the packet socket and the io_uring instance and posts the multishot receive.
+  *  @param transmitter The transmitter whose frames should be sent or NULL to only receive.
+  *  @return Either the new socket or NULL on error.
+  */
+struct cdp_uring_socket *cdp_uring_socket_new(struct cdp_transmitter *transmitter);
+
+/** Destructor
+  *  @param socket The socket to close.
+  */
+void cdp_uring_socket_delete(struct cdp_uring_socket *socket);
+
+/** Processes every pending completion. Received frames are passed to the handler directly from the
+  *  provided buffers, which are then recycled. This makes a system call only when the multishot
+  *  receive has to be posted again.
+  *  @param socket The socket object.
+  *  @param handler The function to call for each frame.
+  *  @param context The context to pass to the handler.
+  *  @return The number of frames processed or a negative value on error.
+  */
+int cdp_uring_socket_receive(struct cdp_uring_socket *socket, cdp_frame_handler handler, void *context);
+
+/** Submits a send for every frame queued on the transmitter in a single system call. The frames
+  *  must not be modified until the sends complete, which cdp_uring_socket_receive processes.
+  *  @param socket The socket object.
+  *  @return The number of sends submitted or a negative value on error.
+  */
+int cdp_uring_socket_send(struct cdp_uring_socket *socket);
+
+#endif
@@ -0,0 +1,528 @@
+#include "cdp_worker.h"
+#include "../libcdp/cdp_neighbor_record.h"
+#include "../libcdp/cdp_packet.h"
+#include "../libcdp/cdp_packet_parser.h"
+#include "../libcdp/platform/platform.h"
+
+#include <errno.h>
+#include <linux/if_arp.h>
+#include <poll.h>
+#include <string.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+
+/** The minimum interval between signalling neighbors which were only refreshed (seconds) */
+static const time_t cdp_worker_refresh_interval = 1;
+
+/** Logs the identity of a neighbor by parsing its frame in place.
+  *  @param interface The interface the neighbor was heard on.
+  *  @param frame The received frame.
+  *  @param event A description of the change.
+  */
+static void cdp_worker_log_neighbor(const struct cdp_interface *interface, const struct cdp_received_frame *frame, const char *event)
+{
+	struct stream_reader *reader;
+	struct cdp_packet *packet = NULL;
+
+	reader = stream_reader_new(frame->payload, frame->payload_length);
+	if (reader == NULL)
+		return;
+
+	if (cdp_parse_packet(reader, &packet) < 0 || packet == NULL)
+	{
+		LOG_ERROR("cdp: %s neighbor on %s sent a frame which could not be parsed\n", event, interface->name);
+	}
+	else
+	{
+		LOG_INFORMATIONAL(
+			"cdp: %s neighbor %s on %s (port %s)\n",
+			event,
+			packet->device_id != NULL ? packet->device_id : "<unknown>",
+			interface->name,
+			packet->port_id != NULL ? packet->port_id : "<unknown>"
+		);
+	}
+
+	if (packet != NULL)
+		cdp_packet_delete(packet);
+
+	stream_reader_delete(reader);
+}
+
+bool cdp_worker_store_frame(
+	struct cdp_neighbor_list *neighbors,
+	const struct cdp_interface_list *interfaces,
+	const struct cdp_received_frame *frame,
+	bool verbose
+)
+{
+	const struct cdp_interface *interface;
+	struct cdp_neighbor *neighbor;
+	uint32_t previous_hash;
+	bool is_new;
+
+	interface = cdp_interface_list_get_by_index(interfaces, frame->ifindex);
+	if (interface == NULL)
+		return false;
+
+	neighbor = cdp_neighbor_list_get_or_create_by_identity(
+		neighbors,
+		ARPHRD_ETHER,
+		frame->ifindex,
+		cdp_neighbor_pack_mac(frame->source_mac)
+	);
+
+	if (neighbor == NULL)
+	{
+		LOG_CRITICAL("cdp_worker_store_frame: failed to find or create a neighbor entry\n");
+		return false;
+	}
+
+	is_new = (neighbor->frame_buffer_length == 0);
+	previous_hash = neighbor->frame_hash;
+
+	cdp_neighbor_set_received_at(neighbor, frame->received_at);
+
+	if (cdp_neighbor_set_frame_buffer(neighbor, frame->payload, frame->payload_length) < 0)
+	{
+		LOG_ERROR("cdp_worker_store_frame: failed to store the frame\n");
+		return false;
+	}
+
+	if (!is_new && neighbor->frame_hash == previous_hash)
+		return false;
+
+	if (verbose)
+		cdp_worker_log_neighbor(interface, frame, is_new ? "new" : "changed");
+
+	return true;
+}
+
+/** Signals the main thread that the worker's shard changed. Refreshes are signalled at most once
+  *  per cdp_worker_refresh_interval, a refresh which is held back stays pending.
+  *  @param worker The worker object.
+  *  @param changed Whether neighbors were added, changed or removed rather than only refreshed.
+  */
+static void cdp_worker_notify(struct cdp_worker *worker, bool changed)
+{
+	const uint64_t increment = 1;
+	struct timespec now;
+
+	clock_gettime(CLOCK_MONOTONIC, &now);
+
+	if (!changed && now.tv_sec < worker->notified_at + cdp_worker_refresh_interval)
+	{
+		worker->refresh_pending = true;
+		return;
+	}
+
+	worker->notified_at = now.tv_sec;
+	worker->refresh_pending = false;
+
+	if (write(worker->changed_fd, &increment, sizeof(increment)) < 0 && errno != EAGAIN)
+		LOG_ERROR("cdp_worker_notify: worker %u failed to signal a change (%s)\n", worker->id, strerror(errno));
+}
+
+/** Frame handler of a worker, called with the worker's lock held.
+  *  @param context The worker object.
+  *  @param frame The received frame.
+  */
+static void cdp_worker_handle_frame(void *context, const struct cdp_received_frame *frame)
+{
+	struct cdp_worker *worker = (struct cdp_worker *)context;
+
+	cdp_worker_notify(worker, cdp_worker_store_frame(worker->neighbors, worker->interfaces, frame, worker->verbose));
+	worker->frames++;
+}
+
+/** Calculates how long a worker can sleep before the next neighbor in its shard expires or a
+  *  pending refresh is due. Only the worker modifies its shard so it can be read without the lock.
+  *  @param worker The worker object.
+  *  @return The timeout in milliseconds or -1 to wait indefinitely.
+  */
+static int cdp_worker_get_timeout(const struct cdp_worker *worker)
+{
+	struct timespec expiry;
+	struct timespec now;
+	time_t delay;
+	int result = -1;
+
+	if (cdp_neighbor_list_get_next_expiry(worker->neighbors, &expiry) > 0)
+	{
+		clock_gettime(CLOCK_REALTIME, &now);
+
+		delay = expiry.tv_sec - now.tv_sec;
+		result = delay <= 0 ? 0 : (int)delay * 1000;
+	}
+
+	if (worker->refresh_pending && (result < 0 || result > cdp_worker_refresh_interval * 1000))
+		result = (int)cdp_worker_refresh_interval * 1000;
+
+	return result;
+}
+
+/** The thread function of a worker. Waits for frames, the next expiry or the stop request.
+  *  @param argument The worker object.
+  *  @return NULL.
+  */
+static void *cdp_worker_run(void *argument)
+{
+	struct cdp_worker *worker = (struct cdp_worker *)argument;
+	struct cdp_interface_list *interfaces;
+	struct pollfd descriptors[2];
+	struct timespec now;
+	int count;
+	int rc;
+
+	descriptors[0].fd = worker->socket->fd;
+	descriptors[0].events = POLLIN;
+	descriptors[1].fd = worker->stop_fd;
+	descriptors[1].events = POLLIN;
+
+	for (;;)
+	{
+		/* Adopt the newest interface list handed over by the main thread */
+		interfaces = __atomic_exchange_n(&worker->pending_interfaces, NULL, __ATOMIC_ACQ_REL);
+		if (interfaces != NULL)
+		{
+			if (worker->interfaces != NULL)
+				cdp_interface_list_delete(worker->interfaces);
+
+			worker->interfaces = interfaces;
+		}
+
+		rc = poll(descriptors, 2, cdp_worker_get_timeout(worker));
+		if (rc < 0)
+		{
+			if (errno == EINTR)
+				continue;
+
+			LOG_ERROR("cdp_worker_run: worker %u failed to poll (%s)\n", worker->id, strerror(errno));
+			break;
+		}
+
+		if ((descriptors[1].revents & POLLIN) != 0)
+			break;
+
+		pthread_mutex_lock(&worker->lock);
+
+		if ((descriptors[0].revents & POLLIN) != 0)
+			cdp_packet_socket_receive(worker->socket, cdp_worker_handle_frame, worker);
+
+		count = worker->neighbors->count;
+		clock_gettime(CLOCK_REALTIME, &now);
+		cdp_neighbor_list_purge_expired_neighbors(worker->neighbors, now);
+
+		pthread_mutex_unlock(&worker->lock);
+
+		if (worker->neighbors->count != count)
+			cdp_worker_notify(worker, true);
+		else if (worker->refresh_pending)
+			cdp_worker_notify(worker, false);
+	}
+
+	return NULL;
+}
+
+struct cdp_worker_pool *cdp_worker_pool_new(unsigned int count, bool verbose)
+{
+	struct cdp_worker_pool *result;
+	uint16_t group_id;
+	unsigned int i;
+
+	if (count == 0)
+	{
+		LOG_CRITICAL("cdp_worker_pool_new: count must be at least 1\n");
+		return NULL;
+	}
+
+	result = ALLOC_NEW(struct cdp_worker_pool);
+	if (result == NULL)
+	{
+		LOG_CRITICAL("cdp_worker_pool_new: failed to allocate memory for worker pool\n");
+		return NULL;
+	}
+
+	result->count = 0;
+	result->stop_fd = eventfd(0, EFD_CLOEXEC);
+	result->changed_fd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+	if (result->stop_fd < 0 || result->changed_fd < 0)
+	{
+		LOG_ERROR("cdp_worker_pool_new: failed to create eventfd (%s)\n", strerror(errno));
+
+		if (result->stop_fd >= 0)
+			close(result->stop_fd);
+
+		if (result->changed_fd >= 0)
+			close(result->changed_fd);
+
+		FREE(result);
+		return NULL;
+	}
+
+	result->workers = ALLOC_NEW_ARRAY(struct cdp_worker, count);
+	if (result->workers == NULL)
+	{
+		LOG_CRITICAL("cdp_worker_pool_new: failed to allocate memory for the workers\n");
+		cdp_worker_pool_delete(result);
+		return NULL;
+	}
+
+	/* Fanout group ids only need to be unique on the host */
+	group_id = (uint16_t)(getpid() & 0xFFFF);
+
+	for (i = 0; i < count; i++)
+	{
+		struct cdp_worker *worker = &result->workers[i];
+
+		memset(worker, 0, sizeof(struct cdp_worker));
+		worker->id = i;
+		worker->verbose = verbose;
+		worker->stop_fd = result->stop_fd;
+		worker->changed_fd = result->changed_fd;
+		pthread_mutex_init(&worker->lock, NULL);
+		result->count++;
+
+		worker->socket = cdp_packet_socket_new();
+		if (worker->socket == NULL || cdp_packet_socket_join_fanout(worker->socket, group_id, count) < 0)
+		{
+			cdp_worker_pool_delete(result);
+			return NULL;
+		}
+
+		worker->neighbors = cdp_neighbor_list_new();
+		worker->interfaces = cdp_interface_list_new();
+		if (worker->neighbors == NULL || worker->interfaces == NULL)
+		{
+			cdp_worker_pool_delete(result);
+			return NULL;
+		}
+	}
+
+	return result;
+}
+
+void cdp_worker_pool_delete(struct cdp_worker_pool *pool)
+{
+	const uint64_t stop = 1;
+	unsigned int received;
+	unsigned int dropped;
+	unsigned int i;
+
+	if (pool == NULL)
+	{
+		LOG_CRITICAL("cdp_worker_pool_delete: pool is NULL\n");
+		return;
+	}
+
+	if (write(pool->stop_fd, &stop, sizeof(stop)) < 0)
+		LOG_ERROR("cdp_worker_pool_delete: failed to signal the workers (%s)\n", strerror(errno));
+
+	for (i = 0; i < pool->count; i++)
+	{
+		struct cdp_worker *worker = &pool->workers[i];
+
+		if (worker->started)
+			pthread_join(worker->thread, NULL);
+
+		if (worker->verbose && worker->socket != NULL && cdp_packet_socket_get_statistics(worker->socket, &received, &dropped) == 0)
+			LOG_INFORMATIONAL("cdp: worker %u processed %lu frames, %u dropped by the kernel\n", worker->id, worker->frames, dropped);
+
+		if (worker->socket != NULL)
+			cdp_packet_socket_delete(worker->socket);
+
+		if (worker->neighbors != NULL)
+			cdp_neighbor_list_clean_and_delete(worker->neighbors);
+
+		if (worker->interfaces != NULL)
+			cdp_interface_list_delete(worker->interfaces);
+
+		if (worker->pending_interfaces != NULL)
+			cdp_interface_list_delete(worker->pending_interfaces);
+
+		pthread_mutex_destroy(&worker->lock);
+	}
+
+	if (pool->workers != NULL)
+		FREE_ARRAY(pool->workers);
+
+	close(pool->stop_fd);
+	close(pool->changed_fd);
+	FREE(pool);
+}
+
+int cdp_worker_pool_start(struct cdp_worker_pool *pool)
+{
+	unsigned int i;
+	int rc;
+
+	if (pool == NULL)
+	{
+		LOG_CRITICAL("cdp_worker_pool_start: pool is NULL\n");
+		return -1;
+	}
+
+	for (i = 0; i < pool->count; i++)
+	{
+		struct cdp_worker *worker = &pool->workers[i];
+
+		rc = pthread_create(&worker->thread, NULL, cdp_worker_run, worker);
+		if (rc != 0)
+		{
+			LOG_ERROR("cdp_worker_pool_start: failed to start worker %u (%s)\n", i, strerror(rc));
+			return -1;
+		}
+
+		worker->started = true;
+	}
+
+	return 0;
+}
+
+int cdp_worker_pool_join(struct cdp_worker_pool *pool, int ifindex)
+{
+	unsigned int i;
+
+	if (pool == NULL)
+	{
+		LOG_CRITICAL("cdp_worker_pool_join: pool is NULL\n");
+		return -1;
+	}
+
+	/* The membership is per socket, every member joins so that the group doesn't depend on one */
+	for (i = 0; i < pool->count; i++)
+	{
+		if (cdp_packet_socket_join(pool->workers[i].socket, ifindex) < 0)
+			return -1;
+	}
+
+	return 0;
+}
+
+int cdp_worker_pool_refresh_interfaces(struct cdp_worker_pool *pool)
+{
+	struct cdp_interface_list *interfaces;
+	unsigned int i;
+
+	if (pool == NULL)
+	{
+		LOG_CRITICAL("cdp_worker_pool_refresh_interfaces: pool is NULL\n");
+		return -1;
+	}
+
+	for (i = 0; i < pool->count; i++)
+	{
+		interfaces = cdp_interface_list_new();
+		if (interfaces == NULL)
+			return -1;
+
+		/* Replaces a list the worker hasn't picked up yet */
+		interfaces = __atomic_exchange_n(&pool->workers[i].pending_interfaces, interfaces, __ATOMIC_ACQ_REL);
+		if (interfaces != NULL)
+			cdp_interface_list_delete(interfaces);
+	}
+
+	return 0;
+}
+
+int cdp_worker_pool_restore(struct cdp_worker_pool *pool, struct cdp_neighbor_list *neighbors)
+{
+	struct cdp_neighbor *neighbor;
+	struct cdp_worker *worker;
+	int result = 0;
+
+	if (pool == NULL)
+	{
+		LOG_CRITICAL("cdp_worker_pool_restore: pool is NULL\n");
+		return -1;
+	}
+
+	if (neighbors == NULL)
+	{
+		LOG_CRITICAL("cdp_worker_pool_restore: neighbors is NULL\n");
+		return -1;
+	}
+
+	while ((neighbor = cdp_neighbor_list_take_first(neighbors)) != NULL)
+	{
+		worker = &pool->workers[cdp_packet_socket_fanout_member(neighbor->device_index, pool->count)];
+
+		pthread_mutex_lock(&worker->lock);
+		if (cdp_neighbor_list_append(worker->neighbors, neighbor) < 0)
+			cdp_neighbor_delete(neighbor);
+		else
+			result++;
+		pthread_mutex_unlock(&worker->lock);
+	}
+
+	return result;
+}
+
+ssize_t cdp_worker_pool_snapshot(struct cdp_worker_pool *pool, uint8_t **result)
+{
+	const struct cdp_neighbor *neighbor;
+	uint8_t *buffer = NULL;
+	size_t length = 0;
+	size_t position = 0;
+	ssize_t record_length;
+	bool failed = false;
+	unsigned int i;
+
+	if (pool == NULL)
+	{
+		LOG_CRITICAL("cdp_worker_pool_snapshot: pool is NULL\n");
+		return -1;
+	}
+
+	if (result == NULL)
+	{
+		LOG_CRITICAL("cdp_worker_pool_snapshot: result is NULL\n");
+		return -1;
+	}
+
+	*result = NULL;
+
+	/* Locked in index order, workers only ever take their own lock so this can't deadlock */
+	for (i = 0; i < pool->count; i++)
+		pthread_mutex_lock(&pool->workers[i].lock);
+
+	for (i = 0; i < pool->count; i++)
+	{
+		for (neighbor = pool->workers[i].neighbors->head; neighbor != NULL; neighbor = neighbor->next)
+		{
+			record_length = cdp_neighbor_record_length(neighbor);
+			if (record_length > 0)
+				length += (size_t)record_length;
+		}
+	}
+
+	if (length > 0)
+	{
+		buffer = ALLOC_NEW_ARRAY(uint8_t, length);
+		if (buffer == NULL)
+		{
+			LOG_CRITICAL("cdp_worker_pool_snapshot: failed to allocate the snapshot\n");
+			failed = true;
+		}
+	}
+
+	for (i = 0; i < pool->count && buffer != NULL; i++)
+	{
+		for (neighbor = pool->workers[i].neighbors->head; neighbor != NULL; neighbor = neighbor->next)
+		{
+			record_length = cdp_neighbor_record_serialize(neighbor, buffer + position, length - position);
+			if (record_length > 0)
+				position += (size_t)record_length;
+		}
+	}
+
+	for (i = pool->count; i > 0; i--)
+		pthread_mutex_unlock(&pool->workers[i - 1].lock);
+
+	if (failed)
+		return -1;
+
+	*result = buffer;
+
+	return (ssize_t)position;
+}
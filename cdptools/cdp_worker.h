@@ -0,0 +1,142 @@
+#ifndef CDP_WORKER_H
+#define CDP_WORKER_H
+
+#include <pthread.h>
+
+#include "cdp_interface.h"
+#include "cdp_packet_socket.h"
+#include "../libcdp/cdp_neighbor.h"
+
+/** A receive thread which owns one shard of the neighbor table. The shard holds the neighbors of
+  *  the interfaces the fanout group assigns to the worker's socket, so no two workers ever touch
+  *  the same neighbor.
+  */
+struct cdp_worker
+{
+	/** The index of the worker within its pool */
+	unsigned int id;
+
+	/** The thread running the worker */
+	pthread_t thread;
+
+	/** Whether the thread was started */
+	bool started;
+
+	/** The socket receiving the worker's share of the frames */
+	struct cdp_packet_socket *socket;
+
+	/** The worker's shard of the neighbor table */
+	struct cdp_neighbor_list *neighbors;
+
+	/** Held by the worker while it modifies its shard and by readers taking a snapshot */
+	pthread_mutex_t lock;
+
+	/** The interfaces as last seen by the worker, only accessed by the worker thread */
+	struct cdp_interface_list *interfaces;
+
+	/** A newer interface list handed over by the main thread, exchanged atomically */
+	struct cdp_interface_list *pending_interfaces;
+
+	/** The pool's eventfd which becomes readable when the worker should exit */
+	int stop_fd;
+
+	/** The pool's eventfd which the worker signals when its shard changed */
+	int changed_fd;
+
+	/** The monotonic time the worker last signalled changed_fd (seconds) */
+	time_t notified_at;
+
+	/** Whether frames refreshed neighbors without changing them since changed_fd was signalled */
+	bool refresh_pending;
+
+	/** The number of CDP frames processed by the worker */
+	unsigned long frames;
+
+	/** Whether to log every neighbor change */
+	bool verbose;
+};
+
+/** A set of workers sharing a fanout group */
+struct cdp_worker_pool
+{
+	/** The workers */
+	struct cdp_worker *workers;
+
+	/** The number of workers */
+	unsigned int count;
+
+	/** An eventfd which becomes readable when the workers should exit */
+	int stop_fd;
+
+	/** An eventfd which becomes readable when a shard changed. Neighbors which are only refreshed
+	  * by a frame identical to the last one are signalled at most once a second.
+	  */
+	int changed_fd;
+};
+
+/** Stores a received frame in a neighbor table, logging the neighbor if it's new or changed.
+  *  @param neighbors The neighbor table to store the frame in.
+  *  @param interfaces The interfaces used to name the interface the frame was received on.
+  *  @param frame The received frame.
+  *  @param verbose Whether to log new and changed neighbors.
+  *  @return true if the neighbor is new or its frame changed, false if it was only refreshed.
+  */
+bool cdp_worker_store_frame(
+	struct cdp_neighbor_list *neighbors,
+	const struct cdp_interface_list *interfaces,
+	const struct cdp_received_frame *frame,
+	bool verbose
+);
+
+/** Constructor, creates the sockets of the workers and joins them to a new fanout group. The
+  *  threads are not started.
+  *  @param count The number of workers.
+  *  @param verbose Whether the workers should log new and changed neighbors.
+  *  @return Either the new pool or NULL on error.
+  */
+struct cdp_worker_pool *cdp_worker_pool_new(unsigned int count, bool verbose);
+
+/** Destructor, stops and joins the worker threads if they were started.
+  *  @param pool The pool to delete.
+  */
+void cdp_worker_pool_delete(struct cdp_worker_pool *pool);
+
+/** Starts the worker threads.
+  *  @param pool The pool object.
+  *  @return 0 on success or a negative value on error.
+  */
+int cdp_worker_pool_start(struct cdp_worker_pool *pool);
+
+/** Subscribes an interface to the CDP multicast MAC address.
+  *  @param pool The pool object.
+  *  @param ifindex The interface index to subscribe.
+  *  @return 0 on success or a negative value on error.
+  */
+int cdp_worker_pool_join(struct cdp_worker_pool *pool, int ifindex);
+
+/** Hands a freshly enumerated interface list to every worker. Each worker needs a list of its
+  *  own, so the interfaces are enumerated once per worker.
+  *  @param pool The pool object.
+  *  @return 0 on success or a negative value on error.
+  */
+int cdp_worker_pool_refresh_interfaces(struct cdp_worker_pool *pool);
+
+/** Hands previously saved neighbors to the workers. Each neighbor goes to the shard of the worker
+  *  which receives the frames of its interface, so that the next frame from the neighbor refreshes
+  *  the restored entry instead of creating a second one.
+  *  @param pool The pool object.
+  *  @param neighbors The neighbors to restore, named after their interfaces. The list is emptied.
+  *  @return The number of neighbors restored or a negative value on error.
+  */
+int cdp_worker_pool_restore(struct cdp_worker_pool *pool, struct cdp_neighbor_list *neighbors);
+
+/** Takes a consistent snapshot of the whole neighbor table as a sequence of neighbor records
+  *  (see cdp_neighbor_record.h). Every shard is locked while the snapshot is taken so that it
+  *  represents a single point in time.
+  *  @param pool The pool object.
+  *  @param result The location to store the newly allocated buffer, to be released with FREE_ARRAY.
+  *  @return The length of the snapshot in bytes or a negative value on error.
+  */
+ssize_t cdp_worker_pool_snapshot(struct cdp_worker_pool *pool, uint8_t **result);
+
+#endif
@@ -1,3 +1,8 @@
+#include "cdp_daemon.h"
+#include "cdp_flood.h"
+#include "cdp_generate.h"
+#include "cdp_neighbors.h"
+#include "cdp_pcap.h"
 #include "../libcdp/cdp_packet.h"
 #include "../libcdp/cdp_packet_parser.h"
 #include "../libcdp/ecdptlv.h"
@@ -10,7 +15,10 @@
 /** This is the software version string sent to all CDP neighbors to describe this device */
 static char *cdp_software_version_string = NULL;
 
-int main()
+/** Builds a CDP frame, serializes it and parses it back again.
+  *  @return 0 on success or a negative value on error.
+  */
+static int cdp_round_trip_demo(void)
 {
 	struct cdp_packet *eth0;
 
@@ -126,3 +134,23 @@ int main()
 
 	return rc;
 }
+
+int main(int argc, char **argv)
+{
+	if (argc > 1 && strcmp(argv[1], "daemon") == 0)
+		return cdp_daemon_main(argc - 1, argv + 1);
+
+	if (argc > 1 && strcmp(argv[1], "flood") == 0)
+		return cdp_flood_main(argc - 1, argv + 1);
+
+	if (argc > 1 && strcmp(argv[1], "generate") == 0)
+		return cdp_generate_main(argc - 1, argv + 1);
+
+	if (argc > 1 && strcmp(argv[1], "neighbors") == 0)
+		return cdp_neighbors_main(argc - 1, argv + 1);
+
+	if (argc > 1 && strcmp(argv[1], "pcap") == 0)
+		return cdp_pcap_main(argc - 1, argv + 1);
+
+	return cdp_round_trip_demo();
+}
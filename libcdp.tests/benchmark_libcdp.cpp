@@ -0,0 +1,344 @@
+#include <benchmark/benchmark.h>
+
+#include <vector>
+
+extern "C" {
+#include "../libcdp/cdp_neighbor.h"
+#include "../libcdp/cdp_packet.h"
+#include "../libcdp/cdp_packet_parser.h"
+#include "../libcdp/ip_address_array.h"
+#include "../libcdp/stream_reader.h"
+#include "../libcdp/platform/checksum.h"
+#include "../libcdp/platform/platform.h"
+}
+
+#include "cdp_sample_data.h"
+
+/* The benchmark is linked with --wrap=malloc and --wrap=free, so every allocation made by libcdp
+ * passes through here and is counted. C++ allocations inside the benchmark library itself go
+ * through libstdc++ and aren't affected.
+ */
+static size_t benchmark_allocations = 0;
+
+extern "C" {
+void *__real_malloc(size_t size);
+void __real_free(void *pointer);
+
+void *__wrap_malloc(size_t size)
+{
+	benchmark_allocations++;
+	return __real_malloc(size);
+}
+
+void __wrap_free(void *pointer)
+{
+	__real_free(pointer);
+}
+}
+
+/// Reports the allocations made since the benchmark started as allocations/op
+static void report_allocations(benchmark::State &state, size_t allocations_at_start)
+{
+	state.counters["allocs/op"] = benchmark::Counter(
+		(double)(benchmark_allocations - allocations_at_start),
+		benchmark::Counter::kAvgIterations
+	);
+}
+
+/// The frames parsed by the benchmarks, the samples captured from real devices followed by generated ones
+static std::vector<std::vector<uint8_t>> benchmark_frames;
+
+/// The names of the frames, used as benchmark labels
+static std::vector<std::string> benchmark_frame_names;
+
+/// Generates an advertisement frame with the given number of IPv4 addresses
+static void generate_frame(int address_count)
+{
+	struct ip_address_array *addresses = ip_address_array_new(address_count);
+	std::string software_version(1000, 'v');
+	std::vector<uint8_t> frame(16384);
+
+	for (int i = 0; i < address_count; i++)
+		ip_address_array_set_into_ipv4_uint32(addresses, i, 0x0A000001 + i);
+
+	struct cdp_packet *packet = cdp_packet_new_advertisement(
+		"GigabitEthernet1/0/1",
+		"generated.test.local",
+		"cisco WS-C3850-48P",
+		software_version.c_str(),
+		addresses
+	);
+
+	ssize_t length = cdp_packet_serialize(packet, frame.data(), frame.size());
+	frame.resize(length > 0 ? length : 0);
+
+	benchmark_frames.push_back(frame);
+	benchmark_frame_names.push_back("generated/" + std::to_string(address_count) + " addresses");
+
+	cdp_packet_delete(packet);
+	ip_address_array_clear_and_delete(addresses);
+}
+
+static void create_frames()
+{
+	benchmark_frames.push_back(std::vector<uint8_t>(cdp_sample_data_csr1000v, cdp_sample_data_csr1000v + sizeof(cdp_sample_data_csr1000v)));
+	benchmark_frame_names.push_back("csr1000v");
+
+	benchmark_frames.push_back(std::vector<uint8_t>(cdp_sample_data_2960g_ios15_0_1_se3, cdp_sample_data_2960g_ios15_0_1_se3 + sizeof(cdp_sample_data_2960g_ios15_0_1_se3)));
+	benchmark_frame_names.push_back("2960g");
+
+	generate_frame(1);
+	generate_frame(16);
+	generate_frame(64);
+}
+
+/// Parsing a received frame into a packet object
+static void BM_ParsePacket(benchmark::State &state) {
+	const std::vector<uint8_t> &frame = benchmark_frames[state.range(0)];
+	size_t allocations_at_start = benchmark_allocations;
+
+	for (auto _ : state)
+	{
+		struct stream_reader *reader = stream_reader_new(frame.data(), frame.size());
+		struct cdp_packet *packet = NULL;
+
+		benchmark::DoNotOptimize(cdp_parse_packet(reader, &packet));
+
+		cdp_packet_delete(packet);
+		stream_reader_delete(reader);
+	}
+
+	report_allocations(state, allocations_at_start);
+	state.SetBytesProcessed(state.iterations() * frame.size());
+	state.SetLabel(benchmark_frame_names[state.range(0)]);
+}
+BENCHMARK(BM_ParsePacket)->DenseRange(0, 4);
+
+/// Serializing a parsed packet object back into a frame
+static void BM_SerializePacket(benchmark::State &state) {
+	const std::vector<uint8_t> &frame = benchmark_frames[state.range(0)];
+	struct stream_reader *reader = stream_reader_new(frame.data(), frame.size());
+	struct cdp_packet *packet = NULL;
+	std::vector<uint8_t> buffer(16384);
+
+	cdp_parse_packet(reader, &packet);
+	stream_reader_delete(reader);
+
+	if (packet == NULL)
+	{
+		state.SkipWithError("the frame can't be parsed");
+		return;
+	}
+
+	size_t allocations_at_start = benchmark_allocations;
+
+	for (auto _ : state)
+		benchmark::DoNotOptimize(cdp_packet_serialize(packet, buffer.data(), buffer.size()));
+
+	report_allocations(state, allocations_at_start);
+	state.SetBytesProcessed(state.iterations() * frame.size());
+	state.SetLabel(benchmark_frame_names[state.range(0)]);
+
+	cdp_packet_delete(packet);
+}
+BENCHMARK(BM_SerializePacket)->DenseRange(0, 4);
+
+/// Building an advertisement from scratch as the daemon does for every interface
+static void BM_CreatePacket(benchmark::State &state) {
+	struct ip_address_array *addresses = ip_address_array_new(state.range(0));
+	int8_t buffer[1500];
+
+	for (int i = 0; i < state.range(0); i++)
+		ip_address_array_set_into_ipv4_uint32(addresses, i, 0x0A000001 + i);
+
+	size_t allocations_at_start = benchmark_allocations;
+
+	for (auto _ : state)
+	{
+		benchmark::DoNotOptimize(cdp_create_packet(
+			"GigabitEthernet1",
+			cdp_sample_data_csr1000v_device_id,
+			cdp_sample_data_csr1000v_platform,
+			cdp_sample_data_csr1000v_software_version,
+			addresses,
+			buffer,
+			sizeof(buffer)
+		));
+	}
+
+	report_allocations(state, allocations_at_start);
+
+	ip_address_array_clear_and_delete(addresses);
+}
+BENCHMARK(BM_CreatePacket)->Arg(1)->Arg(16);
+
+/// The CDP checksum over a frame
+static void BM_ComputeChecksum(benchmark::State &state) {
+	const std::vector<uint8_t> &frame = benchmark_frames[state.range(0)];
+	size_t allocations_at_start = benchmark_allocations;
+
+	for (auto _ : state)
+		benchmark::DoNotOptimize(ip_compute_csum(frame.data(), frame.size()));
+
+	report_allocations(state, allocations_at_start);
+	state.SetBytesProcessed(state.iterations() * frame.size());
+	state.SetLabel(benchmark_frame_names[state.range(0)]);
+}
+BENCHMARK(BM_ComputeChecksum)->DenseRange(0, 4);
+
+/// Reading a string TLV value of the given length
+static void BM_ReaderGetString(benchmark::State &state) {
+	std::vector<uint8_t> data(state.range(0), 'x');
+	size_t allocations_at_start = benchmark_allocations;
+
+	for (auto _ : state)
+	{
+		struct stream_reader *reader = stream_reader_new(data.data(), data.size());
+		char *result = NULL;
+
+		benchmark::DoNotOptimize(stream_reader_get_string(reader, &result, data.size()));
+
+		FREE_ARRAY(result);
+		stream_reader_delete(reader);
+	}
+
+	report_allocations(state, allocations_at_start);
+	state.SetBytesProcessed(state.iterations() * data.size());
+}
+BENCHMARK(BM_ReaderGetString)->Arg(16)->Arg(256)->Arg(1024);
+
+/// The MAC address of the neighbor at the given index in a generated table
+static void neighbor_table_mac(int index, unsigned char *mac)
+{
+	mac[0] = 0x00;
+	mac[1] = 0x1e;
+	mac[2] = (unsigned char)(index >> 24);
+	mac[3] = (unsigned char)(index >> 16);
+	mac[4] = (unsigned char)(index >> 8);
+	mac[5] = (unsigned char)index;
+}
+
+/// Generates a neighbor table with the given number of neighbors received at the given time, spread over 16 interfaces
+static struct cdp_neighbor_list *create_neighbor_table(int count, struct timespec received_at)
+{
+	struct cdp_neighbor_list *neighbors = cdp_neighbor_list_new();
+	unsigned char mac[6];
+
+	for (int i = 0; i < count; i++)
+	{
+		struct cdp_neighbor *neighbor = cdp_neighbor_new();
+
+		neighbor_table_mac(i, mac);
+		cdp_neighbor_set_device_index(neighbor, i % 16 + 2);
+		cdp_neighbor_set_remote_mac(neighbor, mac, sizeof(mac));
+		cdp_neighbor_set_received_at(neighbor, received_at);
+		cdp_neighbor_set_frame_buffer(neighbor, cdp_sample_data_csr1000v, sizeof(cdp_sample_data_csr1000v));
+		cdp_neighbor_list_append(neighbors, neighbor);
+	}
+
+	return neighbors;
+}
+
+/// Finding a neighbor by identity, cycling through every neighbor of the table
+static void BM_NeighborLookup(benchmark::State &state) {
+	struct timespec received_at = { 1546300800, 0 };
+	struct cdp_neighbor_list *neighbors = create_neighbor_table(state.range(0), received_at);
+	unsigned char mac[6];
+	int index = 0;
+	size_t allocations_at_start = benchmark_allocations;
+
+	for (auto _ : state)
+	{
+		neighbor_table_mac(index, mac);
+		benchmark::DoNotOptimize(cdp_neighbor_list_get_by_identity(neighbors, index % 16 + 2, cdp_neighbor_pack_mac(mac)));
+
+		index = (index + 7919) % state.range(0);
+	}
+
+	report_allocations(state, allocations_at_start);
+
+	cdp_neighbor_list_clean_and_delete(neighbors);
+}
+BENCHMARK(BM_NeighborLookup)->Arg(10)->Arg(1000)->Arg(100000);
+
+/// Inserting a new neighbor into a table of the given size, the neighbor is removed again to keep the size constant
+static void BM_NeighborInsert(benchmark::State &state) {
+	struct timespec received_at = { 1546300800, 0 };
+	struct cdp_neighbor_list *neighbors = create_neighbor_table(state.range(0), received_at);
+	unsigned char mac[6];
+	size_t allocations_at_start = benchmark_allocations;
+
+	neighbor_table_mac(-1, mac);
+
+	for (auto _ : state)
+	{
+		struct cdp_neighbor *neighbor = cdp_neighbor_list_get_or_create_by_identity(neighbors, 1, 2, cdp_neighbor_pack_mac(mac));
+
+		cdp_neighbor_set_received_at(neighbor, received_at);
+		cdp_neighbor_set_frame_buffer(neighbor, cdp_sample_data_csr1000v, sizeof(cdp_sample_data_csr1000v));
+
+		cdp_neighbor_list_remove_item(neighbors, neighbor);
+		cdp_neighbor_delete(neighbor);
+	}
+
+	report_allocations(state, allocations_at_start);
+
+	cdp_neighbor_list_clean_and_delete(neighbors);
+}
+BENCHMARK(BM_NeighborInsert)->Arg(10)->Arg(1000)->Arg(100000);
+
+/// Purging a table of the given size when none of the neighbors have expired, which is the periodic case
+static void BM_NeighborPurgeNone(benchmark::State &state) {
+	struct timespec received_at = { 1546300800, 0 };
+	struct timespec now = { 1546300860, 0 };
+	struct cdp_neighbor_list *neighbors = create_neighbor_table(state.range(0), received_at);
+	size_t allocations_at_start = benchmark_allocations;
+
+	for (auto _ : state)
+		benchmark::DoNotOptimize(cdp_neighbor_list_purge_expired_neighbors(neighbors, now));
+
+	report_allocations(state, allocations_at_start);
+
+	cdp_neighbor_list_clean_and_delete(neighbors);
+}
+BENCHMARK(BM_NeighborPurgeNone)->Arg(10)->Arg(1000)->Arg(100000);
+
+/// Purging a table of the given size when every neighbor has expired, the table is rebuilt outside of the timing
+static void BM_NeighborPurgeAll(benchmark::State &state) {
+	struct timespec received_at = { 1546300800, 0 };
+	struct timespec now = { 1546301800, 0 };
+	size_t allocations = 0;
+
+	for (auto _ : state)
+	{
+		state.PauseTiming();
+		struct cdp_neighbor_list *neighbors = create_neighbor_table(state.range(0), received_at);
+		size_t allocations_at_start = benchmark_allocations;
+		state.ResumeTiming();
+
+		benchmark::DoNotOptimize(cdp_neighbor_list_purge_expired_neighbors(neighbors, now));
+
+		state.PauseTiming();
+		allocations += benchmark_allocations - allocations_at_start;
+		cdp_neighbor_list_delete(neighbors);
+		state.ResumeTiming();
+	}
+
+	state.counters["allocs/op"] = benchmark::Counter((double)allocations, benchmark::Counter::kAvgIterations);
+	state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_NeighborPurgeAll)->Arg(10)->Arg(1000)->Arg(100000);
+
+int main(int argc, char **argv)
+{
+	create_frames();
+
+	benchmark::Initialize(&argc, argv);
+	if (benchmark::ReportUnrecognizedArguments(argc, argv))
+		return 1;
+
+	benchmark::RunSpecifiedBenchmarks();
+	benchmark::Shutdown();
+
+	return 0;
+}
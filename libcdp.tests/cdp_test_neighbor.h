@@ -0,0 +1,31 @@
+#pragma once
+
+extern "C" {
+#include "../libcdp/cdp_neighbor.h"
+}
+
+#include "cdp_sample_data.h"
+
+// The remote MAC address of the neighbors created by create_test_neighbor
+static const unsigned char test_remote_mac[6] = { 0x00, 0x1e, 0x49, 0x12, 0x34, 0x56 };
+
+// The time the neighbors created by create_test_neighbor were received
+static const time_t test_received_at_seconds = 1546300800;
+static const long test_received_at_nanoseconds = 123456789;
+
+// Creates a neighbor on the given interface holding the CSR1000v sample frame
+static struct cdp_neighbor *create_test_neighbor(int device_index)
+{
+	struct cdp_neighbor *neighbor = cdp_neighbor_new();
+	struct timespec received_at;
+
+	received_at.tv_sec = test_received_at_seconds;
+	received_at.tv_nsec = test_received_at_nanoseconds;
+
+	cdp_neighbor_set_device_index(neighbor, device_index);
+	cdp_neighbor_set_remote_mac(neighbor, test_remote_mac, sizeof(test_remote_mac));
+	cdp_neighbor_set_received_at(neighbor, received_at);
+	cdp_neighbor_set_frame_buffer(neighbor, cdp_sample_data_csr1000v, sizeof(cdp_sample_data_csr1000v));
+
+	return neighbor;
+}
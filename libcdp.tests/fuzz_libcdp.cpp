@@ -0,0 +1,358 @@
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include <dirent.h>
+#include <sys/stat.h>
+
+extern "C" {
+#include "../libcdp/cdp_packet.h"
+#include "../libcdp/cdp_packet_parser.h"
+#include "../libcdp/ip_address_array.h"
+#include "../libcdp/stream_reader.h"
+#include "../libcdp/platform/platform.h"
+}
+
+#include "cdp_sample_data.h"
+
+/* libcdpfuzz feeds arbitrary frames to cdp_parse_packet and round trips every frame which parses through
+ * cdp_packet_serialize and the parser again. Built with clang it is a libFuzzer target, other compilers get
+ * the standalone driver at the end of the file which replays files and mutates the sample frames. Both report
+ * the executions per second and the slowest input, so a parser change shows its speed and its hardening
+ * together and an input which suddenly takes far longer than the rest is reported as soon as it's found.
+ */
+
+/// An input taking longer than this is reported as soon as it has run
+static const int64_t fuzz_slow_input_us = 10000;
+
+/// The number of executions between throughput reports
+static const uint64_t fuzz_report_interval = 1 << 18;
+
+static uint64_t fuzz_executions = 0;
+static int64_t fuzz_slowest_us = 0;
+static size_t fuzz_slowest_size = 0;
+static std::chrono::steady_clock::time_point fuzz_started_at;
+
+/// Prints the executions per second since the start and the slowest input seen
+static void fuzz_report(const char *when)
+{
+	double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - fuzz_started_at).count();
+
+	fprintf(
+		stderr,
+		"libcdpfuzz: %s %llu execs, %.0f execs/s, slowest input %lld us (%zu bytes)\n",
+		when,
+		(unsigned long long)fuzz_executions,
+		seconds > 0 ? fuzz_executions / seconds : 0.0,
+		(long long)fuzz_slowest_us,
+		fuzz_slowest_size
+	);
+}
+
+static void fuzz_report_at_exit()
+{
+	fuzz_report("done");
+}
+
+/// Serializes a packet, parses the frame and serializes the result, which must produce the same frame
+static void fuzz_round_trip(const struct cdp_packet *packet)
+{
+	// Packets lacking the TLVs required for sending can't be serialized, which isn't an error
+	ssize_t size = cdp_packet_serialized_size(packet);
+	if (size < 0)
+		return;
+
+	std::vector<uint8_t> frame((size_t)size);
+	ssize_t length = cdp_packet_serialize(packet, frame.data(), frame.size());
+	if (length == CDP_ERROR_MISSING_FIELD)
+		return;
+
+	if (length != size)
+	{
+		fprintf(stderr, "libcdpfuzz: serialized %lld bytes, cdp_packet_serialized_size measured %lld\n", (long long)length, (long long)size);
+		abort();
+	}
+
+	struct stream_reader *reader = stream_reader_new(frame.data(), frame.size());
+	struct cdp_packet *reparsed = NULL;
+	int rc = cdp_parse_packet(reader, &reparsed);
+	if (rc < 0)
+	{
+		fprintf(
+			stderr,
+			"libcdpfuzz: a serialized packet failed to parse, %s at offset %lld\n",
+			cdp_error_name(rc),
+			(long long)stream_reader_get_error_position(reader)
+		);
+		abort();
+	}
+	stream_reader_delete(reader);
+
+	std::vector<uint8_t> again((size_t)size);
+	length = cdp_packet_serialize(reparsed, again.data(), again.size());
+	cdp_packet_delete(reparsed);
+
+	if (length != size || memcmp(frame.data(), again.data(), frame.size()) != 0)
+	{
+		fprintf(stderr, "libcdpfuzz: a round trip through the parser changed the serialized packet\n");
+		abort();
+	}
+}
+
+/// Runs the validation functions, the parser and the round trip on an input
+static void fuzz_run(const uint8_t *data, size_t size)
+{
+	cdp_frame_checksum_is_valid(data, size);
+	cdp_frame_is_well_formed(data, size);
+
+	struct stream_reader *reader = stream_reader_new(data, size);
+	if (reader == NULL)
+		return;
+
+	struct cdp_packet *packet = NULL;
+	if (cdp_parse_packet(reader, &packet) == 0)
+	{
+		fuzz_round_trip(packet);
+		cdp_packet_delete(packet);
+	}
+
+	stream_reader_delete(reader);
+}
+
+/// Runs an input and returns how long it took in microseconds
+static int64_t fuzz_timed_run(const uint8_t *data, size_t size)
+{
+	std::chrono::steady_clock::time_point started_at = std::chrono::steady_clock::now();
+
+	fuzz_run(data, size);
+
+	return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - started_at).count();
+}
+
+/// Runs one input, timing it. A slow input is run a second time and only reported if it is slow again, so that
+/// being preempted doesn't make an input look slow.
+static void fuzz_one_input(const uint8_t *data, size_t size)
+{
+	int64_t elapsed_us = fuzz_timed_run(data, size);
+
+	if (elapsed_us >= fuzz_slow_input_us)
+	{
+		int64_t again_us = fuzz_timed_run(data, size);
+		if (again_us < elapsed_us)
+			elapsed_us = again_us;
+
+		if (elapsed_us >= fuzz_slow_input_us)
+			fprintf(stderr, "libcdpfuzz: slow input, %lld us for %zu bytes\n", (long long)elapsed_us, size);
+	}
+
+	if (elapsed_us > fuzz_slowest_us)
+	{
+		fuzz_slowest_us = elapsed_us;
+		fuzz_slowest_size = size;
+	}
+
+	if (++fuzz_executions % fuzz_report_interval == 0)
+		fuzz_report("after");
+}
+
+/// The frames the corpus is seeded with, the samples captured from real devices and a generated advertisement
+static std::vector<std::vector<uint8_t>> fuzz_seeds()
+{
+	std::vector<std::vector<uint8_t>> seeds;
+
+	seeds.push_back(std::vector<uint8_t>(cdp_sample_data_csr1000v, cdp_sample_data_csr1000v + sizeof(cdp_sample_data_csr1000v)));
+	seeds.push_back(std::vector<uint8_t>(cdp_sample_data_2960g_ios15_0_1_se3, cdp_sample_data_2960g_ios15_0_1_se3 + sizeof(cdp_sample_data_2960g_ios15_0_1_se3)));
+
+	struct ip_address_array *addresses = ip_address_array_new(4);
+	for (int i = 0; i < 4; i++)
+		ip_address_array_set_into_ipv4_uint32(addresses, i, 0x0A000001 + i);
+
+	struct cdp_packet *packet = cdp_packet_new_advertisement("eth0", "generated.test.local", "cisco WS-C3850-48P", "Software version", addresses);
+	std::vector<uint8_t> frame(4096);
+	ssize_t length = cdp_packet_serialize(packet, frame.data(), frame.size());
+	if (length > 0)
+	{
+		frame.resize((size_t)length);
+		seeds.push_back(frame);
+	}
+
+	cdp_packet_delete(packet);
+	ip_address_array_clear_and_delete(addresses);
+
+	return seeds;
+}
+
+/// Writes the seeds into a corpus directory which is empty so that fuzzing starts from valid frames
+static void fuzz_seed_directory(const char *path)
+{
+	struct stat status;
+	if (stat(path, &status) != 0 || !S_ISDIR(status.st_mode))
+		return;
+
+	DIR *directory = opendir(path);
+	if (directory == NULL)
+		return;
+
+	bool empty = true;
+	for (struct dirent *entry = readdir(directory); entry != NULL; entry = readdir(directory))
+	{
+		if (strcmp(entry->d_name, ".") != 0 && strcmp(entry->d_name, "..") != 0)
+			empty = false;
+	}
+	closedir(directory);
+
+	if (!empty)
+		return;
+
+	std::vector<std::vector<uint8_t>> seeds = fuzz_seeds();
+	for (size_t i = 0; i < seeds.size(); i++)
+	{
+		std::string name = std::string(path) + "/seed" + std::to_string(i);
+		FILE *file = fopen(name.c_str(), "wb");
+		if (file == NULL)
+			continue;
+
+		fwrite(seeds[i].data(), 1, seeds[i].size(), file);
+		fclose(file);
+	}
+}
+
+static void fuzz_initialize()
+{
+	fuzz_started_at = std::chrono::steady_clock::now();
+	atexit(fuzz_report_at_exit);
+}
+
+#ifndef CDP_FUZZ_STANDALONE
+
+extern "C" int LLVMFuzzerInitialize(int *argc, char ***argv)
+{
+	fuzz_initialize();
+
+	// The first argument which isn't a flag is the corpus directory
+	for (int i = 1; i < *argc; i++)
+	{
+		if ((*argv)[i][0] != '-')
+		{
+			fuzz_seed_directory((*argv)[i]);
+			break;
+		}
+	}
+
+	return 0;
+}
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size)
+{
+	fuzz_one_input(data, size);
+
+	return 0;
+}
+
+#else
+
+/// A xorshift generator, so that a standalone run is repeatable with -seed=
+static uint64_t fuzz_random_state = 88172645463325252ull;
+
+static uint64_t fuzz_random()
+{
+	fuzz_random_state ^= fuzz_random_state << 13;
+	fuzz_random_state ^= fuzz_random_state >> 7;
+	fuzz_random_state ^= fuzz_random_state << 17;
+
+	return fuzz_random_state;
+}
+
+/// Flips, overwrites, inserts or removes a few bytes of a frame
+static void fuzz_mutate(std::vector<uint8_t> &frame)
+{
+	int mutations = 1 + (int)(fuzz_random() % 4);
+
+	for (int i = 0; i < mutations; i++)
+	{
+		size_t at = frame.empty() ? 0 : (size_t)(fuzz_random() % frame.size());
+
+		switch (fuzz_random() % 5)
+		{
+			case 0:
+				if (!frame.empty())
+					frame[at] ^= (uint8_t)(1 << (fuzz_random() % 8));
+				break;
+
+			case 1:
+				if (!frame.empty())
+					frame[at] = (uint8_t)fuzz_random();
+				break;
+
+			case 2:
+				frame.insert(frame.begin() + at, (uint8_t)fuzz_random());
+				break;
+
+			case 3:
+				if (!frame.empty())
+					frame.erase(frame.begin() + at);
+				break;
+
+			default:
+				frame.resize(at);
+				break;
+		}
+	}
+}
+
+/// Replays the files given on the command line, then runs -runs= mutations of the seeds
+int main(int argc, char **argv)
+{
+	uint64_t runs = 1000000;
+
+	fuzz_initialize();
+
+	for (int i = 1; i < argc; i++)
+	{
+		if (strncmp(argv[i], "-runs=", 6) == 0)
+		{
+			runs = strtoull(argv[i] + 6, NULL, 10);
+			continue;
+		}
+
+		if (strncmp(argv[i], "-seed=", 6) == 0)
+		{
+			fuzz_random_state = strtoull(argv[i] + 6, NULL, 10) | 1;
+			continue;
+		}
+
+		FILE *file = fopen(argv[i], "rb");
+		if (file == NULL)
+		{
+			fprintf(stderr, "libcdpfuzz: can't open %s\n", argv[i]);
+			return 1;
+		}
+
+		std::vector<uint8_t> frame;
+		uint8_t buffer[4096];
+		size_t read;
+		while ((read = fread(buffer, 1, sizeof(buffer), file)) > 0)
+			frame.insert(frame.end(), buffer, buffer + read);
+		fclose(file);
+
+		fuzz_one_input(frame.data(), frame.size());
+	}
+
+	std::vector<std::vector<uint8_t>> seeds = fuzz_seeds();
+	for (uint64_t run = 0; run < runs; run++)
+	{
+		std::vector<uint8_t> frame = seeds[run % seeds.size()];
+
+		if (run >= seeds.size())
+			fuzz_mutate(frame);
+
+		fuzz_one_input(frame.data(), frame.size());
+	}
+
+	return 0;
+}
+
+#endif
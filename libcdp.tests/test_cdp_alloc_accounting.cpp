@@ -0,0 +1,86 @@
+#include <gtest/gtest.h>
+
+extern "C" {
+#include "../libcdp/cdp_packet.h"
+#include "../libcdp/cdp_packet_parser.h"
+#include "../libcdp/stream_reader.h"
+#include "../libcdp/platform/platform.h"
+}
+
+#include "cdp_sample_data.h"
+
+#ifdef CDP_ALLOC_ACCOUNTING
+
+/// Verify the allocations made to parse a frame, so that a parser change making more of them fails here
+TEST(CdpAllocAccounting, ParsePacketBudget) {
+	struct cdp_alloc_accounting_counters before;
+	struct cdp_alloc_accounting_counters after;
+	struct cdp_alloc_accounting_counters parser;
+
+	struct stream_reader *reader = stream_reader_new(cdp_sample_data_csr1000v, sizeof(cdp_sample_data_csr1000v));
+	struct cdp_packet *packet = NULL;
+
+	cdp_alloc_accounting_get_totals(&before);
+	cdp_alloc_accounting_reset();
+
+	ASSERT_EQ(0, cdp_parse_packet(reader, &packet));
+	ASSERT_NE(nullptr, packet);
+
+	// Strings are copied once, straight from the frame, so the parser frees nothing before it returns
+	cdp_alloc_accounting_get_totals(&after);
+	ASSERT_LE(after.allocations, 14u);
+	ASSERT_EQ(0u, after.frees);
+	ASSERT_GT(after.bytes_in_use, before.bytes_in_use);
+
+	// The packet object itself is allocated by cdp_packet_new
+	ASSERT_EQ(1, cdp_alloc_accounting_get_function("cdp_packet_new", &parser));
+	ASSERT_EQ(1u, parser.allocations);
+	ASSERT_EQ(sizeof(struct cdp_packet), parser.bytes_allocated);
+
+	cdp_packet_delete(packet);
+	stream_reader_delete(reader);
+
+	// Everything is released again, including the reader allocated before the reset
+	cdp_alloc_accounting_get_totals(&after);
+	ASSERT_EQ(after.allocations + 2, after.frees);
+	ASSERT_EQ(before.bytes_in_use - sizeof(struct stream_reader) - sizeof(struct s_buffer_stream), after.bytes_in_use);
+	ASSERT_GE(after.peak_bytes_in_use, before.bytes_in_use + sizeof(struct cdp_packet));
+}
+
+/// Verify that call sites are listed with the memory they still hold
+TEST(CdpAllocAccounting, Sites) {
+	struct cdp_alloc_accounting_counters site;
+
+	cdp_alloc_accounting_reset();
+
+	struct cdp_packet *packet = cdp_packet_new(2, 180, 0);
+	ASSERT_GE(cdp_packet_set_capabilities(packet, CdpCapabilityRouting), 0);
+
+	bool found = false;
+	for (size_t i = 0; i < cdp_alloc_accounting_get_site_count(); i++)
+	{
+		ASSERT_EQ(0, cdp_alloc_accounting_get_site(i, &site));
+		if (strcmp(site.function, "cdp_packet_set_capabilities") != 0)
+			continue;
+
+		ASSERT_NE(nullptr, strstr(site.file, "cdp_packet.c"));
+		ASSERT_EQ(1u, site.allocations);
+		ASSERT_EQ(0u, site.frees);
+		ASSERT_EQ(sizeof(uint32_t), site.bytes_in_use);
+		found = true;
+	}
+	ASSERT_TRUE(found);
+
+	ASSERT_GT(0, cdp_alloc_accounting_get_site(cdp_alloc_accounting_get_site_count(), &site));
+	ASSERT_EQ(0, cdp_alloc_accounting_get_function("no_such_function", &site));
+	ASSERT_EQ(0u, site.allocations);
+
+	cdp_packet_delete(packet);
+
+	ASSERT_EQ(1, cdp_alloc_accounting_get_function("cdp_packet_set_capabilities", &site));
+	ASSERT_EQ(1u, site.frees);
+	ASSERT_EQ(0u, site.bytes_in_use);
+	ASSERT_EQ(sizeof(uint32_t), site.peak_bytes_in_use);
+}
+
+#endif
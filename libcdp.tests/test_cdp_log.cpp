@@ -0,0 +1,50 @@
+#include <gtest/gtest.h>
+
+extern "C" {
+#include "../libcdp/cdp_log.h"
+#include "../libcdp/platform/platform.h"
+}
+
+/// Verify that a call site may log a burst and is then suppressed until its bucket is refilled
+TEST(CdpLog, RateLimitBurst) {
+	struct cdp_log_ratelimit site = { 0, 0, 0 };
+
+	for (int i = 0; i < CDP_LOG_RATELIMIT_BURST; i++)
+		ASSERT_TRUE(cdp_log_ratelimit_acquire(&site, "RateLimitBurst"));
+
+	ASSERT_FALSE(cdp_log_ratelimit_acquire(&site, "RateLimitBurst"));
+	ASSERT_FALSE(cdp_log_ratelimit_acquire(&site, "RateLimitBurst"));
+	ASSERT_EQ(2u, site.suppressed);
+
+	// Moving the refill time into the past refills the bucket and reports the suppressed messages
+	site.refill_at_ms = 0;
+	ASSERT_TRUE(cdp_log_ratelimit_acquire(&site, "RateLimitBurst"));
+	ASSERT_EQ(0u, site.suppressed);
+	ASSERT_EQ(CDP_LOG_RATELIMIT_BURST - 1, site.tokens);
+}
+
+/// Verify that every call site of the logging macros has a bucket of its own
+TEST(CdpLog, RateLimitPerCallSite) {
+	testing::internal::CaptureStderr();
+
+	for (int i = 0; i < CDP_LOG_RATELIMIT_BURST * 3; i++)
+		LOG_ERROR("first site %d\n", i);
+
+	for (int i = 0; i < CDP_LOG_RATELIMIT_BURST * 3; i++)
+		LOG_ERROR("second site %d\n", i);
+
+	std::string output = testing::internal::GetCapturedStderr();
+
+	size_t first = 0;
+	size_t second = 0;
+	for (size_t position = output.find("site"); position != std::string::npos; position = output.find("site", position + 1))
+	{
+		if (output.compare(position - 6, 6, "first ") == 0)
+			first++;
+		else if (output.compare(position - 7, 7, "second ") == 0)
+			second++;
+	}
+
+	ASSERT_EQ((size_t)CDP_LOG_RATELIMIT_BURST, first);
+	ASSERT_EQ((size_t)CDP_LOG_RATELIMIT_BURST, second);
+}
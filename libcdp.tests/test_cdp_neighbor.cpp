@@ -0,0 +1,155 @@
+#include <gtest/gtest.h>
+
+extern "C" {
+#include "../libcdp/cdp_neighbor.h"
+#include "../libcdp/cdp_packet.h"
+#include "../libcdp/platform/platform.h"
+}
+
+#include "cdp_sample_data.h"
+
+static struct cdp_neighbor *append_test_neighbor(struct cdp_neighbor_list *list, unsigned char mac_suffix, time_t received_at_seconds)
+{
+	unsigned char remote_mac[6] = { 0x00, 0x1e, 0x49, 0x00, 0x00, mac_suffix };
+	struct cdp_neighbor *neighbor;
+	struct timespec received_at;
+
+	neighbor = cdp_neighbor_list_get_or_create_by_identity(list, 1, 2, cdp_neighbor_pack_mac(remote_mac));
+
+	received_at.tv_sec = received_at_seconds;
+	received_at.tv_nsec = 0;
+	cdp_neighbor_set_received_at(neighbor, received_at);
+	cdp_neighbor_set_frame_buffer(neighbor, cdp_sample_data_csr1000v, sizeof(cdp_sample_data_csr1000v));
+
+	return neighbor;
+}
+
+/// Verify the list count is maintained as items are added and removed
+TEST(CdpNeighborList, Count) {
+	struct cdp_neighbor_list *list = cdp_neighbor_list_new();
+
+	struct cdp_neighbor *first = append_test_neighbor(list, 1, 1000);
+	struct cdp_neighbor *second = append_test_neighbor(list, 2, 1000);
+	struct cdp_neighbor *third = append_test_neighbor(list, 3, 1000);
+	ASSERT_EQ(3, list->count);
+
+	ASSERT_EQ(first, cdp_neighbor_list_get_by_index(list, 0));
+	ASSERT_EQ(third, cdp_neighbor_list_get_by_index(list, 2));
+	ASSERT_EQ(nullptr, cdp_neighbor_list_get_by_index(list, 3));
+
+	ASSERT_EQ(0, cdp_neighbor_list_remove_item(list, second));
+	ASSERT_EQ(2, list->count);
+	ASSERT_EQ(third, cdp_neighbor_list_get_by_index(list, 1));
+	cdp_neighbor_delete(second);
+
+	cdp_neighbor_list_clean(list);
+	ASSERT_EQ(0, list->count);
+	ASSERT_EQ(nullptr, list->head);
+	ASSERT_EQ(nullptr, list->tail);
+
+	cdp_neighbor_list_delete(list);
+}
+
+/// Verify expired neighbors are moved to another list, including the head and tail of the list
+TEST(CdpNeighborList, TakeExpiredNeighbors) {
+	struct cdp_neighbor_list *list = cdp_neighbor_list_new();
+	struct cdp_neighbor_list *expired = cdp_neighbor_list_new();
+	int hold_time = cdp_sample_data_csr1000v[1];
+	struct timespec now;
+
+	now.tv_sec = 1000 + hold_time;
+	now.tv_nsec = 0;
+
+	append_test_neighbor(list, 1, 1000);
+	struct cdp_neighbor *current = append_test_neighbor(list, 2, now.tv_sec);
+	append_test_neighbor(list, 3, 1000);
+
+	ASSERT_EQ(2, cdp_neighbor_list_take_expired_neighbors(list, now, expired));
+	ASSERT_EQ(1, list->count);
+	ASSERT_EQ(current, list->head);
+	ASSERT_EQ(current, list->tail);
+	ASSERT_EQ(2, expired->count);
+
+	// Nothing left to expire
+	ASSERT_EQ(0, cdp_neighbor_list_take_expired_neighbors(list, now, expired));
+
+	cdp_neighbor_list_clean_and_delete(expired);
+	cdp_neighbor_list_clean_and_delete(list);
+}
+
+/// Verify the next expiry is the earliest of the neighbors and agrees with cdp_neighbor_is_expired
+TEST(CdpNeighborList, GetNextExpiry) {
+	struct cdp_neighbor_list *list = cdp_neighbor_list_new();
+	int hold_time = cdp_sample_data_csr1000v[1];
+	struct timespec expiry;
+	struct timespec before;
+
+	ASSERT_EQ(0, cdp_neighbor_list_get_next_expiry(list, &expiry));
+
+	append_test_neighbor(list, 1, 2000);
+	struct cdp_neighbor *earliest = append_test_neighbor(list, 2, 1000);
+	append_test_neighbor(list, 3, 3000);
+
+	ASSERT_EQ(1, cdp_neighbor_list_get_next_expiry(list, &expiry));
+	ASSERT_EQ(1000 + hold_time - 1, expiry.tv_sec);
+	ASSERT_EQ(0, expiry.tv_nsec);
+
+	before.tv_sec = expiry.tv_sec - 1;
+	before.tv_nsec = 999999999;
+	ASSERT_FALSE(cdp_neighbor_is_expired(earliest, before));
+	ASSERT_TRUE(cdp_neighbor_is_expired(earliest, expiry));
+
+	ASSERT_GT(0, cdp_neighbor_list_get_next_expiry(list, NULL));
+
+	cdp_neighbor_list_clean_and_delete(list);
+}
+
+/// Verify the frame hash follows the content of the frame buffer
+TEST(CdpNeighbor, FrameHash) {
+	struct cdp_neighbor *neighbor = cdp_neighbor_new();
+	uint8_t frame[sizeof(cdp_sample_data_csr1000v)];
+
+	memcpy(frame, cdp_sample_data_csr1000v, sizeof(frame));
+
+	ASSERT_EQ(0, cdp_neighbor_set_frame_buffer(neighbor, frame, sizeof(frame)));
+	uint32_t original_hash = neighbor->frame_hash;
+	ASSERT_EQ(cdp_neighbor_hash_frame(frame, sizeof(frame)), original_hash);
+
+	// Same content, same hash
+	ASSERT_EQ(0, cdp_neighbor_set_frame_buffer(neighbor, frame, sizeof(frame)));
+	ASSERT_EQ(original_hash, neighbor->frame_hash);
+
+	// Changed content, changed hash
+	frame[sizeof(frame) - 1] ^= 0xFF;
+	ASSERT_EQ(0, cdp_neighbor_set_frame_buffer(neighbor, frame, sizeof(frame)));
+	ASSERT_NE(original_hash, neighbor->frame_hash);
+
+	cdp_neighbor_delete(neighbor);
+}
+
+/// Verify neighbors are identified by interface index and packed MAC address
+TEST(CdpNeighborList, Identity) {
+	struct cdp_neighbor_list *list = cdp_neighbor_list_new();
+	unsigned char remote_mac[6] = { 0x00, 0x1e, 0x49, 0xab, 0xcd, 0xef };
+	unsigned char unpacked[6];
+	uint64_t packed = cdp_neighbor_pack_mac(remote_mac);
+
+	ASSERT_EQ(0x001e49abcdefull, packed);
+	cdp_neighbor_unpack_mac(packed, unpacked);
+	ASSERT_EQ(0, memcmp(remote_mac, unpacked, sizeof(remote_mac)));
+
+	struct cdp_neighbor *first = cdp_neighbor_list_get_or_create_by_identity(list, 1, 2, packed);
+	struct cdp_neighbor *second = cdp_neighbor_list_get_or_create_by_identity(list, 1, 3, packed);
+	ASSERT_NE(first, second);
+	ASSERT_EQ(first, cdp_neighbor_list_get_or_create_by_identity(list, 1, 2, packed));
+	ASSERT_EQ(2, list->count);
+
+	ASSERT_EQ(second, cdp_neighbor_list_get_by_identity(list, 3, packed));
+	ASSERT_EQ(nullptr, cdp_neighbor_list_get_by_identity(list, 2, packed + 1));
+
+	ASSERT_EQ(first, cdp_neighbor_list_take_by_identity(list, 2, packed));
+	ASSERT_EQ(nullptr, cdp_neighbor_list_get_by_identity(list, 2, packed));
+	cdp_neighbor_delete(first);
+
+	cdp_neighbor_list_clean_and_delete(list);
+}
@@ -0,0 +1,147 @@
+#include <gtest/gtest.h>
+
+extern "C" {
+#include "../libcdp/cdp_neighbor.h"
+#include "../libcdp/cdp_neighbor_record.h"
+#include "../libcdp/cdp_packet.h"
+#include "../libcdp/stream_reader.h"
+#include "../libcdp/platform/platform.h"
+}
+
+#include "cdp_test_neighbor.h"
+
+/// Verify the record header layout
+TEST(CdpNeighborRecord, WriteHeader) {
+	struct cdp_neighbor *neighbor = create_test_neighbor(7);
+	uint8_t buffer[CDP_NEIGHBOR_RECORD_HEADER_LENGTH];
+	uint32_t record_length = (uint32_t)(CDP_NEIGHBOR_RECORD_HEADER_LENGTH + sizeof(cdp_sample_data_csr1000v));
+
+	ASSERT_EQ((ssize_t)record_length, cdp_neighbor_record_length(neighbor));
+	ASSERT_EQ(CDP_NEIGHBOR_RECORD_HEADER_LENGTH, cdp_neighbor_record_write_header(neighbor, buffer, sizeof(buffer)));
+
+	// Version and header length
+	ASSERT_EQ(0x00, buffer[0]);
+	ASSERT_EQ(CDP_NEIGHBOR_RECORD_VERSION, buffer[1]);
+	ASSERT_EQ(0x00, buffer[2]);
+	ASSERT_EQ(CDP_NEIGHBOR_RECORD_HEADER_LENGTH, buffer[3]);
+
+	// Record length
+	ASSERT_EQ((record_length >> 8) & 0xFF, buffer[6]);
+	ASSERT_EQ(record_length & 0xFF, buffer[7]);
+
+	// Interface index
+	ASSERT_EQ(7, buffer[11]);
+
+	// Hold time and MAC address
+	ASSERT_EQ(cdp_sample_data_csr1000v[1], buffer[12]);
+	ASSERT_EQ(6, buffer[13]);
+	ASSERT_EQ(0, memcmp(test_remote_mac, buffer + 14, sizeof(test_remote_mac)));
+
+	// Too small a buffer should fail
+	ASSERT_GT(0, cdp_neighbor_record_write_header(neighbor, buffer, sizeof(buffer) - 1));
+
+	cdp_neighbor_delete(neighbor);
+}
+
+/// Verify that a sequence of records can be serialized and parsed back again
+TEST(CdpNeighborRecord, SerializeAndParse) {
+	struct cdp_neighbor *first = create_test_neighbor(2);
+	struct cdp_neighbor *second = create_test_neighbor(3);
+	ssize_t first_length = cdp_neighbor_record_length(first);
+	ssize_t second_length = cdp_neighbor_record_length(second);
+	uint8_t *buffer = new uint8_t[first_length + second_length];
+
+	// Serialize two records back to back
+	ASSERT_EQ(first_length, cdp_neighbor_record_serialize(first, buffer, first_length + second_length));
+	ASSERT_EQ(second_length, cdp_neighbor_record_serialize(second, buffer + first_length, second_length));
+	ASSERT_GT(0, cdp_neighbor_record_serialize(second, buffer, second_length - 1));
+
+	struct stream_reader *reader = stream_reader_new(buffer, first_length + second_length);
+	struct cdp_neighbor *parsed;
+
+	// Parse both records
+	ASSERT_EQ(0, cdp_neighbor_record_parse(reader, &parsed));
+	ASSERT_NE(nullptr, parsed);
+	ASSERT_EQ(2, parsed->device_index);
+	ASSERT_EQ(cdp_neighbor_pack_mac(test_remote_mac), parsed->remote_mac);
+	ASSERT_EQ(first->received_at.tv_sec, parsed->received_at.tv_sec);
+	ASSERT_EQ(first->received_at.tv_nsec, parsed->received_at.tv_nsec);
+	ASSERT_EQ(sizeof(cdp_sample_data_csr1000v), parsed->frame_buffer_length);
+	ASSERT_EQ(0, memcmp(cdp_sample_data_csr1000v, parsed->frame_buffer, parsed->frame_buffer_length));
+	ASSERT_EQ(cdp_neighbor_get_hold_time(first), cdp_neighbor_get_hold_time(parsed));
+	cdp_neighbor_delete(parsed);
+
+	ASSERT_EQ(0, cdp_neighbor_record_parse(reader, &parsed));
+	ASSERT_NE(nullptr, parsed);
+	ASSERT_EQ(3, parsed->device_index);
+	cdp_neighbor_delete(parsed);
+
+	ASSERT_TRUE(stream_reader_at_end(reader));
+	ASSERT_GT(0, cdp_neighbor_record_parse(reader, &parsed));
+	ASSERT_EQ(nullptr, parsed);
+
+	stream_reader_delete(reader);
+
+	// A truncated record should fail to parse
+	reader = stream_reader_new(buffer, first_length - 1);
+	ASSERT_GT(0, cdp_neighbor_record_parse(reader, &parsed));
+	stream_reader_delete(reader);
+
+	delete[] buffer;
+	cdp_neighbor_delete(second);
+	cdp_neighbor_delete(first);
+}
+
+/// Verify that a table snapshot loads back without the neighbors which expired in the meantime
+TEST(CdpNeighborRecord, SnapshotList) {
+	struct cdp_neighbor_list *neighbors = cdp_neighbor_list_new();
+	struct cdp_neighbor *stale = create_test_neighbor(3);
+	struct cdp_neighbor_list *loaded = cdp_neighbor_list_new();
+	int hold_time;
+
+	cdp_neighbor_list_append(neighbors, create_test_neighbor(2));
+	cdp_neighbor_list_append(neighbors, stale);
+
+	// Neighbors without a frame have no record
+	cdp_neighbor_list_append(neighbors, cdp_neighbor_new());
+
+	hold_time = cdp_neighbor_get_hold_time(stale);
+	ASSERT_LT(10, hold_time);
+	stale->received_at.tv_sec -= hold_time - 10;
+
+	ssize_t length = cdp_neighbor_record_list_length(neighbors);
+	ASSERT_EQ(2 * cdp_neighbor_record_length(stale), length);
+
+	uint8_t *buffer = new uint8_t[length];
+	ASSERT_EQ(length, cdp_neighbor_record_serialize_list(neighbors, buffer, length));
+	ASSERT_GT(0, cdp_neighbor_record_serialize_list(neighbors, buffer, length - 1));
+
+	// Both are alive shortly after the snapshot
+	struct timespec now = { test_received_at_seconds + 5, 0 };
+	struct stream_reader *reader = stream_reader_new(buffer, length);
+	ASSERT_EQ(2, cdp_neighbor_record_parse_list(reader, now, loaded));
+	ASSERT_EQ(2, loaded->count);
+	ASSERT_EQ(2, loaded->head->device_index);
+	ASSERT_EQ(3, loaded->tail->device_index);
+	stream_reader_delete(reader);
+
+	// The stale neighbor has expired by the time the snapshot is loaded later
+	cdp_neighbor_list_clean(loaded);
+	now.tv_sec += 10;
+	reader = stream_reader_new(buffer, length);
+	ASSERT_EQ(1, cdp_neighbor_record_parse_list(reader, now, loaded));
+	ASSERT_EQ(2, loaded->head->device_index);
+	stream_reader_delete(reader);
+
+	// A truncated snapshot keeps the neighbors before the damage
+	cdp_neighbor_list_clean(loaded);
+	now.tv_sec -= 10;
+	reader = stream_reader_new(buffer, length - 1);
+	ASSERT_GT(0, cdp_neighbor_record_parse_list(reader, now, loaded));
+	ASSERT_EQ(1, loaded->count);
+	stream_reader_delete(reader);
+
+	delete[] buffer;
+	cdp_neighbor_list_clean_and_delete(loaded);
+	cdp_neighbor_list_clean_and_delete(neighbors);
+}
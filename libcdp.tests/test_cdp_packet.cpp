@@ -132,12 +132,11 @@ TEST(CdpPacket, ProvisionAddresses) {
 	int rc = cdp_packet_provision_address_array(packet, 3);
 	ASSERT_GE(rc, 0);
 	ASSERT_NE(nullptr, packet->addresses);
-	ASSERT_NE(nullptr, packet->addresses->addresses);
 	ASSERT_EQ(3, packet->addresses->count);
 
-	// Varify all the addresses are initialized to null
+	// Varify all the addresses are initialized to empty
 	for (int i = 0; i < packet->addresses->count; i++)
-		ASSERT_EQ(nullptr, packet->addresses->addresses[i]);
+		ASSERT_EQ(nullptr, ip_address_array_get(packet->addresses, i));
 
 	cdp_packet_delete(packet);
 }
@@ -152,7 +151,6 @@ TEST(CdpPacket, SetIPv4Addresses) {
 	int rc = cdp_packet_provision_address_array(packet, 3);
 	ASSERT_GE(rc, 0);
 	ASSERT_NE(nullptr, packet->addresses);
-	ASSERT_NE(nullptr, packet->addresses->addresses);
 
 	// Prepare the structure
 	struct sockaddr_in ipv4_address;
@@ -164,20 +162,16 @@ TEST(CdpPacket, SetIPv4Addresses) {
 	rc = cdp_packet_set_address_copy(packet, 1, (struct sockaddr *)&ipv4_address);
 	ASSERT_GE(rc, 0);
 
-	// Verify the addresses are either null or not null appropriately
-	ASSERT_EQ(nullptr, packet->addresses->addresses[0]);
-	ASSERT_NE(nullptr, packet->addresses->addresses[1]);
-	ASSERT_EQ(nullptr, packet->addresses->addresses[2]);
+	// Verify the addresses are either empty or set appropriately
+	ASSERT_EQ(nullptr, ip_address_array_get(packet->addresses, 0));
+	ASSERT_NE(nullptr, ip_address_array_get(packet->addresses, 1));
+	ASSERT_EQ(nullptr, ip_address_array_get(packet->addresses, 2));
 
 	// Verify the type of the second address
-	ASSERT_EQ(AF_INET, packet->addresses->addresses[1]->sa_family);
+	ASSERT_EQ(AF_INET, packet->addresses->addresses[1].family);
 
 	// Verify the value of the second address
-	struct sockaddr_in *test = (struct sockaddr_in *)packet->addresses->addresses[1];
-	ASSERT_EQ(htonl(0x0A640101), test->sin_addr.s_addr);
-
-	// Verify that the address value is not a pointer to the input structure
-	ASSERT_NE(&ipv4_address, test);
+	ASSERT_EQ(0, memcmp(&ipv4_address.sin_addr, packet->addresses->addresses[1].octets, 4));
 
 	cdp_packet_delete(packet);
 }
@@ -222,7 +216,6 @@ TEST(CdpPacket, SerializePacket) {
 	rc = cdp_packet_provision_address_array(packet, 3);
 	ASSERT_GE(rc, 0);
 	ASSERT_NE(nullptr, packet->addresses);
-	ASSERT_NE(nullptr, packet->addresses->addresses);
 	ASSERT_EQ(3, packet->addresses->count);
 
 	struct sockaddr_in ipv4_address;
@@ -245,16 +238,17 @@ TEST(CdpPacket, SerializePacket) {
 	ASSERT_GE(rc, 0);
 	
 	// Verify the first address
-	struct sockaddr_in *test = (struct sockaddr_in *)packet->addresses->addresses[0];
-	ASSERT_EQ(htonl(0x0A640101), test->sin_addr.s_addr);
+	uint32_t test;
+	memcpy(&test, packet->addresses->addresses[0].octets, 4);
+	ASSERT_EQ(htonl(0x0A640101), test);
 	
 	// Verify the second address
-	test = (struct sockaddr_in *)packet->addresses->addresses[1];
-	ASSERT_EQ(htonl(0xC0A80101), test->sin_addr.s_addr);
+	memcpy(&test, packet->addresses->addresses[1].octets, 4);
+	ASSERT_EQ(htonl(0xC0A80101), test);
 
 	// Verify the third address
-	struct sockaddr_in6 *test6 = (struct sockaddr_in6 *)packet->addresses->addresses[2];
-	ASSERT_EQ(0, memcmp(IPv6Octets(test6), test_address, 16));
+	ASSERT_EQ(AF_INET6, packet->addresses->addresses[2].family);
+	ASSERT_EQ(0, memcmp(packet->addresses->addresses[2].octets, test_address, 16));
 
 	// Serialize the packet into a buffer
 	uint8_t frame_buffer[1500];
@@ -270,6 +264,47 @@ TEST(CdpPacket, SerializePacket) {
 	FREE_ARRAY(cdp_software_version_string);
 }
 
+/// Verify that the precomputed serialized size matches the bytes produced by the serializer
+TEST(CdpPacket, SerializedSize) {
+	// Create the packet object as it would be advertised on an interface
+	struct ip_address_array *addresses = ip_address_array_new(2);
+	ASSERT_NE(nullptr, addresses);
+
+	int rc = ip_address_array_set_into_ipv4_uint32(addresses, 0, htonl(0x0A640101));
+	ASSERT_GE(rc, 0);
+
+	const uint8_t test_address[16] = { 0xFE, 0x80, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x16 };
+	rc = ip_address_array_set_into_ipv6_raw(addresses, 1, test_address);
+	ASSERT_GE(rc, 0);
+
+	struct cdp_packet *packet = cdp_packet_new_advertisement("eth0", "MyDogIsBetterThanYourDog", cdp_platform_string, "Software version", addresses);
+	ip_address_array_clear_and_delete(addresses);
+	ASSERT_NE(nullptr, packet);
+
+	// Measure the packet
+	ssize_t expected_length = cdp_packet_serialized_size(packet);
+	ASSERT_GT(expected_length, 0);
+
+	// Serialize into a buffer of exactly the measured size
+	uint8_t *frame_buffer = new uint8_t[expected_length];
+	ssize_t frame_buffer_length = cdp_packet_serialize(packet, frame_buffer, (size_t)expected_length);
+	ASSERT_EQ(expected_length, frame_buffer_length);
+
+	// Verify one byte less is not enough
+	frame_buffer_length = cdp_packet_serialize(packet, frame_buffer, (size_t)(expected_length - 1));
+	ASSERT_LT(frame_buffer_length, 0);
+
+	delete[] frame_buffer;
+
+	// A packet missing required TLVs can't be measured
+	struct cdp_packet *incomplete = cdp_packet_new(2, 180, 0);
+	ASSERT_NE(nullptr, incomplete);
+	ASSERT_LT(cdp_packet_serialized_size(incomplete), 0);
+
+	cdp_packet_delete(incomplete);
+	cdp_packet_delete(packet);
+}
+
 /// Test that a CDP frame can be serialized and parsed.
 TEST(CdpPacket, SerializeAndDeserializePacket) {
 	// Create a software version string
@@ -310,7 +345,6 @@ TEST(CdpPacket, SerializeAndDeserializePacket) {
 	rc = cdp_packet_provision_address_array(packet, 3);
 	ASSERT_GE(rc, 0);
 	ASSERT_NE(nullptr, packet->addresses);
-	ASSERT_NE(nullptr, packet->addresses->addresses);
 	ASSERT_EQ(3, packet->addresses->count);
 
 	struct sockaddr_in ipv4_address;
@@ -404,23 +438,24 @@ TEST(CdpPacket, ValidateParserCsr1000v) {
 	// Verify the number of addresses
 	ASSERT_EQ(parsed->addresses->count, cdp_sample_data_csr1000v_address_count);
 
-	// Verify the addresses have been allocated
-	ASSERT_NE(nullptr, parsed->addresses->addresses);
-	ASSERT_NE(nullptr, parsed->addresses->addresses[0]);
-	ASSERT_NE(nullptr, parsed->addresses->addresses[1]);
-	ASSERT_NE(nullptr, parsed->addresses->addresses[2]);
+	// Verify the addresses have been set
+	ASSERT_NE(nullptr, ip_address_array_get(parsed->addresses, 0));
+	ASSERT_NE(nullptr, ip_address_array_get(parsed->addresses, 1));
+	ASSERT_NE(nullptr, ip_address_array_get(parsed->addresses, 2));
 
 	// Verify the content of the address (0)
-	ASSERT_EQ(parsed->addresses->addresses[0]->sa_family, cdp_sample_data_csr1000v_address0_type);
-	ASSERT_EQ(((struct sockaddr_in *)parsed->addresses->addresses[0])->sin_addr.s_addr, htonl(cdp_sample_data_csr1000v_address0));
+	uint32_t address;
+	ASSERT_EQ(parsed->addresses->addresses[0].family, cdp_sample_data_csr1000v_address0_type);
+	memcpy(&address, parsed->addresses->addresses[0].octets, 4);
+	ASSERT_EQ(address, htonl(cdp_sample_data_csr1000v_address0));
 
 	// Verify the content of the address (1)
-	ASSERT_EQ(parsed->addresses->addresses[1]->sa_family, cdp_sample_data_csr1000v_address1_type);
-	ASSERT_EQ(0, memcmp(IPv6Octets((struct sockaddr_in6 *)parsed->addresses->addresses[1]), cdp_sample_data_csr1000v_address1, 16));
+	ASSERT_EQ(parsed->addresses->addresses[1].family, cdp_sample_data_csr1000v_address1_type);
+	ASSERT_EQ(0, memcmp(parsed->addresses->addresses[1].octets, cdp_sample_data_csr1000v_address1, 16));
 
 	// Verify the content of the address (2)
-	ASSERT_EQ(parsed->addresses->addresses[2]->sa_family, cdp_sample_data_csr1000v_address2_type);
-	ASSERT_EQ(0, memcmp(IPv6Octets((struct sockaddr_in6 *)parsed->addresses->addresses[2]), cdp_sample_data_csr1000v_address2, 16));
+	ASSERT_EQ(parsed->addresses->addresses[2].family, cdp_sample_data_csr1000v_address2_type);
+	ASSERT_EQ(0, memcmp(parsed->addresses->addresses[2].octets, cdp_sample_data_csr1000v_address2, 16));
 
 	// Verify the port ID
 	ASSERT_STREQ(parsed->port_id, cdp_sample_data_csr1000v_port_id);
@@ -435,14 +470,98 @@ TEST(CdpPacket, ValidateParserCsr1000v) {
 	// Verify the number of management addresses
 	ASSERT_EQ(parsed->management_addresses->count, cdp_sample_data_csr1000v_management_address_count);
 
-	// Verify the management addresses have been allocated
-	ASSERT_NE(nullptr, parsed->management_addresses->addresses);
-	ASSERT_NE(nullptr, parsed->management_addresses->addresses[0]);
+	// Verify the management addresses have been set
+	ASSERT_NE(nullptr, ip_address_array_get(parsed->management_addresses, 0));
 
 	// Verify the content of the management address (0)
-	ASSERT_EQ(parsed->management_addresses->addresses[0]->sa_family, cdp_sample_data_csr1000v_management_address0_type);
-	ASSERT_EQ(((struct sockaddr_in *)parsed->management_addresses->addresses[0])->sin_addr.s_addr, htonl(cdp_sample_data_csr1000v_management_address0));
+	ASSERT_EQ(parsed->management_addresses->addresses[0].family, cdp_sample_data_csr1000v_management_address0_type);
+	memcpy(&address, parsed->management_addresses->addresses[0].octets, 4);
+	ASSERT_EQ(address, htonl(cdp_sample_data_csr1000v_management_address0));
 
 	// Delete the parsed packet
 	cdp_packet_delete(parsed);
 }
+
+/// Verify the parser and serializer report why and where they failed
+TEST(CdpPacket, ErrorCodes) {
+	uint8_t frame[sizeof(cdp_sample_data_csr1000v)];
+	struct cdp_packet *parsed = nullptr;
+
+	// A frame cut short within the last TLV is truncated after the TLV header
+	struct stream_reader *reader = stream_reader_new(cdp_sample_data_csr1000v, sizeof(cdp_sample_data_csr1000v) - 1);
+	ASSERT_NE(nullptr, reader);
+	ASSERT_EQ(CDP_ERROR_TRUNCATED, cdp_parse_packet(reader, &parsed));
+	ASSERT_EQ(nullptr, parsed);
+	ASSERT_EQ(CDP_ERROR_TRUNCATED, stream_reader_get_error(reader));
+	ASSERT_GT(stream_reader_get_error_position(reader), 8);
+	ASSERT_LT(stream_reader_get_error_position(reader), (off_t)sizeof(cdp_sample_data_csr1000v));
+	stream_reader_delete(reader);
+
+	// A TLV shorter than its header fails right after its length field
+	memcpy(frame, cdp_sample_data_csr1000v, sizeof(frame));
+	frame[7] = 2;
+	reader = stream_reader_new(frame, sizeof(frame));
+	ASSERT_NE(nullptr, reader);
+	ASSERT_EQ(CDP_ERROR_BAD_LENGTH, cdp_parse_packet(reader, &parsed));
+	ASSERT_EQ(8, stream_reader_get_error_position(reader));
+	ASSERT_STREQ("bad_length", cdp_error_name(stream_reader_get_error(reader)));
+
+	// Clearing the error allows the reader to be reused
+	stream_reader_clear_error(reader);
+	ASSERT_EQ(CDP_ERROR_NONE, stream_reader_get_error(reader));
+	stream_reader_delete(reader);
+
+	// An address count larger than the TLV could hold is rejected before anything is allocated for it
+	const uint8_t addresses[] = { 0x02, 0xb4, 0x00, 0x00, 0x00, 0x02, 0x00, 0x11, 0xff, 0xff, 0xff, 0xff, 0x01, 0x01, 0xcc, 0x00, 0x04, 0x0a, 0x64, 0x01, 0x12 };
+	reader = stream_reader_new(addresses, sizeof(addresses));
+	ASSERT_NE(nullptr, reader);
+	ASSERT_EQ(CDP_ERROR_BAD_LENGTH, cdp_parse_packet(reader, &parsed));
+	ASSERT_EQ(12, stream_reader_get_error_position(reader));
+	stream_reader_delete(reader);
+
+	// The serializer tells a short buffer apart from a packet missing required fields
+	struct cdp_packet *packet = cdp_packet_new_advertisement("eth0", "MyDogIsBetterThanYourDog", cdp_platform_string, "Software version", nullptr);
+	ASSERT_NE(nullptr, packet);
+	ASSERT_EQ(CDP_ERROR_BUFFER_TOO_SMALL, cdp_packet_serialize(packet, frame, 16));
+	cdp_packet_delete(packet);
+
+	packet = cdp_packet_new(2, 180, 0);
+	ASSERT_NE(nullptr, packet);
+	ASSERT_EQ(CDP_ERROR_MISSING_FIELD, cdp_packet_serialize(packet, frame, sizeof(frame)));
+	ASSERT_EQ(CDP_ERROR_INVALID_ARGUMENT, cdp_packet_serialize(nullptr, frame, sizeof(frame)));
+	cdp_packet_delete(packet);
+
+	ASSERT_STREQ("unknown", cdp_error_name(-CDP_ERROR_COUNT));
+	ASSERT_STREQ("unknown", cdp_error_name(1));
+}
+
+/// Verify that frames are checked for a valid checksum and complete TLVs without parsing them
+TEST(CdpPacket, ValidateFrame) {
+	uint8_t frame[sizeof(cdp_sample_data_csr1000v)];
+
+	ASSERT_TRUE(cdp_frame_checksum_is_valid(cdp_sample_data_csr1000v, sizeof(cdp_sample_data_csr1000v)));
+	ASSERT_TRUE(cdp_frame_is_well_formed(cdp_sample_data_csr1000v, sizeof(cdp_sample_data_csr1000v)));
+	ASSERT_TRUE(cdp_frame_checksum_is_valid(cdp_sample_data_2960g_ios15_0_1_se3, sizeof(cdp_sample_data_2960g_ios15_0_1_se3)));
+	ASSERT_TRUE(cdp_frame_is_well_formed(cdp_sample_data_2960g_ios15_0_1_se3, sizeof(cdp_sample_data_2960g_ios15_0_1_se3)));
+
+	// A corrupted byte fails the checksum but the TLVs are intact
+	memcpy(frame, cdp_sample_data_csr1000v, sizeof(frame));
+	frame[40] ^= 0x01;
+	ASSERT_FALSE(cdp_frame_checksum_is_valid(frame, sizeof(frame)));
+	ASSERT_TRUE(cdp_frame_is_well_formed(frame, sizeof(frame)));
+
+	// A truncated frame ends within a TLV, a TLV shorter than its header never ends
+	ASSERT_FALSE(cdp_frame_is_well_formed(cdp_sample_data_csr1000v, sizeof(cdp_sample_data_csr1000v) - 1));
+	ASSERT_FALSE(cdp_frame_is_well_formed(cdp_sample_data_csr1000v, 3));
+	memcpy(frame, cdp_sample_data_csr1000v, sizeof(frame));
+	frame[7] = 2;
+	ASSERT_FALSE(cdp_frame_is_well_formed(frame, sizeof(frame)));
+
+	// Odd length frames are accepted with the RFC 1071 and the Cisco checksum
+	uint8_t odd_rfc[] = { 0x02, 0xb4, 0xb2, 0xe0, 0x00, 0x01, 0x00, 0x07, 'a', 'b', 0xe9 };
+	uint8_t odd_cisco[] = { 0x02, 0xb4, 0x9b, 0xf8, 0x00, 0x01, 0x00, 0x07, 'a', 'b', 0xe9 };
+	ASSERT_TRUE(cdp_frame_checksum_is_valid(odd_rfc, sizeof(odd_rfc)));
+	ASSERT_TRUE(cdp_frame_checksum_is_valid(odd_cisco, sizeof(odd_cisco)));
+	odd_cisco[3] ^= 0x10;
+	ASSERT_FALSE(cdp_frame_checksum_is_valid(odd_cisco, sizeof(odd_cisco)));
+}
@@ -0,0 +1,148 @@
+#include <gtest/gtest.h>
+
+extern "C" {
+#include "../libcdp/cdp_neighbor.h"
+#include "../libcdp/cdp_packet.h"
+#include "../libcdp/cdp_shm_table.h"
+#include "../libcdp/platform/platform.h"
+}
+
+#include "cdp_test_neighbor.h"
+
+static struct cdp_neighbor_list *create_test_neighbors(int count)
+{
+	struct cdp_neighbor_list *neighbors = cdp_neighbor_list_new();
+	int i;
+
+	// Interface indexes that do not exist, so the name falls back to the index
+	for (i = 0; i < count; i++)
+		cdp_neighbor_list_append(neighbors, create_test_neighbor(i + 100000));
+
+	return neighbors;
+}
+
+/// Verify that a published table reads back decoded, without parsing on the reader side
+TEST(CdpShmTable, PublishAndRead) {
+	size_t size = cdp_shm_table_size(8, 4096);
+	uint8_t *region = new uint8_t[size];
+	struct cdp_neighbor_list *neighbors = create_test_neighbors(2);
+	struct timespec now = { 1546300900, 42 };
+
+	struct cdp_shm_table_writer *writer = cdp_shm_table_writer_new(region, size, 8, 4096);
+	ASSERT_NE(nullptr, writer);
+
+	struct cdp_shm_table_reader *reader = cdp_shm_table_reader_new(region, size);
+	ASSERT_NE(nullptr, reader);
+
+	// An empty table before anything is published
+	ASSERT_EQ(0, cdp_shm_table_reader_read(reader));
+	ASSERT_EQ(nullptr, cdp_shm_table_reader_get_slot(reader, 0));
+
+	ASSERT_EQ(2, cdp_shm_table_writer_publish(writer, neighbors, now));
+	ASSERT_EQ(2, cdp_shm_table_reader_read(reader));
+
+	const struct cdp_shm_table_header *header = cdp_shm_table_reader_get_header(reader);
+	ASSERT_EQ(0u, header->sequence & 1);
+	ASSERT_EQ(0u, header->flags);
+	ASSERT_EQ(1546300900, header->updated_at_seconds);
+
+	const struct cdp_shm_table_slot *slot = cdp_shm_table_reader_get_slot(reader, 1);
+	ASSERT_NE(nullptr, slot);
+	ASSERT_EQ(nullptr, cdp_shm_table_reader_get_slot(reader, 2));
+
+	ASSERT_EQ(100001, slot->interface_index);
+	ASSERT_STREQ("if100001", cdp_shm_table_reader_get_string(reader, slot->interface_name));
+	ASSERT_EQ(test_received_at_seconds, slot->received_at_seconds);
+	ASSERT_EQ((uint32_t)test_received_at_nanoseconds, slot->received_at_nanoseconds);
+	ASSERT_EQ(6, slot->remote_mac_length);
+	ASSERT_EQ(0, memcmp(test_remote_mac, slot->remote_mac, sizeof(test_remote_mac)));
+
+	ASSERT_EQ(cdp_sample_data_csr1000v[1], slot->hold_time);
+	ASSERT_EQ(cdp_sample_data_csr1000v_capabilities, slot->capabilities);
+	ASSERT_EQ(cdp_sample_data_csr1000v_duplex, (ECdpNetworkDuplex)slot->duplex);
+	ASSERT_STREQ(cdp_sample_data_csr1000v_device_id, cdp_shm_table_reader_get_string(reader, slot->device_id));
+	ASSERT_STREQ(cdp_sample_data_csr1000v_port_id, cdp_shm_table_reader_get_string(reader, slot->port_id));
+	ASSERT_STREQ(cdp_sample_data_csr1000v_platform, cdp_shm_table_reader_get_string(reader, slot->platform));
+	ASSERT_STREQ(cdp_sample_data_csr1000v_software_version, cdp_shm_table_reader_get_string(reader, slot->software_version));
+
+	// Addresses are stored in network byte order
+	ASSERT_EQ(cdp_sample_data_csr1000v_address_count, slot->address_count);
+	ASSERT_EQ(4, slot->address_versions[0]);
+	ASSERT_EQ(0xC0, slot->addresses[0][0]);
+	ASSERT_EQ(0x03, slot->addresses[0][3]);
+	ASSERT_EQ(6, slot->address_versions[1]);
+	ASSERT_EQ(0, memcmp(cdp_sample_data_csr1000v_address1, slot->addresses[1], 16));
+
+	// Out of range offsets resolve to the empty string
+	ASSERT_STREQ("", cdp_shm_table_reader_get_string(reader, 0));
+	ASSERT_STREQ("", cdp_shm_table_reader_get_string(reader, 1000000));
+
+	// Republishing a smaller table replaces the contents
+	cdp_neighbor_list_clean(neighbors);
+	ASSERT_EQ(0, cdp_shm_table_writer_publish(writer, neighbors, now));
+	ASSERT_EQ(0, cdp_shm_table_reader_read(reader));
+
+	cdp_shm_table_reader_delete(reader);
+	cdp_shm_table_writer_delete(writer);
+	cdp_neighbor_list_clean_and_delete(neighbors);
+	delete[] region;
+}
+
+/// Verify that neighbors and strings which don't fit are left out and flagged
+TEST(CdpShmTable, Truncated) {
+	size_t size = cdp_shm_table_size(1, 16);
+	uint8_t *region = new uint8_t[size];
+	struct cdp_neighbor_list *neighbors = create_test_neighbors(2);
+	struct timespec now = { 1546300900, 0 };
+
+	struct cdp_shm_table_writer *writer = cdp_shm_table_writer_new(region, size, 1, 16);
+	struct cdp_shm_table_reader *reader = cdp_shm_table_reader_new(region, size);
+
+	ASSERT_EQ(1, cdp_shm_table_writer_publish(writer, neighbors, now));
+	ASSERT_EQ(1, cdp_shm_table_reader_read(reader));
+	ASSERT_EQ(CDP_SHM_TABLE_FLAG_TRUNCATED, cdp_shm_table_reader_get_header(reader)->flags);
+
+	// The interface name fits, the device ID doesn't
+	const struct cdp_shm_table_slot *slot = cdp_shm_table_reader_get_slot(reader, 0);
+	ASSERT_STREQ("if100000", cdp_shm_table_reader_get_string(reader, slot->interface_name));
+	ASSERT_STREQ("", cdp_shm_table_reader_get_string(reader, slot->device_id));
+
+	// A region too small for the requested capacity is refused
+	ASSERT_EQ(nullptr, cdp_shm_table_writer_new(region, size - 1, 1, 16));
+
+	cdp_shm_table_reader_delete(reader);
+	cdp_shm_table_writer_delete(writer);
+	cdp_neighbor_list_clean_and_delete(neighbors);
+	delete[] region;
+}
+
+/// Verify that readers never return a table which is being updated
+TEST(CdpShmTable, ReadDuringUpdate) {
+	size_t size = cdp_shm_table_size(4, 1024);
+	uint8_t *region = new uint8_t[size];
+	struct cdp_neighbor_list *neighbors = create_test_neighbors(1);
+	struct timespec now = { 1546300900, 0 };
+
+	// Anything but an initialized table is refused
+	memset(region, 0, size);
+	ASSERT_EQ(nullptr, cdp_shm_table_reader_new(region, size));
+
+	struct cdp_shm_table_writer *writer = cdp_shm_table_writer_new(region, size, 4, 1024);
+	struct cdp_shm_table_reader *reader = cdp_shm_table_reader_new(region, size);
+	struct cdp_shm_table_header *header = (struct cdp_shm_table_header *)region;
+
+	ASSERT_EQ(1, cdp_shm_table_writer_publish(writer, neighbors, now));
+
+	// A writer stuck half way through an update
+	header->sequence++;
+	ASSERT_GT(0, cdp_shm_table_reader_read(reader));
+	ASSERT_EQ(0u, cdp_shm_table_reader_get_header(reader)->neighbor_count);
+
+	header->sequence++;
+	ASSERT_EQ(1, cdp_shm_table_reader_read(reader));
+
+	cdp_shm_table_reader_delete(reader);
+	cdp_shm_table_writer_delete(writer);
+	cdp_neighbor_list_clean_and_delete(neighbors);
+	delete[] region;
+}
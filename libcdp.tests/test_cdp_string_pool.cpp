@@ -0,0 +1,108 @@
+#include <gtest/gtest.h>
+
+extern "C" {
+#include "../libcdp/cdp_packet.h"
+#include "../libcdp/cdp_packet_parser.h"
+#include "../libcdp/cdp_string_pool.h"
+#include "../libcdp/stream_reader.h"
+#include "../libcdp/platform/platform.h"
+}
+
+#include "cdp_sample_data.h"
+
+static struct cdp_packet *parse_sample(struct cdp_string_pool *pool)
+{
+	struct stream_reader *reader = stream_reader_new(cdp_sample_data_csr1000v, sizeof(cdp_sample_data_csr1000v));
+	struct cdp_packet *packet = NULL;
+
+	EXPECT_EQ(0, cdp_parse_packet_with_pool(reader, pool, &packet));
+	stream_reader_delete(reader);
+
+	return packet;
+}
+
+/// Verify that equal strings are shared and only freed with their last reference
+TEST(CdpStringPool, InternAndRelease) {
+	struct cdp_string_pool *pool = cdp_string_pool_new(2);
+	ASSERT_NE(nullptr, pool);
+
+	char *first = cdp_string_intern(pool, "cisco WS-C3850-48P and some trailing bytes", 18);
+	char *second = cdp_string_intern(pool, "cisco WS-C3850-48P", 18);
+	char *other = cdp_string_intern(pool, "cisco CSR1000V", 14);
+	char *empty = cdp_string_intern(pool, NULL, 0);
+
+	ASSERT_NE(nullptr, first);
+	EXPECT_STREQ("cisco WS-C3850-48P", first);
+	EXPECT_EQ(first, second);
+	EXPECT_NE(first, other);
+	EXPECT_STREQ("", empty);
+	EXPECT_EQ(3u, cdp_string_pool_count(pool));
+
+	cdp_string_release(first);
+	EXPECT_EQ(3u, cdp_string_pool_count(pool));
+	EXPECT_STREQ("cisco WS-C3850-48P", second);
+
+	cdp_string_release(second);
+	EXPECT_EQ(2u, cdp_string_pool_count(pool));
+
+	// Growing the buckets keeps every string reachable
+	char names[64][8];
+	char *strings[64];
+	for (int i = 0; i < 64; i++)
+	{
+		snprintf(names[i], sizeof(names[i]), "vlan%d", i);
+		strings[i] = cdp_string_intern(pool, names[i], strlen(names[i]));
+	}
+	EXPECT_EQ(66u, cdp_string_pool_count(pool));
+
+	for (int i = 0; i < 64; i++)
+	{
+		EXPECT_EQ(strings[i], cdp_string_intern(pool, names[i], strlen(names[i])));
+		cdp_string_release(strings[i]);
+		cdp_string_release(strings[i]);
+	}
+	EXPECT_EQ(2u, cdp_string_pool_count(pool));
+
+	// Strings outliving their pool become private
+	cdp_string_pool_delete(pool);
+	EXPECT_STREQ("cisco CSR1000V", cdp_string_hold(other));
+	cdp_string_release(other);
+	cdp_string_release(other);
+	cdp_string_release(empty);
+}
+
+/// Verify that packets parsed with the same pool share their strings and that private copies still work
+TEST(CdpStringPool, ParsedPacketsShareStrings) {
+	struct cdp_string_pool *pool = cdp_string_pool_new(16);
+	ASSERT_NE(nullptr, pool);
+
+	struct cdp_packet *first = parse_sample(pool);
+	struct cdp_packet *second = parse_sample(pool);
+	struct cdp_packet *unpooled = parse_sample(NULL);
+	ASSERT_NE(nullptr, first);
+	ASSERT_NE(nullptr, second);
+	ASSERT_NE(nullptr, unpooled);
+
+	EXPECT_STREQ(cdp_sample_data_csr1000v_platform, first->platform);
+	EXPECT_EQ(first->platform, second->platform);
+	EXPECT_EQ(first->software_version, second->software_version);
+	EXPECT_EQ(first->device_id, second->device_id);
+	EXPECT_NE(first->platform, unpooled->platform);
+	EXPECT_STREQ(first->platform, unpooled->platform);
+
+	size_t count = cdp_string_pool_count(pool);
+	EXPECT_GT(count, 0u);
+
+	// A setter replaces a pooled string with a private copy
+	EXPECT_EQ(0, cdp_packet_set_platform(second, "cisco WS-C2960G-24TC-L"));
+	EXPECT_STREQ(cdp_sample_data_csr1000v_platform, first->platform);
+
+	cdp_packet_delete(first);
+	EXPECT_EQ(count - 1, cdp_string_pool_count(pool));
+
+	cdp_packet_delete(second);
+	EXPECT_EQ(0u, cdp_string_pool_count(pool));
+
+	cdp_packet_delete(unpooled);
+	cdp_string_pool_delete(pool);
+}
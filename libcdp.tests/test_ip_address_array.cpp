@@ -19,14 +19,15 @@ TEST(IpAddressArray, Constructor) {
 	// Verify the proper number of addresses was set
 	ASSERT_EQ(4, array->count);
 
-	// Verify the address array was constructed
-	ASSERT_NE(nullptr, array->addresses);
+	// Verify that the slots in the array were initialized to empty
+	ASSERT_EQ(nullptr, ip_address_array_get(array, 0));
+	ASSERT_EQ(nullptr, ip_address_array_get(array, 1));
+	ASSERT_EQ(nullptr, ip_address_array_get(array, 2));
+	ASSERT_EQ(nullptr, ip_address_array_get(array, 3));
+	ASSERT_EQ(AF_UNSPEC, array->addresses[3].family);
 
-	// Verify that the values in the array were initialized to null
-	ASSERT_EQ(nullptr, array->addresses[0]);
-	ASSERT_EQ(nullptr, array->addresses[1]);
-	ASSERT_EQ(nullptr, array->addresses[2]);
-	ASSERT_EQ(nullptr, array->addresses[3]);
+	// Verify that reading past the end fails
+	ASSERT_EQ(nullptr, ip_address_array_get(array, 4));
 
 	// Delete the array
 	ip_address_array_delete(array);
@@ -41,13 +42,10 @@ TEST(IpAddressArray, SetIPv6Raw) {
 	// Verify the proper number of addresses was set
 	ASSERT_EQ(3, array->count);
 
-	// Verify the address array was constructed
-	ASSERT_NE(nullptr, array->addresses);
-
-	// Verify that the values in the array were initialized to null
-	ASSERT_EQ(nullptr, array->addresses[0]);
-	ASSERT_EQ(nullptr, array->addresses[1]);
-	ASSERT_EQ(nullptr, array->addresses[2]);
+	// Verify that the slots in the array were initialized to empty
+	ASSERT_EQ(nullptr, ip_address_array_get(array, 0));
+	ASSERT_EQ(nullptr, ip_address_array_get(array, 1));
+	ASSERT_EQ(nullptr, ip_address_array_get(array, 2));
 
 	// Set a test address
 	const uint8_t test_address[16] = { 0xFE, 0x80, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x16 };
@@ -55,19 +53,52 @@ TEST(IpAddressArray, SetIPv6Raw) {
 	ASSERT_GE(rc, 0);
 
 	// Verify that only one address is set now
-	ASSERT_EQ(nullptr, array->addresses[0]);
-	ASSERT_NE(nullptr, array->addresses[1]);
-	ASSERT_EQ(nullptr, array->addresses[2]);
+	ASSERT_EQ(nullptr, ip_address_array_get(array, 0));
+	ASSERT_NE(nullptr, ip_address_array_get(array, 1));
+	ASSERT_EQ(nullptr, ip_address_array_get(array, 2));
 
 	// Verify the address family is IPv6
-	ASSERT_EQ(array->addresses[1]->sa_family, AF_INET6);
-
-	// Verify the address is a copy, not a reference
-	ASSERT_NE(IPv6Octets((struct sockaddr_in6 *)array->addresses[1]), test_address);
+	ASSERT_EQ(array->addresses[1].family, AF_INET6);
 
 	// Verify the address is set correctly
-	ASSERT_EQ(0, memcmp(IPv6Octets((struct sockaddr_in6 *)array->addresses[1]), test_address, 16));
+	ASSERT_EQ(0, memcmp(array->addresses[1].octets, test_address, 16));
 
 	// Delete the array
 	ip_address_array_delete(array);
 }
+
+/// Verify that socket addresses are copied into the slots and that a clone is independent of its source
+TEST(IpAddressArray, CopyAndClone) {
+	struct ip_address_array *array = ip_address_array_new(2);
+	ASSERT_NE(nullptr, array);
+
+	struct sockaddr_in ipv4_address;
+	memset(&ipv4_address, 0, sizeof(struct sockaddr_in));
+	ipv4_address.sin_family = AF_INET;
+	ipv4_address.sin_addr.s_addr = htonl(0x0A640101);
+	ASSERT_EQ(0, ip_address_array_copy_into(array, 0, (struct sockaddr *)&ipv4_address));
+
+	// Verify the address is stored in network order
+	const uint8_t expected[4] = { 0x0A, 0x64, 0x01, 0x01 };
+	ASSERT_EQ(AF_INET, array->addresses[0].family);
+	ASSERT_EQ(0, memcmp(array->addresses[0].octets, expected, 4));
+
+	// Verify an address past the end or of an unknown family is refused
+	ASSERT_LT(ip_address_array_copy_into(array, 2, (struct sockaddr *)&ipv4_address), 0);
+	ipv4_address.sin_family = AF_UNIX;
+	ASSERT_LT(ip_address_array_copy_into(array, 1, (struct sockaddr *)&ipv4_address), 0);
+
+	struct ip_address_array *clone = ip_address_array_clone(array);
+	ASSERT_NE(nullptr, clone);
+	ASSERT_EQ(2, clone->count);
+	ASSERT_EQ(0, memcmp(clone->addresses[0].octets, expected, 4));
+	ASSERT_EQ(nullptr, ip_address_array_get(clone, 1));
+
+	// Verify that clearing the source leaves the clone alone
+	ASSERT_EQ(0, ip_address_array_clear(array));
+	ASSERT_EQ(nullptr, ip_address_array_get(array, 0));
+	ASSERT_NE(nullptr, ip_address_array_get(clone, 0));
+
+	ip_address_array_delete(clone);
+	ip_address_array_delete(array);
+}
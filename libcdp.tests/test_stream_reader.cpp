@@ -22,3 +22,25 @@ TEST(StreamReader, ValidateChecksum) {
 	// Delete the stream reader
 	stream_reader_delete(reader);
 }
+
+/// Verify the checksum of a frame already in the buffer is recomputed after skipping over it
+TEST(StreamWriter, InjectChecksumAfterSkip) {
+	uint8_t frame[sizeof(cdp_sample_data_csr1000v)];
+
+	memcpy(frame, cdp_sample_data_csr1000v, sizeof(frame));
+	frame[2] = 0;
+	frame[3] = 0;
+
+	struct stream_writer *writer = stream_writer_new(frame, sizeof(frame));
+	ASSERT_NE(nullptr, writer);
+
+	ASSERT_EQ(0, stream_writer_skip(writer, sizeof(frame)));
+	ASSERT_EQ((ssize_t)sizeof(frame), stream_writer_length(writer));
+	ASSERT_EQ(0, stream_writer_inject_checksum(writer, 2));
+	ASSERT_EQ(0, memcmp(cdp_sample_data_csr1000v, frame, sizeof(frame)));
+
+	// Nothing is left to skip over
+	ASSERT_EQ(CDP_ERROR_BUFFER_TOO_SMALL, stream_writer_skip(writer, 1));
+
+	stream_writer_delete(writer);
+}
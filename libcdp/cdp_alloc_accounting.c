@@ -0,0 +1,303 @@
+#include "cdp_alloc_accounting.h"
+
+#if defined(CDP_ALLOC_ACCOUNTING) && defined(__linux__) && !defined(__KERNEL__)
+
+#include "platform/platform.h"
+
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+
+/** The number of call sites which can be told apart, sites beyond it are counted together */
+#define CDP_ALLOC_ACCOUNTING_MAX_SITES 512
+
+/** The header in front of every accounted block, padded to keep the block aligned for any type */
+union cdp_alloc_accounting_header
+{
+    struct
+    {
+        /** The size requested by the caller */
+        size_t size;
+
+        /** The index of the site the block is charged to */
+        size_t site;
+    } block;
+
+    /** Alignment padding */
+    long double alignment;
+};
+
+/** The sites in order of their first allocation, the last one collects the overflow */
+static struct cdp_alloc_accounting_counters cdp_alloc_accounting_sites[CDP_ALLOC_ACCOUNTING_MAX_SITES];
+
+/** The number of sites in use */
+static size_t cdp_alloc_accounting_site_count = 0;
+
+/** Open addressed index of the sites by hash, holding site index + 1 or 0 when empty */
+static size_t cdp_alloc_accounting_index[CDP_ALLOC_ACCOUNTING_MAX_SITES * 2];
+
+/** The counters of all sites */
+static struct cdp_alloc_accounting_counters cdp_alloc_accounting_totals;
+
+/** Protects the sites and the totals */
+static pthread_mutex_t cdp_alloc_accounting_lock = PTHREAD_MUTEX_INITIALIZER;
+
+/** Hashes a call site by name. The same literal may be stored more than once, so the pointers
+  *  can't be used as keys.
+  *  @param file The file of the site.
+  *  @param function The function of the site.
+  *  @return The hash.
+  */
+static uint32_t cdp_alloc_accounting_hash(const char *file, const char *function)
+{
+    uint32_t hash = 2166136261U;
+    const char *c;
+
+    for(c = file; *c != '\0'; c++)
+        hash = (hash ^ (uint8_t)*c) * 16777619U;
+
+    for(c = function; *c != '\0'; c++)
+        hash = (hash ^ (uint8_t)*c) * 16777619U;
+
+    return hash;
+}
+
+/** Finds or adds the site of an allocation, must be called with the lock held.
+  *  @param file The file of the site.
+  *  @param function The function of the site.
+  *  @return The index of the site.
+  */
+static size_t cdp_alloc_accounting_find_site(const char *file, const char *function)
+{
+    const size_t mask = CDP_ALLOC_ACCOUNTING_MAX_SITES * 2 - 1;
+    struct cdp_alloc_accounting_counters *site;
+    size_t slot;
+
+    for(slot = cdp_alloc_accounting_hash(file, function) & mask; cdp_alloc_accounting_index[slot] != 0; slot = (slot + 1) & mask)
+    {
+        site = &cdp_alloc_accounting_sites[cdp_alloc_accounting_index[slot] - 1];
+        if(
+            (site->file == file || strcmp(site->file, file) == 0) &&
+            (site->function == function || strcmp(site->function, function) == 0)
+        )
+            return cdp_alloc_accounting_index[slot] - 1;
+    }
+
+    if(cdp_alloc_accounting_site_count == CDP_ALLOC_ACCOUNTING_MAX_SITES - 1)
+    {
+        site = &cdp_alloc_accounting_sites[CDP_ALLOC_ACCOUNTING_MAX_SITES - 1];
+        site->file = "(other)";
+        site->function = "(other)";
+        return CDP_ALLOC_ACCOUNTING_MAX_SITES - 1;
+    }
+
+    site = &cdp_alloc_accounting_sites[cdp_alloc_accounting_site_count];
+    site->file = file;
+    site->function = function;
+    cdp_alloc_accounting_index[slot] = ++cdp_alloc_accounting_site_count;
+
+    return cdp_alloc_accounting_site_count - 1;
+}
+
+/** Charges an allocation to a set of counters.
+  *  @param counters The counters.
+  *  @param size The size of the allocation.
+  */
+static void cdp_alloc_accounting_charge(struct cdp_alloc_accounting_counters *counters, size_t size)
+{
+    counters->allocations++;
+    counters->bytes_allocated += size;
+    counters->bytes_in_use += size;
+
+    if(counters->bytes_in_use > counters->peak_bytes_in_use)
+        counters->peak_bytes_in_use = counters->bytes_in_use;
+}
+
+/** Credits a release to a set of counters.
+  *  @param counters The counters.
+  *  @param size The size of the allocation.
+  */
+static void cdp_alloc_accounting_credit(struct cdp_alloc_accounting_counters *counters, size_t size)
+{
+    counters->frees++;
+    counters->bytes_in_use -= size;
+}
+
+void *cdp_alloc_accounting_allocate(size_t size, const char *file, const char *function)
+{
+    union cdp_alloc_accounting_header *header;
+
+    header = (union cdp_alloc_accounting_header *)malloc(sizeof(union cdp_alloc_accounting_header) + size);
+    if(header == NULL)
+        return NULL;
+
+    header->block.size = size;
+
+    pthread_mutex_lock(&cdp_alloc_accounting_lock);
+    header->block.site = cdp_alloc_accounting_find_site(file, function);
+    cdp_alloc_accounting_charge(&cdp_alloc_accounting_sites[header->block.site], size);
+    cdp_alloc_accounting_charge(&cdp_alloc_accounting_totals, size);
+    pthread_mutex_unlock(&cdp_alloc_accounting_lock);
+
+    return header + 1;
+}
+
+void cdp_alloc_accounting_release(void *pointer)
+{
+    union cdp_alloc_accounting_header *header;
+
+    if(pointer == NULL)
+        return;
+
+    header = (union cdp_alloc_accounting_header *)pointer - 1;
+
+    pthread_mutex_lock(&cdp_alloc_accounting_lock);
+    cdp_alloc_accounting_credit(&cdp_alloc_accounting_sites[header->block.site], header->block.size);
+    cdp_alloc_accounting_credit(&cdp_alloc_accounting_totals, header->block.size);
+    pthread_mutex_unlock(&cdp_alloc_accounting_lock);
+
+    free(header);
+}
+
+/** Clears the counts of a set of counters, keeping the bytes in use.
+  *  @param counters The counters.
+  */
+static void cdp_alloc_accounting_clear(struct cdp_alloc_accounting_counters *counters)
+{
+    counters->allocations = 0;
+    counters->frees = 0;
+    counters->bytes_allocated = 0;
+    counters->peak_bytes_in_use = counters->bytes_in_use;
+}
+
+void cdp_alloc_accounting_reset(void)
+{
+    size_t i;
+
+    pthread_mutex_lock(&cdp_alloc_accounting_lock);
+
+    for(i = 0; i < CDP_ALLOC_ACCOUNTING_MAX_SITES; i++)
+        cdp_alloc_accounting_clear(&cdp_alloc_accounting_sites[i]);
+
+    cdp_alloc_accounting_clear(&cdp_alloc_accounting_totals);
+
+    pthread_mutex_unlock(&cdp_alloc_accounting_lock);
+}
+
+void cdp_alloc_accounting_get_totals(struct cdp_alloc_accounting_counters *result)
+{
+    pthread_mutex_lock(&cdp_alloc_accounting_lock);
+    *result = cdp_alloc_accounting_totals;
+    pthread_mutex_unlock(&cdp_alloc_accounting_lock);
+}
+
+/** Gets the number of sites, must be called with the lock held.
+  *  @return The number of sites including the overflow site once used.
+  */
+static size_t cdp_alloc_accounting_count_sites(void)
+{
+    if(cdp_alloc_accounting_sites[CDP_ALLOC_ACCOUNTING_MAX_SITES - 1].file != NULL)
+        return cdp_alloc_accounting_site_count + 1;
+
+    return cdp_alloc_accounting_site_count;
+}
+
+size_t cdp_alloc_accounting_get_site_count(void)
+{
+    size_t count;
+
+    pthread_mutex_lock(&cdp_alloc_accounting_lock);
+    count = cdp_alloc_accounting_count_sites();
+    pthread_mutex_unlock(&cdp_alloc_accounting_lock);
+
+    return count;
+}
+
+int cdp_alloc_accounting_get_site(size_t index, struct cdp_alloc_accounting_counters *result)
+{
+    int rc = 0;
+
+    pthread_mutex_lock(&cdp_alloc_accounting_lock);
+
+    if(index >= cdp_alloc_accounting_count_sites())
+        rc = -1;
+    else if(index == cdp_alloc_accounting_site_count)
+        *result = cdp_alloc_accounting_sites[CDP_ALLOC_ACCOUNTING_MAX_SITES - 1];
+    else
+        *result = cdp_alloc_accounting_sites[index];
+
+    pthread_mutex_unlock(&cdp_alloc_accounting_lock);
+
+    return rc;
+}
+
+int cdp_alloc_accounting_get_function(const char *function, struct cdp_alloc_accounting_counters *result)
+{
+    const struct cdp_alloc_accounting_counters *site;
+    int found = 0;
+    size_t i;
+
+    memset(result, 0, sizeof(struct cdp_alloc_accounting_counters));
+    result->function = function;
+
+    pthread_mutex_lock(&cdp_alloc_accounting_lock);
+
+    for(i = 0; i < cdp_alloc_accounting_site_count; i++)
+    {
+        site = &cdp_alloc_accounting_sites[i];
+        if(strcmp(site->function, function) != 0)
+            continue;
+
+        result->file = found == 0 ? site->file : NULL;
+        result->allocations += site->allocations;
+        result->frees += site->frees;
+        result->bytes_allocated += site->bytes_allocated;
+        result->bytes_in_use += site->bytes_in_use;
+        result->peak_bytes_in_use += site->peak_bytes_in_use;
+        found++;
+    }
+
+    pthread_mutex_unlock(&cdp_alloc_accounting_lock);
+
+    return found;
+}
+
+void cdp_alloc_accounting_dump(void)
+{
+    struct cdp_alloc_accounting_counters site;
+    size_t count = cdp_alloc_accounting_get_site_count();
+    size_t i;
+
+    LOG_INFORMATIONAL("%-40s %-48s %10s %10s %12s %12s %12s\n", "function", "file", "allocs", "frees", "bytes", "in use", "peak");
+
+    for(i = 0; i < count; i++)
+    {
+        if(cdp_alloc_accounting_get_site(i, &site) < 0)
+            break;
+
+        LOG_INFORMATIONAL(
+            "%-40s %-48s %10lu %10lu %12zu %12zu %12zu\n",
+            site.function,
+            site.file,
+            site.allocations,
+            site.frees,
+            site.bytes_allocated,
+            site.bytes_in_use,
+            site.peak_bytes_in_use
+        );
+    }
+
+    cdp_alloc_accounting_get_totals(&site);
+    LOG_INFORMATIONAL(
+        "%-40s %-48s %10lu %10lu %12zu %12zu %12zu\n",
+        "(total)",
+        "",
+        site.allocations,
+        site.frees,
+        site.bytes_allocated,
+        site.bytes_in_use,
+        site.peak_bytes_in_use
+    );
+}
+
+#endif
@@ -0,0 +1,88 @@
+#ifndef CDP_ALLOC_ACCOUNTING_H
+#define CDP_ALLOC_ACCOUNTING_H
+
+/* Allocation accounting for instrumented user mode builds. When libcdp is compiled with
+ * CDP_ALLOC_ACCOUNTING defined, ALLOC_NEW, ALLOC_NEW_ARRAY, FREE and FREE_ARRAY in platform.h go
+ * through the functions below, which count the calls and bytes of every call site (the file and
+ * function doing the allocation). Frees are charged to the site which made the allocation, so the
+ * bytes in use of a site are the bytes it allocated which are still alive.
+ *
+ * Every translation unit of a program must be built with or without CDP_ALLOC_ACCOUNTING alike, as
+ * accounted blocks can only be released by FREE or FREE_ARRAY from an accounted build.
+ */
+
+#include "platform/types.h"
+
+/** The counters of a call site or of all sites together */
+struct cdp_alloc_accounting_counters
+{
+    /** The file of the call site, NULL for the totals */
+    const char *file;
+
+    /** The function of the call site, NULL for the totals */
+    const char *function;
+
+    /** The number of allocations made */
+    unsigned long allocations;
+
+    /** The number of those allocations which were released */
+    unsigned long frees;
+
+    /** The number of bytes allocated */
+    size_t bytes_allocated;
+
+    /** The number of bytes allocated and not yet released */
+    size_t bytes_in_use;
+
+    /** The highest value bytes_in_use reached */
+    size_t peak_bytes_in_use;
+};
+
+/** Allocates memory and charges it to a call site, the implementation of ALLOC_NEW and ALLOC_NEW_ARRAY.
+  *  @param size The number of bytes to allocate.
+  *  @param file The file of the call site, a string literal.
+  *  @param function The function of the call site, a string literal.
+  *  @return The allocated memory or NULL on error.
+  */
+void *cdp_alloc_accounting_allocate(size_t size, const char *file, const char *function);
+
+/** Releases memory allocated by cdp_alloc_accounting_allocate, the implementation of FREE and FREE_ARRAY.
+  *  @param pointer The memory to release, may be NULL.
+  */
+void cdp_alloc_accounting_release(void *pointer);
+
+/** Clears the allocation, free and byte counts of every site while keeping the bytes in use, so
+  *  that a test or benchmark can measure a single operation. The peaks restart at the bytes in use.
+  */
+void cdp_alloc_accounting_reset(void);
+
+/** Reads the counters of all sites together.
+  *  @param result The location to store the counters.
+  */
+void cdp_alloc_accounting_get_totals(struct cdp_alloc_accounting_counters *result);
+
+/** Gets the number of call sites which have allocated memory.
+  *  @return The number of sites.
+  */
+size_t cdp_alloc_accounting_get_site_count(void);
+
+/** Reads the counters of a call site by index.
+  *  @param index The index of the site, below cdp_alloc_accounting_get_site_count().
+  *  @param result The location to store the counters.
+  *  @return 0 on success or a negative value if there is no such site.
+  */
+int cdp_alloc_accounting_get_site(size_t index, struct cdp_alloc_accounting_counters *result);
+
+/** Reads the counters of the call sites in a function, summing them if the function name appears
+  *  in more than one file.
+  *  @param function The name of the function.
+  *  @param result The location to store the counters, all 0 if the function made no allocation.
+  *  @return The number of sites found.
+  */
+int cdp_alloc_accounting_get_function(const char *function, struct cdp_alloc_accounting_counters *result);
+
+/** Writes the counters of every call site and the totals with LOG_INFORMATIONAL.
+  */
+void cdp_alloc_accounting_dump(void);
+
+#endif
@@ -0,0 +1,23 @@
+#include "cdp_error.h"
+
+/** The names of the errors, indexed by -error */
+static const char * const cdp_error_names[CDP_ERROR_COUNT] = {
+    "none",
+    "invalid_argument",
+    "truncated",
+    "bad_length",
+    "bad_checksum",
+    "no_memory",
+    "unknown_address_protocol",
+    "bad_value",
+    "buffer_too_small",
+    "missing_field"
+};
+
+const char *cdp_error_name(int error)
+{
+    if(error > 0 || error <= -CDP_ERROR_COUNT)
+        return "unknown";
+
+    return cdp_error_names[-error];
+}
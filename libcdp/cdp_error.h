@@ -0,0 +1,52 @@
+#ifndef CDP_ERROR_H
+#define CDP_ERROR_H
+
+/* The reasons libcdp functions fail. They are returned as the negative result of the stream
+ * reader and writer functions, cdp_parse_packet and cdp_packet_serialize so that callers can
+ * count and rate limit failures by type without formatting any text. Functions which haven't
+ * been converted still return -1, which is CDP_ERROR_INVALID_ARGUMENT, so every error stays
+ * negative and "< 0" checks keep working.
+ */
+enum cdp_error
+{
+    /** No error */
+    CDP_ERROR_NONE = 0,
+
+    /** A required argument was NULL or out of range */
+    CDP_ERROR_INVALID_ARGUMENT = -1,
+
+    /** The input ended in the middle of a field */
+    CDP_ERROR_TRUNCATED = -2,
+
+    /** A TLV or field length is too short for its content or runs past its container */
+    CDP_ERROR_BAD_LENGTH = -3,
+
+    /** The checksum of a frame is wrong */
+    CDP_ERROR_BAD_CHECKSUM = -4,
+
+    /** Memory couldn't be allocated */
+    CDP_ERROR_NO_MEMORY = -5,
+
+    /** An address uses a protocol type, NLPID or SNAP protocol which isn't IPv4 or IPv6 */
+    CDP_ERROR_UNKNOWN_ADDRESS_PROTOCOL = -6,
+
+    /** A field holds a value which isn't allowed, such as an unexpected OUI */
+    CDP_ERROR_BAD_VALUE = -7,
+
+    /** The output buffer is too small for the frame */
+    CDP_ERROR_BUFFER_TOO_SMALL = -8,
+
+    /** A packet lacks a field which is required to serialize it */
+    CDP_ERROR_MISSING_FIELD = -9
+};
+
+/** The number of values of enum cdp_error, for arrays of counters indexed by -error */
+#define CDP_ERROR_COUNT 10
+
+/** Gets the name of an error for logs and statistics.
+  *  @param error The error, a value of enum cdp_error.
+  *  @return A constant string, "unknown" for values outside of the enumeration.
+  */
+const char *cdp_error_name(int error);
+
+#endif
@@ -0,0 +1,47 @@
+#include "cdp_log.h"
+
+#if defined(__linux__) && !defined(__KERNEL__)
+
+#include <stdio.h>
+#include <time.h>
+
+/** Reads the monotonic clock.
+  *  @return The time in milliseconds.
+  */
+static uint64_t cdp_log_now_ms(void)
+{
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    return (uint64_t)now.tv_sec * 1000 + (uint64_t)now.tv_nsec / 1000000;
+}
+
+bool cdp_log_ratelimit_acquire(struct cdp_log_ratelimit *site, const char *function)
+{
+    uint64_t now = cdp_log_now_ms();
+    uint64_t refill_at = __atomic_load_n(&site->refill_at_ms, __ATOMIC_RELAXED);
+    uint32_t suppressed;
+
+    /* Only the thread which moves the refill time forward refills the bucket */
+    if(
+        now >= refill_at &&
+        __atomic_compare_exchange_n(&site->refill_at_ms, &refill_at, now + CDP_LOG_RATELIMIT_INTERVAL_MS, false, __ATOMIC_RELAXED, __ATOMIC_RELAXED)
+    )
+    {
+        __atomic_store_n(&site->tokens, CDP_LOG_RATELIMIT_BURST, __ATOMIC_RELAXED);
+
+        suppressed = __atomic_exchange_n(&site->suppressed, 0, __ATOMIC_RELAXED);
+        if(suppressed != 0)
+            fprintf(stderr, "%s: %u messages suppressed\n", function, suppressed);
+    }
+
+    if(__atomic_sub_fetch(&site->tokens, 1, __ATOMIC_RELAXED) >= 0)
+        return true;
+
+    __atomic_add_fetch(&site->suppressed, 1, __ATOMIC_RELAXED);
+
+    return false;
+}
+
+#endif
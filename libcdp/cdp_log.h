@@ -0,0 +1,39 @@
+#ifndef CDP_LOG_H
+#define CDP_LOG_H
+
+/* Rate limiting of the user mode LOG_CRITICAL and LOG_ERROR macros in platform.h. Every call site
+ * gets its own token bucket, so a flood of bad frames can only log a few lines per interval for
+ * each distinct error instead of costing far more than parsing the frames. The kernel build uses
+ * printk_ratelimited for the same purpose.
+ */
+
+#include "platform/types.h"
+
+/** The number of messages a call site may log at once */
+#define CDP_LOG_RATELIMIT_BURST 10
+
+/** The interval in milliseconds after which the bucket of a call site is full again */
+#define CDP_LOG_RATELIMIT_INTERVAL_MS 5000
+
+/** The token bucket of a call site, zero initialized */
+struct cdp_log_ratelimit
+{
+    /** The monotonic time in milliseconds at which the bucket is refilled */
+    uint64_t refill_at_ms;
+
+    /** The tokens left in the bucket, negative once messages are being suppressed */
+    int32_t tokens;
+
+    /** The number of messages suppressed since the bucket was last refilled */
+    uint32_t suppressed;
+};
+
+/** Takes a token from the bucket of a call site. When the bucket is refilled after messages were
+  *  suppressed, the number of them is logged first.
+  *  @param site The bucket of the call site.
+  *  @param function The function of the call site, used when reporting suppressed messages.
+  *  @return true if the message may be logged.
+  */
+bool cdp_log_ratelimit_acquire(struct cdp_log_ratelimit *site, const char *function);
+
+#endif
@@ -13,14 +13,14 @@ struct cdp_neighbor *cdp_neighbor_new(void)
     }
 
     result->device_type = 0;
-    result->device_name = NULL;
-    result->remote_mac = NULL;
-    result->remote_mac_length = 0;
+    result->device_index = 0;
+    result->remote_mac = 0;
     result->received_at.tv_sec = 0;
     result->received_at.tv_nsec = 0;
     result->frame_buffer_size = 0;
     result->frame_buffer_length = 0;
     result->frame_buffer = NULL;
+    result->frame_hash = 0;
     result->next = NULL;
     result->prev = NULL;
 
@@ -38,14 +38,10 @@ void cdp_neighbor_delete(struct cdp_neighbor *neighbor)
     if(neighbor->next != NULL || neighbor->prev != NULL)
         LOG_CRITICAL("cdp_neighbor_delete: deleting neighbor which appears to still be in a list.\n");
 
-    if(neighbor->device_name != NULL)
-        FREE_ARRAY(neighbor->device_name);
-
-    if(neighbor->remote_mac != NULL)
-        FREE_ARRAY(neighbor->remote_mac);
-
     if(neighbor->frame_buffer != NULL)
         FREE_ARRAY(neighbor->frame_buffer);
+
+    FREE(neighbor);
 }
 
 int cdp_neighbor_set_device_type(struct cdp_neighbor *neighbor, int device_type)
@@ -61,38 +57,39 @@ int cdp_neighbor_set_device_type(struct cdp_neighbor *neighbor, int device_type)
     return 0;
 }
 
-int cdp_neighbor_set_device_name(struct cdp_neighbor *neighbor, const char *device_name)
+int cdp_neighbor_set_device_index(struct cdp_neighbor *neighbor, int device_index)
 {
-    size_t device_name_length;
-
     if(neighbor == NULL)
     {
-        LOG_CRITICAL("cdp_neighbor_set_device_name: neighbor is NULL.\n");
+        LOG_CRITICAL("cdp_neighbor_set_device_index: neighbor is NULL.\n");
         return -1;
     }
 
-    if(device_name == NULL)
-    {
-        LOG_CRITICAL("cdp_neighbor_set_device_name: device_name is NULL.\n");
-        return -1;
-    }
+    neighbor->device_index = device_index;
 
-    if(neighbor->device_name != NULL)
-        FREE_ARRAY(neighbor->device_name);
+    return 0;
+}
 
-    device_name_length = strlen(device_name);
+uint64_t cdp_neighbor_pack_mac(const unsigned char *mac)
+{
+    uint64_t result = 0;
+    int i;
 
-    neighbor->device_name = ALLOC_NEW_ARRAY(char, (device_name_length + 1));
-    
-    if(neighbor->device_name == NULL)
-    {
-        LOG_CRITICAL("cdp_neighbor_set_device_name: failed to allocate memory to store the new device_name\n");
-        return -1;
-    }
+    for(i = 0; i < CDP_NEIGHBOR_MAC_LENGTH; i++)
+        result = (result << 8) | mac[i];
 
-    strcpy(neighbor->device_name, device_name);
+    return result;
+}
 
-    return 0;
+void cdp_neighbor_unpack_mac(uint64_t value, unsigned char *mac)
+{
+    int i;
+
+    for(i = CDP_NEIGHBOR_MAC_LENGTH - 1; i >= 0; i--)
+    {
+        mac[i] = (unsigned char)(value & 0xFF);
+        value >>= 8;
+    }
 }
 
 int cdp_neighbor_set_remote_mac(struct cdp_neighbor *neighbor, const unsigned char *remote_mac, size_t remote_mac_length)
@@ -109,33 +106,13 @@ int cdp_neighbor_set_remote_mac(struct cdp_neighbor *neighbor, const unsigned ch
         return -1;
     }
 
-    if(remote_mac_length == 0)
-    {
-        LOG_CRITICAL("cdp_neighbor_set_remote_mac: remote_mac_length is zero.\n");
-        return -1;
-    }
-
-    if(neighbor->remote_mac != NULL)
+    if(remote_mac_length != CDP_NEIGHBOR_MAC_LENGTH)
     {
-        if(neighbor->remote_mac_length == remote_mac_length)
-        {
-            memcpy(neighbor->remote_mac, remote_mac, remote_mac_length);
-            return 0;
-        }
-
-        FREE_ARRAY(neighbor->remote_mac);
-    }
-
-    neighbor->remote_mac = ALLOC_NEW_ARRAY(unsigned char, remote_mac_length);
-
-    if(neighbor->remote_mac == NULL)
-    {
-        LOG_CRITICAL("cdp_neighbor_set_remote_mac: failed to allocate memory to store the new remote MAC address\n");
+        LOG_CRITICAL("cdp_neighbor_set_remote_mac: remote_mac_length is not the length of a MAC address.\n");
         return -1;
     }
 
-    memcpy(neighbor->remote_mac, remote_mac, remote_mac_length);
-    neighbor->remote_mac_length = remote_mac_length;
+    neighbor->remote_mac = cdp_neighbor_pack_mac(remote_mac);
 
     return 0;
 }
@@ -173,16 +150,6 @@ int cdp_neighbor_set_frame_buffer(struct cdp_neighbor *neighbor, const unsigned
         return -1;
     }
 
-    /* If there is a frame buffer already but it's too small to contain the new frame buffer, then delete the old one */
-    if(neighbor->frame_buffer != NULL && neighbor->frame_buffer_size < frame_buffer_length)
-    {
-        FREE_ARRAY(neighbor->frame_buffer);
-        neighbor->frame_buffer = NULL;
-        neighbor->frame_buffer_length = 0;
-        neighbor->frame_buffer_size = 0;        
-    }
-
-    /* If there is no frame buffer, then allocate a new one */
     if(neighbor->frame_buffer == NULL)
     {
         if(neighbor->frame_buffer_size > 0)
@@ -196,15 +163,25 @@ int cdp_neighbor_set_frame_buffer(struct cdp_neighbor *neighbor, const unsigned
             LOG_CRITICAL("cdp_neighbor_set_frame_buffer: neighbor->frame_buffer is null but neighbor->frame_buffer_length is greater than 0, frame buffer corrupt!\n");
             return -1;
         }
+    }
 
-        neighbor->frame_buffer = ALLOC_NEW_ARRAY(unsigned char, frame_buffer_length);
+    /* If there is no frame buffer or it's too small, then allocate a new one. The old one is only released
+     * once the new one is allocated so that a failure leaves the neighbor's previous frame in place.
+     */
+    if(neighbor->frame_buffer == NULL || neighbor->frame_buffer_size < frame_buffer_length)
+    {
+        unsigned char *new_frame_buffer = ALLOC_NEW_ARRAY(unsigned char, frame_buffer_length);
 
-        if(neighbor->frame_buffer == NULL)
+        if(new_frame_buffer == NULL)
         {
             LOG_CRITICAL("cdp_neighbor_set_frame_buffer: Failed to allocate memory to store frame buffer\n");
             return -1;
         }
 
+        if(neighbor->frame_buffer != NULL)
+            FREE_ARRAY(neighbor->frame_buffer);
+
+        neighbor->frame_buffer = new_frame_buffer;
         neighbor->frame_buffer_size = frame_buffer_length;
     }
 
@@ -216,57 +193,37 @@ int cdp_neighbor_set_frame_buffer(struct cdp_neighbor *neighbor, const unsigned
 
     memcpy(neighbor->frame_buffer, frame_buffer, frame_buffer_length);
     neighbor->frame_buffer_length = frame_buffer_length;
+    neighbor->frame_hash = cdp_neighbor_hash_frame(frame_buffer, frame_buffer_length);
 
     return 0;
 }
 
-bool cdp_neighbor_device_name_equals(const struct cdp_neighbor *neighbor, const char *device_name)
+uint32_t cdp_neighbor_hash_frame(const unsigned char *frame_buffer, size_t frame_buffer_length)
 {
-    if(neighbor == NULL)
-    {
-        LOG_CRITICAL("cdp_neighbor_device_name_equals: neighbor is NULL.\n");
-        return false;
-    }
+    uint32_t hash = 2166136261U;
+    size_t i;
 
-    if(neighbor->device_name == NULL)
-    {
-        LOG_CRITICAL("cdp_neighbor_device_name_equals: neighbor->device_name is NULL.\n");
-        return false;
-    }
+    if(frame_buffer == NULL)
+        return hash;
 
-    if(device_name == NULL)
+    for(i = 0; i < frame_buffer_length; i++)
     {
-        LOG_CRITICAL("cdp_neighbor_device_name_equals: device_name is NULL.\n");
-        return false;
+        hash ^= frame_buffer[i];
+        hash *= 16777619U;
     }
 
-    return (strcmp(neighbor->device_name, device_name) == 0) ? true : false;
+    return hash;
 }
 
-bool cdp_neighbor_remote_mac_equals(const struct cdp_neighbor *neighbor, const unsigned char *remote_mac, size_t remote_mac_length)
+bool cdp_neighbor_identity_equals(const struct cdp_neighbor *neighbor, int device_index, uint64_t remote_mac)
 {
     if(neighbor == NULL)
     {
-        LOG_CRITICAL("cdp_neighbor_remote_mac_equals: neighbor is NULL.\n");
+        LOG_CRITICAL("cdp_neighbor_identity_equals: neighbor is NULL.\n");
         return false;
     }
 
-    if(neighbor->remote_mac == NULL)
-    {
-        LOG_CRITICAL("cdp_neighbor_remote_mac_equals: neighbor->remote_mac is NULL.\n");
-        return false;
-    }
-
-    if(remote_mac == NULL)
-    {
-        LOG_CRITICAL("cdp_neighbor_remote_mac_equals: remote_mac is NULL.\n");
-        return false;
-    }
-
-    if(neighbor->remote_mac_length != remote_mac_length)
-        return false;
-
-    return (memcmp(neighbor->remote_mac, remote_mac, remote_mac_length) == 0) ? true : false;
+    return (neighbor->remote_mac == remote_mac && neighbor->device_index == device_index) ? true : false;
 }
 
 int cdp_neighbor_get_hold_time(const struct cdp_neighbor *neighbor)
@@ -443,9 +400,8 @@ struct cdp_neighbor *cdp_neighbor_list_get_by_index(struct cdp_neighbor_list *li
 
 struct cdp_neighbor *cdp_neighbor_list_get_by_identity(
     struct cdp_neighbor_list *list,
-    const char *device_name,
-    const unsigned char *remote_mac,
-    size_t remote_mac_length)
+    int device_index,
+    uint64_t remote_mac)
 {
     struct cdp_neighbor *result;
 
@@ -455,13 +411,11 @@ struct cdp_neighbor *cdp_neighbor_list_get_by_identity(
         return NULL;
     }
 
+    /* The MAC differs between most neighbors, so it is compared first */
     result = list->head;
     while(result != NULL)
     {
-        if(            
-            cdp_neighbor_device_name_equals(result, device_name) &&
-            cdp_neighbor_remote_mac_equals(result, remote_mac, remote_mac_length)
-        )
+        if(result->remote_mac == remote_mac && result->device_index == device_index)
             return result;
 
         result = result->next;
@@ -473,9 +427,8 @@ struct cdp_neighbor *cdp_neighbor_list_get_by_identity(
 struct cdp_neighbor *cdp_neighbor_list_get_or_create_by_identity(
     struct cdp_neighbor_list *list,
     int device_type,
-    const char *device_name,
-    const unsigned char *remote_mac,
-    size_t remote_mac_length)
+    int device_index,
+    uint64_t remote_mac)
 {
     struct cdp_neighbor *result;
 
@@ -485,25 +438,7 @@ struct cdp_neighbor *cdp_neighbor_list_get_or_create_by_identity(
         return NULL;
     }
 
-    if(device_name == NULL)
-    {
-        LOG_CRITICAL("cdp_neighbor_list_get_or_create_by_identity: device_name is NULL\n");
-        return NULL;
-    }
-
-    if(remote_mac == NULL)
-    {
-        LOG_CRITICAL("cdp_neighbor_list_get_or_create_by_identity: remote_mac is NULL\n");
-        return NULL;
-    }
-
-    if(remote_mac_length == 0)
-    {
-        LOG_CRITICAL("cdp_neighbor_list_get_or_create_by_identity: remote_mac_length is NULL\n");
-        return NULL;
-    }
-
-    result = cdp_neighbor_list_get_by_identity(list, device_name, remote_mac, remote_mac_length);
+    result = cdp_neighbor_list_get_by_identity(list, device_index, remote_mac);
 
     if(result != NULL)
         return result;
@@ -523,19 +458,14 @@ struct cdp_neighbor *cdp_neighbor_list_get_or_create_by_identity(
         return NULL;
     }
 
-    if(cdp_neighbor_set_device_name(result, device_name) != 0)
+    if(cdp_neighbor_set_device_index(result, device_index) != 0)
     {
-        LOG_CRITICAL("cdp_neighbor_list_get_or_create_by_identity: failed to set the device name.\n");
+        LOG_CRITICAL("cdp_neighbor_list_get_or_create_by_identity: failed to set the device index.\n");
         cdp_neighbor_delete(result);
         return NULL;
     }
 
-    if(cdp_neighbor_set_remote_mac(result, remote_mac, remote_mac_length) != 0)
-    {
-        LOG_CRITICAL("cdp_neighbor_list_get_or_create_by_identity: failed to set the remote MAC address.\n");
-        cdp_neighbor_delete(result);
-        return NULL;
-    }
+    result->remote_mac = remote_mac;
 
     if(cdp_neighbor_list_append(list, result) != 0)
     {
@@ -549,9 +479,8 @@ struct cdp_neighbor *cdp_neighbor_list_get_or_create_by_identity(
 
 struct cdp_neighbor *cdp_neighbor_list_take_by_identity(
     struct cdp_neighbor_list *list,
-    const char *device_name,
-    const unsigned char *remote_mac,
-    size_t remote_mac_length)
+    int device_index,
+    uint64_t remote_mac)
 {
     struct cdp_neighbor *result;
 
@@ -561,7 +490,7 @@ struct cdp_neighbor *cdp_neighbor_list_take_by_identity(
         return NULL;
     }
 
-    result = cdp_neighbor_list_get_by_identity(list, device_name, remote_mac, remote_mac_length);
+    result = cdp_neighbor_list_get_by_identity(list, device_index, remote_mac);
 
     if(result == NULL)
         return NULL;
@@ -619,6 +548,7 @@ int cdp_neighbor_list_append(struct cdp_neighbor_list *list, struct cdp_neighbor
     list->tail->next = item;
     item->prev = list->tail;
     list->tail = item;
+    list->count++;
 
     return 0;
 }
@@ -682,40 +612,115 @@ int cdp_neighbor_list_remove_item(struct cdp_neighbor_list *list, struct cdp_nei
     item->next = NULL;
     item->prev = NULL;
 
+    list->count--;
+
     return 0;
 }
 
-int cdp_neighbor_list_purge_expired_neighbors(struct cdp_neighbor_list *list, struct timespec now)
+int cdp_neighbor_list_take_expired_neighbors(struct cdp_neighbor_list *list, struct timespec now, struct cdp_neighbor_list *expired)
 {
     struct cdp_neighbor *item;
+    struct cdp_neighbor *next;
+    int result = 0;
 
     if(list == NULL)
     {
-        LOG_CRITICAL("cdp_neighbor_list_purge_expired_neighbors: list is NULL\n");
+        LOG_CRITICAL("cdp_neighbor_list_take_expired_neighbors: list is NULL\n");
+        return -1;
+    }
+
+    if(expired == NULL)
+    {
+        LOG_CRITICAL("cdp_neighbor_list_take_expired_neighbors: expired is NULL\n");
         return -1;
     }
 
     item = list->head;
     while(item != NULL)
     {
+        next = item->next;
+
         if(cdp_neighbor_is_expired(item, now))
         {
-            struct cdp_neighbor *expired_item;
+            if(cdp_neighbor_list_remove_item(list, item) < 0)
+            {
+                LOG_CRITICAL("cdp_neighbor_list_take_expired_neighbors: failed to remove item. List is most likely corrupted now\n");
+                return -1;
+            }
 
-            expired_item = item;
-            item = item->prev;
-            if(cdp_neighbor_list_remove_item(list, expired_item) < 0)
+            if(cdp_neighbor_list_append(expired, item) < 0)
             {
-                LOG_CRITICAL("cdp_neighbor_list_purge_expired_neighbors: failed to remove item. List  is most likely corrupted now\n");
+                LOG_CRITICAL("cdp_neighbor_list_take_expired_neighbors: failed to append item to the expired list\n");
+                cdp_neighbor_delete(item);
                 return -1;
             }
 
-            cdp_neighbor_delete(expired_item);
+            result++;
         }
 
-        if(item != NULL)
-            item = item->next;
+        item = next;
     }
 
-    return 0;
+    return result;
+}
+
+int cdp_neighbor_list_get_next_expiry(const struct cdp_neighbor_list *list, struct timespec *result)
+{
+    const struct cdp_neighbor *item;
+    time_t expires_at;
+    bool found = false;
+    int hold_time;
+
+    if(list == NULL)
+    {
+        LOG_CRITICAL("cdp_neighbor_list_get_next_expiry: list is NULL\n");
+        return -1;
+    }
+
+    if(result == NULL)
+    {
+        LOG_CRITICAL("cdp_neighbor_list_get_next_expiry: result is NULL\n");
+        return -1;
+    }
+
+    for(item = list->head; item != NULL; item = item->next)
+    {
+        hold_time = cdp_neighbor_get_hold_time(item);
+        if(hold_time < 0)
+            continue;
+
+        /* Matches cdp_neighbor_is_expired which expires a second ahead of the hold time */
+        expires_at = item->received_at.tv_sec + hold_time - 1;
+
+        if(!found || expires_at < result->tv_sec)
+        {
+            result->tv_sec = expires_at;
+            result->tv_nsec = 0;
+            found = true;
+        }
+    }
+
+    return found ? 1 : 0;
+}
+
+int cdp_neighbor_list_purge_expired_neighbors(struct cdp_neighbor_list *list, struct timespec now)
+{
+    struct cdp_neighbor_list expired;
+    int result;
+
+    if(list == NULL)
+    {
+        LOG_CRITICAL("cdp_neighbor_list_purge_expired_neighbors: list is NULL\n");
+        return -1;
+    }
+
+    expired.head = NULL;
+    expired.tail = NULL;
+    expired.count = 0;
+
+    result = cdp_neighbor_list_take_expired_neighbors(list, now, &expired);
+
+    cdp_neighbor_list_clean(&expired);
+
+    return (result < 0) ? -1 : 0;
 }
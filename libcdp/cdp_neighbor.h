@@ -4,6 +4,9 @@
 #include "platform/time.h"
 #include "platform/types.h"
 
+/** The length in bytes of the MAC address of a neighbor */
+#define CDP_NEIGHBOR_MAC_LENGTH 6
+
 /** Cisco Discovery Protocol neighbor */
 struct cdp_neighbor
 {
@@ -12,14 +15,14 @@ struct cdp_neighbor
       */
     int device_type;
 
-    /** The name of the interface upon which the neighbor exists. */
-    char *device_name;
-
-    /** The neighbor's MAC address */
-    unsigned char *remote_mac;
+    /** The index of the interface upon which the neighbor exists (ifindex). Together with remote_mac
+      * it identifies the neighbor. Interfaces can be renamed, so the name is looked up from the
+      * index only when the neighbor is displayed.
+      */
+    int device_index;
 
-    /** The neighbor's MAC address length */
-    size_t remote_mac_length;
+    /** The neighbor's 48-bit MAC address packed by cdp_neighbor_pack_mac() */
+    uint64_t remote_mac;
 
     /** The time when the current frame was received */
     struct timespec received_at;
@@ -33,6 +36,9 @@ struct cdp_neighbor
     /** The frame buffer itself. */
     unsigned char *frame_buffer;
 
+    /** A hash of the content of the frame buffer, used to detect changes between frames */
+    uint32_t frame_hash;
+
     /** The next item in the linked list of neighbors */
     struct cdp_neighbor *next;
 
@@ -57,17 +63,29 @@ void cdp_neighbor_delete(struct cdp_neighbor *neighbor);
   */
 int cdp_neighbor_set_device_type(struct cdp_neighbor *neighbor, int device_type);
 
-/** Set the device name.
+/** Set the device index.
   *  @param neighbor The neighbor object.
-  *  @param device_name The value to set
+  *  @param device_index The interface index of the device.
   *  @return 0 on success, a negative value on failure.
   */
-int cdp_neighbor_set_device_name(struct cdp_neighbor *neighbor, const char *device_name);
+int cdp_neighbor_set_device_index(struct cdp_neighbor *neighbor, int device_index);
+
+/** Packs a 48-bit MAC address into an integer so that addresses compare with a single instruction.
+  *  @param mac The CDP_NEIGHBOR_MAC_LENGTH bytes of the address.
+  *  @return The address with its first byte in bits 40 to 47.
+  */
+uint64_t cdp_neighbor_pack_mac(const unsigned char *mac);
+
+/** Unpacks a MAC address packed by cdp_neighbor_pack_mac().
+  *  @param value The packed address.
+  *  @param mac The buffer of CDP_NEIGHBOR_MAC_LENGTH bytes to receive the address.
+  */
+void cdp_neighbor_unpack_mac(uint64_t value, unsigned char *mac);
 
 /** Set the device's remote MAC address
   *  @param neighbor The neighbor object.
   *  @param remote_mac The remote MAC address buffer.
-  *  @param remote_mac_length The length of the remote MAC address in bytes.
+  *  @param remote_mac_length The length of the remote MAC address in bytes, which must be CDP_NEIGHBOR_MAC_LENGTH.
   *  @return 0 on success, a negative value on failure.
   */
 int cdp_neighbor_set_remote_mac(struct cdp_neighbor *neighbor, const unsigned char *remote_mac, size_t remote_mac_length);
@@ -83,24 +101,24 @@ int cdp_neighbor_set_received_at(struct cdp_neighbor *neighbor, struct timespec
   *  @param neighbor The neighbor object.
   *  @param frame_buffer The buffer containing the frame (will be copied).
   *  @param frame_buffer_length The length of the frame buffer in bytes.
-  *  @return 0 on success or a negative value on failure.
+  *  @return 0 on success or a negative value on failure, in which case the previous frame is kept.
   */
 int cdp_neighbor_set_frame_buffer(struct cdp_neighbor *neighbor, const unsigned char *frame_buffer, size_t frame_buffer_length);
 
-/** Tests to see whether the entry's device name matches the given.
-  *  @param neighbor The neighbor entry.
-  *  @param device_name The name to test against.
-  *  @return true on match or false otherwise.
+/** Calculates a hash (32-bit FNV-1a) of a frame buffer for detecting content changes.
+  *  @param frame_buffer The buffer to hash.
+  *  @param frame_buffer_length The length of the buffer in bytes.
+  *  @return The hash value.
   */
-bool cdp_neighbor_device_name_equals(const struct cdp_neighbor *neighbor, const char *device_name);
+uint32_t cdp_neighbor_hash_frame(const unsigned char *frame_buffer, size_t frame_buffer_length);
 
-/** Tests to see whether the entry's remote MAC address matches the given.
-  *  @param neighnor The neighbor entry.
-  *  @param remote_mac The remote MAC address to test.
-  *  @param remote_mac_length The remote mac address length.
+/** Tests to see whether the entry was received on the given interface from the given MAC address.
+  *  @param neighbor The neighbor entry.
+  *  @param device_index The index of the interface to test against.
+  *  @param remote_mac The packed remote MAC address to test against.
   *  @return true on match or false otherwise.
   */
-bool cdp_neighbor_remote_mac_equals(const struct cdp_neighbor *neighbor, const unsigned char *remote_mac, size_t remote_mac_length);
+bool cdp_neighbor_identity_equals(const struct cdp_neighbor *neighbor, int device_index, uint64_t remote_mac);
 
 /** Extracts the hold time from the frame_buffer if it's available.
   *  This is a helper function that is present so that it's not necessary to
@@ -163,48 +181,42 @@ struct cdp_neighbor *cdp_neighbor_list_take_first(struct cdp_neighbor_list *list
   */
 struct cdp_neighbor *cdp_neighbor_list_get_by_index(struct cdp_neighbor_list *list, int index);
 
-/** Finds the neighbor entry by the network device name it was received on and the remote MAC address.
+/** Finds the neighbor entry by the index of the network device it was received on and the remote MAC address.
   *  @param list The list to search.
-  *  @param device_name The name of the network interface to search on.
-  *  @param remote_mac The MAC address on the interface to search for.
-  *  @param remote_mac_length The length of the remote_mac in bytes.
+  *  @param device_index The index of the network interface to search on.
+  *  @param remote_mac The packed MAC address on the interface to search for.
   *  @return Either the CDP neighbor entry or NULL if it wasn't found.
   */
 struct cdp_neighbor *cdp_neighbor_list_get_by_identity(
     struct cdp_neighbor_list *list,
-    const char *device_name,
-    const unsigned char *remote_mac,
-    size_t remote_mac_length);
+    int device_index,
+    uint64_t remote_mac);
 
-/** Finds the neighbor entry by the network device name it was received on and the remote MAC address.
+/** Finds the neighbor entry by the index of the network device it was received on and the remote MAC address.
   *  If the neighbor doesn't exist, it will create a new entry and insert it into the list.
   *  @param list The list to search.
   *  @param device_type The device type of the network interface.
-  *  @param device_name The name of the network interface to search on.
-  *  @param remote_mac The MAC address on the interface to search for.
-  *  @param remote_mac_length The length of the remote_mac in bytes.
+  *  @param device_index The index of the network interface to search on.
+  *  @param remote_mac The packed MAC address on the interface to search for.
   *  @return Either the CDP neighbor entry or NULL if it wasn't found.
   */
 struct cdp_neighbor *cdp_neighbor_list_get_or_create_by_identity(
     struct cdp_neighbor_list *list,
     int device_type,
-    const char *device_name,
-    const unsigned char *remote_mac,
-    size_t remote_mac_length);
+    int device_index,
+    uint64_t remote_mac);
 
-/** Finds the neighbor entry by the network device name it was received on and the remote MAC
+/** Finds the neighbor entry by the index of the network device it was received on and the remote MAC
   *  address and removes it from the list before returning.
   *  @param list The list to search.
-  *  @param device_name The name of the network interface to search on.
-  *  @param remote_mac The MAC address on the interface to search for.
-  *  @param remote_mac_length The length of the remote_mac in bytes.
+  *  @param device_index The index of the network interface to search on.
+  *  @param remote_mac The packed MAC address on the interface to search for.
   *  @return Either the CDP neighbor entry or NULL if it wasn't found.
   */
 struct cdp_neighbor *cdp_neighbor_list_take_by_identity(
     struct cdp_neighbor_list *list,
-    const char *device_name,
-    const unsigned char *remote_mac,
-    size_t remote_mac_length);
+    int device_index,
+    uint64_t remote_mac);
 
 /** Appends a new item to the end of the list
   *  @param list The list to append to.
@@ -220,6 +232,23 @@ int cdp_neighbor_list_append(struct cdp_neighbor_list *list, struct cdp_neighbor
   */
 int cdp_neighbor_list_remove_item(struct cdp_neighbor_list *list, struct cdp_neighbor *item);
 
+/** Iterates over the list and moves the neighbors whose hold timers have expired to another list.
+  *  This allows the caller to report on the expired neighbors after releasing any locks held on the list.
+  *  @param list The list object
+  *  @param now The current time relative to received_at
+  *  @param expired The list to append the expired neighbors to.
+  *  @return The number of neighbors moved or a negative value on error.
+  */
+int cdp_neighbor_list_take_expired_neighbors(struct cdp_neighbor_list *list, struct timespec now, struct cdp_neighbor_list *expired);
+
+/** Finds the time at which the next neighbor in the list will expire so that a caller can sleep
+  *  until then instead of checking periodically.
+  *  @param list The list object
+  *  @param result The location to store the expiry time, relative to received_at.
+  *  @return 1 if an expiry time was stored, 0 if no neighbor will expire or a negative value on error.
+  */
+int cdp_neighbor_list_get_next_expiry(const struct cdp_neighbor_list *list, struct timespec *result);
+
 /** Iterates over the list and purges the neighbors whose hold timers have expired
   *  @param list The list object
   *  @param now The current time relative to received_at
@@ -0,0 +1,363 @@
+#include "cdp_neighbor_record.h"
+#include "stream_writer.h"
+#include "platform/platform.h"
+#include "platform/string.h"
+
+ssize_t cdp_neighbor_record_length(const struct cdp_neighbor *neighbor)
+{
+    if(neighbor == NULL)
+    {
+        LOG_CRITICAL("cdp_neighbor_record_length: neighbor is NULL.\n");
+        return -1;
+    }
+
+    if(neighbor->frame_buffer == NULL || neighbor->frame_buffer_length == 0)
+    {
+        LOG_ERROR("cdp_neighbor_record_length: neighbor has no frame.\n");
+        return -1;
+    }
+
+    return (ssize_t)(CDP_NEIGHBOR_RECORD_HEADER_LENGTH + neighbor->frame_buffer_length);
+}
+
+ssize_t cdp_neighbor_record_write_header(const struct cdp_neighbor *neighbor, uint8_t *buffer, size_t buffer_size)
+{
+    struct stream_writer *writer;
+    uint8_t mac[CDP_NEIGHBOR_RECORD_MAX_MAC_LENGTH];
+    ssize_t record_length;
+    uint64_t received_at_seconds;
+    int hold_time;
+    ssize_t result;
+
+    if(buffer == NULL)
+    {
+        LOG_CRITICAL("cdp_neighbor_record_write_header: buffer is NULL.\n");
+        return -1;
+    }
+
+    if(buffer_size < CDP_NEIGHBOR_RECORD_HEADER_LENGTH)
+    {
+        LOG_ERROR("cdp_neighbor_record_write_header: buffer is too small for the record header.\n");
+        return -1;
+    }
+
+    record_length = cdp_neighbor_record_length(neighbor);
+    if(record_length < 0)
+    {
+        LOG_ERROR("cdp_neighbor_record_write_header: could not calculate the record length.\n");
+        return -1;
+    }
+
+    hold_time = cdp_neighbor_get_hold_time(neighbor);
+    if(hold_time < 0)
+    {
+        LOG_ERROR("cdp_neighbor_record_write_header: could not read the hold time from the frame.\n");
+        return -1;
+    }
+
+    cdp_neighbor_unpack_mac(neighbor->remote_mac, mac);
+
+    received_at_seconds = (uint64_t)(int64_t)neighbor->received_at.tv_sec;
+
+    writer = stream_writer_new(buffer, buffer_size);
+    if(writer == NULL)
+    {
+        LOG_CRITICAL("cdp_neighbor_record_write_header: failed to create stream writer.\n");
+        return -1;
+    }
+
+    if(
+        stream_writer_put16(writer, CDP_NEIGHBOR_RECORD_VERSION) < 0 ||
+        stream_writer_put16(writer, CDP_NEIGHBOR_RECORD_HEADER_LENGTH) < 0 ||
+        stream_writer_put32(writer, (uint32_t)record_length) < 0 ||
+        stream_writer_put32(writer, (uint32_t)neighbor->device_index) < 0 ||
+        stream_writer_put8(writer, (uint8_t)hold_time) < 0 ||
+        stream_writer_put8(writer, CDP_NEIGHBOR_MAC_LENGTH) < 0 ||
+        stream_writer_put_buffer(writer, mac, sizeof(mac)) < 0 ||
+        stream_writer_put32(writer, (uint32_t)(received_at_seconds >> 32)) < 0 ||
+        stream_writer_put32(writer, (uint32_t)(received_at_seconds & 0xFFFFFFFF)) < 0 ||
+        stream_writer_put32(writer, (uint32_t)neighbor->received_at.tv_nsec) < 0
+    )
+    {
+        LOG_ERROR("cdp_neighbor_record_write_header: failed to write the record header.\n");
+        stream_writer_delete(writer);
+        return -1;
+    }
+
+    result = stream_writer_length(writer);
+    stream_writer_delete(writer);
+
+    return result;
+}
+
+ssize_t cdp_neighbor_record_serialize(const struct cdp_neighbor *neighbor, uint8_t *buffer, size_t buffer_size)
+{
+    ssize_t record_length;
+    ssize_t header_length;
+
+    record_length = cdp_neighbor_record_length(neighbor);
+    if(record_length < 0)
+    {
+        LOG_ERROR("cdp_neighbor_record_serialize: could not calculate the record length.\n");
+        return -1;
+    }
+
+    if(buffer == NULL)
+    {
+        LOG_CRITICAL("cdp_neighbor_record_serialize: buffer is NULL.\n");
+        return -1;
+    }
+
+    if(buffer_size < (size_t)record_length)
+    {
+        LOG_ERROR("cdp_neighbor_record_serialize: buffer is too small for the record.\n");
+        return -1;
+    }
+
+    header_length = cdp_neighbor_record_write_header(neighbor, buffer, buffer_size);
+    if(header_length < 0)
+    {
+        LOG_ERROR("cdp_neighbor_record_serialize: failed to write the record header.\n");
+        return -1;
+    }
+
+    memcpy(buffer + header_length, neighbor->frame_buffer, neighbor->frame_buffer_length);
+
+    return record_length;
+}
+
+int cdp_neighbor_record_parse(struct stream_reader *reader, struct cdp_neighbor **result)
+{
+    struct cdp_neighbor *neighbor;
+    off_t record_start;
+    uint16_t version;
+    uint16_t header_length;
+    uint32_t record_length;
+    uint32_t device_index;
+    uint8_t hold_time;
+    uint8_t mac_length;
+    uint8_t mac[CDP_NEIGHBOR_RECORD_MAX_MAC_LENGTH];
+    uint32_t seconds_high;
+    uint32_t seconds_low;
+    uint32_t nanoseconds;
+    struct timespec received_at;
+    size_t frame_length;
+
+    if(reader == NULL)
+    {
+        LOG_CRITICAL("cdp_neighbor_record_parse: reader is NULL.\n");
+        return -1;
+    }
+
+    if(result == NULL)
+    {
+        LOG_CRITICAL("cdp_neighbor_record_parse: result is NULL.\n");
+        return -1;
+    }
+
+    *result = NULL;
+
+    record_start = stream_reader_get_position(reader);
+
+    if(
+        stream_reader_get16(reader, &version) < 0 ||
+        stream_reader_get16(reader, &header_length) < 0 ||
+        stream_reader_get32(reader, &record_length) < 0
+    )
+    {
+        LOG_ERROR("cdp_neighbor_record_parse: record is truncated.\n");
+        return -1;
+    }
+
+    if(version != CDP_NEIGHBOR_RECORD_VERSION)
+    {
+        LOG_ERROR("cdp_neighbor_record_parse: unsupported record version %d.\n", (int)version);
+        return -1;
+    }
+
+    if(header_length < CDP_NEIGHBOR_RECORD_HEADER_LENGTH || record_length <= header_length)
+    {
+        LOG_ERROR("cdp_neighbor_record_parse: record lengths are invalid.\n");
+        return -1;
+    }
+
+    if(!stream_reader_need(reader, (size_t)record_length - 8))
+    {
+        LOG_ERROR("cdp_neighbor_record_parse: record is truncated.\n");
+        return -1;
+    }
+
+    /* The hold time is carried for the convenience of consumers which don't parse the frame,
+     * the neighbor reads it back from the frame itself.
+     */
+    if(
+        stream_reader_get32(reader, &device_index) < 0 ||
+        stream_reader_get8(reader, &hold_time) < 0 ||
+        stream_reader_get8(reader, &mac_length) < 0 ||
+        stream_reader_get_buffer(reader, mac, sizeof(mac)) < 0 ||
+        stream_reader_get32(reader, &seconds_high) < 0 ||
+        stream_reader_get32(reader, &seconds_low) < 0 ||
+        stream_reader_get32(reader, &nanoseconds) < 0
+    )
+    {
+        LOG_ERROR("cdp_neighbor_record_parse: failed to read the record header.\n");
+        return -1;
+    }
+
+    if(mac_length == 0 || mac_length > CDP_NEIGHBOR_RECORD_MAX_MAC_LENGTH)
+    {
+        LOG_ERROR("cdp_neighbor_record_parse: remote MAC address length %d is invalid.\n", (int)mac_length);
+        return -1;
+    }
+
+    /* Skip any header fields added by later revisions of the format */
+    if(stream_reader_set_position(reader, record_start + header_length) < 0)
+    {
+        LOG_ERROR("cdp_neighbor_record_parse: failed to seek to the frame.\n");
+        return -1;
+    }
+
+    neighbor = cdp_neighbor_new();
+    if(neighbor == NULL)
+    {
+        LOG_CRITICAL("cdp_neighbor_record_parse: failed to allocate the neighbor.\n");
+        return -1;
+    }
+
+    received_at.tv_sec = (time_t)(int64_t)(((uint64_t)seconds_high << 32) | seconds_low);
+    received_at.tv_nsec = (long)nanoseconds;
+    frame_length = (size_t)record_length - header_length;
+
+    if(
+        cdp_neighbor_set_device_index(neighbor, (int)device_index) < 0 ||
+        cdp_neighbor_set_remote_mac(neighbor, mac, mac_length) < 0 ||
+        cdp_neighbor_set_received_at(neighbor, received_at) < 0 ||
+        cdp_neighbor_set_frame_buffer(neighbor, reader->stream->data + reader->position, frame_length) < 0
+    )
+    {
+        LOG_ERROR("cdp_neighbor_record_parse: failed to populate the neighbor.\n");
+        cdp_neighbor_delete(neighbor);
+        return -1;
+    }
+
+    if(stream_reader_skip(reader, (off_t)frame_length) < 0)
+    {
+        LOG_ERROR("cdp_neighbor_record_parse: failed to skip past the frame.\n");
+        cdp_neighbor_delete(neighbor);
+        return -1;
+    }
+
+    *result = neighbor;
+
+    return 0;
+}
+
+ssize_t cdp_neighbor_record_list_length(const struct cdp_neighbor_list *list)
+{
+    const struct cdp_neighbor *neighbor;
+    ssize_t record_length;
+    ssize_t result = 0;
+
+    if(list == NULL)
+    {
+        LOG_CRITICAL("cdp_neighbor_record_list_length: list is NULL.\n");
+        return -1;
+    }
+
+    for(neighbor = list->head; neighbor != NULL; neighbor = neighbor->next)
+    {
+        if(neighbor->frame_buffer == NULL || neighbor->frame_buffer_length == 0)
+            continue;
+
+        record_length = cdp_neighbor_record_length(neighbor);
+        if(record_length < 0)
+        {
+            LOG_ERROR("cdp_neighbor_record_list_length: could not calculate a record length.\n");
+            return -1;
+        }
+
+        result += record_length;
+    }
+
+    return result;
+}
+
+ssize_t cdp_neighbor_record_serialize_list(const struct cdp_neighbor_list *list, uint8_t *buffer, size_t buffer_size)
+{
+    const struct cdp_neighbor *neighbor;
+    ssize_t record_length;
+    size_t result = 0;
+
+    if(list == NULL)
+    {
+        LOG_CRITICAL("cdp_neighbor_record_serialize_list: list is NULL.\n");
+        return -1;
+    }
+
+    if(buffer == NULL && buffer_size > 0)
+    {
+        LOG_CRITICAL("cdp_neighbor_record_serialize_list: buffer is NULL.\n");
+        return -1;
+    }
+
+    for(neighbor = list->head; neighbor != NULL; neighbor = neighbor->next)
+    {
+        if(neighbor->frame_buffer == NULL || neighbor->frame_buffer_length == 0)
+            continue;
+
+        record_length = cdp_neighbor_record_serialize(neighbor, buffer + result, buffer_size - result);
+        if(record_length < 0)
+        {
+            LOG_ERROR("cdp_neighbor_record_serialize_list: failed to serialize a neighbor.\n");
+            return -1;
+        }
+
+        result += (size_t)record_length;
+    }
+
+    return (ssize_t)result;
+}
+
+int cdp_neighbor_record_parse_list(struct stream_reader *reader, struct timespec now, struct cdp_neighbor_list *list)
+{
+    struct cdp_neighbor *neighbor;
+    int result = 0;
+
+    if(reader == NULL)
+    {
+        LOG_CRITICAL("cdp_neighbor_record_parse_list: reader is NULL.\n");
+        return -1;
+    }
+
+    if(list == NULL)
+    {
+        LOG_CRITICAL("cdp_neighbor_record_parse_list: list is NULL.\n");
+        return -1;
+    }
+
+    while(!stream_reader_at_end(reader))
+    {
+        if(cdp_neighbor_record_parse(reader, &neighbor) < 0)
+        {
+            LOG_ERROR("cdp_neighbor_record_parse_list: failed to parse record %d.\n", result);
+            return -1;
+        }
+
+        if(cdp_neighbor_is_expired(neighbor, now))
+        {
+            cdp_neighbor_delete(neighbor);
+            continue;
+        }
+
+        if(cdp_neighbor_list_append(list, neighbor) < 0)
+        {
+            LOG_ERROR("cdp_neighbor_record_parse_list: failed to append the neighbor.\n");
+            cdp_neighbor_delete(neighbor);
+            return -1;
+        }
+
+        result++;
+    }
+
+    return result;
+}
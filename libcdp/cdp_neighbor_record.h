@@ -0,0 +1,96 @@
+#ifndef CDP_NEIGHBOR_RECORD_H
+#define CDP_NEIGHBOR_RECORD_H
+
+#include "cdp_neighbor.h"
+#include "stream_reader.h"
+#include "platform/types.h"
+
+/* A neighbor record is the binary export format of a single neighbor table entry as it is
+ * presented by /proc/net/cdp/raw. Records are concatenated back to back. All values are
+ * big-endian and the layout of the version 1 header is :
+ *
+ *   offset  size  field
+ *        0     2  version (CDP_NEIGHBOR_RECORD_VERSION)
+ *        2     2  header length in bytes (offset of the frame from the start of the record)
+ *        4     4  record length in bytes (header + frame)
+ *        8     4  interface index the frame was received on
+ *       12     1  hold time from the frame in seconds
+ *       13     1  length of the remote MAC address in bytes
+ *       14     6  remote MAC address (zero padded)
+ *       20     8  received at, seconds since the epoch
+ *       28     4  received at, nanoseconds
+ *       32     n  the raw CDP frame as received (starting with the CDP version byte)
+ *
+ * Readers must use the header length to find the frame and the record length to find the next
+ * record so that fields appended to the header in later versions can be skipped.
+ *
+ * The same concatenation of records is used to snapshot a whole table to a file on shutdown and to
+ * load it back on start so that a restart doesn't leave the table empty for a full hold time.
+ */
+
+/** The version of the record format written by this library */
+#define CDP_NEIGHBOR_RECORD_VERSION 1
+
+/** The length of the version 1 record header in bytes */
+#define CDP_NEIGHBOR_RECORD_HEADER_LENGTH 32
+
+/** The maximum length of a remote MAC address which can be stored in a record */
+#define CDP_NEIGHBOR_RECORD_MAX_MAC_LENGTH 6
+
+/** Calculates the total length of the record which would be written for a neighbor.
+  *  @param neighbor The neighbor to measure.
+  *  @return The record length in bytes or a negative value on error.
+  */
+ssize_t cdp_neighbor_record_length(const struct cdp_neighbor *neighbor);
+
+/** Writes the record header for a neighbor to a buffer. The frame itself is not written so that
+  *  callers which stream the output can copy it directly from the neighbor's frame buffer.
+  *  @param neighbor The neighbor to write the header for.
+  *  @param buffer The buffer to write to.
+  *  @param buffer_size The size of the buffer in bytes.
+  *  @return The number of bytes written or a negative value on error.
+  */
+ssize_t cdp_neighbor_record_write_header(const struct cdp_neighbor *neighbor, uint8_t *buffer, size_t buffer_size);
+
+/** Writes the complete record (header and frame) for a neighbor to a buffer.
+  *  @param neighbor The neighbor to serialize.
+  *  @param buffer The buffer to write to.
+  *  @param buffer_size The size of the buffer in bytes.
+  *  @return The number of bytes written or a negative value on error.
+  */
+ssize_t cdp_neighbor_record_serialize(const struct cdp_neighbor *neighbor, uint8_t *buffer, size_t buffer_size);
+
+/** Reads a single record from a stream and constructs a neighbor from it. The reader is left
+  *  positioned at the start of the next record.
+  *  @param reader The reader to read the record from.
+  *  @param result The location to store the newly allocated neighbor.
+  *  @return 0 on success or a negative value on error.
+  */
+int cdp_neighbor_record_parse(struct stream_reader *reader, struct cdp_neighbor **result);
+
+/** Calculates the length of the records which would be written for every neighbor of a list.
+  *  Neighbors which have not received a frame yet have no record and are not counted.
+  *  @param list The list to measure.
+  *  @return The length in bytes or a negative value on error.
+  */
+ssize_t cdp_neighbor_record_list_length(const struct cdp_neighbor_list *list);
+
+/** Writes the records of every neighbor of a list back to back to a buffer.
+  *  @param list The list to serialize.
+  *  @param buffer The buffer to write to.
+  *  @param buffer_size The size of the buffer in bytes.
+  *  @return The number of bytes written or a negative value on error.
+  */
+ssize_t cdp_neighbor_record_serialize_list(const struct cdp_neighbor_list *list, uint8_t *buffer, size_t buffer_size);
+
+/** Reads records until the end of a stream and appends a neighbor for each to a list. Records whose
+  *  hold time has run out by now are skipped, so an old snapshot never resurrects a neighbor which
+  *  would have expired while nothing was listening.
+  *  @param reader The reader to read the records from.
+  *  @param now The current time, relative to the received at times of the records.
+  *  @param list The list to append the neighbors to, neighbors read before an error are kept.
+  *  @return The number of neighbors appended or a negative value on error.
+  */
+int cdp_neighbor_record_parse_list(struct stream_reader *reader, struct timespec now, struct cdp_neighbor_list *list);
+
+#endif
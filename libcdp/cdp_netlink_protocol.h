@@ -0,0 +1,57 @@
+#ifndef CDP_NETLINK_PROTOCOL_H
+#define CDP_NETLINK_PROTOCOL_H
+
+/* Definitions of the generic netlink family exposed by the CDP kernel module. These are shared
+ * between the module and user mode consumers.
+ *
+ * Every message carries a single CDP_ATTR_NEIGHBOR_RECORD attribute containing one neighbor in
+ * the binary record format described in cdp_neighbor_record.h.
+ */
+
+/** The name of the generic netlink family */
+#define CDP_GENL_FAMILY_NAME "cdp"
+
+/** The version of the generic netlink family */
+#define CDP_GENL_FAMILY_VERSION 1
+
+/** The name of the multicast group neighbor events are sent to */
+#define CDP_GENL_EVENTS_GROUP_NAME "events"
+
+/** Generic netlink commands */
+enum cdp_genl_command
+{
+    CDP_CMD_UNSPEC,
+
+    /** Request (dump) of the entire neighbor table, also the command of each reply message. Replies are
+      * flagged with NLM_F_DUMP_INTR if the table changed during the dump.
+      */
+    CDP_CMD_GET_NEIGHBORS,
+
+    /** Event: a neighbor was heard from for the first time */
+    CDP_CMD_NEIGHBOR_ADDED,
+
+    /** Event: a neighbor sent a frame whose content differs from the previous one */
+    CDP_CMD_NEIGHBOR_CHANGED,
+
+    /** Event: a neighbor's hold time expired and it was removed from the table */
+    CDP_CMD_NEIGHBOR_EXPIRED,
+
+    __CDP_CMD_MAX
+};
+
+#define CDP_CMD_MAX (__CDP_CMD_MAX - 1)
+
+/** Generic netlink attributes */
+enum cdp_genl_attribute
+{
+    CDP_ATTR_UNSPEC,
+
+    /** Binary neighbor record (see cdp_neighbor_record.h) */
+    CDP_ATTR_NEIGHBOR_RECORD,
+
+    __CDP_ATTR_MAX
+};
+
+#define CDP_ATTR_MAX (__CDP_ATTR_MAX - 1)
+
+#endif
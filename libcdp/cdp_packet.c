@@ -1,4 +1,5 @@
 #include "cdp_packet.h"
+#include "cdp_string_pool.h"
 #include "platform/platform.h"
 
 struct cdp_packet* cdp_packet_new(uint8_t version, uint8_t ttl, uint16_t checksum)
@@ -43,20 +44,17 @@ void cdp_packet_delete(struct cdp_packet *packet)
         return;
     }
 
-    if (packet->device_id != NULL)
-        FREE_ARRAY(packet->device_id);
+    cdp_string_release(packet->device_id);
 
     if (packet->addresses != NULL)
         ip_address_array_clear_and_delete(packet->addresses);
 
-    if (packet->software_version != NULL)
-        FREE_ARRAY(packet->software_version);
+    cdp_string_release(packet->software_version);
 
     if (packet->capabilities != NULL)
         FREE(packet->capabilities);
 
-    if (packet->platform != NULL)
-        FREE_ARRAY(packet->platform);
+    cdp_string_release(packet->platform);
 
     if (packet->odr_prefixes != NULL)
         ip_prefix_array_clear_and_delete(packet->odr_prefixes);
@@ -64,11 +62,9 @@ void cdp_packet_delete(struct cdp_packet *packet)
     if (packet->cluster_management_protocol != NULL)
         cisco_cluster_management_protocol_delete(packet->cluster_management_protocol);
 
-    if (packet->vtp_management_domain != NULL)
-        FREE_ARRAY(packet->vtp_management_domain);
+    cdp_string_release(packet->vtp_management_domain);
 
-    if (packet->port_id != NULL)
-        FREE_ARRAY(packet->port_id);
+    cdp_string_release(packet->port_id);
 
     if (packet->management_addresses != NULL)
         ip_address_array_clear_and_delete(packet->management_addresses);
@@ -85,46 +81,43 @@ void cdp_packet_delete(struct cdp_packet *packet)
     if (packet->poe_availability != NULL)
         power_over_ethernet_availability_delete(packet->poe_availability);
 
-    if (packet->startup_native_vlan != NULL)
-        FREE_ARRAY(packet->startup_native_vlan);
+    cdp_string_release(packet->startup_native_vlan);
 
     FREE(packet);
 }
 
-int cdp_packet_set_device_id(struct cdp_packet *packet, const char *deviceId)
+/** Replaces a string field of a packet with a private copy of a string, keeping the field as it
+  *  was on failure.
+  *  @param field The field to set.
+  *  @param value The string to copy or NULL to clear the field.
+  *  @return 0 on success or -1 on failure.
+  */
+static int cdp_packet_set_string(char **field, const char *value)
 {
-    size_t bufferLength;
+    char *copy = NULL;
 
-    if (packet == NULL)
+    if (value != NULL)
     {
-        LOG_CRITICAL("cdp_packet_set_device_id: neighbor is null\n");
-        return -1;
-    }
-
-    if (packet->device_id != NULL)
-        FREE_ARRAY(packet->device_id);
-
-    if (deviceId == NULL)
-    {
-        packet->device_id = NULL;
+        copy = cdp_string_intern(NULL, value, strlen(value));
+        if (copy == NULL)
+            return -1;
     }
-    else
-    {
-        /* TODO: Is there a "safe way" to find the string length? Should I make a string class? */
-        bufferLength = strlen(deviceId) + 1;
 
-        packet->device_id = ALLOC_NEW_ARRAY(char, bufferLength);
+    cdp_string_release(*field);
+    *field = copy;
 
-        if (packet->device_id == NULL)
-        {
-            LOG_ERROR("cdp_packet_set_device_id: Failed to allocate memory for the new device ID string.\n");
-            return -1;
-        }
+    return 0;
+}
 
-        COPY_MEMORY(deviceId, packet->device_id, bufferLength);
+int cdp_packet_set_device_id(struct cdp_packet *packet, const char *deviceId)
+{
+    if (packet == NULL)
+    {
+        LOG_CRITICAL("cdp_packet_set_device_id: neighbor is null\n");
+        return -1;
     }
 
-    return 0;
+    return cdp_packet_set_string(&packet->device_id, deviceId);
 }
 
 int cdp_packet_clear_addresses(struct cdp_packet *packet)
@@ -253,110 +246,35 @@ int cdp_packet_set_capabilities(struct cdp_packet *packet, uint32_t capabilities
 
 int cdp_packet_set_port_id(struct cdp_packet *packet, const char *portId)
 {
-    size_t bufferLength;
-
     if (packet == NULL)
     {
         LOG_CRITICAL("cdp_packet_set_port_id: neighbor is null\n");
         return -1;
     }
 
-    if (packet->port_id != NULL)
-        FREE_ARRAY(packet->port_id);
-
-    if (portId == NULL)
-    {
-        packet->port_id = NULL;
-    }
-    else
-    {
-        /* TODO: Is there a "safe way" to find the string length? Should I make a string class? */
-        bufferLength = strlen(portId) + 1;
-
-        packet->port_id = ALLOC_NEW_ARRAY(char, bufferLength);
-
-        if (packet->port_id == NULL)
-        {
-            LOG_ERROR("cdp_packet_set_device_id: Failed to allocate memory for the new port_id string.\n");
-            return -1;
-        }
-
-        COPY_MEMORY(portId, packet->port_id, bufferLength);
-    }
-
-    return 0;
+    return cdp_packet_set_string(&packet->port_id, portId);
 }
 
 int cdp_packet_set_software_version(struct cdp_packet *packet, const char *softwareVersion)
 {
-    size_t bufferLength;
-
     if (packet == NULL)
     {
         LOG_CRITICAL("cdp_packet_set_software_version: neighbor is null\n");
         return -1;
     }
 
-    if (packet->software_version != NULL)
-        FREE_ARRAY(packet->software_version);
-
-    if (softwareVersion == NULL)
-    {
-        packet->software_version = NULL;
-    }
-    else
-    {
-        /* TODO: Is there a "safe way" to find the string length? Should I make a string class? */
-        bufferLength = strlen(softwareVersion) + 1;
-
-        packet->software_version = ALLOC_NEW_ARRAY(char, bufferLength);
-
-        if (packet->software_version == NULL)
-        {
-            LOG_ERROR("cdp_packet_set_device_id: Failed to allocate memory for the new software version string.\n");
-            return -1;
-        }
-
-        COPY_MEMORY(softwareVersion, packet->software_version, bufferLength);
-    }
-
-    return 0;
+    return cdp_packet_set_string(&packet->software_version, softwareVersion);
 }
 
 int cdp_packet_set_platform(struct cdp_packet *packet, const char *platform)
 {
-    size_t bufferLength;
-
     if (packet == NULL)
     {
         LOG_CRITICAL("cdp_packet_set_platform: neighbor is null\n");
         return -1;
     }
 
-    if (packet->platform != NULL)
-        FREE_ARRAY(packet->platform);
-
-    if (platform == NULL)
-    {
-        packet->platform = NULL;
-    }
-    else
-    {
-        /* TODO: Is there a "safe way" to find the string length? Should I make a string class? */
-        bufferLength = strlen(platform) + 1;
-
-        packet->platform = ALLOC_NEW_ARRAY(char, bufferLength);
-
-        if (packet->platform == NULL)
-        {
-            LOG_ERROR("cdp_packet_set_device_id: Failed to allocate memory for the new platform string.\n");
-            return -1;
-        }
-
-        COPY_MEMORY(platform, packet->platform, bufferLength);
-    }
-
-    return 0;
+    return cdp_packet_set_string(&packet->platform, platform);
 }
 
 int cdp_packet_clear_odr_prefixes(struct cdp_packet *packet)
@@ -442,38 +360,13 @@ int cdp_packet_set_cisco_cluster_management_protocol(struct cdp_packet *packet,
 
 int cdp_packet_set_vtp_management_domain(struct cdp_packet *packet, const char *vtpManagementDomain)
 {
-    size_t bufferLength;
-
     if (packet == NULL)
     {
         LOG_CRITICAL("cdp_packet_set_platform: neighbor is null\n");
         return -1;
     }
 
-    if (packet->vtp_management_domain != NULL)
-        FREE_ARRAY(packet->vtp_management_domain);
-
-    if (vtpManagementDomain == NULL)
-    {
-        packet->vtp_management_domain = NULL;
-    }
-    else
-    {
-        /* TODO: Is there a "safe way" to find the string length? Should I make a string class? */
-        bufferLength = strlen(vtpManagementDomain) + 1;
-
-        packet->vtp_management_domain = ALLOC_NEW_ARRAY(char, bufferLength);
-
-        if (packet->vtp_management_domain == NULL)
-        {
-            LOG_ERROR("cdp_packet_set_device_id: Failed to allocate memory for the new platform string.\n");
-            return -1;
-        }
-
-        COPY_MEMORY(vtpManagementDomain, packet->vtp_management_domain, bufferLength);
-    }
-
-    return 0;
+    return cdp_packet_set_string(&packet->vtp_management_domain, vtpManagementDomain);
 }
 
 int cdp_packet_set_native_vlan(struct cdp_packet *packet, uint16_t nativeVlan)
@@ -633,6 +526,23 @@ int cdp_packet_set_management_address(struct cdp_packet *packet, off_t index, st
     return ip_address_array_set_into(packet->management_addresses, index, address);
 }
 
+int cdp_packet_set_management_address_copy(struct cdp_packet *packet, off_t index, struct sockaddr *address)
+{
+    if (packet == NULL)
+    {
+        LOG_CRITICAL("cdp_packet_set_management_address_copy: neighbor is null\n");
+        return -1;
+    }
+
+    if (packet->management_addresses == NULL)
+    {
+        LOG_CRITICAL("cdp_packet_set_management_address_copy: neighbor management address array is null\n");
+        return -1;
+    }
+
+    return ip_address_array_copy_into(packet->management_addresses, index, address);
+}
+
 int cdp_packet_set_poe_availability(struct cdp_packet *neighbor, struct power_over_ethernet_availability *poe)
 {
     if (neighbor == NULL)
@@ -651,38 +561,13 @@ int cdp_packet_set_poe_availability(struct cdp_packet *neighbor, struct power_ov
 
 int cdp_packet_set_startup_native_vlan(struct cdp_packet *packet, const char *startupNativeVlan)
 {
-    size_t bufferLength;
-
     if (packet == NULL)
     {
         LOG_CRITICAL("cdp_packet_set_startupNativeVlan: neighbor is null\n");
         return -1;
     }
 
-    if (packet->startup_native_vlan != NULL)
-        FREE_ARRAY(packet->startup_native_vlan);
-
-    if (startupNativeVlan == NULL)
-    {
-        packet->startup_native_vlan = NULL;
-    }
-    else
-    {
-        /* TODO: Is there a "safe way" to find the string length? Should I make a string class? */
-        bufferLength = strlen(startupNativeVlan) + 1;
-
-        packet->startup_native_vlan = ALLOC_NEW_ARRAY(char, bufferLength);
-
-        if (packet->startup_native_vlan == NULL)
-        {
-            LOG_ERROR("cdp_packet_set_startupNativeVlan: Failed to allocate memory for the new startup native VLAN string.\n");
-            return -1;
-        }
-
-        COPY_MEMORY(startupNativeVlan, packet->startup_native_vlan, bufferLength);
-    }
-
-    return 0;
+    return cdp_packet_set_string(&packet->startup_native_vlan, startupNativeVlan);
 }
 
 int cdp_packet_write_version(const struct cdp_packet *packet, struct stream_writer *writer)
@@ -841,56 +726,20 @@ int cdp_packet_write_uint32ptr_tlv(struct stream_writer *writer, ECdpTlv tlv, co
     return cdp_packet_write_uint32_tlv(writer, tlv, *value);
 }
 
-int cdp_packet_write_addresses_tlv(struct stream_writer *writer, ECdpTlv tlv, struct ip_address_array *value, bool is_required)
+ssize_t cdp_packet_addresses_tlv_length(const struct ip_address_array *value)
 {
-    size_t length = 8;
+    ssize_t length = 8;
     size_t i;
 
-    if (writer == NULL)
-    {
-        LOG_CRITICAL("cdp_packet_write_addresses_tlv: writer is NULL\n");
-        return -1;
-    }
-
     if (value == NULL)
     {
-        if (is_required)
-        {
-            LOG_ERROR("cdp_packet_write_addresses_tlv: value is required but is NULL\n");
-            return -1;
-        }
-
-        LOG_DEBUG("cdp_packet_write_addresses_tlv: value is required but is optional\n");
-        return 0;
-    }
-
-    if (is_required && value->count == 0)
-    {
-        LOG_ERROR("cdp_packet_write_addresses_tlv: value is required but contains no entries\n");
-        return -1;
-    }
-
-    if (!is_required && value->count == 0)
-    {
-        LOG_DEBUG("cdp_packet_write_addresses_tlv: value is not required but contains no entries.\n");
-        return 0;
-    }
-
-    if (value->addresses == NULL)
-    {
-        LOG_CRITICAL("cdp_packet_write_addresses_tlv: addresses is uninitialized\n");
+        LOG_CRITICAL("cdp_packet_addresses_tlv_length: value is NULL\n");
         return -1;
     }
 
     for (i = 0; i < value->count; i++)
     {
-        if (value->addresses[i] == 0)
-        {
-            LOG_CRITICAL("cdp_packet_write_addresses_tlv: address at index %zd is NULL\n", i);
-            return -1;
-        }
-
-        switch (value->addresses[i]->sa_family)
+        switch (value->addresses[i].family)
         {
             case AF_INET:
                 /* Protocol Type:   (NLPID) 0x01 (1 byte)
@@ -917,12 +766,61 @@ int cdp_packet_write_addresses_tlv(struct stream_writer *writer, ECdpTlv tlv, st
                 length += 28;
                 break;
 
+            case AF_UNSPEC:
+                LOG_CRITICAL("cdp_packet_addresses_tlv_length: address at index %zd is empty\n", i);
+                return -1;
+
             default:
-                LOG_CRITICAL("cdp_packet_write_addresses_tlv: unknown address family at index %zd\n", i);
+                LOG_CRITICAL("cdp_packet_addresses_tlv_length: unknown address family at index %zd\n", i);
                 return -1;
         }
     }
 
+    return length;
+}
+
+int cdp_packet_write_addresses_tlv(struct stream_writer *writer, ECdpTlv tlv, struct ip_address_array *value, bool is_required)
+{
+    ssize_t length;
+    size_t i;
+
+    if (writer == NULL)
+    {
+        LOG_CRITICAL("cdp_packet_write_addresses_tlv: writer is NULL\n");
+        return -1;
+    }
+
+    if (value == NULL)
+    {
+        if (is_required)
+        {
+            LOG_ERROR("cdp_packet_write_addresses_tlv: value is required but is NULL\n");
+            return -1;
+        }
+
+        LOG_DEBUG("cdp_packet_write_addresses_tlv: value is required but is optional\n");
+        return 0;
+    }
+
+    if (is_required && value->count == 0)
+    {
+        LOG_ERROR("cdp_packet_write_addresses_tlv: value is required but contains no entries\n");
+        return -1;
+    }
+
+    if (!is_required && value->count == 0)
+    {
+        LOG_DEBUG("cdp_packet_write_addresses_tlv: value is not required but contains no entries.\n");
+        return 0;
+    }
+
+    length = cdp_packet_addresses_tlv_length(value);
+    if (length < 0)
+    {
+        LOG_ERROR("cdp_packet_write_addresses_tlv: failed to calculate the TLV length\n");
+        return -1;
+    }
+
     if (stream_writer_put16(writer, (uint16_t)tlv) < 0)
     {
         LOG_ERROR("cdp_packet_write_addresses_tlv: failed to write TLV type\n");
@@ -943,7 +841,7 @@ int cdp_packet_write_addresses_tlv(struct stream_writer *writer, ECdpTlv tlv, st
 
     for (i = 0; i < value->count; i++)
     {
-        switch (value->addresses[i]->sa_family)
+        switch (value->addresses[i].family)
         {
         case AF_INET:
             if (stream_writer_put8(writer, 0x01) < 0)
@@ -970,7 +868,7 @@ int cdp_packet_write_addresses_tlv(struct stream_writer *writer, ECdpTlv tlv, st
                 return -1;
             }
 
-            if (stream_writer_put32(writer, htonl(((struct sockaddr_in *)value->addresses[i])->sin_addr.s_addr)) < 0)
+            if (stream_writer_put_buffer(writer, value->addresses[i].octets, 4) < 0)
             {
                 LOG_ERROR("cdp_packet_write_addresses_tlv: failed to write address on index %zd\n", i);
                 return -1;
@@ -1026,7 +924,7 @@ int cdp_packet_write_addresses_tlv(struct stream_writer *writer, ECdpTlv tlv, st
                 return -1;
             }
 
-            if (stream_writer_put_buffer(writer, IPv6Octets((struct sockaddr_in6 *)value->addresses[i]), 16) < 0)
+            if (stream_writer_put_buffer(writer, value->addresses[i].octets, 16) < 0)
             {
                 LOG_ERROR("cdp_packet_write_addresses_tlv: failed to write address on index %zd\n", i);
                 return -1;
@@ -1101,167 +999,287 @@ int cdp_packet_write_tlvs(const struct cdp_packet *packet, struct stream_writer
     return 0;
 }
 
+ssize_t cdp_packet_string_tlv_length(const char *value, bool is_required)
+{
+    if (value == NULL)
+    {
+        if (is_required)
+        {
+            LOG_ERROR("cdp_packet_string_tlv_length: value is required but is NULL\n");
+            return -1;
+        }
+
+        return 0;
+    }
+
+    return (ssize_t)(strlen(value) + 4);
+}
+
+ssize_t cdp_packet_serialized_size(const struct cdp_packet *packet)
+{
+    /* Version (1 byte), TTL (1 byte) and checksum (2 bytes) */
+    ssize_t result = 4;
+    ssize_t length;
+
+    if (packet == NULL)
+    {
+        LOG_CRITICAL("cdp_packet_serialized_size: packet is NULL\n");
+        return -1;
+    }
+
+    if (packet->cdp_proto_ver == 2 && packet->duplex == DuplexUnset)
+    {
+        LOG_ERROR("cdp_packet_serialized_size: CDP verison 2 requires that port duplex is set.\n");
+        return -1;
+    }
+
+    /* The TLVs below must be kept in sync with cdp_packet_write_tlvs */
+    length = cdp_packet_string_tlv_length(packet->device_id, true);
+    if (length < 0)
+    {
+        LOG_CRITICAL("cdp_packet_serialized_size: device_id could not be measured.\n");
+        return -1;
+    }
+    result += length;
+
+    length = cdp_packet_string_tlv_length(packet->software_version, true);
+    if (length < 0)
+    {
+        LOG_CRITICAL("cdp_packet_serialized_size: software version could not be measured.\n");
+        return -1;
+    }
+    result += length;
+
+    length = cdp_packet_string_tlv_length(packet->platform, true);
+    if (length < 0)
+    {
+        LOG_CRITICAL("cdp_packet_serialized_size: platform could not be measured.\n");
+        return -1;
+    }
+    result += length;
+
+    length = cdp_packet_string_tlv_length(packet->port_id, true);
+    if (length < 0)
+    {
+        LOG_CRITICAL("cdp_packet_serialized_size: port ID could not be measured.\n");
+        return -1;
+    }
+    result += length;
+
+    if (packet->capabilities == NULL)
+    {
+        LOG_CRITICAL("cdp_packet_serialized_size: capabilities are required but are NULL.\n");
+        return -1;
+    }
+    result += 8;
+
+    if (packet->addresses == NULL || packet->addresses->count == 0)
+    {
+        LOG_CRITICAL("cdp_packet_serialized_size: addresses are required but there are none.\n");
+        return -1;
+    }
+
+    length = cdp_packet_addresses_tlv_length(packet->addresses);
+    if (length < 0)
+    {
+        LOG_CRITICAL("cdp_packet_serialized_size: addresses could not be measured.\n");
+        return -1;
+    }
+    result += length;
+
+    if (packet->cdp_proto_ver == 2)
+        result += 5;
+
+    return result;
+}
+
+/** Deletes the writer of a failed serialization and picks the error to return.
+  *  @param writer The writer the packet was being serialized with.
+  *  @param rc The negative result of the step which failed.
+  *  @return The first error recorded by the writer, rc if the writer hasn't recorded one.
+  */
+static ssize_t cdp_packet_serialize_fail(struct stream_writer *writer, int rc)
+{
+    enum cdp_error error;
+
+    error = stream_writer_get_error(writer);
+    stream_writer_delete(writer);
+
+    return (error != CDP_ERROR_NONE) ? error : rc;
+}
+
 ssize_t cdp_packet_serialize(const struct cdp_packet *packet, uint8_t *buffer, size_t size)
 {
     struct stream_writer *writer;
     ssize_t result;
+    int rc;
 
     if (packet == NULL)
     {
         LOG_CRITICAL("cdp_packet_serialize: packet is NULL\n");
-        return -1;
+        return CDP_ERROR_INVALID_ARGUMENT;
     }
 
     if (packet->cdp_proto_ver == 2 && packet->duplex == DuplexUnset)
     {
         LOG_ERROR("cdp_packet_serialize: CDP verison 2 requires that port duplex is set.\n");
-        return -1;
+        return CDP_ERROR_MISSING_FIELD;
     }
 
     writer = stream_writer_new(buffer, size);
     if (writer == NULL)
     {
         LOG_ERROR("cdp_packet_serialize: failed to allocate memory for the stream writer\n");
-        return -1;
+        return (buffer == NULL || size == 0) ? CDP_ERROR_INVALID_ARGUMENT : CDP_ERROR_NO_MEMORY;
     }
 
-    if (cdp_packet_write_version(packet, writer) < 0)
+    rc = cdp_packet_write_version(packet, writer);
+    if (rc < 0)
     {
         LOG_ERROR("cdp_packet_serialize: failed to write the CDP version to the packet.\n");
-        stream_writer_delete(writer);
-        return -1;
+        return cdp_packet_serialize_fail(writer, rc);
     }
 
-    if (cdp_packet_write_ttl(packet, writer) < 0)
+    rc = cdp_packet_write_ttl(packet, writer);
+    if (rc < 0)
     {
         LOG_ERROR("cdp_packet_serialize: failed to write the CDP hold time to the packet.\n");
-        stream_writer_delete(writer);
-        return -1;
+        return cdp_packet_serialize_fail(writer, rc);
     }
 
-    if (stream_writer_put16(writer, 0) < 0)
+    rc = stream_writer_put16(writer, 0);
+    if (rc < 0)
     {
         LOG_ERROR("cdp_packet_serialize: failed to write a placeholder for the frame checksum.\n");
-        stream_writer_delete(writer);
-        return -1;
+        return cdp_packet_serialize_fail(writer, rc);
     }
 
-    if (cdp_packet_write_tlvs(packet, writer) < 0)
+    rc = cdp_packet_write_tlvs(packet, writer);
+    if (rc < 0)
     {
         LOG_ERROR("cdp_packet_serialize: failed to write the CDP TLVs to the packet.\n");
-        stream_writer_delete(writer);
-        return -1;
+        return cdp_packet_serialize_fail(writer, rc);
     }
 
     result = stream_writer_length(writer);
 
-    if (stream_writer_inject_checksum(writer, 2) < 0)
+    rc = stream_writer_inject_checksum(writer, 2);
+    if (rc < 0)
     {
         LOG_ERROR("cdp_packet_serialize: failed to inject checksum at position 2.\n");
-        stream_writer_delete(writer);
-        return -1;
+        return cdp_packet_serialize_fail(writer, rc);
     }
 
     if (stream_writer_delete(writer) < 0)
     {
         LOG_ERROR("cdp_packet_serialize: failed to do delete the stream writer.\n");
-        return -1;
+        return CDP_ERROR_INVALID_ARGUMENT;
     }
 
     return result;
 }
 
-ssize_t cdp_create_packet(
+struct cdp_packet *cdp_packet_new_advertisement(
     const char *outgoing_interface_name,
     const char *device_id_string,
     const char *platform_string,
     const char *software_version_string,
-    const struct ip_address_array *addresses,
-    int8_t *buffer,
-    size_t buffer_length
+    const struct ip_address_array *addresses
 )
 {
     struct cdp_packet *result;
-    ssize_t consumed;
 
     result = cdp_packet_new(2, 180, 0);
     if (result == NULL)
     {
-        LOG_CRITICAL("cdp_create_packet: Failed to allocate memory for creating a new CDP packet\n");
-        return -1;
+        LOG_CRITICAL("cdp_packet_new_advertisement: Failed to allocate memory for creating a new CDP packet\n");
+        return NULL;
     }
 
     if (cdp_packet_set_device_id(result, device_id_string) < 0)
     {
-        LOG_CRITICAL("cdp_create_packet: Failed to set the device ID for the CDP frame.\n");
+        LOG_CRITICAL("cdp_packet_new_advertisement: Failed to set the device ID for the CDP frame.\n");
         cdp_packet_delete(result);
-        return -1;
+        return NULL;
     }
 
     if (cdp_packet_set_software_version(result, software_version_string) < 0)
     {
-        LOG_CRITICAL("cdp_create_packet: Failed to set the software version string for the CDP frame.\n");
+        LOG_CRITICAL("cdp_packet_new_advertisement: Failed to set the software version string for the CDP frame.\n");
         cdp_packet_delete(result);
-        return -1;
+        return NULL;
     }
 
     if (cdp_packet_set_platform(result, platform_string) < 0)
     {
-        LOG_CRITICAL("cdp_create_packet: Failed to set the platform string for the CDP frame.\n");
+        LOG_CRITICAL("cdp_packet_new_advertisement: Failed to set the platform string for the CDP frame.\n");
         cdp_packet_delete(result);
-        return -1;
+        return NULL;
     }
 
     if (cdp_packet_set_capabilities(result, CdpCapabilityHost | CdpCapabilityIGMP) < 0)
     {
-        LOG_CRITICAL("cdp_create_packet: Failed to set the capabilities for the CDP frame.\n");
+        LOG_CRITICAL("cdp_packet_new_advertisement: Failed to set the capabilities for the CDP frame.\n");
         cdp_packet_delete(result);
-        return -1;
+        return NULL;
     }
 
     if (cdp_packet_set_port_id(result, outgoing_interface_name) < 0)
     {
-        LOG_CRITICAL("cdp_create_packet: Failed to set the port ID for the CDP frame.\n");
+        LOG_CRITICAL("cdp_packet_new_advertisement: Failed to set the port ID for the CDP frame.\n");
         cdp_packet_delete(result);
-        return -1;
+        return NULL;
     }
 
     if (cdp_packet_set_duplex(result, DuplexFull) < 0)
     {
-        LOG_CRITICAL("cdp_create_packet: Failed to set the port duplex for the CDP frame.\n");
+        LOG_CRITICAL("cdp_packet_new_advertisement: Failed to set the port duplex for the CDP frame.\n");
         cdp_packet_delete(result);
-        return -1;
+        return NULL;
     }
 
     if (addresses != NULL)
     {
-        off_t i;
-        if (addresses->addresses == NULL)
+        result->addresses = ip_address_array_clone(addresses);
+        if (result->addresses == NULL)
         {
-            LOG_CRITICAL("cdp_create_packet: The addresses structure within addresses is NULL");
+            LOG_CRITICAL("cdp_packet_new_advertisement: Failed to copy the addresses\n");
             cdp_packet_delete(result);
-            return -1;
+            return NULL;
         }
+    }
 
-        if (cdp_packet_provision_address_array(result, addresses->count) < 0)
-        {
-            LOG_CRITICAL("cdp_create_packet: Failed to provision storage for addresses\n");
-            cdp_packet_delete(result);
-            return -1;
-        }
+    return result;
+}
 
-        for (i = 0; i < addresses->count; i++)
-        {
-            if (cdp_packet_set_address_copy(result, i, addresses->addresses[i]) < 0)
-            {
-                LOG_ERROR("cdp_create_packet: Failed to copy addresses at index " FORMAT_OFF_T " into addresses\n", i);
-                cdp_packet_delete(result);
-                return -1;
-            }
-        }
+ssize_t cdp_create_packet(
+    const char *outgoing_interface_name,
+    const char *device_id_string,
+    const char *platform_string,
+    const char *software_version_string,
+    const struct ip_address_array *addresses,
+    int8_t *buffer,
+    size_t buffer_length
+)
+{
+    struct cdp_packet *result;
+    ssize_t consumed;
+
+    result = cdp_packet_new_advertisement(
+        outgoing_interface_name,
+        device_id_string,
+        platform_string,
+        software_version_string,
+        addresses
+    );
+
+    if (result == NULL)
+    {
+        LOG_CRITICAL("cdp_create_packet: Failed to create the CDP packet\n");
+        return -1;
     }
 
-    consumed = cdp_packet_serialize(result, buffer, buffer_length);
+    consumed = cdp_packet_serialize(result, (uint8_t *)buffer, buffer_length);
 
     cdp_packet_delete(result);
 
@@ -1303,6 +1321,30 @@ void printAddress(const struct sockaddr *address)
     }
 }
 
+void printIpAddress(const struct ip_address *address)
+{
+    int i;
+
+    if (address->family == AF_INET)
+    {
+        _P("%d.%d.%d.%d", address->octets[0], address->octets[1], address->octets[2], address->octets[3]);
+    }
+    else if (address->family == AF_INET6)
+    {
+        for (i = 0; i < 16; i += 2)
+        {
+            if (i > 0)
+                _P(":");
+
+            _P("%02X%02X", address->octets[i], address->octets[i + 1]);
+        }
+    }
+    else
+    {
+        _P("<unknown format>");
+    }
+}
+
 void printCapabilities(uint32_t caps)
 {
     if ((caps & CdpCapabilityRouting) == CdpCapabilityRouting)
@@ -1352,7 +1394,7 @@ void cdp_packet_dump(struct cdp_packet *neighbor)
             if (i > 0)
                 _P(", ");
 
-            printAddress(neighbor->addresses->addresses[i]);
+            printIpAddress(&neighbor->addresses->addresses[i]);
         }
         _P("\n");
     }
@@ -1434,7 +1476,7 @@ void cdp_packet_dump(struct cdp_packet *neighbor)
             if (i > 0)
                 _P(", ");
 
-            printAddress(neighbor->management_addresses->addresses[i]);
+            printIpAddress(&neighbor->management_addresses->addresses[i]);
         }
         _P("\n");
     }
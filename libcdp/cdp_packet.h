@@ -263,6 +263,14 @@ int cdp_packet_provision_management_address_array(struct cdp_packet *packet, siz
   */
 int cdp_packet_set_management_address(struct cdp_packet *packet, off_t index, struct sockaddr *address);
 
+/** Sets a management IP address on the neighbor
+  *  @param packet The CDP neighbor object.
+  *  @param index The index to set.
+  *  @param address The address to set.
+  *  @return 0 on success, a negative value on failure
+  */
+int cdp_packet_set_management_address_copy(struct cdp_packet *packet, off_t index, struct sockaddr *address);
+
 /** Sets the power over Ethernet availability information for the link.
   *  @param packet The CDP neighbor object.
   *  @param poe The power over Ethernet availability information.
@@ -336,6 +344,19 @@ int cdp_packet_write_uint32ptr_tlv(struct stream_writer *writer, ECdpTlv tlv, co
   */
 int cdp_packet_write_addresses_tlv(struct stream_writer *writer, ECdpTlv tlv, struct ip_address_array *value, bool is_required);
 
+/** Calculates the length of an IP address list TLV object including the TLV header.
+  *  @param value The address list to measure.
+  *  @return The length of the TLV in bytes or a negative value on error.
+  */
+ssize_t cdp_packet_addresses_tlv_length(const struct ip_address_array *value);
+
+/** Calculates the length of a null terminated string TLV object including the TLV header.
+  *  @param value The string to measure.
+  *  @param is_required If set to true will generate an error if value is NULL.
+  *  @return The length of the TLV in bytes, 0 if the optional value is absent or a negative value on error.
+  */
+ssize_t cdp_packet_string_tlv_length(const char *value, bool is_required);
+
 /** Writes the defined values (some are required) from a packet to a stream writer as TLV objects.
   *  @param packet The CDP packet object.
   *  @param writer The writer object.
@@ -343,14 +364,37 @@ int cdp_packet_write_addresses_tlv(struct stream_writer *writer, ECdpTlv tlv, st
   */
 int cdp_packet_write_tlvs(const struct cdp_packet *packet, struct stream_writer *writer);
 
+/** Calculates the exact number of bytes cdp_packet_serialize will produce for a packet without writing anything.
+  *  @param packet The packet to measure.
+  *  @return The serialized size of the packet in bytes or a negative value on error.
+  */
+ssize_t cdp_packet_serialized_size(const struct cdp_packet *packet);
+
 /** Serializes a CDP packet into the buffer provided.
   *  @param packet The packet to serialize.
   *  @param buffer The buffer to write to.
   *  @param size The size of the buffer in bytes.
-  *  @return The number of bytes written to the buffer or a negative value on error.
+  *  @return The number of bytes written to the buffer or a negative enum cdp_error, CDP_ERROR_BUFFER_TOO_SMALL
+  *          if the packet doesn't fit and CDP_ERROR_MISSING_FIELD if a required field isn't set.
   */
 ssize_t cdp_packet_serialize(const struct cdp_packet *packet, uint8_t *buffer, size_t size);
 
+/** Constructs the CDP packet object advertising this device on an interface.
+  *  @param outgoing_interface_name The name of the interface to include in the header.
+  *  @param device_id_string The name of the device transmit. Typically the FQDN.
+  *  @param platform_string The platform identifier to transmit.
+  *  @param software_version_string The software version information. This is a multiline free-form string.
+  *  @param addresses The list of IP and IPv6 addresses associated with this interface (will be copied)
+  *  @return A new CDP packet object or NULL on error.
+  */
+struct cdp_packet *cdp_packet_new_advertisement(
+	const char *outgoing_interface_name,
+	const char *device_id_string,
+	const char *platform_string,
+	const char *software_version_string,
+	const struct ip_address_array *addresses
+);
+
 /** Creates a simple CDP packet. This is basically a helper function to do it "easy"
   *  @param outgoing_interface_name The name of the interface to include in the header.
   *  @param device_id_string The name of the device transmit. Typically the FQDN.
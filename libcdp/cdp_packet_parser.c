@@ -1,21 +1,62 @@
 #include "cdp_packet.h"
 #include "cdp_packet_parser.h"
+#include "cdp_string_pool.h"
 #include "cisco_cluster_management_protocol.h"
 #include "ip_address_array.h"
 #include "power_over_ethernet_availability.h"
 #include "platform/platform.h"
 #include "platform/types.h"
 
+/** The shortest encoding of an address, an NLPID protocol of one byte followed by an IPv4 address */
+#define CDP_ADDRESS_MINIMUM_LENGTH 9
+
+/** Reads a string TLV into a string field of a packet, interning it in a pool
+  *  @param reader The reader positioned at the value of the TLV.
+  *  @param pool The pool to intern the string in or NULL for a private copy.
+  *  @param maximumLength The length of the value.
+  *  @param field The field to set, whose previous string is released.
+  *  @return 0 on success or a negative enum cdp_error.
+  */
+static int cdp_parse_string(struct stream_reader *reader, struct cdp_string_pool *pool, size_t maximumLength, char **field)
+{
+	const char *value;
+	size_t length;
+	char *string;
+	int rc;
+
+	rc = stream_reader_get_string_reference(reader, &value, &length, maximumLength);
+	if (rc < 0)
+		return rc;
+
+	string = cdp_string_intern(pool, value, length);
+	if (string == NULL)
+		return stream_reader_fail(reader, CDP_ERROR_NO_MEMORY);
+
+	cdp_string_release(*field);
+	*field = string;
+
+	return 0;
+}
+
 int cdp_parse_packet(struct stream_reader *reader, struct cdp_packet **neighbor)
+{
+	return cdp_parse_packet_with_pool(reader, NULL, neighbor);
+}
+
+int cdp_parse_packet_with_pool(struct stream_reader *reader, struct cdp_string_pool *pool, struct cdp_packet **neighbor)
 {
 	uint8_t cdpVersion;
 	uint8_t ttl;
 	uint16_t checksum;
 	struct cdp_packet *result;
+	int rc;
+
+	stream_reader_clear_error(reader);
 
 	LOG_DEBUG("cdp_parse_packet: Reading CDP version\n");
-	if (stream_reader_get8(reader, &cdpVersion) < 0)
-		return -1;
+	rc = stream_reader_get8(reader, &cdpVersion);
+	if (rc < 0)
+		return rc;
 
 	// if (cdpVersion != 2)
 	// {
@@ -24,14 +65,16 @@ int cdp_parse_packet(struct stream_reader *reader, struct cdp_packet **neighbor)
 	// }
 
 	LOG_DEBUG("cdp_parse_packet: Reading TTL\n");
-	if (stream_reader_get8(reader, &ttl) < 0)
-		return -1;
+	rc = stream_reader_get8(reader, &ttl);
+	if (rc < 0)
+		return rc;
 
 	LOG_DEBUG("cdp_parse_packet: TTL is %d\n", ttl);
 
 	LOG_DEBUG("cdp_parse_packet: Reading checksum\n");
-	if (stream_reader_get16(reader, &checksum) < 0)
-		return -1;
+	rc = stream_reader_get16(reader, &checksum);
+	if (rc < 0)
+		return rc;
 
 	LOG_DEBUG("cdp_parse_packet: Checksum is %04X\n", checksum);
 
@@ -39,7 +82,7 @@ int cdp_parse_packet(struct stream_reader *reader, struct cdp_packet **neighbor)
 	if (result == NULL)
 	{
 		LOG_ERROR("cdp_parse_packet: Failed to allocate resulting object\n");
-		return -1;
+		return stream_reader_fail(reader, CDP_ERROR_NO_MEMORY);
 	}
 
 	while (!stream_reader_at_end(reader))
@@ -51,45 +94,48 @@ int cdp_parse_packet(struct stream_reader *reader, struct cdp_packet **neighbor)
 		initialPosition = stream_reader_get_position(reader);
 
 		LOG_DEBUG("cdp_parse_packet: Reading TLV type (" FORMAT_OFF_T ")\n", stream_reader_get_position(reader));
-		if (stream_reader_get16(reader, &tlvType) < 0)
+		rc = stream_reader_get16(reader, &tlvType);
+		if (rc < 0)
 		{
-			LOG_ERROR("cdp_parse_packet: Failed to read TLV type\n");
+			LOG_DEBUG("cdp_parse_packet: Failed to read TLV type\n");
 			cdp_packet_delete(result);
-			return -1;
+			return rc;
 		}
 
 		LOG_DEBUG("cdp_parse_packet: Reading TLV length (" FORMAT_OFF_T ")\n", stream_reader_get_position(reader));
-		if (stream_reader_get16(reader, &tlvLength) < 0)
+		rc = stream_reader_get16(reader, &tlvLength);
+		if (rc < 0)
+		{
+			LOG_DEBUG("cdp_parse_packet: Failed to read TLV length\n");
+			cdp_packet_delete(result);
+			return rc;
+		}
+
+		/* The length includes the type and length fields, anything shorter would never advance */
+		if (tlvLength < 4)
 		{
-			LOG_ERROR("cdp_parse_packet: Failed to read TLV length\n");
+			LOG_DEBUG("cdp_parse_packet: TLV length %d is shorter than the TLV header\n", tlvLength);
 			cdp_packet_delete(result);
-			return -1;
+			return stream_reader_fail(reader, CDP_ERROR_BAD_LENGTH);
+		}
+
+		if (!stream_reader_need(reader, (size_t)(tlvLength - 4)))
+		{
+			LOG_DEBUG("cdp_parse_packet: TLV length %d runs past the end of the frame\n", tlvLength);
+			cdp_packet_delete(result);
+			return stream_reader_fail(reader, CDP_ERROR_TRUNCATED);
 		}
 
 		switch (tlvType)
 		{
 			case CdpTlvDeviceId:
+				rc = cdp_parse_string(reader, pool, (size_t)(tlvLength - 4), &result->device_id);
+				if (rc < 0)
 				{
-					char *deviceId;
-
-					if (stream_reader_get_string(reader, &deviceId, (size_t)(tlvLength - 4)) < 0)
-					{
-						LOG_ERROR("cdp_parse_packet: Failed to read device ID string\n");
-						cdp_packet_delete(result);
-
-						return -1;
-					}
-
-					if (cdp_packet_set_device_id(result, deviceId) < 0)
-					{
-						LOG_ERROR("cdp_parse_packet: Failed to set the device ID\n");
-						FREE_ARRAY(deviceId);
-						cdp_packet_delete(result);
+					LOG_DEBUG("cdp_parse_packet: Failed to read device ID string\n");
+					cdp_packet_delete(result);
 
-						return -1;
-					}
-
-					FREE_ARRAY(deviceId);
+					return rc;
 				}
 				break;
 
@@ -98,64 +144,61 @@ int cdp_parse_packet(struct stream_reader *reader, struct cdp_packet **neighbor)
 					uint32_t addressCount;
 					uint32_t i;
 
-					if (stream_reader_get32(reader, &addressCount) < 0)
+					rc = stream_reader_get32(reader, &addressCount);
+					if (rc < 0)
 					{
-						LOG_ERROR("cdp_parse_packet: Failed to read address count\n");
+						LOG_DEBUG("cdp_parse_packet: Failed to read address count\n");
 						cdp_packet_delete(result);
-						return -1;
+						return rc;
+					}
+
+					/* Don't let the count provision more addresses than the TLV could hold */
+					if (tlvLength < 8 || addressCount > (uint32_t)(tlvLength - 8) / CDP_ADDRESS_MINIMUM_LENGTH)
+					{
+						LOG_DEBUG("cdp_parse_packet: Address count %u doesn't fit in the TLV\n", addressCount);
+						cdp_packet_delete(result);
+						return stream_reader_fail(reader, CDP_ERROR_BAD_LENGTH);
 					}
 
 					if (cdp_packet_provision_address_array(result, addressCount) < 0)
 					{
-						LOG_ERROR("cdp_parse_packet: Failed to allocate IP address array\n");
+						LOG_DEBUG("cdp_parse_packet: Failed to allocate IP address array\n");
 						cdp_packet_delete(result);
-						return -1;
+						return stream_reader_fail(reader, CDP_ERROR_NO_MEMORY);
 					}
 
 					for (i = 0; i < addressCount; i++)
 					{
-						struct sockaddr *item = NULL;
+						/* Read into the stack, the array copies the address into its own slot */
+						struct sockaddr_in6 storage;
+						struct sockaddr *item = (struct sockaddr *)&storage;
 
-						if (stream_reader_get_address(reader, &item) < 0)
+						rc = stream_reader_get_address(reader, &item);
+						if (rc < 0)
 						{
-							LOG_ERROR("cdp_parse_packet: Failed to read address\n");
+							LOG_DEBUG("cdp_parse_packet: Failed to read address\n");
 							cdp_packet_delete(result);
-							return -1;
+							return rc;
 						}
 
-						if (cdp_packet_set_address(result, i, item) < 0)
+						if (cdp_packet_set_address_copy(result, i, item) < 0)
 						{
-							LOG_ERROR("cdp_parse_packet: Failed to set address\n");
+							LOG_DEBUG("cdp_parse_packet: Failed to set address\n");
 							cdp_packet_delete(result);
-							FREE(item);
-							return -1;
+							return stream_reader_fail(reader, CDP_ERROR_BAD_VALUE);
 						}
 					}
 				}
 				break;
 
 			case CdpTlvPortId:
+				rc = cdp_parse_string(reader, pool, (size_t)(tlvLength - 4), &result->port_id);
+				if (rc < 0)
 				{
-					char *portId;
-
-					if (stream_reader_get_string(reader, &portId, (size_t)(tlvLength - 4)) < 0)
-					{
-						LOG_ERROR("cdp_parse_packet: Failed to read port ID string\n");
-						cdp_packet_delete(result);
-
-						return -1;
-					}
-
-					if (cdp_packet_set_port_id(result, portId) < 0)
-					{
-						LOG_ERROR("cdp_parse_packet: Failed to set the port ID\n");
-						FREE_ARRAY(portId);
-						cdp_packet_delete(result);
+					LOG_DEBUG("cdp_parse_packet: Failed to read port ID string\n");
+					cdp_packet_delete(result);
 
-						return -1;
-					}
-
-					FREE_ARRAY(portId);
+					return rc;
 				}
 				break;
 
@@ -163,69 +206,43 @@ int cdp_parse_packet(struct stream_reader *reader, struct cdp_packet **neighbor)
 				{
 					uint32_t capabilities;
 
-					if (stream_reader_get32(reader, &capabilities) < 0)
+					rc = stream_reader_get32(reader, &capabilities);
+					if (rc < 0)
 					{
-						LOG_ERROR("cdp_parse_packet: failed to read capabilities\n");
+						LOG_DEBUG("cdp_parse_packet: failed to read capabilities\n");
 						cdp_packet_delete(result);
 
-						return -1;
+						return rc;
 					}
 
 					if (cdp_packet_set_capabilities(result, capabilities) < 0)
 					{
-						LOG_ERROR("cdp_parse_packet: failed to set capabilities\n");
-						return -1;
+						LOG_DEBUG("cdp_parse_packet: failed to set capabilities\n");
+						cdp_packet_delete(result);
+						return stream_reader_fail(reader, CDP_ERROR_NO_MEMORY);
 					}
 				}
 				break;
 
 			case CdpTlvSoftwareVersion:
+				rc = cdp_parse_string(reader, pool, (size_t)(tlvLength - 4), &result->software_version);
+				if (rc < 0)
 				{
-					char *softwareVersion;
+					LOG_DEBUG("cdp_parse_packet: Failed to read software version string\n");
+					cdp_packet_delete(result);
 
-					if (stream_reader_get_string(reader, &softwareVersion, (size_t)(tlvLength - 4)) < 0)
-					{
-						LOG_ERROR("cdp_parse_packet: Failed to read software version string\n");
-						cdp_packet_delete(result);
-
-						return -1;
-					}
-
-					if (cdp_packet_set_software_version(result, softwareVersion) < 0)
-					{
-						LOG_ERROR("cdp_parse_packet: Failed to set the software version\n");
-						FREE_ARRAY(softwareVersion);
-						cdp_packet_delete(result);
-
-						return -1;
-					}
-
-					FREE_ARRAY(softwareVersion);
+					return rc;
 				}
 				break;
 
 			case CdpTlvPlatform:
+				rc = cdp_parse_string(reader, pool, (size_t)(tlvLength - 4), &result->platform);
+				if (rc < 0)
 				{
-					char *platform;
-
-					if (stream_reader_get_string(reader, &platform, (size_t)(tlvLength - 4)) < 0)
-					{
-						LOG_ERROR("cdp_parse_packet: Failed to read platform string\n");
-						cdp_packet_delete(result);
-
-						return -1;
-					}
-
-					if (cdp_packet_set_platform(result, platform) < 0)
-					{
-						LOG_ERROR("cdp_parse_packet: Failed to set the platform\n");
-						FREE_ARRAY(platform);
-						cdp_packet_delete(result);
-
-						return -1;
-					}
+					LOG_DEBUG("cdp_parse_packet: Failed to read platform string\n");
+					cdp_packet_delete(result);
 
-					FREE_ARRAY(platform);
+					return rc;
 				}
 				break;
 
@@ -236,9 +253,9 @@ int cdp_parse_packet(struct stream_reader *reader, struct cdp_packet **neighbor)
 
 					if (cdp_packet_provision_odr_ip_prefix_array(result, prefixCount) < 0)
 					{
-						LOG_ERROR("cdp_parse_packet: Failed to allocate ODR IP prefix array\n");
+						LOG_DEBUG("cdp_parse_packet: Failed to allocate ODR IP prefix array\n");
 						cdp_packet_delete(result);
-						return -1;
+						return stream_reader_fail(reader, CDP_ERROR_NO_MEMORY);
 					}
 
 					for (i = 0; i < prefixCount; i++)
@@ -247,48 +264,50 @@ int cdp_parse_packet(struct stream_reader *reader, struct cdp_packet **neighbor)
 						uint8_t length;
 						struct ip_prefix *prefix = NULL;
 
-						if (stream_reader_get_inet_address(reader, &item) < 0)
+						rc = stream_reader_get_inet_address(reader, &item);
+						if (rc < 0)
 						{
-							LOG_ERROR("cdp_parse_packet: Failed to read ODR IP network address\n");
+							LOG_DEBUG("cdp_parse_packet: Failed to read ODR IP network address\n");
 							cdp_packet_delete(result);
-							return -1;
+							return rc;
 						}
 
-						if (stream_reader_get8(reader, &length) < 0)
+						rc = stream_reader_get8(reader, &length);
+						if (rc < 0)
 						{
-							LOG_ERROR("cdp_parse_packet: Failed to ODR IP prefix length\n");
+							LOG_DEBUG("cdp_parse_packet: Failed to ODR IP prefix length\n");
 							cdp_packet_delete(result);
 							FREE(item);
-							return -1;
+							return rc;
 						}
 
 						prefix = ip_prefix_new();
 						if (prefix == NULL)
 						{
-							LOG_ERROR("cdp_parse_packet: Failed to allocate IP prefix\n");
+							LOG_DEBUG("cdp_parse_packet: Failed to allocate IP prefix\n");
 							cdp_packet_delete(result);
 							FREE(item);
-							return -1;
+							return stream_reader_fail(reader, CDP_ERROR_NO_MEMORY);
 						}
 
 						if (ip_prefix_set(prefix, item, length) < 0)
 						{
-							LOG_ERROR("cdp_parse_packet: Failed to allocate IP prefix\n");
+							LOG_DEBUG("cdp_parse_packet: Failed to allocate IP prefix\n");
 							cdp_packet_delete(result);
 							FREE(item);
 							ip_prefix_delete(prefix);
 
-							return -1;
+							return stream_reader_fail(reader, CDP_ERROR_NO_MEMORY);
 						}
 
 						if (cdp_packet_set_odr_ip_prefix(result, i, prefix) < 0)
 						{
-							LOG_ERROR("cdp_parse_packet: Failed to allocate IP prefix\n");
+							LOG_DEBUG("cdp_parse_packet: Failed to allocate IP prefix\n");
 							cdp_packet_delete(result);
 							FREE(item);
 							ip_prefix_delete(prefix);
 
-							return -1;
+							return stream_reader_fail(reader, CDP_ERROR_NO_MEMORY);
 						}
 					}
 				}
@@ -298,43 +317,32 @@ int cdp_parse_packet(struct stream_reader *reader, struct cdp_packet **neighbor)
 				{
 					struct cisco_cluster_management_protocol *clusterProtocol;
 
-					if (stream_reader_get_cisco_cluster_management_protocol(reader, &clusterProtocol) < 0)
+					rc = stream_reader_get_cisco_cluster_management_protocol(reader, &clusterProtocol);
+					if (rc < 0)
 					{
-						LOG_ERROR("cdp_parse_packet: Failed to read cisco cluster management protocol tlv\n");
-						return -1;
+						LOG_DEBUG("cdp_parse_packet: Failed to read cisco cluster management protocol tlv\n");
+						cdp_packet_delete(result);
+						return rc;
 					}
 
 					if (cdp_packet_set_cisco_cluster_management_protocol(result, clusterProtocol) < 0)
 					{
-						LOG_ERROR("cdp_parse_packet: Failed to set the cisco cluster management protocol\n");
+						LOG_DEBUG("cdp_parse_packet: Failed to set the cisco cluster management protocol\n");
 						cisco_cluster_management_protocol_delete(clusterProtocol);
-						return -1;
+						cdp_packet_delete(result);
+						return stream_reader_fail(reader, CDP_ERROR_NO_MEMORY);
 					}
 				}
 				break;
 
 			case CdpTlvVtpManagementDomain:
+				rc = cdp_parse_string(reader, pool, (size_t)(tlvLength - 4), &result->vtp_management_domain);
+				if (rc < 0)
 				{
-					char *vtpManagementDomain;
-
-					if (stream_reader_get_string(reader, &vtpManagementDomain, (size_t)(tlvLength - 4)) < 0)
-					{
-						LOG_ERROR("cdp_parse_packet: Failed to read VTP management domain string\n");
-						cdp_packet_delete(result);
-
-						return -1;
-					}
-
-					if (cdp_packet_set_vtp_management_domain(result, vtpManagementDomain) < 0)
-					{
-						LOG_ERROR("cdp_parse_packet: Failed to set the VTP management domain\n");
-						FREE_ARRAY(vtpManagementDomain);
-						cdp_packet_delete(result);
-
-						return -1;
-					}
+					LOG_DEBUG("cdp_parse_packet: Failed to read VTP management domain string\n");
+					cdp_packet_delete(result);
 
-					FREE_ARRAY(vtpManagementDomain);
+					return rc;
 				}
 				break;
 
@@ -342,18 +350,20 @@ int cdp_parse_packet(struct stream_reader *reader, struct cdp_packet **neighbor)
 				{
 					uint16_t nativeVlan;
 
-					if (stream_reader_get16(reader, &nativeVlan) < 0)
+					rc = stream_reader_get16(reader, &nativeVlan);
+					if (rc < 0)
 					{
-						LOG_ERROR("cdp_parse_packet: failed to read the native VLAN\n");
+						LOG_DEBUG("cdp_parse_packet: failed to read the native VLAN\n");
 						cdp_packet_delete(result);
 
-						return -1;
+						return rc;
 					}
 
 					if (cdp_packet_set_native_vlan(result, nativeVlan) < 0)
 					{
-						LOG_ERROR("cdp_parse_packet: failed to set native VLAN\n");
-						return -1;
+						LOG_DEBUG("cdp_parse_packet: failed to set native VLAN\n");
+						cdp_packet_delete(result);
+						return stream_reader_fail(reader, CDP_ERROR_BAD_VALUE);
 					}
 				}
 				break;
@@ -362,18 +372,20 @@ int cdp_parse_packet(struct stream_reader *reader, struct cdp_packet **neighbor)
 				{
 					uint8_t duplex;
 
-					if (stream_reader_get8(reader, &duplex) < 0)
+					rc = stream_reader_get8(reader, &duplex);
+					if (rc < 0)
 					{
-						LOG_ERROR("cdp_parse_packet: failed to read the link duplex\n");
+						LOG_DEBUG("cdp_parse_packet: failed to read the link duplex\n");
 						cdp_packet_delete(result);
 
-						return -1;
+						return rc;
 					}
 
 					if (cdp_packet_set_duplex(result, duplex) < 0)
 					{
-						LOG_ERROR("cdp_parse_packet: failed to set the link duplex\n");
-						return -1;
+						LOG_DEBUG("cdp_parse_packet: failed to set the link duplex\n");
+						cdp_packet_delete(result);
+						return stream_reader_fail(reader, CDP_ERROR_NO_MEMORY);
 					}
 				}
 				break;
@@ -382,18 +394,20 @@ int cdp_parse_packet(struct stream_reader *reader, struct cdp_packet **neighbor)
 				{
 					uint8_t trustBitmap;
 
-					if (stream_reader_get8(reader, &trustBitmap) < 0)
+					rc = stream_reader_get8(reader, &trustBitmap);
+					if (rc < 0)
 					{
-						LOG_ERROR("cdp_parse_packet: failed to read the trust bitmap\n");
+						LOG_DEBUG("cdp_parse_packet: failed to read the trust bitmap\n");
 						cdp_packet_delete(result);
 
-						return -1;
+						return rc;
 					}
 
 					if (cdp_packet_set_trust_bitmap(result, trustBitmap) < 0)
 					{
-						LOG_ERROR("cdp_parse_packet: failed to set the trust bitmap\n");
-						return -1;
+						LOG_DEBUG("cdp_parse_packet: failed to set the trust bitmap\n");
+						cdp_packet_delete(result);
+						return stream_reader_fail(reader, CDP_ERROR_NO_MEMORY);
 					}
 				}
 				break;
@@ -402,18 +416,20 @@ int cdp_parse_packet(struct stream_reader *reader, struct cdp_packet **neighbor)
 				{
 					uint8_t untrustedPortCoS;
 
-					if (stream_reader_get8(reader, &untrustedPortCoS) < 0)
+					rc = stream_reader_get8(reader, &untrustedPortCoS);
+					if (rc < 0)
 					{
-						LOG_ERROR("cdp_parse_packet: failed to read the untrusted port CoS\n");
+						LOG_DEBUG("cdp_parse_packet: failed to read the untrusted port CoS\n");
 						cdp_packet_delete(result);
 
-						return -1;
+						return rc;
 					}
 
 					if (cdp_packet_set_untrusted_port_cos(result, untrustedPortCoS) < 0)
 					{
-						LOG_ERROR("cdp_parse_packet: failed to set the untrusted port CoS\n");
-						return -1;
+						LOG_DEBUG("cdp_parse_packet: failed to set the untrusted port CoS\n");
+						cdp_packet_delete(result);
+						return stream_reader_fail(reader, CDP_ERROR_NO_MEMORY);
 					}
 				}
 				break;
@@ -423,37 +439,48 @@ int cdp_parse_packet(struct stream_reader *reader, struct cdp_packet **neighbor)
 					uint32_t addressCount;
 					uint32_t i;
 
-					if (stream_reader_get32(reader, &addressCount) < 0)
+					rc = stream_reader_get32(reader, &addressCount);
+					if (rc < 0)
+					{
+						LOG_DEBUG("cdp_parse_packet: Failed to read management address count\n");
+						cdp_packet_delete(result);
+						return rc;
+					}
+
+					/* Don't let the count provision more addresses than the TLV could hold */
+					if (tlvLength < 8 || addressCount > (uint32_t)(tlvLength - 8) / CDP_ADDRESS_MINIMUM_LENGTH)
 					{
-						LOG_ERROR("cdp_parse_packet: Failed to read management address count\n");
+						LOG_DEBUG("cdp_parse_packet: Management address count %u doesn't fit in the TLV\n", addressCount);
 						cdp_packet_delete(result);
-						return -1;
+						return stream_reader_fail(reader, CDP_ERROR_BAD_LENGTH);
 					}
 
 					if (cdp_packet_provision_management_address_array(result, addressCount) < 0)
 					{
-						LOG_ERROR("cdp_parse_packet: Failed to allocate management address array\n");
+						LOG_DEBUG("cdp_parse_packet: Failed to allocate management address array\n");
 						cdp_packet_delete(result);
-						return -1;
+						return stream_reader_fail(reader, CDP_ERROR_NO_MEMORY);
 					}
 
 					for (i = 0; i < addressCount; i++)
 					{
-						struct sockaddr *item = NULL;
+						/* Read into the stack, the array copies the address into its own slot */
+						struct sockaddr_in6 storage;
+						struct sockaddr *item = (struct sockaddr *)&storage;
 
-						if (stream_reader_get_address(reader, &item) < 0)
+						rc = stream_reader_get_address(reader, &item);
+						if (rc < 0)
 						{
-							LOG_ERROR("cdp_parse_packet: Failed to read address\n");
+							LOG_DEBUG("cdp_parse_packet: Failed to read address\n");
 							cdp_packet_delete(result);
-							return -1;
+							return rc;
 						}
 
-						if (cdp_packet_set_management_address(result, i, item) < 0)
+						if (cdp_packet_set_management_address_copy(result, i, item) < 0)
 						{
-							LOG_ERROR("cdp_parse_packet: Failed to set address\n");
+							LOG_DEBUG("cdp_parse_packet: Failed to set address\n");
 							cdp_packet_delete(result);
-							FREE(item);
-							return -1;
+							return stream_reader_fail(reader, CDP_ERROR_BAD_VALUE);
 						}
 					}
 				}
@@ -463,49 +490,37 @@ int cdp_parse_packet(struct stream_reader *reader, struct cdp_packet **neighbor)
 				{
 					struct power_over_ethernet_availability *poe;
 
-					if (power_over_ethernet_availability_read(reader, &poe) < 0)
+					rc = power_over_ethernet_availability_read(reader, &poe);
+					if (rc < 0)
 					{
-						LOG_ERROR("cdp_parse_packet: Failed to read PoE availability\n");
+						LOG_DEBUG("cdp_parse_packet: Failed to read PoE availability\n");
 						cdp_packet_delete(result);
-						return -1;
+						return rc;
 					}
 
 					if (cdp_packet_set_poe_availability(result, poe) < 0)
 					{
-						LOG_ERROR("cdp_parse_packet: Failed to set PoE availability\n");
+						LOG_DEBUG("cdp_parse_packet: Failed to set PoE availability\n");
 						power_over_ethernet_availability_delete(poe);
-						return -1;
+						cdp_packet_delete(result);
+						return stream_reader_fail(reader, CDP_ERROR_NO_MEMORY);
 					}
 				}
 				break;
 
 			case CdpTlvStartupNativeVlan:
+				rc = cdp_parse_string(reader, pool, (size_t)(tlvLength - 4), &result->startup_native_vlan);
+				if (rc < 0)
 				{
-					char *startupNativeVlan;
-
-					if (stream_reader_get_string(reader, &startupNativeVlan, (size_t)(tlvLength - 4)) < 0)
-					{
-						LOG_ERROR("cdp_parse_packet: Failed to read startup native VLAN string\n");
-						cdp_packet_delete(result);
-
-						return -1;
-					}
+					LOG_DEBUG("cdp_parse_packet: Failed to read startup native VLAN string\n");
+					cdp_packet_delete(result);
 
-					if (cdp_packet_set_startup_native_vlan(result, startupNativeVlan) < 0)
-					{
-						LOG_ERROR("cdp_parse_packet: Failed to set the startup native VLAN\n");
-						FREE_ARRAY(startupNativeVlan);
-						cdp_packet_delete(result);
-
-						return -1;
-					}
-
-					FREE_ARRAY(startupNativeVlan);
+					return rc;
 				}
 				break;
 
 			default:
-				LOG_INFORMATIONAL(
+				LOG_DEBUG(
 					"cdp_parse_packet: Encountered unknown TLV (0x%04X) at position " FORMAT_OFF_T " (0x" FORMAT_HEX_OFF_T ") with length %d bytes\n",
 					tlvType,
 					initialPosition,
@@ -516,10 +531,74 @@ int cdp_parse_packet(struct stream_reader *reader, struct cdp_packet **neighbor)
 				break;
 		}
 
-		stream_reader_set_position(reader, initialPosition + tlvLength);
+		rc = stream_reader_set_position(reader, initialPosition + tlvLength);
+		if (rc < 0)
+		{
+			cdp_packet_delete(result);
+			return rc;
+		}
 	}
 
 	*neighbor = result;
 
 	return 0;
 }
+
+/** Folds a one's complement sum into a checksum.
+  *  @param sum The sum of the 16-bit words.
+  *  @return The checksum, 0 if the sum included a valid checksum.
+  */
+static uint16_t cdp_frame_fold_checksum(uint32_t sum)
+{
+	sum = (sum & 0xFFFF) + (sum >> 16);
+	sum = (sum & 0xFFFF) + (sum >> 16);
+
+	return (uint16_t)~sum;
+}
+
+bool cdp_frame_checksum_is_valid(const uint8_t *frame, size_t length)
+{
+	uint32_t sum = 0;
+	uint8_t last;
+	size_t i;
+
+	if (frame == NULL || length < 4)
+		return false;
+
+	for (i = 0; i + 1 < length; i += 2)
+		sum += ((uint32_t)frame[i] << 8) | frame[i + 1];
+
+	if ((length & 1) == 0)
+		return cdp_frame_fold_checksum(sum) == 0;
+
+	last = frame[length - 1];
+
+	/* RFC 1071 padding, then the Cisco sign extended form */
+	if (cdp_frame_fold_checksum(sum + ((uint32_t)last << 8)) == 0)
+		return true;
+
+	return cdp_frame_fold_checksum(sum + ((last & 0x80) ? (0xFF00U | last) - 1 : last)) == 0;
+}
+
+bool cdp_frame_is_well_formed(const uint8_t *frame, size_t length)
+{
+	size_t position = 4;
+	size_t tlv_length;
+
+	if (frame == NULL || length < 4)
+		return false;
+
+	while (position < length)
+	{
+		if (length - position < 4)
+			return false;
+
+		tlv_length = ((size_t)frame[position + 2] << 8) | frame[position + 3];
+		if (tlv_length < 4 || tlv_length > length - position)
+			return false;
+
+		position += tlv_length;
+	}
+
+	return true;
+}
@@ -2,8 +2,42 @@
 #define CDP_PACKET_PARSER_H
 
 #include "cdp_packet.h"
+#include "cdp_string_pool.h"
 #include "stream_reader.h"
 
+/** Parses a CDP frame starting at the version.
+  *  @param reader The reader positioned at the start of the frame. On failure, the byte offset of
+  *  the failure is available from stream_reader_get_error_position().
+  *  @param neighbor The location to store the parsed packet, only set on success.
+  *  @return 0 on success or a negative enum cdp_error telling why the frame was rejected.
+  */
 int cdp_parse_packet(struct stream_reader *reader, struct cdp_packet **neighbor);
 
+/** Parses a CDP frame like cdp_parse_packet, interning its strings in a pool. Packets parsed with
+  *  the same pool share one copy of each distinct device ID, port ID, software version, platform,
+  *  VTP management domain and startup native VLAN, which can then be compared by pointer.
+  *  @param reader The reader positioned at the start of the frame.
+  *  @param pool The pool to intern the strings in, NULL gives every packet private copies.
+  *  @param neighbor The location to store the parsed packet, only set on success.
+  *  @return 0 on success or a negative enum cdp_error telling why the frame was rejected.
+  */
+int cdp_parse_packet_with_pool(struct stream_reader *reader, struct cdp_string_pool *pool, struct cdp_packet **neighbor);
+
+/** Validates the checksum of a CDP frame without parsing it. Cisco devices compute the checksum of
+  *  odd length frames with the last byte in the low order half of a sign extended word rather than
+  *  padded as RFC 1071 says, so both forms are accepted.
+  *  @param frame The CDP frame starting at the version.
+  *  @param length The length of the frame in bytes.
+  *  @return true if the checksum is valid.
+  */
+bool cdp_frame_checksum_is_valid(const uint8_t *frame, size_t length);
+
+/** Checks that a CDP frame has a complete header and that its TLVs fill it exactly, without
+  *  allocating anything. This is cheap enough for a receive path to reject garbage before storing it.
+  *  @param frame The CDP frame starting at the version.
+  *  @param length The length of the frame in bytes.
+  *  @return true if the frame is well formed.
+  */
+bool cdp_frame_is_well_formed(const uint8_t *frame, size_t length);
+
 #endif
@@ -0,0 +1,646 @@
+#include "cdp_shm_table.h"
+#include "cdp_packet.h"
+#include "cdp_packet_parser.h"
+#include "stream_reader.h"
+#include "platform/atomic.h"
+#include "platform/platform.h"
+#include "platform/socket.h"
+#include "platform/string.h"
+
+#if defined(__linux__) && !defined(__KERNEL__)
+#include <errno.h>
+#include <fcntl.h>
+#include <net/if.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+/** The size of a buffer for an interface name, IF_NAMESIZE on Linux */
+#define CDP_SHM_TABLE_INTERFACE_NAME_SIZE 16
+
+/** How many times a reader retries a copy which raced with the writer before giving up. A writer
+  * which died while updating leaves the sequence odd forever.
+  */
+#define CDP_SHM_TABLE_READ_ATTEMPTS 65536
+
+/** Gets the heap of a region or a staging copy, which follows the slots.
+  *  @param slots The start of the slots.
+  *  @param slot_capacity The number of slots.
+  *  @return The start of the heap.
+  */
+static char *cdp_shm_table_heap(uint8_t *slots, uint32_t slot_capacity)
+{
+    return (char *)(slots + (size_t)slot_capacity * sizeof(struct cdp_shm_table_slot));
+}
+
+size_t cdp_shm_table_size(uint32_t slot_capacity, uint32_t heap_capacity)
+{
+    return sizeof(struct cdp_shm_table_header) + (size_t)slot_capacity * sizeof(struct cdp_shm_table_slot) + heap_capacity;
+}
+
+struct cdp_shm_table_writer *cdp_shm_table_writer_new(void *region, size_t size, uint32_t slot_capacity, uint32_t heap_capacity)
+{
+    struct cdp_shm_table_writer *result;
+    struct cdp_shm_table_header *header;
+    size_t staging_size;
+
+    if(region == NULL)
+    {
+        LOG_CRITICAL("cdp_shm_table_writer_new: region is NULL\n");
+        return NULL;
+    }
+
+    if(heap_capacity == 0 || size < cdp_shm_table_size(slot_capacity, heap_capacity))
+    {
+        LOG_ERROR("cdp_shm_table_writer_new: the region is too small for the table\n");
+        return NULL;
+    }
+
+    result = ALLOC_NEW(struct cdp_shm_table_writer);
+    if(result == NULL)
+    {
+        LOG_CRITICAL("cdp_shm_table_writer_new: failed to allocate memory for writer\n");
+        return NULL;
+    }
+
+    staging_size = size - sizeof(struct cdp_shm_table_header);
+    result->staging = ALLOC_NEW_ARRAY(uint8_t, staging_size);
+    if(result->staging == NULL)
+    {
+        LOG_CRITICAL("cdp_shm_table_writer_new: failed to allocate memory for the staging copy\n");
+        FREE(result);
+        return NULL;
+    }
+
+    result->region = (uint8_t *)region;
+    result->size = size;
+    result->path = NULL;
+
+    memset(region, 0, cdp_shm_table_size(slot_capacity, heap_capacity));
+
+    header = (struct cdp_shm_table_header *)region;
+    header->version = CDP_SHM_TABLE_VERSION;
+    header->header_length = sizeof(struct cdp_shm_table_header);
+    header->slot_length = sizeof(struct cdp_shm_table_slot);
+    header->slot_capacity = slot_capacity;
+    header->heap_capacity = heap_capacity;
+    header->heap_used = 1;
+
+    /* The magic is stored last so a reader never accepts a half initialized region */
+    ATOMIC_STORE_RELEASE(&header->magic, CDP_SHM_TABLE_MAGIC);
+
+    return result;
+}
+
+void cdp_shm_table_writer_delete(struct cdp_shm_table_writer *writer)
+{
+    if(writer == NULL)
+    {
+        LOG_CRITICAL("cdp_shm_table_writer_delete: writer is NULL\n");
+        return;
+    }
+
+#if defined(__linux__) && !defined(__KERNEL__)
+    if(writer->path != NULL)
+    {
+        munmap(writer->region, writer->size);
+        unlink(writer->path);
+        FREE_ARRAY(writer->path);
+    }
+#endif
+
+    FREE_ARRAY(writer->staging);
+    FREE(writer);
+}
+
+/** Appends a string to the staging heap.
+  *  @param heap The staging heap.
+  *  @param heap_capacity The size of the heap.
+  *  @param heap_used The number of bytes of the heap in use, updated.
+  *  @param value The string to append or NULL.
+  *  @param truncated Set if the string didn't fit.
+  *  @return The offset of the string, 0 (the empty string) if the value is NULL or didn't fit.
+  */
+static uint32_t cdp_shm_table_add_string(char *heap, uint32_t heap_capacity, uint32_t *heap_used, const char *value, bool *truncated)
+{
+    size_t length;
+    uint32_t result;
+
+    if(value == NULL || value[0] == '\0')
+        return 0;
+
+    length = strlen(value) + 1;
+    if(length > heap_capacity - *heap_used)
+    {
+        *truncated = true;
+        return 0;
+    }
+
+    result = *heap_used;
+    COPY_MEMORY(value, heap + result, length);
+    *heap_used += (uint32_t)length;
+
+    return result;
+}
+
+/** Looks up the current name of an interface. Neighbors are identified by the interface index, so
+  *  a renamed interface is published with its new name.
+  *  @param index The index of the interface.
+  *  @param buffer A buffer of CDP_SHM_TABLE_INTERFACE_NAME_SIZE bytes for the name.
+  *  @return The name, or the index formatted as "if<index>" if the interface no longer exists.
+  */
+static const char *cdp_shm_table_interface_name(int index, char *buffer)
+{
+#if defined(__linux__) && !defined(__KERNEL__)
+    if(index > 0 && if_indextoname((unsigned int)index, buffer) != NULL)
+        return buffer;
+#endif
+
+    snprintf(buffer, CDP_SHM_TABLE_INTERFACE_NAME_SIZE, "if%d", index);
+
+    return buffer;
+}
+
+/** Copies the addresses of a packet into a slot.
+  *  @param slot The slot to fill.
+  *  @param addresses The addresses from the packet or NULL.
+  */
+static void cdp_shm_table_add_addresses(struct cdp_shm_table_slot *slot, const struct ip_address_array *addresses)
+{
+    size_t i;
+
+    if(addresses == NULL)
+        return;
+
+    for(i = 0; i < addresses->count && slot->address_count < CDP_SHM_TABLE_MAX_ADDRESSES; i++)
+    {
+        const struct ip_address *address = &addresses->addresses[i];
+
+        if(address->family == AF_INET)
+        {
+            slot->address_versions[slot->address_count] = 4;
+            COPY_MEMORY(address->octets, slot->addresses[slot->address_count], 4);
+            slot->address_count++;
+        }
+        else if(address->family == AF_INET6)
+        {
+            slot->address_versions[slot->address_count] = 6;
+            COPY_MEMORY(address->octets, slot->addresses[slot->address_count], 16);
+            slot->address_count++;
+        }
+    }
+}
+
+/** Fills a slot from a neighbor, decoding the neighbor's last frame.
+  *  @param slot The slot to fill.
+  *  @param neighbor The neighbor.
+  *  @param heap The staging heap.
+  *  @param heap_capacity The size of the heap.
+  *  @param heap_used The number of bytes of the heap in use, updated.
+  *  @param truncated Set if a string didn't fit.
+  */
+static void cdp_shm_table_fill_slot(
+    struct cdp_shm_table_slot *slot,
+    const struct cdp_neighbor *neighbor,
+    char *heap,
+    uint32_t heap_capacity,
+    uint32_t *heap_used,
+    bool *truncated
+)
+{
+    struct stream_reader *reader;
+    struct cdp_packet *packet = NULL;
+    char interface_name[CDP_SHM_TABLE_INTERFACE_NAME_SIZE];
+
+    memset(slot, 0, sizeof(struct cdp_shm_table_slot));
+
+    slot->interface_index = neighbor->device_index;
+    slot->received_at_seconds = (int64_t)neighbor->received_at.tv_sec;
+    slot->received_at_nanoseconds = (uint32_t)neighbor->received_at.tv_nsec;
+    slot->interface_name = cdp_shm_table_add_string(
+        heap,
+        heap_capacity,
+        heap_used,
+        cdp_shm_table_interface_name(neighbor->device_index, interface_name),
+        truncated
+    );
+
+    cdp_neighbor_unpack_mac(neighbor->remote_mac, slot->remote_mac);
+    slot->remote_mac_length = CDP_NEIGHBOR_MAC_LENGTH;
+
+    if(neighbor->frame_buffer == NULL || neighbor->frame_buffer_length == 0)
+        return;
+
+    reader = stream_reader_new(neighbor->frame_buffer, neighbor->frame_buffer_length);
+    if(reader == NULL)
+        return;
+
+    if(cdp_parse_packet(reader, &packet) == 0 && packet != NULL)
+    {
+        slot->hold_time = packet->cdp_ttl;
+        slot->duplex = (uint8_t)packet->duplex;
+
+        if(packet->capabilities != NULL)
+            slot->capabilities = *packet->capabilities;
+
+        if(packet->native_vlan != NULL)
+            slot->native_vlan = *packet->native_vlan;
+
+        cdp_shm_table_add_addresses(slot, packet->addresses);
+
+        slot->device_id = cdp_shm_table_add_string(heap, heap_capacity, heap_used, packet->device_id, truncated);
+        slot->port_id = cdp_shm_table_add_string(heap, heap_capacity, heap_used, packet->port_id, truncated);
+        slot->platform = cdp_shm_table_add_string(heap, heap_capacity, heap_used, packet->platform, truncated);
+        slot->software_version = cdp_shm_table_add_string(heap, heap_capacity, heap_used, packet->software_version, truncated);
+        slot->vtp_management_domain = cdp_shm_table_add_string(heap, heap_capacity, heap_used, packet->vtp_management_domain, truncated);
+    }
+
+    if(packet != NULL)
+        cdp_packet_delete(packet);
+
+    stream_reader_delete(reader);
+}
+
+int cdp_shm_table_writer_publish(struct cdp_shm_table_writer *writer, const struct cdp_neighbor_list *neighbors, struct timespec now)
+{
+    struct cdp_shm_table_header *header;
+    struct cdp_shm_table_slot *slots;
+    const struct cdp_neighbor *neighbor;
+    char *heap;
+    uint32_t neighbor_count = 0;
+    uint32_t heap_used = 1;
+    uint32_t sequence;
+    bool truncated = false;
+
+    if(writer == NULL)
+    {
+        LOG_CRITICAL("cdp_shm_table_writer_publish: writer is NULL\n");
+        return -1;
+    }
+
+    if(neighbors == NULL)
+    {
+        LOG_CRITICAL("cdp_shm_table_writer_publish: neighbors is NULL\n");
+        return -1;
+    }
+
+    header = (struct cdp_shm_table_header *)writer->region;
+    slots = (struct cdp_shm_table_slot *)writer->staging;
+    heap = cdp_shm_table_heap(writer->staging, header->slot_capacity);
+    heap[0] = '\0';
+
+    /* Build the whole table privately, parsing frames can be slow compared to a copy */
+    for(neighbor = neighbors->head; neighbor != NULL; neighbor = neighbor->next)
+    {
+        if(neighbor_count == header->slot_capacity)
+        {
+            truncated = true;
+            break;
+        }
+
+        cdp_shm_table_fill_slot(&slots[neighbor_count], neighbor, heap, header->heap_capacity, &heap_used, &truncated);
+        neighbor_count++;
+    }
+
+    sequence = ATOMIC_LOAD_RELAXED(&header->sequence);
+    ATOMIC_STORE_RELAXED(&header->sequence, sequence + 1);
+    THREAD_FENCE_RELEASE();
+
+    COPY_MEMORY(writer->staging, writer->region + header->header_length, (size_t)neighbor_count * sizeof(struct cdp_shm_table_slot));
+    COPY_MEMORY(heap, cdp_shm_table_heap(writer->region + header->header_length, header->slot_capacity), heap_used);
+
+    header->neighbor_count = neighbor_count;
+    header->heap_used = heap_used;
+    header->flags = truncated ? CDP_SHM_TABLE_FLAG_TRUNCATED : 0;
+    header->updated_at_seconds = (int64_t)now.tv_sec;
+    header->updated_at_nanoseconds = (int64_t)now.tv_nsec;
+
+    ATOMIC_STORE_RELEASE(&header->sequence, sequence + 2);
+
+    return (int)neighbor_count;
+}
+
+struct cdp_shm_table_reader *cdp_shm_table_reader_new(const void *region, size_t size)
+{
+    struct cdp_shm_table_reader *result;
+    const struct cdp_shm_table_header *header;
+
+    if(region == NULL)
+    {
+        LOG_CRITICAL("cdp_shm_table_reader_new: region is NULL\n");
+        return NULL;
+    }
+
+    header = (const struct cdp_shm_table_header *)region;
+
+    if(size < sizeof(struct cdp_shm_table_header) || ATOMIC_LOAD_ACQUIRE(&header->magic) != CDP_SHM_TABLE_MAGIC)
+    {
+        LOG_ERROR("cdp_shm_table_reader_new: the region is not a CDP neighbor table\n");
+        return NULL;
+    }
+
+    /* The layout fields are written once before the magic and never change */
+    if(
+        header->version != CDP_SHM_TABLE_VERSION ||
+        header->header_length != sizeof(struct cdp_shm_table_header) ||
+        header->slot_length != sizeof(struct cdp_shm_table_slot) ||
+        header->heap_capacity == 0 ||
+        size < cdp_shm_table_size(header->slot_capacity, header->heap_capacity)
+    )
+    {
+        LOG_ERROR("cdp_shm_table_reader_new: unsupported table layout (version %d)\n", (int)header->version);
+        return NULL;
+    }
+
+    result = ALLOC_NEW(struct cdp_shm_table_reader);
+    if(result == NULL)
+    {
+        LOG_CRITICAL("cdp_shm_table_reader_new: failed to allocate memory for reader\n");
+        return NULL;
+    }
+
+    size = cdp_shm_table_size(header->slot_capacity, header->heap_capacity);
+    result->copy = ALLOC_NEW_ARRAY(uint8_t, size);
+    if(result->copy == NULL)
+    {
+        LOG_CRITICAL("cdp_shm_table_reader_new: failed to allocate memory for the copy\n");
+        FREE(result);
+        return NULL;
+    }
+
+    /* Until the first read the copy is an empty table */
+    memset(result->copy, 0, size);
+    COPY_MEMORY(region, result->copy, sizeof(struct cdp_shm_table_header));
+    ((struct cdp_shm_table_header *)result->copy)->neighbor_count = 0;
+    ((struct cdp_shm_table_header *)result->copy)->heap_used = 1;
+
+    result->region = (const uint8_t *)region;
+    result->size = size;
+    result->mapped = false;
+
+    return result;
+}
+
+void cdp_shm_table_reader_delete(struct cdp_shm_table_reader *reader)
+{
+    if(reader == NULL)
+    {
+        LOG_CRITICAL("cdp_shm_table_reader_delete: reader is NULL\n");
+        return;
+    }
+
+#if defined(__linux__) && !defined(__KERNEL__)
+    if(reader->mapped)
+        munmap((void *)reader->region, reader->size);
+#endif
+
+    FREE_ARRAY(reader->copy);
+    FREE(reader);
+}
+
+int cdp_shm_table_reader_read(struct cdp_shm_table_reader *reader)
+{
+    const struct cdp_shm_table_header *shared;
+    struct cdp_shm_table_header *header;
+    uint32_t begin;
+    uint32_t end;
+    int attempt;
+
+    if(reader == NULL)
+    {
+        LOG_CRITICAL("cdp_shm_table_reader_read: reader is NULL\n");
+        return -1;
+    }
+
+    shared = (const struct cdp_shm_table_header *)reader->region;
+    header = (struct cdp_shm_table_header *)reader->copy;
+
+    for(attempt = 0; attempt < CDP_SHM_TABLE_READ_ATTEMPTS; attempt++)
+    {
+        begin = ATOMIC_LOAD_ACQUIRE(&shared->sequence);
+        if((begin & 1) != 0)
+            continue;
+
+        COPY_MEMORY(shared, header, sizeof(struct cdp_shm_table_header));
+
+        /* The counts may be torn by a concurrent update, they're only trusted once the sequence is
+         * confirmed but must keep the copy in bounds until then
+         */
+        if(header->neighbor_count > header->slot_capacity)
+            header->neighbor_count = header->slot_capacity;
+
+        if(header->heap_used > header->heap_capacity || header->heap_used == 0)
+            header->heap_used = 1;
+
+        COPY_MEMORY(
+            reader->region + header->header_length,
+            reader->copy + header->header_length,
+            (size_t)header->neighbor_count * sizeof(struct cdp_shm_table_slot)
+        );
+
+        COPY_MEMORY(
+            cdp_shm_table_heap((uint8_t *)reader->region + header->header_length, header->slot_capacity),
+            cdp_shm_table_heap(reader->copy + header->header_length, header->slot_capacity),
+            header->heap_used
+        );
+
+        THREAD_FENCE_ACQUIRE();
+        end = ATOMIC_LOAD_RELAXED(&shared->sequence);
+
+        if(begin == end)
+            return (int)header->neighbor_count;
+    }
+
+    LOG_ERROR("cdp_shm_table_reader_read: the table is being updated, try again later\n");
+
+    /* Leave an empty table rather than a torn one */
+    header->neighbor_count = 0;
+    header->heap_used = 1;
+
+    return -1;
+}
+
+const struct cdp_shm_table_header *cdp_shm_table_reader_get_header(const struct cdp_shm_table_reader *reader)
+{
+    if(reader == NULL)
+    {
+        LOG_CRITICAL("cdp_shm_table_reader_get_header: reader is NULL\n");
+        return NULL;
+    }
+
+    return (const struct cdp_shm_table_header *)reader->copy;
+}
+
+const struct cdp_shm_table_slot *cdp_shm_table_reader_get_slot(const struct cdp_shm_table_reader *reader, uint32_t index)
+{
+    const struct cdp_shm_table_header *header;
+
+    if(reader == NULL)
+    {
+        LOG_CRITICAL("cdp_shm_table_reader_get_slot: reader is NULL\n");
+        return NULL;
+    }
+
+    header = (const struct cdp_shm_table_header *)reader->copy;
+    if(index >= header->neighbor_count)
+        return NULL;
+
+    return (const struct cdp_shm_table_slot *)(reader->copy + header->header_length) + index;
+}
+
+const char *cdp_shm_table_reader_get_string(const struct cdp_shm_table_reader *reader, uint32_t offset)
+{
+    const struct cdp_shm_table_header *header;
+    const char *heap;
+
+    if(reader == NULL)
+    {
+        LOG_CRITICAL("cdp_shm_table_reader_get_string: reader is NULL\n");
+        return "";
+    }
+
+    header = (const struct cdp_shm_table_header *)reader->copy;
+    if(offset >= header->heap_used)
+        return "";
+
+    heap = cdp_shm_table_heap(reader->copy + header->header_length, header->slot_capacity);
+
+    /* The writer terminates every string, this only guards against a corrupted region */
+    if(memchr(heap + offset, '\0', header->heap_used - offset) == NULL)
+        return "";
+
+    return heap + offset;
+}
+
+#if defined(__linux__) && !defined(__KERNEL__)
+struct cdp_shm_table_writer *cdp_shm_table_writer_create(const char *path, uint32_t slot_capacity, uint32_t heap_capacity)
+{
+    struct cdp_shm_table_writer *result;
+    size_t path_length;
+    size_t size;
+    char *temporary_path;
+    void *region;
+    int fd;
+
+    if(path == NULL)
+    {
+        LOG_CRITICAL("cdp_shm_table_writer_create: path is NULL\n");
+        return NULL;
+    }
+
+    path_length = strlen(path);
+    temporary_path = ALLOC_NEW_ARRAY(char, path_length + 5);
+    if(temporary_path == NULL)
+    {
+        LOG_CRITICAL("cdp_shm_table_writer_create: failed to allocate memory for path\n");
+        return NULL;
+    }
+
+    COPY_MEMORY(path, temporary_path, path_length);
+    COPY_MEMORY(".new", temporary_path + path_length, 5);
+
+    /* The table is prepared under another name and renamed into place, so readers of a previous
+     * instance keep their mapping of the old file instead of seeing it truncated
+     */
+    size = cdp_shm_table_size(slot_capacity, heap_capacity);
+    fd = open(temporary_path, O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if(fd < 0)
+    {
+        LOG_ERROR("cdp_shm_table_writer_create: failed to create %s (%s)\n", temporary_path, strerror(errno));
+        FREE_ARRAY(temporary_path);
+        return NULL;
+    }
+
+    if(ftruncate(fd, (off_t)size) < 0)
+    {
+        LOG_ERROR("cdp_shm_table_writer_create: failed to size %s (%s)\n", temporary_path, strerror(errno));
+        close(fd);
+        unlink(temporary_path);
+        FREE_ARRAY(temporary_path);
+        return NULL;
+    }
+
+    region = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+
+    if(region == MAP_FAILED)
+    {
+        LOG_ERROR("cdp_shm_table_writer_create: failed to map %s (%s)\n", temporary_path, strerror(errno));
+        unlink(temporary_path);
+        FREE_ARRAY(temporary_path);
+        return NULL;
+    }
+
+    result = cdp_shm_table_writer_new(region, size, slot_capacity, heap_capacity);
+    if(result == NULL || rename(temporary_path, path) < 0)
+    {
+        if(result != NULL)
+        {
+            LOG_ERROR("cdp_shm_table_writer_create: failed to rename %s (%s)\n", temporary_path, strerror(errno));
+            cdp_shm_table_writer_delete(result);
+        }
+
+        munmap(region, size);
+        unlink(temporary_path);
+        FREE_ARRAY(temporary_path);
+        return NULL;
+    }
+
+    /* The buffer is reused for the final path, which is never longer */
+    COPY_MEMORY(path, temporary_path, path_length + 1);
+    result->path = temporary_path;
+
+    return result;
+}
+
+struct cdp_shm_table_reader *cdp_shm_table_reader_open(const char *path)
+{
+    struct cdp_shm_table_reader *result;
+    struct stat status;
+    void *region;
+    int fd;
+
+    if(path == NULL)
+    {
+        LOG_CRITICAL("cdp_shm_table_reader_open: path is NULL\n");
+        return NULL;
+    }
+
+    fd = open(path, O_RDONLY | O_CLOEXEC);
+    if(fd < 0)
+    {
+        LOG_ERROR("cdp_shm_table_reader_open: failed to open %s (%s)\n", path, strerror(errno));
+        return NULL;
+    }
+
+    if(fstat(fd, &status) < 0 || status.st_size < (off_t)sizeof(struct cdp_shm_table_header))
+    {
+        LOG_ERROR("cdp_shm_table_reader_open: %s is not a CDP neighbor table\n", path);
+        close(fd);
+        return NULL;
+    }
+
+    region = mmap(NULL, (size_t)status.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+
+    if(region == MAP_FAILED)
+    {
+        LOG_ERROR("cdp_shm_table_reader_open: failed to map %s (%s)\n", path, strerror(errno));
+        return NULL;
+    }
+
+    result = cdp_shm_table_reader_new(region, (size_t)status.st_size);
+    if(result == NULL)
+    {
+        munmap(region, (size_t)status.st_size);
+        return NULL;
+    }
+
+    /* The whole file is unmapped on delete */
+    result->size = (size_t)status.st_size;
+    result->mapped = true;
+
+    return result;
+}
+#endif
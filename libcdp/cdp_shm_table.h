@@ -0,0 +1,266 @@
+#ifndef CDP_SHM_TABLE_H
+#define CDP_SHM_TABLE_H
+
+#include "cdp_neighbor.h"
+#include "platform/time.h"
+#include "platform/types.h"
+
+/* A shared memory table is the neighbor table published as a flat memory region, normally a file
+ * under /dev/shm, so that local consumers can map it once and read the table with no system calls
+ * and no CDP parsing. The region is laid out as :
+ *
+ *   struct cdp_shm_table_header
+ *   struct cdp_shm_table_slot[slot_capacity]
+ *   char heap[heap_capacity]
+ *
+ * Every value is in host byte order except IP addresses, which are in network byte order. String
+ * fields of a slot are offsets into the heap of NUL terminated strings, offset 0 is always the
+ * empty string.
+ *
+ * There is a single writer which protects the contents with a sequence lock. The sequence is odd
+ * while the writer is updating the region. Readers copy the region and retry if the sequence was
+ * odd or changed during the copy, so a reader never observes a partial update and never blocks the
+ * writer.
+ */
+
+/** The magic number at the start of the region, "CDPT" when read as little-endian bytes */
+#define CDP_SHM_TABLE_MAGIC 0x54504443
+
+/** The version of the layout written by this library */
+#define CDP_SHM_TABLE_VERSION 1
+
+/** The file the user mode daemon publishes its table in */
+#define CDP_SHM_TABLE_DEFAULT_PATH "/dev/shm/cdp-neighbors"
+
+/** The maximum number of addresses stored per neighbor */
+#define CDP_SHM_TABLE_MAX_ADDRESSES 4
+
+/** The maximum length of a remote MAC address stored per neighbor */
+#define CDP_SHM_TABLE_MAX_MAC_LENGTH 6
+
+/** Set in the header flags when neighbors or strings didn't fit in the region */
+#define CDP_SHM_TABLE_FLAG_TRUNCATED 0x01
+
+/** The header at the start of the region */
+struct cdp_shm_table_header
+{
+    /** CDP_SHM_TABLE_MAGIC */
+    uint32_t magic;
+
+    /** CDP_SHM_TABLE_VERSION */
+    uint16_t version;
+
+    /** The length of this header, the slots follow it */
+    uint16_t header_length;
+
+    /** The length of a slot */
+    uint32_t slot_length;
+
+    /** The number of slots in the region */
+    uint32_t slot_capacity;
+
+    /** The size of the string heap in bytes */
+    uint32_t heap_capacity;
+
+    /** The sequence lock, odd while the writer updates the region */
+    uint32_t sequence;
+
+    /** The number of slots in use */
+    uint32_t neighbor_count;
+
+    /** The number of bytes of the heap in use */
+    uint32_t heap_used;
+
+    /** CDP_SHM_TABLE_FLAG_* */
+    uint32_t flags;
+
+    /** Reserved, zero */
+    uint32_t reserved;
+
+    /** The time the table was last published, seconds since the epoch */
+    int64_t updated_at_seconds;
+
+    /** The time the table was last published, nanoseconds */
+    int64_t updated_at_nanoseconds;
+};
+
+/** A single neighbor, decoded from its last CDP frame */
+struct cdp_shm_table_slot
+{
+    /** The index of the interface the neighbor was seen on */
+    int32_t interface_index;
+
+    /** The capabilities bitmap advertised by the neighbor, 0 if not advertised */
+    uint32_t capabilities;
+
+    /** The time the last frame was received, seconds since the epoch */
+    int64_t received_at_seconds;
+
+    /** The time the last frame was received, nanoseconds */
+    uint32_t received_at_nanoseconds;
+
+    /** The native VLAN advertised by the neighbor, 0 if not advertised */
+    uint16_t native_vlan;
+
+    /** The hold time of the last frame in seconds */
+    uint8_t hold_time;
+
+    /** The duplex advertised by the neighbor (ECdpNetworkDuplex) */
+    uint8_t duplex;
+
+    /** The neighbor's MAC address */
+    uint8_t remote_mac[CDP_SHM_TABLE_MAX_MAC_LENGTH];
+
+    /** The length of the neighbor's MAC address */
+    uint8_t remote_mac_length;
+
+    /** The number of entries of addresses in use */
+    uint8_t address_count;
+
+    /** The IP version of each address, 4 or 6 */
+    uint8_t address_versions[CDP_SHM_TABLE_MAX_ADDRESSES];
+
+    /** The addresses advertised by the neighbor, IPv4 addresses use the first 4 bytes */
+    uint8_t addresses[CDP_SHM_TABLE_MAX_ADDRESSES][16];
+
+    /** Heap offset of the name of the interface the neighbor was seen on */
+    uint32_t interface_name;
+
+    /** Heap offset of the device ID */
+    uint32_t device_id;
+
+    /** Heap offset of the port ID */
+    uint32_t port_id;
+
+    /** Heap offset of the platform */
+    uint32_t platform;
+
+    /** Heap offset of the software version */
+    uint32_t software_version;
+
+    /** Heap offset of the VTP management domain */
+    uint32_t vtp_management_domain;
+
+    /** Reserved, zero */
+    uint32_t reserved;
+};
+
+/** The publishing side of a shared memory table */
+struct cdp_shm_table_writer
+{
+    /** The shared region */
+    uint8_t *region;
+
+    /** The size of the shared region */
+    size_t size;
+
+    /** A private copy of the slots and the heap which are built before being published, so that
+      * readers only have to retry while the finished table is copied in
+      */
+    uint8_t *staging;
+
+    /** The file the region is mapped from or NULL when the region was passed in */
+    char *path;
+};
+
+/** The reading side of a shared memory table */
+struct cdp_shm_table_reader
+{
+    /** The shared region */
+    const uint8_t *region;
+
+    /** The size of the shared region */
+    size_t size;
+
+    /** The consistent copy of the region made by the last successful read */
+    uint8_t *copy;
+
+    /** Whether the region was mapped by cdp_shm_table_reader_open */
+    bool mapped;
+};
+
+/** Calculates the size of a region.
+  *  @param slot_capacity The number of neighbor slots.
+  *  @param heap_capacity The size of the string heap in bytes.
+  *  @return The size of the region in bytes.
+  */
+size_t cdp_shm_table_size(uint32_t slot_capacity, uint32_t heap_capacity);
+
+/** Constructor, initializes a region as an empty table.
+  *  @param region The region to publish the table in, at least cdp_shm_table_size() bytes.
+  *  @param size The size of the region.
+  *  @param slot_capacity The number of neighbor slots.
+  *  @param heap_capacity The size of the string heap in bytes.
+  *  @return Either the new writer or NULL on error.
+  */
+struct cdp_shm_table_writer *cdp_shm_table_writer_new(void *region, size_t size, uint32_t slot_capacity, uint32_t heap_capacity);
+
+/** Destructor, unmaps and removes the file if the writer was created with cdp_shm_table_writer_create.
+  *  @param writer The writer to delete.
+  */
+void cdp_shm_table_writer_delete(struct cdp_shm_table_writer *writer);
+
+/** Publishes a neighbor table, replacing the previous contents. Each neighbor's frame is parsed to
+  *  fill its slot. Neighbors which don't fit are left out and the table is flagged as truncated.
+  *  @param writer The writer object.
+  *  @param neighbors The neighbor table to publish.
+  *  @param now The time to record as the time of the update.
+  *  @return The number of neighbors published or a negative value on error.
+  */
+int cdp_shm_table_writer_publish(struct cdp_shm_table_writer *writer, const struct cdp_neighbor_list *neighbors, struct timespec now);
+
+/** Constructor, validates the layout of a region.
+  *  @param region The region the table is published in.
+  *  @param size The size of the region.
+  *  @return Either the new reader or NULL on error.
+  */
+struct cdp_shm_table_reader *cdp_shm_table_reader_new(const void *region, size_t size);
+
+/** Destructor, unmaps the region if the reader was created with cdp_shm_table_reader_open.
+  *  @param reader The reader to delete.
+  */
+void cdp_shm_table_reader_delete(struct cdp_shm_table_reader *reader);
+
+/** Takes a consistent copy of the table, which stays valid until the next read.
+  *  @param reader The reader object.
+  *  @return The number of neighbors in the copy or a negative value on error.
+  */
+int cdp_shm_table_reader_read(struct cdp_shm_table_reader *reader);
+
+/** Gets the header of the last copy.
+  *  @param reader The reader object.
+  *  @return The header.
+  */
+const struct cdp_shm_table_header *cdp_shm_table_reader_get_header(const struct cdp_shm_table_reader *reader);
+
+/** Gets a neighbor of the last copy.
+  *  @param reader The reader object.
+  *  @param index The index of the neighbor, less than the count returned by the read.
+  *  @return The neighbor or NULL if the index is out of range.
+  */
+const struct cdp_shm_table_slot *cdp_shm_table_reader_get_slot(const struct cdp_shm_table_reader *reader, uint32_t index);
+
+/** Resolves a string field of a neighbor of the last copy.
+  *  @param reader The reader object.
+  *  @param offset The heap offset stored in the slot.
+  *  @return The string, the empty string if the offset is invalid.
+  */
+const char *cdp_shm_table_reader_get_string(const struct cdp_shm_table_reader *reader, uint32_t offset);
+
+#if defined(__linux__) && !defined(__KERNEL__)
+/** Constructor, creates or replaces a file, maps it and initializes it as an empty table.
+  *  @param path The file to create, normally CDP_SHM_TABLE_DEFAULT_PATH.
+  *  @param slot_capacity The number of neighbor slots.
+  *  @param heap_capacity The size of the string heap in bytes.
+  *  @return Either the new writer or NULL on error.
+  */
+struct cdp_shm_table_writer *cdp_shm_table_writer_create(const char *path, uint32_t slot_capacity, uint32_t heap_capacity);
+
+/** Constructor, maps a table file read only.
+  *  @param path The file to map, normally CDP_SHM_TABLE_DEFAULT_PATH.
+  *  @return Either the new reader or NULL on error.
+  */
+struct cdp_shm_table_reader *cdp_shm_table_reader_open(const char *path);
+#endif
+
+#endif
@@ -0,0 +1,273 @@
+#include "cdp_string_pool.h"
+#include "platform/platform.h"
+#include "platform/string.h"
+
+#ifdef __KERNEL__
+#include <linux/stddef.h>
+#else
+#include <stddef.h>
+#endif
+
+/** The header in front of the characters of every string */
+struct cdp_string
+{
+    /** The next string in the same bucket of the pool */
+    struct cdp_string *next;
+
+    /** The pool the string is interned in or NULL for a private string */
+    struct cdp_string_pool *pool;
+
+    /** The hash of the characters */
+    uint32_t hash;
+
+    /** The number of references */
+    uint32_t references;
+
+    /** The number of characters, not counting the NUL */
+    size_t length;
+
+    /** The NUL terminated characters */
+    char value[];
+};
+
+struct cdp_string_pool
+{
+    /** The hash buckets, chained through cdp_string.next */
+    struct cdp_string **buckets;
+
+    /** The number of buckets, a power of 2 */
+    size_t bucket_count;
+
+    /** The number of strings in the pool */
+    size_t count;
+};
+
+/** Gets the header of a string.
+  *  @param string The characters of the string.
+  *  @return The header.
+  */
+static struct cdp_string *cdp_string_header(char *string)
+{
+    return (struct cdp_string *)(string - offsetof(struct cdp_string, value));
+}
+
+/** Hashes the characters of a string with FNV-1a.
+  *  @param value The characters.
+  *  @param length The number of characters.
+  *  @return The hash.
+  */
+static uint32_t cdp_string_hash(const char *value, size_t length)
+{
+    uint32_t hash = 2166136261U;
+    size_t i;
+
+    for(i = 0; i < length; i++)
+    {
+        hash ^= (uint8_t)value[i];
+        hash *= 16777619U;
+    }
+
+    return hash;
+}
+
+/** Allocates an array of empty buckets.
+  *  @param bucket_count The number of buckets.
+  *  @return The buckets or NULL on failure.
+  */
+static struct cdp_string **cdp_string_pool_new_buckets(size_t bucket_count)
+{
+    struct cdp_string **result;
+
+    result = ALLOC_NEW_ARRAY(struct cdp_string *, bucket_count);
+    if(result == NULL)
+        return NULL;
+
+    memset(result, 0, bucket_count * sizeof(struct cdp_string *));
+
+    return result;
+}
+
+struct cdp_string_pool *cdp_string_pool_new(size_t bucket_count)
+{
+    struct cdp_string_pool *result;
+    size_t rounded = 1;
+
+    while(rounded < bucket_count)
+        rounded <<= 1;
+
+    result = ALLOC_NEW(struct cdp_string_pool);
+    if(result == NULL)
+    {
+        LOG_ERROR("cdp_string_pool_new: Failed to allocate memory for the pool\n");
+        return NULL;
+    }
+
+    result->buckets = cdp_string_pool_new_buckets(rounded);
+    if(result->buckets == NULL)
+    {
+        LOG_ERROR("cdp_string_pool_new: Failed to allocate memory for the buckets\n");
+        FREE(result);
+        return NULL;
+    }
+
+    result->bucket_count = rounded;
+    result->count = 0;
+
+    return result;
+}
+
+void cdp_string_pool_delete(struct cdp_string_pool *pool)
+{
+    struct cdp_string *string;
+    struct cdp_string *next;
+    size_t i;
+
+    if(pool == NULL)
+        return;
+
+    for(i = 0; i < pool->bucket_count; i++)
+    {
+        for(string = pool->buckets[i]; string != NULL; string = next)
+        {
+            next = string->next;
+            string->next = NULL;
+            string->pool = NULL;
+        }
+    }
+
+    FREE_ARRAY(pool->buckets);
+    FREE(pool);
+}
+
+size_t cdp_string_pool_count(const struct cdp_string_pool *pool)
+{
+    if(pool == NULL)
+        return 0;
+
+    return pool->count;
+}
+
+/** Doubles the number of buckets of a pool. A pool which can't grow keeps working with longer chains.
+  *  @param pool The pool.
+  */
+static void cdp_string_pool_grow(struct cdp_string_pool *pool)
+{
+    struct cdp_string **buckets;
+    struct cdp_string *string;
+    struct cdp_string *next;
+    size_t bucket_count = pool->bucket_count << 1;
+    size_t i;
+
+    buckets = cdp_string_pool_new_buckets(bucket_count);
+    if(buckets == NULL)
+        return;
+
+    for(i = 0; i < pool->bucket_count; i++)
+    {
+        for(string = pool->buckets[i]; string != NULL; string = next)
+        {
+            next = string->next;
+            string->next = buckets[string->hash & (bucket_count - 1)];
+            buckets[string->hash & (bucket_count - 1)] = string;
+        }
+    }
+
+    FREE_ARRAY(pool->buckets);
+    pool->buckets = buckets;
+    pool->bucket_count = bucket_count;
+}
+
+char *cdp_string_intern(struct cdp_string_pool *pool, const char *value, size_t length)
+{
+    struct cdp_string *string;
+    uint32_t hash;
+
+    if(value == NULL && length > 0)
+    {
+        LOG_CRITICAL("cdp_string_intern: value is null\n");
+        return NULL;
+    }
+
+    hash = cdp_string_hash(value, length);
+
+    if(pool != NULL)
+    {
+        for(string = pool->buckets[hash & (pool->bucket_count - 1)]; string != NULL; string = string->next)
+        {
+            if(string->hash == hash && string->length == length && memcmp(string->value, value, length) == 0)
+            {
+                string->references++;
+                return string->value;
+            }
+        }
+    }
+
+    string = (struct cdp_string *)ALLOC_NEW_ARRAY(uint8_t, (sizeof(struct cdp_string) + length + 1));
+    if(string == NULL)
+    {
+        LOG_ERROR("cdp_string_intern: Failed to allocate memory for the string\n");
+        return NULL;
+    }
+
+    if(length > 0)
+        COPY_MEMORY(value, string->value, length);
+    string->value[length] = '\0';
+
+    string->next = NULL;
+    string->pool = pool;
+    string->hash = hash;
+    string->references = 1;
+    string->length = length;
+
+    if(pool != NULL)
+    {
+        if(pool->count >= pool->bucket_count)
+            cdp_string_pool_grow(pool);
+
+        string->next = pool->buckets[hash & (pool->bucket_count - 1)];
+        pool->buckets[hash & (pool->bucket_count - 1)] = string;
+        pool->count++;
+    }
+
+    return string->value;
+}
+
+char *cdp_string_hold(char *string)
+{
+    if(string != NULL)
+        cdp_string_header(string)->references++;
+
+    return string;
+}
+
+void cdp_string_release(char *string)
+{
+    struct cdp_string *header;
+    struct cdp_string **link;
+
+    if(string == NULL)
+        return;
+
+    header = cdp_string_header(string);
+    if(--header->references > 0)
+        return;
+
+    if(header->pool != NULL)
+    {
+        link = &header->pool->buckets[header->hash & (header->pool->bucket_count - 1)];
+        while(*link != NULL && *link != header)
+            link = &(*link)->next;
+
+        if(*link == header)
+        {
+            *link = header->next;
+            header->pool->count--;
+        }
+        else
+        {
+            LOG_CRITICAL("cdp_string_release: string is missing from its pool\n");
+        }
+    }
+
+    FREE_ARRAY(header);
+}
@@ -0,0 +1,60 @@
+#ifndef CDP_STRING_POOL_H
+#define CDP_STRING_POOL_H
+
+#include "platform/types.h"
+
+/* The text TLVs of a cdp_packet are reference counted strings. A string interned in a pool is shared
+ * by every packet parsed with that pool which carries the same text, so a table of parsed packets
+ * costs memory in proportion to its distinct platforms, software versions and VTP domains rather
+ * than to its neighbors, and two strings of the same pool are equal exactly when their pointers are.
+ * A string created without a pool is a private copy with a single reference.
+ *
+ * Strings are handed out as char * for compatibility with the fields of cdp_packet but must never be
+ * modified. Neither the pool nor the reference counts are locked, so a pool and the strings interned
+ * in it belong to one thread at a time.
+ */
+
+struct cdp_string_pool;
+
+/** Constructs an empty string pool.
+  *  @param bucket_count The initial number of hash buckets, rounded up to a power of 2. The pool
+  *  grows as strings are added.
+  *  @return The new pool or NULL on failure.
+  */
+struct cdp_string_pool *cdp_string_pool_new(size_t bucket_count);
+
+/** Deletes a pool. Strings which are still referenced stay valid and become private, they're
+  *  freed when their last reference is released.
+  *  @param pool The pool to delete, may be NULL.
+  */
+void cdp_string_pool_delete(struct cdp_string_pool *pool);
+
+/** Gets the number of distinct strings in a pool.
+  *  @param pool The pool.
+  *  @return The number of strings.
+  */
+size_t cdp_string_pool_count(const struct cdp_string_pool *pool);
+
+/** Gets a reference to the pooled copy of a string, adding the string to the pool if it isn't
+  *  there yet.
+  *  @param pool The pool or NULL for a private copy.
+  *  @param value The characters of the string, which need not be NUL terminated.
+  *  @param length The number of characters.
+  *  @return The NUL terminated string, which must be released with cdp_string_release(), or NULL
+  *  on failure.
+  */
+char *cdp_string_intern(struct cdp_string_pool *pool, const char *value, size_t length);
+
+/** Adds a reference to a string returned by cdp_string_intern().
+  *  @param string The string, may be NULL.
+  *  @return The string.
+  */
+char *cdp_string_hold(char *string);
+
+/** Releases a reference to a string returned by cdp_string_intern(). The last reference removes
+  *  the string from its pool and frees it.
+  *  @param string The string, may be NULL.
+  */
+void cdp_string_release(char *string);
+
+#endif
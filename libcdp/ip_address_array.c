@@ -1,80 +1,81 @@
 #include "ip_address_array.h"
 #include "platform/platform.h"
 
+/** Computes the size of the single allocation holding an array and its slots.
+  *  @param count The number of slots
+  *  @return The size in bytes
+  */
+static size_t ip_address_array_size(size_t count)
+{
+	return sizeof(struct ip_address_array) + count * sizeof(struct ip_address);
+}
+
 struct ip_address_array *ip_address_array_new(size_t count)
 {
 	struct ip_address_array *result;
-	struct sockaddr **addresses;
-	int i;
 
-	addresses = ALLOC_NEW_ARRAY(struct sockaddr *, count);
-	if (addresses == NULL)
+	if (count > (((size_t)-1) - sizeof(struct ip_address_array)) / sizeof(struct ip_address))
 	{
-		LOG_ERROR("ip_address_array_new: failed to allocate memory for address storage\n");
+		LOG_ERROR("ip_address_array_new: too many addresses\n");
 		return NULL;
 	}
 
-	result = ALLOC_NEW(struct ip_address_array);
+	result = (struct ip_address_array *)ALLOC_NEW_ARRAY(uint8_t, ip_address_array_size(count));
 	if (result == NULL)
 	{
-		LOG_ERROR("ip_address_array_new: failed to allocate memory for container.\n");
-		FREE_ARRAY(addresses);
-
+		LOG_ERROR("ip_address_array_new: failed to allocate memory for address storage\n");
 		return NULL;
 	}
 
-	for (i = 0; i < count; i++)
-		addresses[i] = NULL;
-
-	result->addresses = addresses;
+	/* AF_UNSPEC is 0 on every platform, so this leaves all the slots empty */
+	memset(result, 0, ip_address_array_size(count));
 	result->count = count;
 
 	return result;
 }
 
-void ip_address_array_delete(struct ip_address_array *array)
+struct ip_address_array *ip_address_array_clone(const struct ip_address_array *array)
 {
+	struct ip_address_array *result;
+
 	if (array == NULL)
 	{
-		LOG_CRITICAL("ip_address_array_delete: array is NULL\n");
-		return;
+		LOG_CRITICAL("ip_address_array_clone: array is NULL\n");
+		return NULL;
 	}
 
-	if (array->addresses == NULL)
+	result = (struct ip_address_array *)ALLOC_NEW_ARRAY(uint8_t, ip_address_array_size(array->count));
+	if (result == NULL)
 	{
-		LOG_CRITICAL("ip_address_array_delete: array contents is NULL\n");
-		return;
+		LOG_ERROR("ip_address_array_clone: failed to allocate memory for address storage\n");
+		return NULL;
 	}
 
-	FREE_ARRAY(array->addresses);
+	COPY_MEMORY(array, result, ip_address_array_size(array->count));
 
-	FREE(array);
+	return result;
 }
 
-int ip_address_array_clear(struct ip_address_array *array)
+void ip_address_array_delete(struct ip_address_array *array)
 {
-	off_t index;
-
 	if (array == NULL)
 	{
-		LOG_CRITICAL("ip_address_array_clear: array is NULL\n");
-		return -1;
+		LOG_CRITICAL("ip_address_array_delete: array is NULL\n");
+		return;
 	}
 
-	if (array->addresses == NULL)
+	FREE_ARRAY(array);
+}
+
+int ip_address_array_clear(struct ip_address_array *array)
+{
+	if (array == NULL)
 	{
-		LOG_CRITICAL("ip_address_array_clear: array contents is NULL\n");
+		LOG_CRITICAL("ip_address_array_clear: array is NULL\n");
 		return -1;
 	}
 
-	for (index = 0; index < array->count; index++)
-	{
-		if (array->addresses[index] != NULL)
-		{
-			FREE(array->addresses[index]);
-			array->addresses[index] = NULL;
-		}
-	}
+	memset(array->addresses, 0, array->count * sizeof(struct ip_address));
 
 	return 0;
 }
@@ -98,31 +99,40 @@ int ip_address_array_clear_and_delete(struct ip_address_array *array)
 	return 0;
 }
 
-int ip_address_array_set_into(struct ip_address_array *array, off_t index, struct sockaddr *address)
+const struct ip_address *ip_address_array_get(const struct ip_address_array *array, off_t index)
 {
 	if (array == NULL)
 	{
-		LOG_CRITICAL("ip_address_set_into: array is NULL\n");
-		return -1;
+		LOG_CRITICAL("ip_address_array_get: array is NULL\n");
+		return NULL;
 	}
 
-	if (index >= array->count)
-	{
-		LOG_CRITICAL("ip_address_set_into: input past end\n");
-		return -1;
-	}
+	if (index < 0 || index >= array->count)
+		return NULL;
+
+	if (array->addresses[index].family == AF_UNSPEC)
+		return NULL;
 
-	if (array->addresses[index] != NULL)
-		FREE(array->addresses[index]);
+	return &array->addresses[index];
+}
+
+int ip_address_array_set_into(struct ip_address_array *array, off_t index, struct sockaddr *address)
+{
+	int rc;
 
-	array->addresses[index] = address;
+	rc = ip_address_array_copy_into(array, index, address);
+	if (rc < 0)
+		return rc;
+
+	if (address != NULL)
+		FREE(address);
 
 	return 0;
 }
 
-int ip_address_array_copy_into(struct ip_address_array *array, off_t index, struct sockaddr *address)
+int ip_address_array_copy_into(struct ip_address_array *array, off_t index, const struct sockaddr *address)
 {
-	struct sockaddr *copy;
+	struct ip_address *slot;
 
 	if (array == NULL)
 	{
@@ -136,74 +146,62 @@ int ip_address_array_copy_into(struct ip_address_array *array, off_t index, stru
 		return -1;
 	}
 
+	slot = &array->addresses[index];
+
 	if (address == NULL)
 	{
-		copy = NULL;
+		memset(slot, 0, sizeof(struct ip_address));
+		return 0;
 	}
-	else
+
+	switch (address->sa_family)
 	{
-		switch (address->sa_family)
-		{
-			case AF_INET:
-				copy = ALLOC_NEW(struct sockaddr_in);
-				if (copy == NULL)
-				{
-					LOG_CRITICAL("ip_address_array_copy_into: failed to allocate memory to copy address\n");
-					return -1;
-				}
-				memcpy(copy, address, sizeof(struct sockaddr_in));
-				break;
+		case AF_INET:
+			memset(slot->octets, 0, sizeof(slot->octets));
+			memcpy(slot->octets, &((const struct sockaddr_in *)address)->sin_addr, 4);
+			break;
 
-			case AF_INET6:
-				copy = ALLOC_NEW(struct sockaddr_in6);
-				if (copy == NULL)
-				{
-					LOG_CRITICAL("ip_address_array_copy_into: failed to allocate memory to copy address\n");
-					return -1;
-				}
-				memcpy(copy, address, sizeof(struct sockaddr_in6));
-				break;
+		case AF_INET6:
+			memcpy(slot->octets, IPv6Octets((const struct sockaddr_in6 *)address), 16);
+			break;
 
-			default:
-				LOG_CRITICAL("ip_address_array_copy_into: unknown address type\n");
-				return -1;
-		}
+		default:
+			LOG_CRITICAL("ip_address_array_copy_into: unknown address type\n");
+			return -1;
 	}
 
-	if (array->addresses[index] != NULL)
-		FREE(array->addresses[index]);
-
-	array->addresses[index] = copy;
+	slot->family = (uint8_t)address->sa_family;
 
 	return 0;
 }
 
 int ip_address_array_set_into_ipv4_uint32(struct ip_address_array *array, off_t index, uint32_t address)
 {
-	struct sockaddr_in new_item;
+	struct ip_address *slot;
 
 	if (array == NULL)
 	{
-		LOG_CRITICAL("ip_address_array_copy_into_ipv4_uint32: array is NULL\n");
+		LOG_CRITICAL("ip_address_array_set_into_ipv4_uint32: array is NULL\n");
 		return -1;
 	}
 
 	if (index >= array->count)
 	{
-		LOG_CRITICAL("ip_address_array_copy_into_ipv4_uint32: input past end\n");
+		LOG_CRITICAL("ip_address_array_set_into_ipv4_uint32: input past end\n");
 		return -1;
 	}
 
-	memset(&new_item, 0, sizeof(struct sockaddr_in));
-	new_item.sin_family = AF_INET;
-	new_item.sin_addr.s_addr = address;
+	slot = &array->addresses[index];
+	memset(slot, 0, sizeof(struct ip_address));
+	slot->family = AF_INET;
+	memcpy(slot->octets, &address, 4);
 
-	return ip_address_array_copy_into(array, index, (struct sockaddr *)&new_item);
+	return 0;
 }
 
 int ip_address_array_set_into_ipv6_raw(struct ip_address_array *array, off_t index, const uint8_t *address)
 {
-	struct sockaddr_in6 new_item;
+	struct ip_address *slot;
 
 	if (array == NULL)
 	{
@@ -223,9 +221,9 @@ int ip_address_array_set_into_ipv6_raw(struct ip_address_array *array, off_t ind
 		return -1;
 	}
 
-	memset(&new_item, 0, sizeof(struct sockaddr_in6));
-	new_item.sin6_family = AF_INET6;
-	memcpy(IPv6Octets(&new_item), address, 16);
+	slot = &array->addresses[index];
+	slot->family = AF_INET6;
+	memcpy(slot->octets, address, 16);
 
-	return ip_address_array_copy_into(array, index, (struct sockaddr *)&new_item);
+	return 0;
 }
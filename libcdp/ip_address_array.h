@@ -4,11 +4,23 @@
 #include "platform/socket.h"
 #include "platform/types.h"
 
-/** Container for an array of IP addresses */
+/** An IP address stored in place within an ip_address_array */
+struct ip_address
+{
+	/** AF_INET or AF_INET6, AF_UNSPEC while the slot is empty */
+	uint8_t family;
+
+	/** The address in network order, an IPv4 address uses the first 4 octets */
+	uint8_t octets[16];
+};
+
+/** Container for an array of IP addresses. The container and its slots are a single allocation so
+  * that walking the addresses of a packet touches one block of memory.
+  */
 struct ip_address_array
 {
-	struct sockaddr **addresses;
 	size_t count;
+	struct ip_address addresses[];
 };
 
 /** Constructs a new array
@@ -17,14 +29,18 @@ struct ip_address_array
   */
 struct ip_address_array *ip_address_array_new(size_t count);
 
+/** Constructs a copy of an array
+  *  @param array The array to copy
+  *  @return The copy on success, NULL on failure
+  */
+struct ip_address_array *ip_address_array_clone(const struct ip_address_array *array);
+
 /** Delete and array of IP addresess
   *  @param array The array to delete.
-  *
-  * This does not delete the addresses themselves, call ip_address_array_clear_and_delete for that
   */
 void ip_address_array_delete(struct ip_address_array *array);
 
-/** Deletes and sets to null all the addresses in the array.
+/** Empties all the slots of the array.
   *  @param array The array to clear
   *  @return 0 on success, a negative number on failure
   */
@@ -36,10 +52,18 @@ int ip_address_array_clear(struct ip_address_array *array);
   */
 int ip_address_array_clear_and_delete(struct ip_address_array *array);
 
-/** Sets the value of an index within the array. This takes ownership of the address passed.
+/** Gets the address at an index within the array.
+  *  @param array The array to read
+  *  @param index The index of the slot
+  *  @return The address or NULL if the slot is empty or past the end
+  */
+const struct ip_address *ip_address_array_get(const struct ip_address_array *array, off_t index);
+
+/** Sets the value of an index within the array. This takes ownership of the address passed, which is
+  *  copied into the slot and freed.
   *  @param array The array to alter
   *  @param index The index of the slot to occupy
-  *  @param address The address to place at the index
+  *  @param address The address to place at the index or NULL to empty the slot
   *  @return 0 on success, a negative number on failure
   */
 int ip_address_array_set_into(struct ip_address_array *array, off_t index, struct sockaddr *address);
@@ -47,15 +71,15 @@ int ip_address_array_set_into(struct ip_address_array *array, off_t index, struc
 /** Sets the value of an index within the array.
   *  @param array The array to alter
   *  @param index The index of the slot to occupy
-  *  @param address The address to place at the index
+  *  @param address The address to place at the index or NULL to empty the slot
   *  @return 0 on success, a negative number on failure
   */
-int ip_address_array_copy_into(struct ip_address_array *array, off_t index, struct sockaddr *address);
+int ip_address_array_copy_into(struct ip_address_array *array, off_t index, const struct sockaddr *address);
 
 /** Sets the value of an index within the array.
   *  @param array The array to alter
   *  @param index The index of the slot to occupy
-  *  @param address The address to place at the index (this should be host order)
+  *  @param address The address to place at the index (this should be network order)
   *  @return 0 on success, a negative number on failure
   */
 int ip_address_array_set_into_ipv4_uint32(struct ip_address_array *array, off_t index, uint32_t address);
@@ -63,7 +87,7 @@ int ip_address_array_set_into_ipv4_uint32(struct ip_address_array *array, off_t
 /** Sets the value of an index within the array.
   *  @param array The array to alter
   *  @param index The index of the slot to occupy
-  *  @param address The address to place at the index (this should be host order)
+  *  @param address The 16 octets of the address to place at the index
   *  @return 0 on success, a negative number on failure
   */
 int ip_address_array_set_into_ipv6_raw(struct ip_address_array *array, off_t index, const uint8_t *address);
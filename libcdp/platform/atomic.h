@@ -0,0 +1,46 @@
+#ifndef PLATFORM_ATOMIC_H
+#define PLATFORM_ATOMIC_H
+
+/* Memory ordering primitives for data shared with other processes or threads.
+ *
+ *   ATOMIC_LOAD_ACQUIRE(pointer)         load, later accesses can't be reordered before it
+ *   ATOMIC_LOAD_RELAXED(pointer)         load without ordering
+ *   ATOMIC_STORE_RELEASE(pointer, value) store, earlier accesses can't be reordered after it
+ *   ATOMIC_STORE_RELAXED(pointer, value) store without ordering
+ *   THREAD_FENCE_ACQUIRE()               earlier loads can't be reordered after later accesses
+ *   THREAD_FENCE_RELEASE()               earlier accesses can't be reordered after later stores
+ */
+
+#ifdef __KERNEL__
+#include <asm/barrier.h>
+#include <linux/compiler.h>
+
+#define ATOMIC_LOAD_ACQUIRE(pointer) smp_load_acquire(pointer)
+#define ATOMIC_LOAD_RELAXED(pointer) READ_ONCE(*(pointer))
+#define ATOMIC_STORE_RELEASE(pointer, value) smp_store_release((pointer), (value))
+#define ATOMIC_STORE_RELAXED(pointer, value) WRITE_ONCE(*(pointer), (value))
+#define THREAD_FENCE_ACQUIRE() smp_rmb()
+#define THREAD_FENCE_RELEASE() smp_wmb()
+
+#elif defined(_MSC_VER)
+#include <intrin.h>
+
+/* x86 and x64 only reorder stores after loads, volatile accesses and compiler barriers suffice */
+#define ATOMIC_LOAD_ACQUIRE(pointer) (*(volatile const uint32_t *)(pointer))
+#define ATOMIC_LOAD_RELAXED(pointer) (*(volatile const uint32_t *)(pointer))
+#define ATOMIC_STORE_RELEASE(pointer, value) (*(volatile uint32_t *)(pointer) = (value))
+#define ATOMIC_STORE_RELAXED(pointer, value) (*(volatile uint32_t *)(pointer) = (value))
+#define THREAD_FENCE_ACQUIRE() _ReadWriteBarrier()
+#define THREAD_FENCE_RELEASE() _ReadWriteBarrier()
+
+#else
+
+#define ATOMIC_LOAD_ACQUIRE(pointer) __atomic_load_n((pointer), __ATOMIC_ACQUIRE)
+#define ATOMIC_LOAD_RELAXED(pointer) __atomic_load_n((pointer), __ATOMIC_RELAXED)
+#define ATOMIC_STORE_RELEASE(pointer, value) __atomic_store_n((pointer), (value), __ATOMIC_RELEASE)
+#define ATOMIC_STORE_RELAXED(pointer, value) __atomic_store_n((pointer), (value), __ATOMIC_RELAXED)
+#define THREAD_FENCE_ACQUIRE() __atomic_thread_fence(__ATOMIC_ACQUIRE)
+#define THREAD_FENCE_RELEASE() __atomic_thread_fence(__ATOMIC_RELEASE)
+#endif
+
+#endif
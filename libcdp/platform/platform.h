@@ -1,17 +1,36 @@
 #ifndef PLATFORM_H
 #define PLATFORM_H
 
+/* Log levels, numbered like the KERN_* levels of the kernel. Calls above CDP_LOG_LEVEL are compiled
+ * out along with the evaluation of their arguments, so they cost nothing on the frame path. The
+ * kernel build only keeps errors by default, user mode keeps the informational output of cdptools.
+ * LOG_CRITICAL and LOG_ERROR are rate limited per call site on Linux.
+ */
+#define CDP_LOG_LEVEL_CRITICAL 2
+#define CDP_LOG_LEVEL_ERROR 3
+#define CDP_LOG_LEVEL_INFORMATIONAL 6
+#define CDP_LOG_LEVEL_DEBUG 7
+
+#ifndef CDP_LOG_LEVEL
+#ifdef __KERNEL__
+#define CDP_LOG_LEVEL CDP_LOG_LEVEL_ERROR
+#else
+#define CDP_LOG_LEVEL CDP_LOG_LEVEL_INFORMATIONAL
+#endif
+#endif
+
+#define LOG_ENABLED(Level) (CDP_LOG_LEVEL_##Level <= CDP_LOG_LEVEL)
+
 /* The following section is related to how code should compile when running in the Linux Kernel */
 #ifdef __KERNEL__
 #include <linux/slab.h>
 #include <linux/kernel.h>
+#include <linux/printk.h>
 
-#define LOG_CRITICAL(...) printk(__VA_ARGS__)
-#define LOG_ERROR(...) printk(__VA_ARGS__)
-#define LOG_INFORMATIONAL(...) printk(__VA_ARGS__)
-#define LOG_INFORMATIONAL(...) printk(__VA_ARGS__)
-//#define LOG_DEBUG(...) printk(__VA_ARGS__)
-#define LOG_DEBUG(...)
+#define LOG_CRITICAL(...) do { if(LOG_ENABLED(CRITICAL)) printk_ratelimited(KERN_CRIT __VA_ARGS__); } while(0)
+#define LOG_ERROR(...) do { if(LOG_ENABLED(ERROR)) printk_ratelimited(KERN_ERR __VA_ARGS__); } while(0)
+#define LOG_INFORMATIONAL(...) do { if(LOG_ENABLED(INFORMATIONAL)) printk(KERN_INFO __VA_ARGS__); } while(0)
+#define LOG_DEBUG(...) do { if(LOG_ENABLED(DEBUG)) printk(KERN_DEBUG __VA_ARGS__); } while(0)
 #define _P printk
 
 #define ALLOC_NEW(AllocationType) (kmalloc(sizeof(AllocationType), GFP_ATOMIC))
@@ -32,11 +51,20 @@
 #include <memory.h>
 #include <stdio.h>
 
-#define LOG_CRITICAL(...) fprintf(stderr, __VA_ARGS__)
-#define LOG_ERROR(...) fprintf(stderr, __VA_ARGS__)
-#define LOG_INFORMATIONAL(...) fprintf(stdout, __VA_ARGS__)
-//#define LOG_DEBUG(...) fprintf(stdout, __VA_ARGS__)
-#define LOG_DEBUG(...)
+#include "../cdp_log.h"
+
+/* Each call site gets its own token bucket, see cdp_log.h */
+#define LOG_RATELIMITED(Level, Stream, ...) \
+    do { \
+        static struct cdp_log_ratelimit cdp_log_site; \
+        if(LOG_ENABLED(Level) && cdp_log_ratelimit_acquire(&cdp_log_site, __func__)) \
+            fprintf(Stream, __VA_ARGS__); \
+    } while(0)
+
+#define LOG_CRITICAL(...) LOG_RATELIMITED(CRITICAL, stderr, __VA_ARGS__)
+#define LOG_ERROR(...) LOG_RATELIMITED(ERROR, stderr, __VA_ARGS__)
+#define LOG_INFORMATIONAL(...) do { if(LOG_ENABLED(INFORMATIONAL)) fprintf(stdout, __VA_ARGS__); } while(0)
+#define LOG_DEBUG(...) do { if(LOG_ENABLED(DEBUG)) fprintf(stdout, __VA_ARGS__); } while(0)
 #define _P printf
 
 #define ALLOC_NEW(AllocationType) (malloc(sizeof(AllocationType)))
@@ -59,11 +87,10 @@
 #include <memory.h>
 #include <stdio.h>
 
-#define LOG_CRITICAL(...) fprintf(stderr, __VA_ARGS__)
-#define LOG_ERROR(...) fprintf(stderr, __VA_ARGS__)
-#define LOG_INFORMATIONAL(...) fprintf(stdout, __VA_ARGS__)
-//#define LOG_DEBUG(...) fprintf(stdout, __VA_ARGS__)
-#define LOG_DEBUG(...)
+#define LOG_CRITICAL(...) do { if(LOG_ENABLED(CRITICAL)) fprintf(stderr, __VA_ARGS__); } while(0)
+#define LOG_ERROR(...) do { if(LOG_ENABLED(ERROR)) fprintf(stderr, __VA_ARGS__); } while(0)
+#define LOG_INFORMATIONAL(...) do { if(LOG_ENABLED(INFORMATIONAL)) fprintf(stdout, __VA_ARGS__); } while(0)
+#define LOG_DEBUG(...) do { if(LOG_ENABLED(DEBUG)) fprintf(stdout, __VA_ARGS__); } while(0)
 #define _P printf
 
 #define ALLOC_NEW(AllocationType) (malloc(sizeof(AllocationType)))
@@ -77,4 +104,19 @@
 #define FORMAT_HEX_OFF_T "%X"
 #endif
 
+/* Instrumented user mode builds count every allocation by call site, see cdp_alloc_accounting.h */
+#if defined(CDP_ALLOC_ACCOUNTING) && defined(__linux__) && !defined(__KERNEL__)
+#include "../cdp_alloc_accounting.h"
+
+#undef ALLOC_NEW
+#undef ALLOC_NEW_ARRAY
+#undef FREE
+#undef FREE_ARRAY
+
+#define ALLOC_NEW(AllocationType) (cdp_alloc_accounting_allocate(sizeof(AllocationType), __FILE__, __func__))
+#define ALLOC_NEW_ARRAY(AllocationType, Count) (cdp_alloc_accounting_allocate(sizeof(AllocationType) * Count, __FILE__, __func__))
+#define FREE cdp_alloc_accounting_release
+#define FREE_ARRAY cdp_alloc_accounting_release
+#endif
+
 #endif
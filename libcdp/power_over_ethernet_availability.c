@@ -34,6 +34,7 @@ int power_over_ethernet_availability_read(struct stream_reader *reader, struct p
 	uint16_t management_id;
 	uint32_t availableMilliwatts;
 	uint32_t powerManagementLevel;
+	int rc;
 
 	if (reader == NULL)
 	{
@@ -47,35 +48,27 @@ int power_over_ethernet_availability_read(struct stream_reader *reader, struct p
 		return -1;
 	}
 
-	if (stream_reader_get16(reader, &request_id) < 0)
-	{
-		LOG_ERROR("power_over_ethernet_availability_read: failed to read request ID\n");
-		return -1;
-	}
+	rc = stream_reader_get16(reader, &request_id);
+	if (rc < 0)
+		return rc;
 
-	if (stream_reader_get16(reader, &management_id) < 0)
-	{
-		LOG_ERROR("power_over_ethernet_availability_read: failed to read management ID\n");
-		return -1;
-	}
+	rc = stream_reader_get16(reader, &management_id);
+	if (rc < 0)
+		return rc;
 
-	if (stream_reader_get32(reader, &availableMilliwatts) < 0)
-	{
-		LOG_ERROR("power_over_ethernet_availability_read: failed to the amount of power available\n");
-		return -1;
-	}
+	rc = stream_reader_get32(reader, &availableMilliwatts);
+	if (rc < 0)
+		return rc;
 
-	if (stream_reader_get32(reader, &powerManagementLevel) < 0)
-	{
-		LOG_ERROR("power_over_ethernet_availability_read: failed to the power management level\n");
-		return -1;
-	}
+	rc = stream_reader_get32(reader, &powerManagementLevel);
+	if (rc < 0)
+		return rc;
 
 	*result = power_over_ethernet_availability_new();
 	if (*result == NULL)
 	{
 		LOG_ERROR("power_over_ethernet_availability_read: failed to allocate memory to store the result\n");
-		return -1;
+		return stream_reader_fail(reader, CDP_ERROR_NO_MEMORY);
 	}
 
 	(*result)->request_id = request_id;
@@ -33,7 +33,7 @@ void power_over_ethernet_availability_delete(struct power_over_ethernet_availabi
 /** Read and deserialize and instance of the structure from a stream
   *  @reader: The reader
   *  @result: The result or NULL on error.
-  *  @return: 0 on success, a negative value on error.
+  *  @return: 0 on success, a negative enum cdp_error on error.
   */
 int power_over_ethernet_availability_read(struct stream_reader *reader, struct power_over_ethernet_availability **result);
 
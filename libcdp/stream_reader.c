@@ -29,6 +29,8 @@ struct stream_reader *stream_reader_new(const uint8_t *data, size_t length)
 
 	result->stream = stream;
 	result->position = 0;
+	result->error = CDP_ERROR_NONE;
+	result->error_position = 0;
 
 	return result;
 }
@@ -49,6 +51,42 @@ void stream_reader_delete(struct stream_reader *reader)
 	FREE(reader);
 }
 
+int stream_reader_fail(struct stream_reader *reader, enum cdp_error error)
+{
+	if (reader != NULL && reader->error == CDP_ERROR_NONE)
+	{
+		reader->error = error;
+		reader->error_position = reader->position;
+	}
+
+	return error;
+}
+
+enum cdp_error stream_reader_get_error(const struct stream_reader *reader)
+{
+	if (reader == NULL)
+		return CDP_ERROR_INVALID_ARGUMENT;
+
+	return reader->error;
+}
+
+off_t stream_reader_get_error_position(const struct stream_reader *reader)
+{
+	if (reader == NULL)
+		return 0;
+
+	return reader->error_position;
+}
+
+void stream_reader_clear_error(struct stream_reader *reader)
+{
+	if (reader == NULL)
+		return;
+
+	reader->error = CDP_ERROR_NONE;
+	reader->error_position = 0;
+}
+
 size_t stream_reader_remaining(const struct stream_reader *reader)
 {
 	if (reader == NULL)
@@ -104,21 +142,18 @@ int stream_reader_set_position(struct stream_reader *reader, off_t newPosition)
 {
 	if (reader == NULL)
 	{
-		LOG_ERROR("stream_reader_set_position: reader is NULL\n");
-		return -1;
+		LOG_CRITICAL("stream_reader_set_position: reader is NULL\n");
+		return CDP_ERROR_INVALID_ARGUMENT;
 	}
 
 	if (reader->stream == NULL)
 	{
-		LOG_ERROR("stream_reader_set_position: stream is NULL\n");
-		return -1;
+		LOG_CRITICAL("stream_reader_set_position: stream is NULL\n");
+		return CDP_ERROR_INVALID_ARGUMENT;
 	}
 
 	if (newPosition > reader->stream->length)
-	{
-		LOG_ERROR("stream_reader_set_position: newPosition is past the end of the stream.\n");
-		return -1;
-	}
+		return stream_reader_fail(reader, CDP_ERROR_TRUNCATED);
 
 	reader->position = newPosition;
 
@@ -129,8 +164,8 @@ int stream_reader_skip(struct stream_reader *reader, off_t toSkip)
 {
 	if (reader == NULL)
 	{
-		LOG_ERROR("stream_reader_skip: reader is NULL\n");
-		return -1;
+		LOG_CRITICAL("stream_reader_skip: reader is NULL\n");
+		return CDP_ERROR_INVALID_ARGUMENT;
 	}
 
 	return stream_reader_set_position(reader, stream_reader_get_position(reader) + toSkip);
@@ -141,14 +176,11 @@ int stream_reader_get8(struct stream_reader * reader, uint8_t *result)
 	if (result == NULL)
 	{
 		LOG_CRITICAL("stream_reader_get8: result is null\n");
-		return -1;
+		return CDP_ERROR_INVALID_ARGUMENT;
 	}
 
 	if (!stream_reader_need(reader, 1))
-	{
-		LOG_ERROR("stream_reader_get8: Input past end of buffer\n");
-		return -1;
-	}
+		return stream_reader_fail(reader, CDP_ERROR_TRUNCATED);
 
 	*result =
 		(((uint8_t)reader->stream->data[reader->position]) & 0xFF);
@@ -163,14 +195,11 @@ int stream_reader_get16(struct stream_reader * reader, uint16_t *result)
 	if (result == NULL)
 	{
 		LOG_CRITICAL("stream_reader_get16: result is null\n");
-		return -1;
+		return CDP_ERROR_INVALID_ARGUMENT;
 	}
 
 	if (!stream_reader_need(reader, 2))
-	{
-		LOG_ERROR("stream_reader_get16: Input past end of buffer\n");
-		return -1;
-	}
+		return stream_reader_fail(reader, CDP_ERROR_TRUNCATED);
 
 	*result =
 		(uint16_t)(
@@ -188,14 +217,11 @@ int stream_reader_get24(struct stream_reader * reader, uint32_t *result)
 	if (result == NULL)
 	{
 		LOG_CRITICAL("stream_reader_get24: result is null\n");
-		return -1;
+		return CDP_ERROR_INVALID_ARGUMENT;
 	}
 
 	if (!stream_reader_need(reader, 3))
-	{
-		LOG_ERROR("stream_reader_get24: Input past end of buffer\n");
-		return -1;
-	}
+		return stream_reader_fail(reader, CDP_ERROR_TRUNCATED);
 
 	*result =
 		(uint32_t)(
@@ -214,14 +240,11 @@ int stream_reader_get32(struct stream_reader * reader, uint32_t *result)
 	if (result == NULL)
 	{
 		LOG_CRITICAL("stream_reader_get32: result is null\n");
-		return -1;
+		return CDP_ERROR_INVALID_ARGUMENT;
 	}
 
 	if (!stream_reader_need(reader, 4))
-	{
-		LOG_ERROR("stream_reader_get32: Input past end of buffer\n");
-		return -1;
-	}
+		return stream_reader_fail(reader, CDP_ERROR_TRUNCATED);
 
 	*result =
 		(uint32_t)(
@@ -238,16 +261,18 @@ int stream_reader_get32(struct stream_reader * reader, uint32_t *result)
 
 int stream_reader_get_variable_length_integer(struct stream_reader *reader, int length, uint32_t *result)
 {
+	int rc;
+
 	if (result == NULL)
 	{
 		LOG_CRITICAL("stream_reader_get_variable_length_integer: result is null\n");
-		return -1;
+		return CDP_ERROR_INVALID_ARGUMENT;
 	}
 
 	if (length < 1 || length > 4)
 	{
 		LOG_CRITICAL("stream_reader_get_variable_length_integer: length must be between 1 and 4 bytes\n");
-		return -1;
+		return CDP_ERROR_INVALID_ARGUMENT;
 	}
 
 	switch (length)
@@ -255,11 +280,9 @@ int stream_reader_get_variable_length_integer(struct stream_reader *reader, int
 		case 1:
 			{
 				uint8_t temp8;
-				if (stream_reader_get8(reader, &temp8) < 0)
-				{
-					LOG_ERROR("stream_reader_get_variable_length_integer: could not read a byte\n");
-					return -1;
-				}
+				rc = stream_reader_get8(reader, &temp8);
+				if (rc < 0)
+					return rc;
 
 				*result = temp8;
 			}
@@ -268,11 +291,9 @@ int stream_reader_get_variable_length_integer(struct stream_reader *reader, int
 		case 2:
 			{
 				uint16_t temp16;
-				if (stream_reader_get16(reader, &temp16) < 0)
-				{
-					LOG_ERROR("stream_reader_get_variable_length_integer: could not read a short\n");
-					return -1;
-				}
+				rc = stream_reader_get16(reader, &temp16);
+				if (rc < 0)
+					return rc;
 
 				*result = temp16;
 			}
@@ -289,18 +310,16 @@ int stream_reader_get_variable_length_integer(struct stream_reader *reader, int
 int stream_reader_get_string(struct stream_reader *reader, char **result, size_t maximumLength)
 {
 	size_t stringLength = 0;
+	int rc;
 	
 	if (result == NULL)
 	{
 		LOG_CRITICAL("stream_reader_get_string: result is null\n");
-		return -1;
+		return CDP_ERROR_INVALID_ARGUMENT;
 	}
 
 	if (!stream_reader_need(reader, maximumLength))
-	{
-		LOG_ERROR("stream_reader_get_string: Input past end of buffer\n");
-		return -1;
-	}
+		return stream_reader_fail(reader, CDP_ERROR_TRUNCATED);
 
 	while (stringLength < maximumLength && reader->stream->data[reader->position + (off_t)stringLength] != 0)
 		stringLength++;
@@ -310,45 +329,69 @@ int stream_reader_get_string(struct stream_reader *reader, char **result, size_t
 	if (*result == NULL)
 	{
 		LOG_ERROR("stream_reader_get_string: Failed to allocate result buffer\n");
-		return -1;
+		return stream_reader_fail(reader, CDP_ERROR_NO_MEMORY);
 	}
 
 	COPY_MEMORY(reader->stream->data + reader->position, *result, stringLength);
 	(*result)[stringLength] = '\0';
 
-	if (stream_reader_skip(reader, (off_t)maximumLength) < 0)
+	rc = stream_reader_skip(reader, (off_t)maximumLength);
+	if (rc < 0)
 	{
-		LOG_ERROR("stream_reader_get_string: Failed to advance reader pointer\n");
 		FREE_ARRAY(*result);
 		*result = 0;
 
-		return -1;
+		return rc;
 	}
 
 	return 0;
 }
 
+int stream_reader_get_string_reference(struct stream_reader *reader, const char **result, size_t *length, size_t maximumLength)
+{
+	size_t stringLength = 0;
+	int rc;
+
+	if (result == NULL || length == NULL)
+	{
+		LOG_CRITICAL("stream_reader_get_string_reference: result is null\n");
+		return CDP_ERROR_INVALID_ARGUMENT;
+	}
+
+	if (!stream_reader_need(reader, maximumLength))
+		return stream_reader_fail(reader, CDP_ERROR_TRUNCATED);
+
+	while (stringLength < maximumLength && reader->stream->data[reader->position + (off_t)stringLength] != 0)
+		stringLength++;
+
+	*result = (const char *)(reader->stream->data + reader->position);
+	*length = stringLength;
+
+	rc = stream_reader_skip(reader, (off_t)maximumLength);
+	if (rc < 0)
+		return rc;
+
+	return 0;
+}
+
 int stream_reader_get_buffer(struct stream_reader *reader, uint8_t *result, size_t count)
 {
+	int rc;
+
 	if (result == NULL)
 	{
 		LOG_CRITICAL("stream_reader_get_buffer: result is null\n");
-		return -1;
+		return CDP_ERROR_INVALID_ARGUMENT;
 	}
 
 	if (!stream_reader_need(reader, count))
-	{
-		LOG_ERROR("stream_reader_get_buffer: Input past end of buffer\n");
-		return -1;
-	}
+		return stream_reader_fail(reader, CDP_ERROR_TRUNCATED);
 
 	COPY_MEMORY(reader->stream->data + reader->position, result, count);
 
-	if (stream_reader_skip(reader, (off_t)count) < 0)
-	{
-		LOG_ERROR("stream_reader_get_buffer: Failed to advance reader pointer\n");
-		return -1;
-	}
+	rc = stream_reader_skip(reader, (off_t)count);
+	if (rc < 0)
+		return rc;
 
 	return 0;
 }
@@ -360,68 +403,47 @@ int stream_reader_get_protocol_from_snap(struct stream_reader *reader, int *resu
 	uint8_t control;
 	uint32_t oui;
 	uint16_t pid;
+	int rc;
 
 	if (result == NULL)
 	{
 		LOG_CRITICAL("stream_reader_get_protocol_from_snap: result is null\n");
-		return -1;
+		return CDP_ERROR_INVALID_ARGUMENT;
 	}
 
 	if (!stream_reader_need(reader, 5))
-	{
-		LOG_ERROR("stream_reader_get_protocol_from_snap: Input past end of buffer\n");
-		return -1;
-	}
+		return stream_reader_fail(reader, CDP_ERROR_TRUNCATED);
 
-	if (stream_reader_get8(reader, &dsap) < 0)
-	{
-		LOG_ERROR("stream_reader_get_protocol_from_snap: Failed to read DSAP\n");
-		return -1;
-	}
+	rc = stream_reader_get8(reader, &dsap);
+	if (rc < 0)
+		return rc;
 
 	if (dsap != 0xAA)
-	{
-		LOG_ERROR("stream_reader_get_protocol_from_snap: Unknown DSAP type (%02X)\n", dsap);
-		return -1;
-	}
+		return stream_reader_fail(reader, CDP_ERROR_UNKNOWN_ADDRESS_PROTOCOL);
 
-	if (stream_reader_get8(reader, &ssap) < 0)
-	{
-		LOG_ERROR("stream_reader_get_protocol_from_snap: Failed to read SSAP\n");
-		return -1;
-	}
+	rc = stream_reader_get8(reader, &ssap);
+	if (rc < 0)
+		return rc;
 
 	if (ssap != 0xAA)
-	{
-		LOG_ERROR("stream_reader_get_protocol_from_snap: Unknown SSAP type (%02X)\n", ssap);
-		return -1;
-	}
+		return stream_reader_fail(reader, CDP_ERROR_UNKNOWN_ADDRESS_PROTOCOL);
 
-	if (stream_reader_get8(reader, &control) < 0)
-	{
-		LOG_ERROR("stream_reader_get_protocol_from_snap: Failed to read SSAP\n");
-		return -1;
-	}
+	rc = stream_reader_get8(reader, &control);
+	if (rc < 0)
+		return rc;
 
 	/* TODO: Consider validating control, it should be 0x3, but I don't know what 0x3 means. */
 
-	if (stream_reader_get24(reader, &oui) < 0)
-	{
-		LOG_ERROR("stream_reader_get_protocol_from_snap: Failed to read protocol vendor OUI from SNAP\n");
-		return -1;
-	}
+	rc = stream_reader_get24(reader, &oui);
+	if (rc < 0)
+		return rc;
 
 	if (oui != 0x000000)
-	{
-		LOG_ERROR("stream_reader_get_protocol_from_snap: Vendor OUI is not generic (00:00:00) as expected\n");
-		return -1;
-	}
+		return stream_reader_fail(reader, CDP_ERROR_UNKNOWN_ADDRESS_PROTOCOL);
 
-	if (stream_reader_get16(reader, &pid) < 0)
-	{
-		LOG_ERROR("stream_reader_get_protocol_from_snap: Failed to read PID\n");
-		return -1;
-	}
+	rc = stream_reader_get16(reader, &pid);
+	if (rc < 0)
+		return rc;
 
 	switch (pid)
 	{
@@ -434,38 +456,31 @@ int stream_reader_get_protocol_from_snap(struct stream_reader *reader, int *resu
 			return 0;
 	}
 
-	LOG_ERROR("stream_reader_get_protocol_from_snap: Unrecognized PID (0x%4X)\n", pid);
-	return -1;
+	return stream_reader_fail(reader, CDP_ERROR_UNKNOWN_ADDRESS_PROTOCOL);
 }
 
 int stream_reader_get_protocol_type(struct stream_reader *reader, int *result)
 {
 	uint8_t protocolType;
 	uint8_t protocolLength;
+	int rc;
 
 	if (result == NULL)
 	{
 		LOG_CRITICAL("stream_reader_get_protocol_type: result is null\n");
-		return -1;
+		return CDP_ERROR_INVALID_ARGUMENT;
 	}
 
 	if (!stream_reader_need(reader, 2))
-	{
-		LOG_ERROR("stream_reader_get_protocol_type: Input past end of buffer\n");
-		return -1;
-	}
+		return stream_reader_fail(reader, CDP_ERROR_TRUNCATED);
 
-	if (stream_reader_get8(reader, &protocolType) < 0)
-	{
-		LOG_ERROR("stream_reader_get_protocol_type: failed to read the protocol type of the address\n");
-		return -1;
-	}
+	rc = stream_reader_get8(reader, &protocolType);
+	if (rc < 0)
+		return rc;
 
-	if (stream_reader_get8(reader, &protocolLength) < 0)
-	{
-		LOG_ERROR("stream_reader_get_protocol_type: failed to read the protocol length of the address\n");
-		return -1;
-	}
+	rc = stream_reader_get8(reader, &protocolLength);
+	if (rc < 0)
+		return rc;
 
 	switch (protocolType)
 	{
@@ -473,11 +488,9 @@ int stream_reader_get_protocol_type(struct stream_reader *reader, int *result)
 			{
 				uint32_t protocolId;
 
-				if (stream_reader_get_variable_length_integer(reader, protocolLength, &protocolId) < 0)
-				{
-					LOG_ERROR("stream_reader_get_protocol: failed to read the protocol ID of an address\n");
-					return -1;
-				}
+				rc = stream_reader_get_variable_length_integer(reader, protocolLength, &protocolId);
+				if (rc < 0)
+					return rc;
 
 				switch (protocolId)
 				{
@@ -492,25 +505,23 @@ int stream_reader_get_protocol_type(struct stream_reader *reader, int *result)
 			return stream_reader_get_protocol_from_snap(reader, result);
 	}
 
-	LOG_ERROR("stream_reader_get_protocol: cannot identify the protocol type to read\n");
-	return -1;
+	return stream_reader_fail(reader, CDP_ERROR_UNKNOWN_ADDRESS_PROTOCOL);
 }
 
 int stream_reader_get_inet_address(struct stream_reader *reader, struct sockaddr **result)
 {
 	uint32_t address;
+	int rc;
 
 	if (result == NULL)
 	{
 		LOG_CRITICAL("stream_reader_get_inet_address: result is null\n");
-		return -1;
+		return CDP_ERROR_INVALID_ARGUMENT;
 	}
 
-	if (stream_reader_get32(reader, &address))
-	{
-		LOG_ERROR("stream_reader_get_inet_address: failed to read address\n");
-		return -1;
-	}
+	rc = stream_reader_get32(reader, &address);
+	if (rc < 0)
+		return rc;
 
 	/* If there is no address already allocated, allocate one. */
 	if (*result == NULL)
@@ -519,7 +530,7 @@ int stream_reader_get_inet_address(struct stream_reader *reader, struct sockaddr
 		if (*result == NULL)
 		{
 			LOG_ERROR("stream_reader_get_inet_address: failed to allocate enough memory for the address\n");
-			return -1;
+			return stream_reader_fail(reader, CDP_ERROR_NO_MEMORY);
 		}
 	}
 
@@ -535,18 +546,16 @@ int stream_reader_get_inet6_address(struct stream_reader *reader, struct sockadd
 {
 	int i;
 	uint8_t *addressBuffer;
+	int rc;
 
 	if (result == NULL)
 	{
 		LOG_CRITICAL("stream_reader_get_inet6_address: result is null\n");
-		return -1;
+		return CDP_ERROR_INVALID_ARGUMENT;
 	}
 
 	if (!stream_reader_need(reader, 16))
-	{
-		LOG_ERROR("stream_reader_get_inet6_address: input past end\n");
-		return -1;
-	}
+		return stream_reader_fail(reader, CDP_ERROR_TRUNCATED);
 
 	if (*result == NULL)
 	{
@@ -554,7 +563,7 @@ int stream_reader_get_inet6_address(struct stream_reader *reader, struct sockadd
 		if (*result == NULL)
 		{
 			LOG_ERROR("stream_reader_get_inet6_address: failed to allocate enough memory for the address\n");
-			return -1;
+			return stream_reader_fail(reader, CDP_ERROR_NO_MEMORY);
 		}
 	}
 
@@ -566,11 +575,9 @@ int stream_reader_get_inet6_address(struct stream_reader *reader, struct sockadd
 	addressBuffer = IPv6Octets((struct sockaddr_in6 *)(*result));
 	for (i = 0; i < 16; i++)
 	{
-		if (stream_reader_get8(reader, addressBuffer + i) < 0)
-		{
-			LOG_ERROR("stream_reader_get_int6_address: failed to read address\n");
-			return -1;
-		}
+		rc = stream_reader_get8(reader, addressBuffer + i);
+		if (rc < 0)
+			return rc;
 	}
 
 	return 0;
@@ -580,52 +587,41 @@ int stream_reader_get_address(struct stream_reader *reader, struct sockaddr **re
 {
 	int addressFamily;
 	uint16_t addressLength;
+	int rc;
 
 	if (result == NULL)
 	{
 		LOG_CRITICAL("stream_reader_get_address: result is null\n");
-		return -1;
+		return CDP_ERROR_INVALID_ARGUMENT;
 	}
 
-	if (stream_reader_get_protocol_type(reader, &addressFamily) < 0)
-	{
-		LOG_ERROR("stream_reader_get_address: unknown or unhandled address family\n");
-		return -1;
-	}
+	rc = stream_reader_get_protocol_type(reader, &addressFamily);
+	if (rc < 0)
+		return rc;
 
-	if (stream_reader_get16(reader, &addressLength) < 0)
-	{
-		LOG_ERROR("stream_reader_get_address: failed to read address length\n");
-		return -1;
-	}
+	rc = stream_reader_get16(reader, &addressLength);
+	if (rc < 0)
+		return rc;
 
 	if (!stream_reader_need(reader, addressLength))
-	{
-		LOG_ERROR("stream_reader_get_address: input is past end\n");
-		return -1;
-	}
+		return stream_reader_fail(reader, CDP_ERROR_TRUNCATED);
 
 	switch (addressFamily)
 	{
 		case AF_INET:
-			if (stream_reader_get_inet_address(reader, result) < 0)
-			{
-				LOG_ERROR("stream_reader_get_address: failed to read an IPv4 address\n");
-				return -1;
-			}
+			rc = stream_reader_get_inet_address(reader, result);
+			if (rc < 0)
+				return rc;
 			return 0;
 
 		case AF_INET6:
-			if (stream_reader_get_inet6_address(reader, result) < 0)
-			{
-				LOG_ERROR("stream_reader_get_address: failed to read an IPv6 address\n");
-				return -1;
-			}
+			rc = stream_reader_get_inet6_address(reader, result);
+			if (rc < 0)
+				return rc;
 			return 0;
 	}
 
-	LOG_ERROR("stream_reader_get_address: unknown address type\n");
-	return -1;
+	return stream_reader_fail(reader, CDP_ERROR_UNKNOWN_ADDRESS_PROTOCOL);
 }
 
 /* TODO: Move this to the file. It doesn't feel right here. */
@@ -633,34 +629,33 @@ int stream_reader_get_cisco_cluster_management_protocol(struct stream_reader *re
 {
 	struct cisco_cluster_management_protocol *clusterProtocol;
 	struct sockaddr *ip_placeholder;
+	int rc;
 
 	clusterProtocol = cisco_cluster_management_protocol_new();
 	if (clusterProtocol == NULL)
 	{
 		LOG_ERROR("stream_reader_get_cisco_cluster_management_protocol: Failed to allocate a buffer for the cisco cluster management protocol\n");
-		cisco_cluster_management_protocol_delete(clusterProtocol);
-		return -1;
+		return stream_reader_fail(reader, CDP_ERROR_NO_MEMORY);
 	}
 
-	if (stream_reader_get24(reader, &clusterProtocol->oui) < 0)
+	rc = stream_reader_get24(reader, &clusterProtocol->oui);
+	if (rc < 0)
 	{
-		LOG_ERROR("stream_reader_get_cisco_cluster_management_protocol: Failed to read the OUI for the Cisco cluster management protocol\n");
 		cisco_cluster_management_protocol_delete(clusterProtocol);
-		return -1;
+		return rc;
 	}
 
 	if (clusterProtocol->oui != 0x00000C)
 	{
-		LOG_ERROR("stream_reader_get_cisco_cluster_management_protocol: The OUI specified for the cluster management protocol is not 00:00:0C\n");
 		cisco_cluster_management_protocol_delete(clusterProtocol);
-		return -1;
+		return stream_reader_fail(reader, CDP_ERROR_BAD_VALUE);
 	}
 
-	if (stream_reader_get16(reader, &clusterProtocol->protocol_id) < 0)
+	rc = stream_reader_get16(reader, &clusterProtocol->protocol_id);
+	if (rc < 0)
 	{
-		LOG_ERROR("stream_reader_get_cisco_cluster_management_protocol: Failed to read cluster management protocol ID\n");
 		cisco_cluster_management_protocol_delete(clusterProtocol);
-		return -1;
+		return rc;
 	}
 
 	/*
@@ -669,26 +664,26 @@ int stream_reader_get_cisco_cluster_management_protocol(struct stream_reader *re
 	}
 	*/
 	ip_placeholder = (struct sockaddr *)&(clusterProtocol->cluster_master_ip);
-	if (stream_reader_get_inet_address(reader, &ip_placeholder) < 0)
+	rc = stream_reader_get_inet_address(reader, &ip_placeholder);
+	if (rc < 0)
 	{
-		LOG_ERROR("stream_reader_get_cisco_cluster_management_protocol: failed to read cluster master IP\n");
 		cisco_cluster_management_protocol_delete(clusterProtocol);
-		return -1;
+		return rc;
 	}
 
 	ip_placeholder = (struct sockaddr *)&(clusterProtocol->netmask);
-	if (stream_reader_get_inet_address(reader, &ip_placeholder) < 0)
+	rc = stream_reader_get_inet_address(reader, &ip_placeholder);
+	if (rc < 0)
 	{
-		LOG_ERROR("stream_reader_get_cisco_cluster_management_protocol: failed to read cluster netmask\n");
 		cisco_cluster_management_protocol_delete(clusterProtocol);
-		return -1;
+		return rc;
 	}
 
-	if (stream_reader_get16(reader, &clusterProtocol->version) < 0)
+	rc = stream_reader_get16(reader, &clusterProtocol->version);
+	if (rc < 0)
 	{
-		LOG_ERROR("stream_reader_get_cisco_cluster_management_protocol: failed to read cluster management protocol version\n");
 		cisco_cluster_management_protocol_delete(clusterProtocol);
-		return -1;
+		return rc;
 	}
 
 	/*
@@ -697,53 +692,53 @@ int stream_reader_get_cisco_cluster_management_protocol(struct stream_reader *re
 	}
 	*/
 
-	if (stream_reader_get8(reader, &clusterProtocol->status) < 0)
+	rc = stream_reader_get8(reader, &clusterProtocol->status);
+	if (rc < 0)
 	{
-		LOG_ERROR("stream_reader_get_cisco_cluster_management_protocol: failed to read cluster management protocol status\n");
 		cisco_cluster_management_protocol_delete(clusterProtocol);
-		return -1;
+		return rc;
 	}
 
-	if (stream_reader_skip(reader, 1) < 0)
+	rc = stream_reader_skip(reader, 1);
+	if (rc < 0)
 	{
-		LOG_ERROR("stream_reader_get_cisco_cluster_management_protocol: failed to advance position\n");
 		cisco_cluster_management_protocol_delete(clusterProtocol);
-		return -1;
+		return rc;
 	}
 
-	if (stream_reader_get_buffer(reader, clusterProtocol->cluster_commander_mac, 6) < 0)
+	rc = stream_reader_get_buffer(reader, clusterProtocol->cluster_commander_mac, 6);
+	if (rc < 0)
 	{
-		LOG_ERROR("stream_reader_get_cisco_cluster_management_protocol: failed to read the cluster commander MAC\n");
 		cisco_cluster_management_protocol_delete(clusterProtocol);
-		return -1;
+		return rc;
 	}
 
-	if (stream_reader_get_buffer(reader, clusterProtocol->local_mac, 6) < 0)
+	rc = stream_reader_get_buffer(reader, clusterProtocol->local_mac, 6);
+	if (rc < 0)
 	{
-		LOG_ERROR("stream_reader_get_cisco_cluster_management_protocol: failed to read the local switch MAC\n");
 		cisco_cluster_management_protocol_delete(clusterProtocol);
-		return -1;
+		return rc;
 	}	
 
-	if (stream_reader_skip(reader, 1) < 0)
+	rc = stream_reader_skip(reader, 1);
+	if (rc < 0)
 	{
-		LOG_ERROR("stream_reader_get_cisco_cluster_management_protocol: failed to advance position\n");
 		cisco_cluster_management_protocol_delete(clusterProtocol);
-		return -1;
+		return rc;
 	}
 
-	if (stream_reader_skip(reader, 1) < 0)
+	rc = stream_reader_skip(reader, 1);
+	if (rc < 0)
 	{
-		LOG_ERROR("stream_reader_get_cisco_cluster_management_protocol: failed to advance position\n");
 		cisco_cluster_management_protocol_delete(clusterProtocol);
-		return -1;
+		return rc;
 	}
 
-	if (stream_reader_get16(reader, &clusterProtocol->management_vlan) < 0)
+	rc = stream_reader_get16(reader, &clusterProtocol->management_vlan);
+	if (rc < 0)
 	{
-		LOG_ERROR("stream_reader_get_cisco_cluster_management_protocol: failed to read cluster management vlan\n");
 		cisco_cluster_management_protocol_delete(clusterProtocol);
-		return -1;
+		return rc;
 	}
 
 	*result = clusterProtocol;
@@ -2,17 +2,22 @@
 #define STREAM_READER_H
 
 #include "buffer_stream.h"
+#include "cdp_error.h"
 #include "cisco_cluster_management_protocol.h"
 #include "platform/socket.h"
 
 /** struct stream_reader: An abstraction of a buffer for parsing data as a stream
   * @stream: The pointer to the buffer to parse
   * @position: The current position within the buffer
+  * @error: The first error since the reader was created or the error was cleared
+  * @error_position: The position at which the first error occurred
   */
 struct stream_reader
 {
 	struct s_buffer_stream *stream;
 	off_t position;
+	enum cdp_error error;
+	off_t error_position;
 };
 
 /** Constructs a new stream reader object.
@@ -27,6 +32,30 @@ struct stream_reader *stream_reader_new(const uint8_t *data, size_t length);
   */
 void stream_reader_delete(struct stream_reader *reader);
 
+/** Records a failure at the current position unless an earlier one is already recorded.
+  *  @reader: The reader object.
+  *  @error: The reason of the failure.
+  *  @return: error, so that a function can fail with "return stream_reader_fail(reader, error);"
+  */
+int stream_reader_fail(struct stream_reader *reader, enum cdp_error error);
+
+/** Returns the first error recorded by the reader.
+  *  @reader: The reader object.
+  *  @return: The error or CDP_ERROR_NONE.
+  */
+enum cdp_error stream_reader_get_error(const struct stream_reader *reader);
+
+/** Returns the position in the buffer at which the first error was recorded.
+  *  @reader: The reader object.
+  *  @return: The byte offset of the failure, 0 if there is no error.
+  */
+off_t stream_reader_get_error_position(const struct stream_reader *reader);
+
+/** Forgets the recorded error, for reusing a reader.
+  *  @reader: The reader object.
+  */
+void stream_reader_clear_error(struct stream_reader *reader);
+
 /** Returns the number of bytes remaining before the end of the buffer
   *  @reader: The reader object.
   *  @return: The number of bytes remaining
@@ -54,42 +83,42 @@ off_t stream_reader_get_position(const struct stream_reader *reader);
 /** Sets the current position of the stream manually.
   *  @reader: The reader object.
   *  @newPosition: The new byte position in the stream.
-  *  @return 0 on success or a negative value on error.
+  *  @return 0 on success or a negative enum cdp_error.
   */
 int stream_reader_set_position(struct stream_reader *reader, off_t newPosition);
 
 /** Sets the current position relative to the current position by the given number of bytes.
 *  @reader: The reader object.
 *  @toSkip: The number of bytes to advance the stream.
-*  @return 0 on success or a negative value on error.
+*  @return 0 on success or a negative enum cdp_error.
 */
 int stream_reader_skip(struct stream_reader *reader, off_t toSkip);
 
 /** Reads an 8-bit value from the stream
   *  @reader: The reader object
   *  @result: The resulting value
-  *  @return: 0 or a negative value representing an error
+  *  @return: 0 or a negative enum cdp_error
   */
 int stream_reader_get8(struct stream_reader *reader, uint8_t *result);
 
 /** Reads a 16-bit big endian value from the stream
   *  @reader: The reader object
   *  @result: The resulting value
-  *  @return: 0 or a negative value representing an error
+  *  @return: 0 or a negative enum cdp_error
   */
 int stream_reader_get16(struct stream_reader *reader, uint16_t *result);
 
 /** Reads a 24-bit big endian value from the stream
   *  @reader: The reader object
   *  @result: The resulting value
-  *  @return: 0 or a negative value representing an error
+  *  @return: 0 or a negative enum cdp_error
   */
 int stream_reader_get24(struct stream_reader *reader, uint32_t *result);
 
 /** Reads a 32-bit big endian value from the stream
   *  @reader: The reader object
   *  @result: The resulting value
-  *  @return: 0 or a negative value representing an error
+  *  @return: 0 or a negative enum cdp_error
   */
 int stream_reader_get32(struct stream_reader *reader, uint32_t *result);
 
@@ -97,49 +126,60 @@ int stream_reader_get32(struct stream_reader *reader, uint32_t *result);
   *  @reader: The reader object
   *  @result: A resulting zero terminated string or NULL
   *  @maximumLength: The maximum length of the string in bytes.
-  *  @return: 0 on success or a negative value on error
+  *  @return: 0 on success or a negative enum cdp_error
   *
   * Even if the string is null terminated, the position will be advanced to the position
   * signified by maximumLength.
   */
 int stream_reader_get_string(struct stream_reader *reader, char **result, size_t maximumLength);
 
+/** Reads a zero terminated string like stream_reader_get_string without copying it
+  *  @reader: The reader object
+  *  @result: Set to the first character of the string within the stream's buffer, which isn't
+  *  necessarily zero terminated
+  *  @length: Set to the length of the string, up to the first zero or maximumLength
+  *  @maximumLength: The maximum length of the string in bytes.
+  *  @return: 0 on success or a negative enum cdp_error
+  */
+int stream_reader_get_string_reference(struct stream_reader *reader, const char **result, size_t *length, size_t maximumLength);
+
 /** Reads fixed size buffer from the stream
   *  @reader: The reader object
   *  @result: The buffer, it must be pre-allocated this function won't do it itself.
   *  @count: The number of bytes to read
-  *  @return: 0 on success or a negative value on error
+  *  @return: 0 on success or a negative enum cdp_error
   */
 int stream_reader_get_buffer(struct stream_reader *reader, uint8_t *result, size_t count);
 
 /** Reads an IPv4 address from the stream
   * @param reader The reader object
   * @param result The return value or NULL on error
-  * @return Either 0 on success or a negative value on error.
+  * @return Either 0 on success or a negative enum cdp_error.
   */
 int stream_reader_get_inet_address(struct stream_reader *reader, struct sockaddr **result);
 
 /** Reads an IPv6 address from the stream
   * @param reader The reader object
   * @param result The return value or NULL on error
-  * @return Either 0 on success or a negative value on error.
+  * @return Either 0 on success or a negative enum cdp_error.
   */
 int stream_reader_get_inet6_address(struct stream_reader *reader, struct sockaddr **result);
 
 /** Reads an IPv4 or IPv6 address from the stream.
   *  @reader: The reader object
   *  @result: A resulting IP address
-  *  @return: 0 on success or a negative value on error
+  *  @return: 0 on success or a negative enum cdp_error
   *
   * This function identifies the address family of the address and allocates the proper sockaddr 
-  * structure type.
+  * structure type. When *result is not NULL the address is written there instead, so it must point
+  * to storage as large as a sockaddr_in6.
   */
 int stream_reader_get_address(struct stream_reader *reader, struct sockaddr **result);
 
 /** Read the Cisco cluster management protocol TLV.
   *  @reader: The reader object
   *  @result: The resulting cluster management protocol information or NULL on error.
-  *  @return: 0 on success or a negative value on error.
+  *  @return: 0 on success or a negative enum cdp_error.
   */
 int stream_reader_get_cisco_cluster_management_protocol(struct stream_reader *reader, struct cisco_cluster_management_protocol **result);
 
@@ -29,6 +29,8 @@ struct stream_writer *stream_writer_new(uint8_t *buffer, size_t size)
 	result->buffer = buffer;
 	result->size = size;
 	result->position = buffer;
+	result->error = CDP_ERROR_NONE;
+	result->error_position = 0;
 
 	return result;
 }
@@ -46,6 +48,33 @@ int stream_writer_delete(struct stream_writer *writer)
 	return 0;
 }
 
+int stream_writer_fail(struct stream_writer *writer, enum cdp_error error)
+{
+	if (writer != NULL && writer->error == CDP_ERROR_NONE)
+	{
+		writer->error = error;
+		writer->error_position = writer->position - writer->buffer;
+	}
+
+	return error;
+}
+
+enum cdp_error stream_writer_get_error(const struct stream_writer *writer)
+{
+	if (writer == NULL)
+		return CDP_ERROR_INVALID_ARGUMENT;
+
+	return writer->error;
+}
+
+off_t stream_writer_get_error_position(const struct stream_writer *writer)
+{
+	if (writer == NULL)
+		return 0;
+
+	return writer->error_position;
+}
+
 ssize_t stream_writer_length(const struct stream_writer *writer)
 {
 	if (writer == NULL)
@@ -94,14 +123,11 @@ int stream_writer_put8(struct stream_writer *writer, uint8_t value)
 	if (writer == NULL)
 	{
 		LOG_CRITICAL("stream_writer_put8: writer is NULL\n");
-		return -1;
+		return CDP_ERROR_INVALID_ARGUMENT;
 	}
 
 	if (!stream_writer_need(writer, 1))
-	{
-		LOG_CRITICAL("stream_writer_put8: Output past end\n");
-		return -1;
-	}
+		return stream_writer_fail(writer, CDP_ERROR_BUFFER_TOO_SMALL);
 
 	*(writer->position)++ = value;
 
@@ -113,14 +139,11 @@ int stream_writer_put16(struct stream_writer *writer, uint16_t value)
 	if (writer == NULL)
 	{
 		LOG_CRITICAL("stream_writer_put16: writer is NULL\n");
-		return -1;
+		return CDP_ERROR_INVALID_ARGUMENT;
 	}
 
 	if (!stream_writer_need(writer, 2))
-	{
-		LOG_CRITICAL("stream_writer_put16: Output past end\n");
-		return -1;
-	}
+		return stream_writer_fail(writer, CDP_ERROR_BUFFER_TOO_SMALL);
 
 	*(writer->position)++ = (uint8_t)((value >> 8) & 0xFF);
 	*(writer->position)++ = (uint8_t)(value & 0xFF);
@@ -133,14 +156,11 @@ int stream_writer_put24(struct stream_writer *writer, uint32_t value)
 	if (writer == NULL)
 	{
 		LOG_CRITICAL("stream_writer_put24: writer is NULL\n");
-		return -1;
+		return CDP_ERROR_INVALID_ARGUMENT;
 	}
 
 	if (!stream_writer_need(writer, 3))
-	{
-		LOG_CRITICAL("stream_writer_put24: Output past end\n");
-		return -1;
-	}
+		return stream_writer_fail(writer, CDP_ERROR_BUFFER_TOO_SMALL);
 
 	*(writer->position)++ = (uint8_t)((value >> 16) & 0xFF);
 	*(writer->position)++ = (uint8_t)((value >> 8) & 0xFF);
@@ -154,14 +174,11 @@ int stream_writer_put32(struct stream_writer *writer, uint32_t value)
 	if (writer == NULL)
 	{
 		LOG_CRITICAL("stream_writer_put32: writer is NULL\n");
-		return -1;
+		return CDP_ERROR_INVALID_ARGUMENT;
 	}
 
 	if (!stream_writer_need(writer, 4))
-	{
-		LOG_CRITICAL("stream_writer_put32: Output past end\n");
-		return -1;
-	}
+		return stream_writer_fail(writer, CDP_ERROR_BUFFER_TOO_SMALL);
 
 	*(writer->position)++ = (uint8_t)((value >> 24) & 0xFF);
 	*(writer->position)++ = (uint8_t)((value >> 16) & 0xFF);
@@ -176,13 +193,13 @@ int stream_writer_put_buffer(struct stream_writer *writer, const uint8_t *value,
 	if (writer == NULL)
 	{
 		LOG_CRITICAL("stream_writer_put_buffer: writer is NULL\n");
-		return -1;
+		return CDP_ERROR_INVALID_ARGUMENT;
 	}
 
 	if (value == NULL)
 	{
 		LOG_CRITICAL("stream_writer_put_buffer: value is NULL\n");
-		return -1;
+		return CDP_ERROR_INVALID_ARGUMENT;
 	}
 
 	if (length == 0)
@@ -192,10 +209,7 @@ int stream_writer_put_buffer(struct stream_writer *writer, const uint8_t *value,
 	}
 
 	if (!stream_writer_need(writer, length))
-	{
-		LOG_CRITICAL("stream_writer_put_buffer: Output past end\n");
-		return -1;
-	}
+		return stream_writer_fail(writer, CDP_ERROR_BUFFER_TOO_SMALL);
 
 	memcpy(writer->position, value, length);
 
@@ -211,24 +225,37 @@ int stream_writer_put_string(struct stream_writer *writer, const char *value)
 	if (writer == NULL)
 	{
 		LOG_CRITICAL("stream_writer_put_string: writer is NULL\n");
-		return -1;
+		return CDP_ERROR_INVALID_ARGUMENT;
 	}
 
 	if (value == NULL)
 	{
 		LOG_CRITICAL("stream_writer_put_string: value is NULL\n");
-		return -1;
+		return CDP_ERROR_INVALID_ARGUMENT;
 	}
 
 	length = strlen(value);
 
 	if (!stream_writer_need(writer, length))
+		return stream_writer_fail(writer, CDP_ERROR_BUFFER_TOO_SMALL);
+
+	memcpy(writer->position, value, length);
+
+	writer->position += length;
+
+	return 0;
+}
+
+int stream_writer_skip(struct stream_writer *writer, size_t length)
+{
+	if (writer == NULL)
 	{
-		LOG_CRITICAL("stream_writer_put_string: Output past end\n");
-		return -1;
+		LOG_CRITICAL("stream_writer_skip: writer is NULL\n");
+		return CDP_ERROR_INVALID_ARGUMENT;
 	}
 
-	memcpy(writer->position, value, length);
+	if (!stream_writer_need(writer, length))
+		return stream_writer_fail(writer, CDP_ERROR_BUFFER_TOO_SMALL);
 
 	writer->position += length;
 
@@ -243,7 +270,7 @@ int stream_writer_inject_checksum(struct stream_writer *writer, off_t position)
 	if (writer == NULL)
 	{
 		LOG_CRITICAL("stream_writer_inject_checksum: writer is NULL\n");
-		return -1;
+		return CDP_ERROR_INVALID_ARGUMENT;
 	}
 
 	length = stream_writer_length(writer);
@@ -254,10 +281,7 @@ int stream_writer_inject_checksum(struct stream_writer *writer, off_t position)
 	}
 
 	if (length < (position + 2))
-	{
-		LOG_CRITICAL("stream_writer_inject_checksum: buffer overflow error\n");
-		return -1;
-	}
+		return stream_writer_fail(writer, CDP_ERROR_BUFFER_TOO_SMALL);
 
 	checksum = ip_compute_csum(writer->buffer, (size_t)length);
 
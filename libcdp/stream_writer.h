@@ -1,6 +1,7 @@
 #ifndef STREAM_WRITER_H
-#define STREAM_WRITER_C
+#define STREAM_WRITER_H
 
+#include "cdp_error.h"
 #include "platform/types.h"
 
 /** A memory buffer stream writer for serialization */
@@ -14,6 +15,12 @@ struct stream_writer
 
 	/** The current index within the buffer */
 	uint8_t *position;
+
+	/** The first error recorded by the writer */
+	enum cdp_error error;
+
+	/** The offset in the buffer at which the first error occurred */
+	off_t error_position;
 };
 
 /** Constructor
@@ -29,6 +36,25 @@ struct stream_writer *stream_writer_new(uint8_t *buffer, size_t size);
   */
 int stream_writer_delete(struct stream_writer *writer);
 
+/** Records a failure at the current position unless an earlier one is already recorded.
+  *  @param writer The writer object.
+  *  @param error The reason of the failure.
+  *  @return error, so that a function can fail with "return stream_writer_fail(writer, error);"
+  */
+int stream_writer_fail(struct stream_writer *writer, enum cdp_error error);
+
+/** Returns the first error recorded by the writer.
+  *  @param writer The writer object.
+  *  @return The error or CDP_ERROR_NONE.
+  */
+enum cdp_error stream_writer_get_error(const struct stream_writer *writer);
+
+/** Returns the offset in the buffer at which the first error was recorded.
+  *  @param writer The writer object.
+  *  @return The byte offset of the failure, 0 if there is no error.
+  */
+off_t stream_writer_get_error_position(const struct stream_writer *writer);
+
 /** Returns the consumed length of the writer buffer
   *  @param writer The writer object
   *  @return the length of the data written to the buffer or a negative value on error.
@@ -51,28 +77,28 @@ bool stream_writer_need(const struct stream_writer *writer, size_t needed);
 /** Writes a single byte to the end of the buffer.
   *  @param writer The writer object.
   *  @param value The value to write.
-  *  @return 0 on success or a negative value on error.
+  *  @return 0 on success or a negative enum cdp_error.
   */
 int stream_writer_put8(struct stream_writer *writer, uint8_t value);
 
 /** Writes a two byte unsigned integer to the end of the buffer as big-endian.
   *  @param writer The writer object.
   *  @param value The value to write.
-  *  @return 0 on success or a negative value on error.
+  *  @return 0 on success or a negative enum cdp_error.
   */
 int stream_writer_put16(struct stream_writer *writer, uint16_t value);
 
 /** Writes a three byte unsigned integer to the end of the buffer as big-endian.
   *  @param writer The writer object.
   *  @param value The value to write.
-  *  @return 0 on success or a negative value on error.
+  *  @return 0 on success or a negative enum cdp_error.
   */
 int stream_writer_put24(struct stream_writer *writer, uint32_t value);
 
 /** Writes a four byte unsigned integer to the end of the buffer as big-endian.
   *  @param writer The writer object.
   *  @param value The value to write.
-  *  @return 0 on success or a negative value on error.
+  *  @return 0 on success or a negative enum cdp_error.
   */
 int stream_writer_put32(struct stream_writer *writer, uint32_t value);
 
@@ -80,7 +106,7 @@ int stream_writer_put32(struct stream_writer *writer, uint32_t value);
   *  @param writer The writer object.
   *  @param value The value to write.
   *  @param length The number of bytes to write.
-  *  @return 0 on success or a negative value on error.
+  *  @return 0 on success or a negative enum cdp_error.
   */
 int stream_writer_put_buffer(struct stream_writer *writer, const uint8_t *value, size_t length);
 
@@ -88,14 +114,21 @@ int stream_writer_put_buffer(struct stream_writer *writer, const uint8_t *value,
   *  @param writer The writer object.
   *  @param value The value to write.
   *  @param length The number of bytes to write.
-  *  @return 0 on success or a negative value on error.
+  *  @return 0 on success or a negative enum cdp_error.
   */
 int stream_writer_put_string(struct stream_writer *writer, const char *value);
 
+/** Advances the end of the stream over bytes which are already in the buffer.
+  *  @param writer The writer object.
+  *  @param length The number of bytes to skip.
+  *  @return 0 on success or a negative enum cdp_error.
+  */
+int stream_writer_skip(struct stream_writer *writer, size_t length);
+
 /** Calculate the checksum for the buffer represented by the writer and inject it at the given position.
   *  @param writer The writer object.
   *  @param position The position to inject the checksum.
-  *  @return 0 on success or a negative value on error.
+  *  @return 0 on success or a negative enum cdp_error.
   */
 int stream_writer_inject_checksum(struct stream_writer *writer, off_t position);
 
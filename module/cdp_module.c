@@ -6,8 +6,10 @@
 #include <linux/inetdevice.h>
 
 #include "cdp_module.h"
+#include "cdp_netlink.h"
 #include "cdp_proc.h"
 #include "cdp_receive.h"
+#include "cdp_stats.h"
 #include "cdp_transmit.h"
 #include "../libcdp/cdp_software_version_string.h"
 #include "../libcdp/cdp_packet.h"
@@ -16,8 +18,7 @@ static char *name = "cdp";                       ///< An example LKM argument --
 module_param(name, charp, S_IRUGO);              ///< Param desc. charp = char ptr, S_IRUGO can be read/not changed
 MODULE_PARM_DESC(name, "The name to display in /var/log/kern.log");  ///< parameter description
 
-rwlock_t cdp_neighbors_rw_lock = __RW_LOCK_UNLOCKED(cdp_neighbors_rw_lock);
-struct cdp_neighbor_list *cdp_neighbors;
+unsigned int cdp_net_id;
 char *cdp_software_version_string = NULL;
 char *cdp_device_id_string = NULL;
 /*const*/ uint8_t cdp_multicast_address[] = { 0x01, 0x00, 0x0C, 0xCC, 0xCC, 0xCC };    
@@ -26,10 +27,7 @@ char *cdp_device_id_string = NULL;
 static unsigned char cdp_snap_id[5] = { 0x0, 0x0, 0x0c, 0x20, 0x00 };
 
 /** Handle to the datalink protocol for CDP */
-struct datalink_proto *cdp_snap_datalink_protocol;
-
-/** A timer for running cleanup tasks and sending packets (TBD) */
-static struct timer_list cdp_timer;
+struct datalink_proto __rcu *cdp_snap_datalink_protocol;
 
 /** The interval which should be waited for between running CDP processes */
 static const unsigned long cdp_timer_interval_ms = 1000;
@@ -37,33 +35,67 @@ static const unsigned long cdp_timer_interval_ms = 1000;
 /** The interval which should be waited for between transmitting CDP frames */
 static const unsigned long cdp_transmit_interval_ms = 5000;
 
-/** The time when the last CDP packet was transmitted */
-static struct timespec last_frame_transmitted = { 0, 0 }; 
+void cdp_neighbors_changed(struct cdp_net *cdp)
+{
+    WRITE_ONCE(cdp->neighbors_generation, cdp->neighbors_generation + 1);
+
+    wake_up_interruptible(&cdp->neighbors_wait);
+}
 
 static void cdp_timer_event_handler(
     TIMER_DATA_TYPE data
 )
 {
+    struct cdp_net *cdp = TIMER_OWNER(cdp, data, timer);
     unsigned long flags;
     int rc;
     struct timespec now;
+    struct cdp_neighbor_list expired = { NULL, NULL, 0 };
+    struct cdp_neighbor *neighbor;
+    struct cdp_stats_lock_timer timer;
+    unsigned int table_size;
+    u64 purge_start;
+    u64 purge_ns;
     
     getnstimeofday(&now);
 
-    write_lock_irqsave(&cdp_neighbors_rw_lock, flags);
+    cdp_stats_lock_requested(&timer);
+    write_lock_irqsave(&cdp->neighbors_rw_lock, flags);
+    cdp_stats_lock_acquired(&timer);
+
+    table_size = cdp->neighbors->count;
+    purge_start = ktime_get_ns();
+    rc = cdp_neighbor_list_take_expired_neighbors(cdp->neighbors, now, &expired);
+    purge_ns = ktime_get_ns() - purge_start;
+    if(rc > 0)
+        cdp_neighbors_changed(cdp);
 
-    cdp_neighbor_list_purge_expired_neighbors(cdp_neighbors, now);
+    write_unlock_irqrestore(&cdp->neighbors_rw_lock, flags);
+    cdp_stats_lock_released(&timer, true);
 
-    write_unlock_irqrestore(&cdp_neighbors_rw_lock, flags);
+    cdp_stats_latency(CDP_LATENCY_PURGE, purge_ns);
+    trace_cdp_purge(table_size, rc, purge_ns);
+
+    if(rc > 0)
+        cdp_stats_add(CDP_STAT_NEIGHBORS_EXPIRED, rc);
+
+    /* The expired neighbors are no longer shared so they can be reported without the lock */
+    neighbor = cdp_neighbor_list_take_first(&expired);
+    while(neighbor != NULL)
+    {
+        cdp_netlink_send_event(cdp->net, cdp_netlink_build_event(cdp->net, neighbor, CDP_CMD_NEIGHBOR_EXPIRED));
+        cdp_neighbor_delete(neighbor);
+
+        neighbor = cdp_neighbor_list_take_first(&expired);
+    }
 
-    if(((now.tv_sec - last_frame_transmitted.tv_sec) * 1000) >= cdp_transmit_interval_ms)
+    if(((now.tv_sec - cdp->last_frame_transmitted.tv_sec) * 1000) >= cdp_transmit_interval_ms)
     {
-        //printk("Send me now\n");
-        cdp_transmit_packets();
-        last_frame_transmitted = now;
+        cdp_transmit_packets(cdp->net);
+        cdp->last_frame_transmitted = now;
     }
 
-    rc = mod_timer(&cdp_timer, jiffies + msecs_to_jiffies(cdp_timer_interval_ms));
+    rc = mod_timer(&cdp->timer, jiffies + msecs_to_jiffies(cdp_timer_interval_ms));
     if(rc < 0)
     {
 		printk(KERN_CRIT "cdp: Unable to modify cleanup timer\n" );
@@ -71,66 +103,133 @@ static void cdp_timer_event_handler(
     }
 }
 
-/** Registers the CDP multicast receiver address to all Ethernet adapters on the system.
-  *  @return 0 on success, a negative value on error.
+/** Registers the CDP multicast receiver address on Ethernet interfaces as they appear in any
+  *  namespace and deregisters it as they go. Moving an interface to another namespace flushes its
+  *  multicast list and registers it again, and registering the notifier replays NETDEV_REGISTER
+  *  for the interfaces which already exist, as unregistering it replays NETDEV_UNREGISTER.
+  *  The transmit counters of an interface in /proc/net/cdp/stats live as long as it stays in its
+  *  namespace. Neighbors are keyed by interface index, so a renamed interface only invalidates the
+  *  cached renderings of /proc/net/cdp which show its old name.
+  *  @param nb the notifier block.
+  *  @param event the NETDEV_ event.
+  *  @param ptr the notifier info of the interface.
+  *  @return NOTIFY_DONE.
   */
-static int __init register_cdp_multicast(void)
+static int cdp_netdevice_event(struct notifier_block *nb, unsigned long event, void *ptr)
 {
-    struct net_device *dev;
-
-    read_lock(&dev_base_lock);
+    struct net_device *dev = netdev_notifier_info_to_dev(ptr);
+    struct cdp_net *cdp;
+    unsigned long flags;
+    int rc;
 
-    dev = first_net_device(&init_net);
-    while (dev) {
-        int rc;
+    if(dev->type != ARPHRD_ETHER)
+        return NOTIFY_DONE;
 
-        if(dev->type == ARPHRD_ETHER)
-        {
+    switch(event)
+    {
+        case NETDEV_REGISTER:
             rc = dev_mc_add_global(dev, cdp_multicast_address);
             if(rc == 0)
                 printk(KERN_INFO "cdp: registered 01:00:0C:CC:CC:CC on interface %s\n", dev->name);
             else
                 printk(KERN_INFO "cdp: failed to register 01:00:0C:CC:CC:CC on interface %s\n", dev->name);
-        }
 
-        dev = next_net_device(dev);
-    }
+            if(cdp_stats_interface_add(dev) < 0)
+                printk(KERN_ERR "cdp: failed to allocate the transmit counters of interface %s\n", dev->name);
+            break;
 
-    read_unlock(&dev_base_lock);
+        case NETDEV_UNREGISTER:
+            cdp_stats_interface_remove(dev);
 
-    return 0;
+            rc = dev_mc_del_global(dev, cdp_multicast_address);
+            if(rc == 0)
+                printk(KERN_INFO "cdp: deregistered 01:00:0C:CC:CC:CC from interface %s\n", dev->name);
+            else
+                printk(KERN_INFO "cdp: failed to deregister 01:00:0C:CC:CC:CC from interface %s\n", dev->name);
+            break;
+
+        case NETDEV_CHANGENAME:
+            cdp = cdp_net(dev_net(dev));
+            write_lock_irqsave(&cdp->neighbors_rw_lock, flags);
+            cdp_neighbors_changed(cdp);
+            write_unlock_irqrestore(&cdp->neighbors_rw_lock, flags);
+            break;
+    }
+
+    return NOTIFY_DONE;
 }
 
-/** Deregisters the CDP multicast receiver address from all Ethernet adapters on the system.
+/** The notifier registering the CDP multicast address on Ethernet interfaces */
+static struct notifier_block cdp_netdevice_notifier = {
+    .notifier_call = cdp_netdevice_event,
+};
+
+/** Creates the neighbor table, /proc/net/cdp and timer of a namespace. It's called for each
+  *  namespace which exists when the module is loaded and for each namespace created afterwards.
+  *  @param net the namespace.
   *  @return 0 on success, a negative value on error.
   */
-static int unregister_cdp_multicast(void)
+static int __net_init cdp_net_init(struct net *net)
 {
-    struct net_device *dev;
-
-    read_lock(&dev_base_lock);
+    struct cdp_net *cdp = cdp_net(net);
+    int rc;
 
-    dev = first_net_device(&init_net);
-    while (dev) {
-        int rc;
+    cdp->net = net;
+    rwlock_init(&cdp->neighbors_rw_lock);
+    init_waitqueue_head(&cdp->neighbors_wait);
+    cdp_stats_net_init(cdp);
 
-        if(dev->type == ARPHRD_ETHER)
-        {
-            rc = dev_mc_del_global(dev, cdp_multicast_address);
-            if(rc == 0)
-                printk(KERN_INFO "cdp: deregistered 01:00:0C:CC:CC:CC from interface %s\n", dev->name);
-            else
-                printk(KERN_INFO "cdp: failed to deregister 01:00:0C:CC:CC:CC from interface %s\n", dev->name);
-        }
+    /* Initialize the CDP neighbor list for storing CDP data */
+    cdp->neighbors = cdp_neighbor_list_new();
+    if(cdp->neighbors == NULL)
+        return -ENOMEM;
 
-        dev = next_net_device(dev);
+    /* Create the /proc/net/cdp file system */
+    rc = cdp_proc_net_init(cdp);
+    if(rc < 0)
+    {
+        printk(KERN_CRIT "cdp: Failed to allocate proc/net/cdp\n");
+        cdp_neighbor_list_clean_and_delete(cdp->neighbors);
+        return rc;
     }
 
-    read_unlock(&dev_base_lock);
+    /* Register a time to process cleanup events */
+    TIMER_SETUP(
+        &cdp->timer,
+        cdp_timer_event_handler,
+        TIMER_SETUP_DATA(cdp)
+    );
+
+    mod_timer(&cdp->timer, jiffies + msecs_to_jiffies(cdp_timer_interval_ms));
 
     return 0;
 }
 
+/** Releases the neighbor table, /proc/net/cdp, timer and transmit counters of a namespace. The
+  *  interfaces of the namespace are gone by now, so nothing is received into the table anymore.
+  *  @param net the namespace.
+  */
+static void __net_exit cdp_net_exit(struct net *net)
+{
+    struct cdp_net *cdp = cdp_net(net);
+
+    del_timer_sync(&cdp->timer);
+
+    cdp_proc_net_exit(cdp);
+
+    cdp_neighbor_list_clean_and_delete(cdp->neighbors);
+    cdp->neighbors = NULL;
+
+    cdp_stats_net_exit(cdp);
+}
+
+/** The per namespace operations, the core allocates a struct cdp_net for each namespace */
+static struct pernet_operations cdp_net_ops = {
+    .init = cdp_net_init,
+    .exit = cdp_net_exit,
+    .id = &cdp_net_id,
+    .size = sizeof(struct cdp_net),
+};
 
 /** @brief The LKM initialization function
  *  The static keyword restricts the visibility of the function to within this C file. The __init
@@ -139,6 +238,7 @@ static int unregister_cdp_multicast(void)
  *  @return returns 0 if successful
  */
 static int __init cdp_module_init(void){
+    struct datalink_proto *snap;
     int rc;
 
     printk(KERN_INFO "cdp: Hello %s from the Cisco Discovery Protocol module!\n", name);
@@ -161,61 +261,73 @@ static int __init cdp_module_init(void){
     }
     printk(KERN_INFO "cdp: device ID: %s\n", cdp_device_id_string);
 
-    /* Initialize the CDP neighbor list for storing CDP data */
-    cdp_neighbors = cdp_neighbor_list_new();
-    if(cdp_neighbors == NULL)
+    /* Create the neighbor table, /proc/net/cdp and timer of every namespace. The timers don't
+     * transmit until the datalink protocol is registered below.
+     */
+    rc = register_pernet_subsys(&cdp_net_ops);
+    if(rc < 0)
     {
+        printk(KERN_CRIT "cdp: Failed to register the namespace operations\n");
         kfree(cdp_software_version_string);
         kfree(cdp_device_id_string);
-        return -ENOMEM;
+        return rc;
     }
 
-    /* Create the /proc/net/cdp file system */
-    rc = cdp_proc_init();
+    /* Register the generic netlink family for neighbor events, whose dumps read the tables */
+    rc = cdp_netlink_init();
     if(rc < 0)
     {
-        printk(KERN_CRIT "cdp: Failed to allocate proc/net/cdp\n");
-        cdp_neighbor_list_clean_and_delete(cdp_neighbors);
+        printk(KERN_CRIT "cdp: Failed to register the generic netlink family\n");
+        unregister_pernet_subsys(&cdp_net_ops);
         kfree(cdp_software_version_string);
         kfree(cdp_device_id_string);
         return rc;
     }
 
-    /* Register a time to process cleanup events */
-    TIMER_SETUP(
-        &cdp_timer,
-        cdp_timer_event_handler,
-        0
-    );
-    
-    rc = mod_timer(&cdp_timer, jiffies + msecs_to_jiffies(cdp_timer_interval_ms));
+    /* Create /proc/net/cdp/stats and /proc/net/cdp/latency, which cover the whole module */
+    rc = cdp_proc_init();
     if(rc < 0)
     {
-		printk(KERN_CRIT "cdp: Unable to register cleanup timer\n" );
-        cdp_proc_exit();
-        cdp_neighbor_list_clean_and_delete(cdp_neighbors);
+        printk(KERN_CRIT "cdp: Failed to allocate proc/net/cdp/stats\n");
+        cdp_netlink_exit();
+        unregister_pernet_subsys(&cdp_net_ops);
         kfree(cdp_software_version_string);
         kfree(cdp_device_id_string);
-        return -ENOMEM;
+        return rc;
     }
 
     /* Register the packet receive handler for incoming CDP packets */
-    cdp_snap_datalink_protocol = register_snap_client(cdp_snap_id, cdp_receive);
-    if (!cdp_snap_datalink_protocol)
+    snap = register_snap_client(cdp_snap_id, cdp_receive);
+    if (!snap)
     {
 		printk(KERN_CRIT "cdp: Unable to register with psnap\n");
-        del_timer(&cdp_timer);
         cdp_proc_exit();
-        cdp_neighbor_list_clean_and_delete(cdp_neighbors);
+        cdp_netlink_exit();
+        unregister_pernet_subsys(&cdp_net_ops);
         kfree(cdp_software_version_string);
         kfree(cdp_device_id_string);
         return -ENOMEM;
 	}
 
+    rcu_assign_pointer(cdp_snap_datalink_protocol, snap);
+
     /* Register the CDP MAC address on the interfaces so the Ethernet MAC will permit the frames */
-    register_cdp_multicast();
+    rc = register_netdevice_notifier(&cdp_netdevice_notifier);
+    if(rc < 0)
+    {
+		printk(KERN_CRIT "cdp: Unable to register the network device notifier\n");
+        RCU_INIT_POINTER(cdp_snap_datalink_protocol, NULL);
+        unregister_snap_client(snap);
+        cdp_proc_exit();
+        cdp_netlink_exit();
+        unregister_pernet_subsys(&cdp_net_ops);
+        cdp_stats_exit();
+        kfree(cdp_software_version_string);
+        kfree(cdp_device_id_string);
+        return rc;
+    }
 
-    return rc;
+    return 0;
 }
 
 /** @brief The LKM cleanup function
@@ -223,19 +335,26 @@ static int __init cdp_module_init(void){
  *  code is used for a built-in driver (not a LKM) that this function is not required.
  */
 static void __exit cdp_module_exit(void)
-{    
-	del_timer(&cdp_timer);
+{
+    struct datalink_proto *snap = rcu_dereference_protected(cdp_snap_datalink_protocol, 1);
 
-    unregister_cdp_multicast();
+    unregister_netdevice_notifier(&cdp_netdevice_notifier);
 
     printk(KERN_INFO "cdp: Goodbye %s from the Cisco Discovery Protocol module!\n", name);
 
-    unregister_snap_client(cdp_snap_datalink_protocol);
-	cdp_snap_datalink_protocol = NULL;
+    /* unregister_snap_client() waits for the receive handlers and the transmitting timers which
+     * still hold the protocol before freeing it
+     */
+    RCU_INIT_POINTER(cdp_snap_datalink_protocol, NULL);
+    unregister_snap_client(snap);
 
     cdp_proc_exit();
 
-    cdp_neighbor_list_clean_and_delete(cdp_neighbors);
+    unregister_pernet_subsys(&cdp_net_ops);
+
+    cdp_netlink_exit();
+
+    cdp_stats_exit();
 
     kfree(cdp_device_id_string);
 
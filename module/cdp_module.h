@@ -2,8 +2,13 @@
 #define CDP_MODULE_H
 
 #include "../libcdp/cdp_neighbor.h"
+#include <linux/hashtable.h>
 #include <linux/netdevice.h>
+#include <linux/timer.h>
+#include <linux/wait.h>
 #include <net/datalink.h>
+#include <net/net_namespace.h>
+#include <net/netns/generic.h>
 
 #ifdef timer_setup
     #define TIMER_SETUP         timer_setup
@@ -11,19 +16,83 @@
     #ifndef TIMER_DATA_TYPE
         #define TIMER_DATA_TYPE		struct timer_list *
     #endif
+
+    /** The last argument of TIMER_SETUP for a timer embedded in owner */
+    #define TIMER_SETUP_DATA(owner)         0
+
+    /** Gets the structure a timer is embedded in from the argument of its handler */
+    #define TIMER_OWNER(owner, data, field) from_timer(owner, data, field)
 #else
     #define TIMER_SETUP         setup_timer
 
     #ifndef TIMER_DATA_TYPE
         #define TIMER_DATA_TYPE		unsigned long
     #endif
+
+    #define TIMER_SETUP_DATA(owner)         ((unsigned long)(owner))
+    #define TIMER_OWNER(owner, data, field) ((typeof(owner))(data))
 #endif     
 
-/** A read/write spin-lock for controlling access to cdp_neighbors */
-extern rwlock_t cdp_neighbors_rw_lock;
+struct cdp_proc_net;
+
+/** The number of bits of the hash of the interface counters of a namespace */
+#define CDP_NET_INTERFACE_HASH_BITS 4
+
+/** The CDP state of a network namespace. Each namespace has its own neighbor table, lock and
+  *  timer so that the interfaces of one container never contend with or see those of another.
+  */
+struct cdp_net
+{
+    /** The namespace the state belongs to */
+    struct net *net;
+
+    /** A read/write spin-lock for controlling access to neighbors */
+    rwlock_t neighbors_rw_lock;
+
+    /** A list of the known CDP neighbor entries */
+    struct cdp_neighbor_list *neighbors;
+
+    /** A counter which is incremented each time a neighbor is added, changed or expired.
+      *  It is protected by neighbors_rw_lock and used to detect whether cached views of the
+      *  table are current.
+      */
+    unsigned long neighbors_generation;
+
+    /** A wait queue which is woken each time neighbors_generation changes */
+    wait_queue_head_t neighbors_wait;
+
+    /** A timer for expiring neighbors and sending packets on the interfaces of the namespace */
+    struct timer_list timer;
+
+    /** The time when the last CDP packet was transmitted */
+    struct timespec last_frame_transmitted;
+
+    /** The /proc/net/cdp files of the namespace */
+    struct cdp_proc_net *proc;
+
+    /** The transmit counters of the Ethernet interfaces of the namespace by interface index. The
+      *  netdevice notifier adds and removes them under RTNL, they are looked up under RCU.
+      */
+    DECLARE_HASHTABLE(interfaces, CDP_NET_INTERFACE_HASH_BITS);
+};
+
+/** The index of struct cdp_net in the generic data of each namespace */
+extern unsigned int cdp_net_id;
+
+/** Gets the CDP state of a network namespace.
+  *  @param net the namespace.
+  *  @return the state, which exists for as long as the namespace does.
+  */
+static inline struct cdp_net *cdp_net(const struct net *net)
+{
+    return net_generic(net, cdp_net_id);
+}
 
-/** A list of the known CDP neighbor entries */
-extern struct cdp_neighbor_list *cdp_neighbors;
+/** Records that the content of a neighbor table has changed and wakes any waiters.
+  *  This must be called while holding the neighbors_rw_lock of the namespace for writing.
+  *  @param cdp the namespace whose table changed.
+  */
+void cdp_neighbors_changed(struct cdp_net *cdp);
 
 /** This is the software version string sent to all CDP neighbors to describe this device */
 extern char *cdp_software_version_string;
@@ -36,7 +105,9 @@ extern /*const*/ uint8_t cdp_multicast_address[];
 
 struct datalink_proto;
 
-/** Handle to the datalink protocol for CDP */
-extern struct datalink_proto *cdp_snap_datalink_protocol;
+/** Handle to the datalink protocol for CDP, NULL while the module is being loaded or unloaded.
+  *  It is read under rcu_read_lock() since the timers of the namespaces may still be sending.
+  */
+extern struct datalink_proto __rcu *cdp_snap_datalink_protocol;
 
 #endif
@@ -0,0 +1,203 @@
+#include <net/genetlink.h>
+#include <net/net_namespace.h>
+
+#include "cdp_module.h"
+#include "cdp_netlink.h"
+#include "cdp_stats.h"
+
+#include "../libcdp/cdp_neighbor_record.h"
+
+/** Attribute validation policy for requests */
+static const struct nla_policy cdp_genl_policy[CDP_ATTR_MAX + 1] = {
+    [CDP_ATTR_NEIGHBOR_RECORD] = { .type = NLA_BINARY },
+};
+
+static int cdp_netlink_dump_neighbors(struct sk_buff *skb, struct netlink_callback *cb);
+
+/** The operations supported by the family */
+static const struct genl_ops cdp_genl_ops[] = {
+    {
+        .cmd = CDP_CMD_GET_NEIGHBORS,
+        .policy = cdp_genl_policy,
+        .dumpit = cdp_netlink_dump_neighbors,
+    },
+};
+
+/** The multicast groups of the family */
+static const struct genl_multicast_group cdp_genl_groups[] = {
+    { .name = CDP_GENL_EVENTS_GROUP_NAME },
+};
+
+/** The CDP generic netlink family */
+static struct genl_family cdp_genl_family __ro_after_init = {
+    .name = CDP_GENL_FAMILY_NAME,
+    .version = CDP_GENL_FAMILY_VERSION,
+    .maxattr = CDP_ATTR_MAX,
+    .netnsok = true,
+    .module = THIS_MODULE,
+    .ops = cdp_genl_ops,
+    .n_ops = ARRAY_SIZE(cdp_genl_ops),
+    .mcgrps = cdp_genl_groups,
+    .n_mcgrps = ARRAY_SIZE(cdp_genl_groups),
+};
+
+/** Appends a message containing a neighbor record to a netlink buffer.
+  *  @param skb The buffer to write the message to.
+  *  @param neighbor The neighbor to write.
+  *  @param portid The netlink port id of the recipient.
+  *  @param seq The sequence number of the message.
+  *  @param flags The netlink message flags.
+  *  @param command The generic netlink command for the message.
+  *  @return 0 on success, -EMSGSIZE if the buffer is full or another negative value on error.
+  */
+static int cdp_netlink_put_neighbor(struct sk_buff *skb, const struct cdp_neighbor *neighbor, u32 portid, u32 seq, int flags, u8 command)
+{
+    struct nlattr *attribute;
+    ssize_t record_length;
+    void *header;
+
+    record_length = cdp_neighbor_record_length(neighbor);
+    if(record_length < 0)
+        return -EINVAL;
+
+    header = genlmsg_put(skb, portid, seq, &cdp_genl_family, flags, command);
+    if(header == NULL)
+        return -EMSGSIZE;
+
+    attribute = nla_reserve(skb, CDP_ATTR_NEIGHBOR_RECORD, (int)record_length);
+    if(attribute == NULL)
+    {
+        genlmsg_cancel(skb, header);
+        return -EMSGSIZE;
+    }
+
+    if(cdp_neighbor_record_serialize(neighbor, nla_data(attribute), (size_t)record_length) != record_length)
+    {
+        genlmsg_cancel(skb, header);
+        return -EINVAL;
+    }
+
+    genlmsg_end(skb, header);
+
+    return 0;
+}
+
+/** Dump handler for CDP_CMD_GET_NEIGHBORS, which returns the table of the requester's namespace.
+  *  Between calls cb->args[0] holds the index of the next neighbor to send, cb->args[1] the
+  *  neighbor itself and cb->args[2] the generation of the table it was taken from. Neighbors are
+  *  only unlinked along with a generation change, so while the generation holds the dump resumes
+  *  from the saved neighbor. Otherwise it resumes by index and the messages are flagged with
+  *  NLM_F_DUMP_INTR, as the generation is also the sequence checked by nl_dump_check_consistent().
+  *  @param skb The buffer to fill with messages.
+  *  @param cb The netlink dump state.
+  *  @return The length of the buffer, 0 when the dump is complete or a negative value on error.
+  */
+static int cdp_netlink_dump_neighbors(struct sk_buff *skb, struct netlink_callback *cb)
+{
+    struct cdp_net *cdp = cdp_net(sock_net(skb->sk));
+    struct cdp_neighbor *neighbor;
+    struct nlmsghdr *header;
+    struct cdp_stats_lock_timer timer;
+    unsigned long flags;
+    int index = (int)cb->args[0];
+    int rc = 0;
+
+    cdp_stats_lock_requested(&timer);
+    read_lock_irqsave(&cdp->neighbors_rw_lock, flags);
+    cdp_stats_lock_acquired(&timer);
+
+    /* A sequence of 0 disables the consistency check */
+    cb->seq = (unsigned int)cdp->neighbors_generation + 1;
+
+    if(cb->args[1] != 0 && cb->args[2] == cdp->neighbors_generation)
+        neighbor = (struct cdp_neighbor *)cb->args[1];
+    else
+        neighbor = cdp_neighbor_list_get_by_index(cdp->neighbors, index);
+
+    while(neighbor != NULL)
+    {
+        /* Entries without a frame have nothing to report yet */
+        if(neighbor->frame_buffer_length > 0)
+        {
+            header = (struct nlmsghdr *)skb_tail_pointer(skb);
+
+            rc = cdp_netlink_put_neighbor(
+                skb,
+                neighbor,
+                NETLINK_CB(cb->skb).portid,
+                cb->nlh->nlmsg_seq,
+                NLM_F_MULTI,
+                CDP_CMD_GET_NEIGHBORS);
+
+            if(rc < 0)
+                break;
+
+            nl_dump_check_consistent(cb, header);
+        }
+
+        index++;
+        neighbor = neighbor->next;
+    }
+
+    cb->args[1] = (long)neighbor;
+    cb->args[2] = cdp->neighbors_generation;
+
+    read_unlock_irqrestore(&cdp->neighbors_rw_lock, flags);
+    cdp_stats_lock_released(&timer, false);
+
+    cb->args[0] = index;
+
+    /* A full buffer simply means the dump continues on the next call */
+    if(rc == -EMSGSIZE)
+        rc = 0;
+
+    return (rc < 0) ? rc : skb->len;
+}
+
+struct sk_buff *cdp_netlink_build_event(struct net *net, const struct cdp_neighbor *neighbor, u8 command)
+{
+    struct sk_buff *skb;
+    ssize_t record_length;
+
+    if(!genl_has_listeners(&cdp_genl_family, net, 0))
+        return NULL;
+
+    record_length = cdp_neighbor_record_length(neighbor);
+    if(record_length < 0)
+        return NULL;
+
+    skb = genlmsg_new(nla_total_size((int)record_length), GFP_ATOMIC);
+    if(skb == NULL)
+    {
+        printk_ratelimited(KERN_ERR "cdp: failed to allocate netlink event\n");
+        return NULL;
+    }
+
+    if(cdp_netlink_put_neighbor(skb, neighbor, 0, 0, 0, command) < 0)
+    {
+        printk_ratelimited(KERN_ERR "cdp: failed to build netlink event\n");
+        nlmsg_free(skb);
+        return NULL;
+    }
+
+    return skb;
+}
+
+void cdp_netlink_send_event(struct net *net, struct sk_buff *skb)
+{
+    if(skb == NULL)
+        return;
+
+    /* -ESRCH only means every listener went away since the event was built */
+    genlmsg_multicast_netns(&cdp_genl_family, net, skb, 0, 0, GFP_ATOMIC);
+}
+
+int __init cdp_netlink_init(void)
+{
+    return genl_register_family(&cdp_genl_family);
+}
+
+void cdp_netlink_exit(void)
+{
+    genl_unregister_family(&cdp_genl_family);
+}
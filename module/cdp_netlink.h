@@ -0,0 +1,33 @@
+#ifndef CDP_NETLINK_H
+#define CDP_NETLINK_H
+
+#include <linux/skbuff.h>
+
+#include "../libcdp/cdp_neighbor.h"
+#include "../libcdp/cdp_netlink_protocol.h"
+
+/** Registers the CDP generic netlink family.
+  *  @return 0 on success or a negative value on error.
+  */
+int __init cdp_netlink_init(void);
+
+/** Unregisters the CDP generic netlink family. */
+void cdp_netlink_exit(void);
+
+/** Builds an event message describing a neighbor. This is intended to be called while the
+  *  neighbor is protected by the neighbors_rw_lock of its namespace so that the message can be
+  *  sent after the lock is released.
+  *  @param net The namespace of the neighbor, whose listeners receive the event.
+  *  @param neighbor The neighbor to describe.
+  *  @param command The event command (CDP_CMD_NEIGHBOR_ADDED, _CHANGED or _EXPIRED).
+  *  @return The message or NULL if there are no listeners or on error.
+  */
+struct sk_buff *cdp_netlink_build_event(struct net *net, const struct cdp_neighbor *neighbor, u8 command);
+
+/** Multicasts an event message built by cdp_netlink_build_event to the events group of a namespace.
+  *  @param net The namespace the event was built for.
+  *  @param skb The message to send, may be NULL in which case nothing is done.
+  */
+void cdp_netlink_send_event(struct net *net, struct sk_buff *skb);
+
+#endif
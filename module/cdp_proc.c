@@ -1,152 +1,636 @@
+#include <linux/fs.h>
+#include <linux/kref.h>
+#include <linux/mm.h>
+#include <linux/mutex.h>
+#include <linux/netdevice.h>
+#include <linux/poll.h>
 #include <linux/proc_fs.h>
 #include <linux/seq_file.h>
+#include <linux/time.h>
+#include <linux/uaccess.h>
 #include <net/net_namespace.h>
 
 #include "cdp_module.h"
 #include "cdp_proc.h"
+#include "cdp_stats.h"
 
-/** The top level proc directory entry for CDP (/proc/net/cdp) */
-static struct proc_dir_entry *cdp_proc_dir;
+/** The size of the buffer used to render a view when there is no previous snapshot to size it from */
+#define CDP_PROC_INITIAL_RENDER_SIZE PAGE_SIZE
 
-/** The proc directory entry (/proc/net/cdp/summary) */
-static struct proc_dir_entry *cdp_summary_proc_entry;
+/** The size of the buffer the neighbor table is first copied into when there is no previous copy */
+#define CDP_PROC_INITIAL_COPY_SIZE PAGE_SIZE
 
-/** The proc directory entry (/proc/net/cdp/detail) */
-static struct proc_dir_entry *cdp_detail_proc_entry;
+/** A fully rendered view of the neighbor table.
+  *  Snapshots are immutable once rendered and are shared between the cache and every file
+  *  handle which opened the view while the snapshot was current.
+  */
+struct cdp_proc_snapshot
+{
+    /** Reference count, the cache and each open file hold a reference */
+    struct kref ref;
 
-/** The proc directory entry (/proc/net/cdp/json) */
-static struct proc_dir_entry *cdp_json_proc_entry;
+    /** The value of neighbors_generation the snapshot was rendered from */
+    unsigned long generation;
 
-/** proc_fs sequential file system handler for iterating the CDP entries start function.
-  *  This function is called by the system with the starting index for this pass. If
-  *  the index is invalid (past the end) then it simply returns zero.
-  *
-  *  @param seq the handle to the sequential file structure.
-  *  @param pos a pointer to the position/index in the array.
-  *  @return a pointer to a CDP neighbor entry or NULL.
-  */
-static void *cdp_seq_start(struct seq_file *seq, loff_t *pos)
+    /** The time the snapshot was rendered */
+    struct timespec rendered_at;
+
+    /** The length of the rendered data in bytes */
+    size_t length;
+
+    /** The rendered data */
+    char *data;
+};
+
+/** A file in /proc/net/cdp */
+struct cdp_proc_view
 {
-    unsigned long *cdp_neighbors_rw_lock_flags = (unsigned long *)kmalloc(sizeof(unsigned long), GFP_ATOMIC);
-    seq->private = cdp_neighbors_rw_lock_flags;
+    /** The name of the file */
+    const char *name;
 
-    read_lock_irqsave(&cdp_neighbors_rw_lock, *cdp_neighbors_rw_lock_flags);
+    /** The function which renders a single neighbor for this view */
+    int (*show)(struct seq_file *seq, void *v);
 
-    if(cdp_neighbors == NULL)
-        return NULL;
+    /** The function which loads data written to the file or NULL if the view is read only */
+    ssize_t (*load)(struct cdp_net *cdp, const uint8_t *data, size_t length);
+};
+
+/** The views provided under /proc/net/cdp */
+static const struct cdp_proc_view cdp_proc_views[] = {
+    { .name = "summary", .show = cdp_seq_summary_show },
+    { .name = "detail", .show = cdp_seq_detail_show },
+    { .name = "json", .show = cdp_seq_json_show },
+    { .name = "raw", .show = cdp_seq_raw_show, .load = cdp_seq_raw_load },
+};
+
+/** A view of the neighbor table of a namespace and the cached rendering of its content */
+struct cdp_proc_instance
+{
+    /** The view */
+    const struct cdp_proc_view *view;
+
+    /** The namespace whose table is presented */
+    struct cdp_net *cdp;
+
+    /** The most recently rendered snapshot or NULL, protected by cache_lock of the namespace */
+    struct cdp_proc_snapshot *cache;
+};
+
+/** The /proc/net/cdp directory of a namespace */
+struct cdp_proc_net
+{
+    /** The directory entry (/proc/net/cdp) */
+    struct proc_dir_entry *dir;
+
+    /** Serializes rendering and replacing the cached snapshots */
+    struct mutex cache_lock;
+
+    /** The size of the buffer the table was last copied into, protected by cache_lock */
+    size_t copy_size;
+
+    /** The views of the namespace's table, one per entry of cdp_proc_views */
+    struct cdp_proc_instance instances[ARRAY_SIZE(cdp_proc_views)];
+};
+
+/** The state of an open /proc/net/cdp file */
+struct cdp_proc_file
+{
+    /** The view the file presents */
+    struct cdp_proc_instance *instance;
+
+    /** The snapshot currently being read through the file */
+    struct cdp_proc_snapshot *snapshot;
+
+    /** Data written to the file which the view hasn't consumed yet, allocated on the first write */
+    uint8_t *pending;
+
+    /** The length of the data in pending */
+    size_t pending_length;
+
+    /** Protects snapshot and pending against concurrent use */
+    struct mutex lock;
+};
 
-    return cdp_neighbor_list_get_by_index(cdp_neighbors, (int)*pos);
+/** kref release function for snapshots
+  *  @param ref the reference counter embedded in the snapshot.
+  */
+static void cdp_proc_snapshot_release(struct kref *ref)
+{
+    struct cdp_proc_snapshot *snapshot = container_of(ref, struct cdp_proc_snapshot, ref);
+
+    kvfree(snapshot->data);
+    kfree(snapshot);
 }
 
-/** proc_fs sequential file system handler for iterating the CDP entries next function
-  *  This function is called to iterate to the next item in the CDP entry list.
-  *  When there is nothing left to iterate to, the function returns NULL to say so.
-  *  Since NULL can also signify that the process is willing to give up time by
-  *  returning NULL, cdp_seq_start will be called again following the end of the list.
-  *
-  *  @param seq the handle to the sequential file structure.
-  *  @param v the value to iterate forward from. This is the last "show"n value.
-  *  @param pos the iterator index to be updated.
-  *  @return the next CDP neighbor entry if it's available or NULL if the end is reached.
+/** Releases a reference to a snapshot
+  *  @param snapshot the snapshot to release, may be NULL.
   */
-static void *cdp_seq_next(struct seq_file *seq, void *v, loff_t *pos)
+static void cdp_proc_snapshot_put(struct cdp_proc_snapshot *snapshot)
 {
-    struct cdp_neighbor *neighbor = (struct cdp_neighbor *)v;
-    ++*pos;
+    if(snapshot != NULL)
+        kref_put(&snapshot->ref, cdp_proc_snapshot_release);
+}
 
-    if(neighbor == NULL)
-        return NULL;
+/** Checks whether a cached snapshot can still be served.
+  *  A snapshot is current when the table hasn't changed since it was rendered. Hold time
+  *  countdowns and receive times change without a generation change, so a snapshot is also
+  *  limited to CDP_PROC_CACHE_MAX_AGE_SECONDS of age.
+  *  @param cdp the namespace whose table the snapshot was rendered from.
+  *  @param snapshot the snapshot to test.
+  *  @return true if the snapshot can be served.
+  */
+static bool cdp_proc_snapshot_is_current(const struct cdp_net *cdp, const struct cdp_proc_snapshot *snapshot)
+{
+    struct timespec now;
+
+    if(snapshot == NULL)
+        return false;
+
+    if(snapshot->generation != READ_ONCE(cdp->neighbors_generation))
+        return false;
 
-    return neighbor->next;
+    getnstimeofday(&now);
+
+    return (now.tv_sec - snapshot->rendered_at.tv_sec) < CDP_PROC_CACHE_MAX_AGE_SECONDS;
 }
 
-/** proc_fs sequential file system handler for iterating the CDP entries stop function
-  *  This function is called at the end of a sequence of iterating over the entries
-  *  in the list. It is responsible for releasing any associated thread synchronization
-  *  locks.
-  * 
-  *  @param seq the handle to the sequential file structure.
-  *  @param v the value of the last item iterated to.
+const char *cdp_proc_interface_name(struct seq_file *seq, const struct cdp_neighbor *neighbor, char *name)
+{
+    struct cdp_net *cdp = seq->private;
+    struct net_device *dev;
+
+    rcu_read_lock();
+    dev = dev_get_by_index_rcu(cdp->net, neighbor->device_index);
+    if(dev != NULL)
+        memcpy(name, dev->name, IFNAMSIZ);
+    else
+        snprintf(name, IFNAMSIZ, "if%d", neighbor->device_index);
+    rcu_read_unlock();
+
+    return name;
+}
+
+/** Copies the neighbor table so that it can be rendered without holding neighbors_rw_lock.
+  *  The neighbors and their frames are copied into a single buffer and linked in their table order.
+  *  The buffer is sized from the previous copy and, if the table has outgrown it, is reallocated
+  *  after the lock is released and the copy is retried.
+  *  @param cdp the namespace whose table is copied.
+  *  @param snapshot the snapshot which receives the generation and time of the copy.
+  *  @param count receives the number of neighbors copied.
+  *  @return the copied neighbors, freed with kvfree(), or NULL on error.
   */
-static void cdp_seq_stop(struct seq_file *seq, void *v)
+static struct cdp_neighbor *cdp_proc_copy_table(struct cdp_net *cdp, struct cdp_proc_snapshot *snapshot, size_t *count)
 {
-    unsigned long *cdp_neighbors_rw_lock_flags = (unsigned long *)seq->private;
+    struct cdp_proc_net *proc = cdp->proc;
+    struct cdp_neighbor *copies;
+    struct cdp_neighbor *neighbor;
+    struct cdp_stats_lock_timer timer;
+    unsigned char *frames;
+    size_t size = max_t(size_t, proc->copy_size, CDP_PROC_INITIAL_COPY_SIZE);
+    size_t needed;
+    size_t i;
+    unsigned long flags;
+
+    for(;;)
+    {
+        copies = kvmalloc(size, GFP_KERNEL);
+        if(copies == NULL)
+            return NULL;
 
-    read_unlock_irqrestore(&cdp_neighbors_rw_lock, *cdp_neighbors_rw_lock_flags);
+        cdp_stats_lock_requested(&timer);
+        read_lock_irqsave(&cdp->neighbors_rw_lock, flags);
+        cdp_stats_lock_acquired(&timer);
 
-    kfree(cdp_neighbors_rw_lock_flags);
+        snapshot->generation = cdp->neighbors_generation;
+        getnstimeofday(&snapshot->rendered_at);
+
+        *count = 0;
+        needed = 0;
+        for(neighbor = cdp->neighbors->head; neighbor != NULL; neighbor = neighbor->next)
+        {
+            needed += sizeof(struct cdp_neighbor) + neighbor->frame_buffer_length;
+            (*count)++;
+        }
+
+        if(needed <= size)
+        {
+            frames = (unsigned char *)(copies + *count);
+
+            for(neighbor = cdp->neighbors->head, i = 0; neighbor != NULL; neighbor = neighbor->next, i++)
+            {
+                copies[i] = *neighbor;
+                copies[i].prev = (i > 0) ? &copies[i - 1] : NULL;
+                copies[i].next = (i + 1 < *count) ? &copies[i + 1] : NULL;
+
+                if(neighbor->frame_buffer != NULL)
+                {
+                    memcpy(frames, neighbor->frame_buffer, neighbor->frame_buffer_length);
+                    copies[i].frame_buffer = frames;
+                    frames += neighbor->frame_buffer_length;
+                }
+            }
+        }
+
+        read_unlock_irqrestore(&cdp->neighbors_rw_lock, flags);
+        cdp_stats_lock_released(&timer, false);
+
+        if(needed <= size)
+            break;
+
+        /* Leave room for the table to keep growing until the next attempt */
+        kvfree(copies);
+        size = needed + needed / 4;
+    }
+
+    proc->copy_size = size;
+
+    return copies;
 }
 
-static int cdp_seq_show(struct seq_file *seq, void *v)
+/** Renders a view of the entire neighbor table into a new snapshot.
+  *  The table is copied under the lock and the show functions are called for each copied neighbor
+  *  into a sequential file structure backed by the snapshot's buffer, so no formatting is done
+  *  with interrupts disabled. The buffer is sized from the previous snapshot of the view and, if
+  *  it overflows, it is doubled and rendering restarts.
+  *  @param instance the view to render.
+  *  @return the snapshot with a single reference or NULL on error.
+  */
+static struct cdp_proc_snapshot *cdp_proc_render(const struct cdp_proc_instance *instance)
 {
-    //seq_printf(seq, "%s\n--\n", seq->file->f_path.dentry->d_iname);
+    struct cdp_proc_snapshot *snapshot;
+    struct cdp_neighbor *copies;
+    struct seq_file seq;
+    size_t size = CDP_PROC_INITIAL_RENDER_SIZE;
+    size_t count;
+    size_t i;
+
+    snapshot = kzalloc(sizeof(struct cdp_proc_snapshot), GFP_KERNEL);
+    if(snapshot == NULL)
+        return NULL;
+
+    kref_init(&snapshot->ref);
+
+    copies = cdp_proc_copy_table(instance->cdp, snapshot, &count);
+    if(copies == NULL)
+    {
+        kfree(snapshot);
+        return NULL;
+    }
+
+    /* The table rarely changes much between renderings, so the last one is a good estimate */
+    if(instance->cache != NULL)
+        size = max_t(size_t, size, instance->cache->length + instance->cache->length / 4);
+
+    for(;;)
+    {
+        snapshot->data = kvmalloc(size, GFP_KERNEL);
+        if(snapshot->data == NULL)
+        {
+            kvfree(copies);
+            kfree(snapshot);
+            return NULL;
+        }
+
+        memset(&seq, 0, sizeof(seq));
+        seq.buf = snapshot->data;
+        seq.size = size;
+        seq.private = instance->cdp;
+
+        for(i = 0; i < count && !seq_has_overflowed(&seq); i++)
+            instance->view->show(&seq, &copies[i]);
 
-    if(!strcmp(seq->file->f_path.dentry->d_iname, "summary"))
-        return cdp_seq_summary_show(seq, v);
-    else if(!strcmp(seq->file->f_path.dentry->d_iname, "detail"))
-        return cdp_seq_detail_show(seq, v);
-    else if(!strcmp(seq->file->f_path.dentry->d_iname, "json"))
-        return cdp_seq_json_show(seq, v);
+        if(!seq_has_overflowed(&seq))
+            break;
 
-    printk("Attempting to read an unknown /proc/net/cdp file (%s)\n", seq->file->f_path.dentry->d_iname);
-    return -1;
+        kvfree(snapshot->data);
+        size <<= 1;
+    }
+
+    kvfree(copies);
+
+    snapshot->length = seq.count;
+
+    return snapshot;
 }
 
-/** Sequential file system handler entry points for the /proc/net/cdp/ files */
-static const struct seq_operations cdp_seq_ops = {
-	.start  = cdp_seq_start,
-	.next   = cdp_seq_next,
-	.stop   = cdp_seq_stop,
-	.show   = cdp_seq_show,
-};
+/** Returns a referenced snapshot of a view, rendering a new one if the cache isn't current.
+  *  @param instance the view to get the snapshot of.
+  *  @return the snapshot or NULL on error.
+  */
+static struct cdp_proc_snapshot *cdp_proc_get_snapshot(struct cdp_proc_instance *instance)
+{
+    struct mutex *cache_lock = &instance->cdp->proc->cache_lock;
+    struct cdp_proc_snapshot *snapshot;
+
+    mutex_lock(cache_lock);
+
+    if(!cdp_proc_snapshot_is_current(instance->cdp, instance->cache))
+    {
+        snapshot = cdp_proc_render(instance);
+        if(snapshot == NULL)
+        {
+            mutex_unlock(cache_lock);
+            return NULL;
+        }
+
+        cdp_proc_snapshot_put(instance->cache);
+        instance->cache = snapshot;
+    }
+
+    snapshot = instance->cache;
+    kref_get(&snapshot->ref);
+
+    mutex_unlock(cache_lock);
 
-/** The inode open handler for the /proc/net/cdp/ files
+    return snapshot;
+}
+
+/** The inode open handler for the /proc/net/cdp/ files.
+  *  The file is bound to the current snapshot of its view so that partial reads always see
+  *  consistent content. A read from the start of the file moves it to a newer snapshot if the
+  *  table has changed since.
   *  @param inode the inode structure to provide entry points for.
   *  @param file the file to provide entry points for processing to.
   *  @return 0 on success, negative values on failure.
   */
 static int cdp_seq_open(struct inode *inode, struct file *file)
 {
-	return seq_open(file, &cdp_seq_ops);
+    struct cdp_proc_file *proc_file;
+
+    proc_file = kzalloc(sizeof(struct cdp_proc_file), GFP_KERNEL);
+    if(proc_file == NULL)
+        return -ENOMEM;
+
+    proc_file->instance = PDE_DATA(inode);
+    mutex_init(&proc_file->lock);
+
+    proc_file->snapshot = cdp_proc_get_snapshot(proc_file->instance);
+    if(proc_file->snapshot == NULL)
+    {
+        kfree(proc_file);
+        return -ENOMEM;
+    }
+
+    file->private_data = proc_file;
+
+    return 0;
+}
+
+/** The read handler for the /proc/net/cdp/ files, served as a copy of the snapshot.
+  *  @param file the file being read.
+  *  @param buffer the user mode buffer to read into.
+  *  @param count the size of the user mode buffer.
+  *  @param ppos the position within the file.
+  *  @return the number of bytes read or a negative value on error.
+  */
+static ssize_t cdp_seq_read(struct file *file, char __user *buffer, size_t count, loff_t *ppos)
+{
+    struct cdp_proc_file *proc_file = file->private_data;
+    ssize_t result;
+
+    mutex_lock(&proc_file->lock);
+
+    /* Rewinding to the start after a change picks up the new content */
+    if(*ppos == 0 && !cdp_proc_snapshot_is_current(proc_file->instance->cdp, proc_file->snapshot))
+    {
+        struct cdp_proc_snapshot *snapshot = cdp_proc_get_snapshot(proc_file->instance);
+
+        if(snapshot != NULL)
+        {
+            cdp_proc_snapshot_put(proc_file->snapshot);
+            proc_file->snapshot = snapshot;
+        }
+    }
+
+    result = simple_read_from_buffer(buffer, count, ppos, proc_file->snapshot->data, proc_file->snapshot->length);
+
+    mutex_unlock(&proc_file->lock);
+
+    return result;
+}
+
+/** The write handler for the /proc/net/cdp/ files which can be loaded.
+  *  Writes may split the loaded data anywhere, so whatever the view doesn't consume is kept
+  *  until the next write completes it.
+  *  @param file the file being written.
+  *  @param buffer the user mode buffer to write from.
+  *  @param count the size of the user mode buffer.
+  *  @param ppos the position within the file.
+  *  @return the number of bytes written or a negative value on error.
+  */
+static ssize_t cdp_seq_write(struct file *file, const char __user *buffer, size_t count, loff_t *ppos)
+{
+    struct cdp_proc_file *proc_file = file->private_data;
+    const struct cdp_proc_view *view = proc_file->instance->view;
+    ssize_t consumed;
+    size_t accepted;
+
+    if(view->load == NULL)
+        return -EINVAL;
+
+    mutex_lock(&proc_file->lock);
+
+    if(proc_file->pending == NULL)
+    {
+        proc_file->pending = kvmalloc(CDP_PROC_MAX_RECORD_LENGTH, GFP_KERNEL);
+        if(proc_file->pending == NULL)
+        {
+            mutex_unlock(&proc_file->lock);
+            return -ENOMEM;
+        }
+    }
+
+    /* A short write makes the writer retry with the rest, there is always room as the view
+     * consumes every complete record
+     */
+    accepted = min(count, (size_t)CDP_PROC_MAX_RECORD_LENGTH - proc_file->pending_length);
+    if(copy_from_user(proc_file->pending + proc_file->pending_length, buffer, accepted) != 0)
+    {
+        mutex_unlock(&proc_file->lock);
+        return -EFAULT;
+    }
+
+    proc_file->pending_length += accepted;
+
+    consumed = view->load(proc_file->instance->cdp, proc_file->pending, proc_file->pending_length);
+    if(consumed < 0)
+    {
+        proc_file->pending_length = 0;
+        mutex_unlock(&proc_file->lock);
+        return -EINVAL;
+    }
+
+    memmove(proc_file->pending, proc_file->pending + consumed, proc_file->pending_length - consumed);
+    proc_file->pending_length -= consumed;
+    *ppos += accepted;
+
+    mutex_unlock(&proc_file->lock);
+
+    return accepted;
+}
+
+/** The poll handler for the /proc/net/cdp/ files.
+  *  The file is readable while there is unread content in its snapshot or when the neighbor
+  *  table has changed since the snapshot was rendered. A reader which has consumed the file
+  *  therefore blocks until the table changes, then seeks to 0 and reads the new content.
+  *  @param file the file being polled.
+  *  @param wait the poll table to register the wait queue with.
+  *  @return the poll event mask.
+  */
+static unsigned int cdp_seq_poll(struct file *file, poll_table *wait)
+{
+    struct cdp_proc_file *proc_file = file->private_data;
+    struct cdp_net *cdp = proc_file->instance->cdp;
+    unsigned int mask = 0;
+
+    poll_wait(file, &cdp->neighbors_wait, wait);
+
+    mutex_lock(&proc_file->lock);
+
+    if(proc_file->snapshot->generation != READ_ONCE(cdp->neighbors_generation))
+        mask |= POLLIN | POLLRDNORM;
+    else if(file->f_pos < proc_file->snapshot->length)
+        mask |= POLLIN | POLLRDNORM;
+
+    mutex_unlock(&proc_file->lock);
+
+    return mask;
+}
+
+/** The release handler for the /proc/net/cdp/ files.
+  *  @param inode the inode of the file.
+  *  @param file the file being closed.
+  *  @return 0.
+  */
+static int cdp_seq_release(struct inode *inode, struct file *file)
+{
+    struct cdp_proc_file *proc_file = file->private_data;
+
+    if(proc_file->pending_length > 0)
+        printk(KERN_WARNING "cdp: discarding %zu bytes of a partial record written to /proc/net/cdp/%s\n", proc_file->pending_length, proc_file->instance->view->name);
+
+    cdp_proc_snapshot_put(proc_file->snapshot);
+    kvfree(proc_file->pending);
+    kfree(proc_file);
+
+    return 0;
 }
 
 /** The proc_fs inode entry points for processing the /proc/net/cdp/ files */
 static const struct file_operations cdp_seq_fops = {
 	.open		= cdp_seq_open,
+	.read		= cdp_seq_read,
+	.write		= cdp_seq_write,
+	.poll		= cdp_seq_poll,
+	.llseek		= default_llseek,
+	.release	= cdp_seq_release,
+};
+
+/** Opens /proc/net/cdp/stats, which is rendered on every read as the counters change all the time
+  *  @param inode the inode of the file.
+  *  @param file the file being opened.
+  *  @return 0 on success or a negative value on error.
+  */
+static int cdp_proc_stats_open(struct inode *inode, struct file *file)
+{
+    return single_open(file, cdp_stats_show, NULL);
+}
+
+/** The proc_fs inode entry points for /proc/net/cdp/stats */
+static const struct file_operations cdp_proc_stats_fops = {
+	.open		= cdp_proc_stats_open,
 	.read		= seq_read,
 	.llseek		= seq_lseek,
-	.release	= seq_release,
+	.release	= single_release,
 };
 
-int __init cdp_proc_init(void)
+/** Opens /proc/net/cdp/latency, which is rendered on every read like /proc/net/cdp/stats
+  *  @param inode the inode of the file.
+  *  @param file the file being opened.
+  *  @return 0 on success or a negative value on error.
+  */
+static int cdp_proc_latency_open(struct inode *inode, struct file *file)
 {
-    cdp_proc_dir = proc_mkdir("cdp", init_net.proc_net);
-    if(cdp_proc_dir == NULL)
+    return single_open(file, cdp_stats_latency_show, NULL);
+}
+
+/** The proc_fs inode entry points for /proc/net/cdp/latency */
+static const struct file_operations cdp_proc_latency_fops = {
+	.open		= cdp_proc_latency_open,
+	.read		= seq_read,
+	.llseek		= seq_lseek,
+	.release	= single_release,
+};
+
+int cdp_proc_net_init(struct cdp_net *cdp)
+{
+    struct cdp_proc_net *proc;
+    int i;
+
+    proc = kzalloc(sizeof(struct cdp_proc_net), GFP_KERNEL);
+    if(proc == NULL)
+        return -ENOMEM;
+
+    mutex_init(&proc->cache_lock);
+
+    proc->dir = proc_mkdir("cdp", cdp->net->proc_net);
+    if(proc->dir == NULL)
     {
+        kfree(proc);
         return -ENOMEM;
     }
 
-    cdp_summary_proc_entry = proc_create("summary", 0444, cdp_proc_dir, &cdp_seq_fops);
-	if (!cdp_summary_proc_entry)
+    cdp->proc = proc;
+
+    for(i = 0; i < ARRAY_SIZE(cdp_proc_views); i++)
     {
-        remove_proc_entry("cdp", init_net.proc_net);
-        return -ENOMEM;
+        proc->instances[i].view = &cdp_proc_views[i];
+        proc->instances[i].cdp = cdp;
+
+        if(proc_create_data(cdp_proc_views[i].name, cdp_proc_views[i].load != NULL ? 0644 : 0444, proc->dir, &cdp_seq_fops, &proc->instances[i]) == NULL)
+        {
+            while(--i >= 0)
+                remove_proc_entry(cdp_proc_views[i].name, proc->dir);
+
+            remove_proc_entry("cdp", cdp->net->proc_net);
+            cdp->proc = NULL;
+            kfree(proc);
+            return -ENOMEM;
+        }
     }
 
-    cdp_detail_proc_entry = proc_create("detail", 0444, cdp_proc_dir, &cdp_seq_fops);
-	if (!cdp_detail_proc_entry)
+    return 0;
+}
+
+void cdp_proc_net_exit(struct cdp_net *cdp)
+{
+    struct cdp_proc_net *proc = cdp->proc;
+    int i;
+
+    /* Removing an entry waits for the files which are still open to be released */
+    for(i = ARRAY_SIZE(cdp_proc_views) - 1; i >= 0; i--)
     {
-        remove_proc_entry("summary", cdp_proc_dir);
-        remove_proc_entry("cdp", init_net.proc_net);
-        return -ENOMEM;
+        remove_proc_entry(cdp_proc_views[i].name, proc->dir);
+
+        cdp_proc_snapshot_put(proc->instances[i].cache);
     }
 
-    cdp_json_proc_entry = proc_create("json", 0444, cdp_proc_dir, &cdp_seq_fops);
-	if (!cdp_json_proc_entry)
+    remove_proc_entry("cdp", cdp->net->proc_net);
+
+    cdp->proc = NULL;
+    kfree(proc);
+}
+
+int __init cdp_proc_init(void)
+{
+    struct proc_dir_entry *dir = cdp_net(&init_net)->proc->dir;
+
+    if(proc_create("stats", 0444, dir, &cdp_proc_stats_fops) == NULL)
+        return -ENOMEM;
+
+    if(proc_create("latency", 0444, dir, &cdp_proc_latency_fops) == NULL)
     {
-        remove_proc_entry("detail", cdp_proc_dir);
-        remove_proc_entry("summary", cdp_proc_dir);
-        remove_proc_entry("cdp", init_net.proc_net);
+        remove_proc_entry("stats", dir);
         return -ENOMEM;
     }
 
@@ -155,8 +639,8 @@ int __init cdp_proc_init(void)
 
 void cdp_proc_exit(void)
 {
-    remove_proc_entry("json", cdp_proc_dir);
-    remove_proc_entry("detail", cdp_proc_dir);
-    remove_proc_entry("summary", cdp_proc_dir);
-    remove_proc_entry("cdp", init_net.proc_net);
+    struct proc_dir_entry *dir = cdp_net(&init_net)->proc->dir;
+
+    remove_proc_entry("latency", dir);
+    remove_proc_entry("stats", dir);
 }
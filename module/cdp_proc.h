@@ -4,14 +4,50 @@
 #include <linux/seq_file.h>
 #include <linux/socket.h>
 
-/** Entry point for initializing the proc_fs entries.
+/** The maximum age in seconds of a cached rendering of a /proc/net/cdp file.
+  *  Renderings are cached until the neighbor table changes (see neighbors_generation of struct cdp_net). Values
+  *  which count down without the table changing, such as the remaining hold time, can therefore
+  *  be up to this many seconds stale.
+  */
+#define CDP_PROC_CACHE_MAX_AGE_SECONDS 5
+
+/** The longest neighbor record accepted by a write to /proc/net/cdp/raw */
+#define CDP_PROC_MAX_RECORD_LENGTH 65536
+
+struct cdp_net;
+struct cdp_neighbor;
+struct ip_address;
+
+/** Creates /proc/net/cdp and the views of the neighbor table of a namespace.
+  *  @param cdp The namespace, whose proc member is set.
+  *  @return 0 on success or a negative value on error.
+  */
+int cdp_proc_net_init(struct cdp_net *cdp);
+
+/** Removes /proc/net/cdp of a namespace, waiting for the files still open to be released.
+  *  @param cdp The namespace.
+  */
+void cdp_proc_net_exit(struct cdp_net *cdp);
+
+/** Entry point for initializing /proc/net/cdp/stats and /proc/net/cdp/latency. The counters
+  *  cover the whole module, so the files only exist in the initial namespace, whose /proc/net/cdp
+  *  must have been created by cdp_proc_net_init.
   *  @return 0 on success or a negative value on error.
   */
 int __init cdp_proc_init(void);
 
-/** Exit point for tearing down the proc_fs entries. */
+/** Exit point for tearing down /proc/net/cdp/stats and /proc/net/cdp/latency. */
 void cdp_proc_exit(void);
 
+/** Looks up the current name of the interface a neighbor was received on. Neighbors are keyed by
+  *  the interface index, so a renamed interface is shown with its new name.
+  *  @param seq The sequential file being rendered, whose private member is the namespace.
+  *  @param neighbor The neighbor.
+  *  @param name A buffer of IFNAMSIZ bytes to receive the name.
+  *  @return name, holding "if<index>" if the interface no longer exists.
+  */
+const char *cdp_proc_interface_name(struct seq_file *seq, const struct cdp_neighbor *neighbor, char *name);
+
 /** Function to be called to produce printable summary output for 
   *  the sequential file /proc/net/cdp/summary
   *  @param seq The handle to the sequential file structure.
@@ -37,6 +73,25 @@ int cdp_seq_detail_show(struct seq_file *seq, void *v);
   */
 int cdp_seq_json_show(struct seq_file *seq, void *v);
 
+/** Function to be called to produce binary neighbor records for the
+  *  sequential file /proc/net/cdp/raw (see libcdp/cdp_neighbor_record.h)
+  *  @param seq The handle to the sequential file structure.
+  *  @param v A pointer to the current value to print
+  *  @return 0 on success or a negative value on failure.
+  */
+int cdp_seq_raw_show(struct seq_file *seq, void *v);
+
+/** Function to be called to load binary neighbor records written to the
+  *  file /proc/net/cdp/raw, so that a table saved before the module was
+  *  unloaded is restored once it's loaded again. Records which would have
+  *  expired by now are dropped.
+  *  @param cdp The namespace whose table the records are loaded into.
+  *  @param data The records written so far, possibly ending with a partial record.
+  *  @param length The length of data.
+  *  @return The number of bytes of complete records consumed or a negative value on failure.
+  */
+ssize_t cdp_seq_raw_load(struct cdp_net *cdp, const uint8_t *data, size_t length);
+
 /** Prints the contents of a socket address if the format is known and understood
   *  @param seq the sequential file handle to print to
   *  @param address the address to print
@@ -44,4 +99,11 @@ int cdp_seq_json_show(struct seq_file *seq, void *v);
   */
 int seq_print_sockaddr(struct seq_file *seq, const struct sockaddr *address);
 
+/** Prints an IP address from an ip_address_array if the format is known and understood
+  *  @param seq the sequential file handle to print to
+  *  @param address the address to print
+  *  @return 0 on success or a negative value on success.
+  */
+int seq_print_ip_address(struct seq_file *seq, const struct ip_address *address);
+
 #endif
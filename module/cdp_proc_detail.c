@@ -1,5 +1,6 @@
 #include <linux/in.h>
 #include <linux/in6.h>
+#include <linux/netdevice.h>
 #include <linux/time.h>
 
 #include "cdp_module.h"
@@ -30,6 +31,7 @@ int cdp_seq_detail_show(struct seq_file *seq, void *v)
         else
         {
             struct cdp_packet *packet;
+            char interface_name[IFNAMSIZ];
             struct stream_reader *reader;
             int parse_result;
             struct timespec now;
@@ -43,7 +45,7 @@ int cdp_seq_detail_show(struct seq_file *seq, void *v)
             reader = stream_reader_new(neighbor->frame_buffer, neighbor->frame_buffer_length);
             if(reader == NULL)
             {
-                printk("cdp_seq_summary_show: failed to allocate stream reader\n");                
+                printk_ratelimited(KERN_ERR "cdp_seq_summary_show: failed to allocate stream reader\n");                
                 return 0;
             }
 
@@ -63,18 +65,20 @@ int cdp_seq_detail_show(struct seq_file *seq, void *v)
             {
                 for(i=0; i<packet->addresses->count; i++)
                 {
-                    if(packet->addresses->addresses[i] == NULL)
+                    const struct ip_address *address = &packet->addresses->addresses[i];
+
+                    if(address->family == AF_UNSPEC)
                         seq_printf(seq, "  <address is null>\n");
                     else
                     {
-                        if(packet->addresses->addresses[i]->sa_family == AF_INET)
+                        if(address->family == AF_INET)
                             seq_puts(seq, "  IP address: ");
-                        else if(packet->addresses->addresses[i]->sa_family == AF_INET6)
+                        else if(address->family == AF_INET6)
                             seq_puts(seq, "  IPv6 address: ");
                         else
                             seq_puts(seq, "  ");
 
-                        seq_print_sockaddr(seq, packet->addresses->addresses[i]);
+                        seq_print_ip_address(seq, address);
                         seq_puts(seq, "\n");                        
                     }
                 }
@@ -109,7 +113,7 @@ int cdp_seq_detail_show(struct seq_file *seq, void *v)
             seq_printf(
                 seq,
                 "Interface: %s,  Port-Id (outgoing port): %s\n",
-                (neighbor->device_name == NULL) ? "<local port null>" : neighbor->device_name,
+                cdp_proc_interface_name(seq, neighbor, interface_name),
                 (packet->port_id == NULL) ? "<port id null>" : packet->port_id
             );
 
@@ -154,18 +158,20 @@ int cdp_seq_detail_show(struct seq_file *seq, void *v)
                 seq_printf(seq, "Management address(es):\n");
                 for(i=0; i<packet->management_addresses->count; i++)
                 {
-                    if(packet->management_addresses->addresses[i] == NULL)
+                    const struct ip_address *address = &packet->management_addresses->addresses[i];
+
+                    if(address->family == AF_UNSPEC)
                         seq_printf(seq, "  <address is null>\n");
                     else
                     {
-                        if(packet->management_addresses->addresses[i]->sa_family == AF_INET)
+                        if(address->family == AF_INET)
                             seq_puts(seq, "  IP address: ");
-                        else if(packet->management_addresses->addresses[i]->sa_family == AF_INET6)
+                        else if(address->family == AF_INET6)
                             seq_puts(seq, "  IPv6 address: ");
                         else
                             seq_puts(seq, "  ");
 
-                        seq_print_sockaddr(seq, packet->management_addresses->addresses[i]);
+                        seq_print_ip_address(seq, address);
                         seq_puts(seq, "\n");                        
                     }
                 }
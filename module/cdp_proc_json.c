@@ -1,3 +1,4 @@
+#include <linux/netdevice.h>
 #include <linux/time.h>
 
 #include "cdp_proc.h"
@@ -197,7 +198,7 @@ static int json_address_array_out(struct seq_file *seq, const struct ip_address_
         {
             seq_puts(seq, "      \"");
 
-            seq_print_sockaddr(seq, array->addresses[i]);
+            seq_print_ip_address(seq, &array->addresses[i]);
 
             if(i < (array->count - 1))
                 seq_puts(seq, "\",\n");
@@ -386,7 +387,7 @@ int cdp_seq_json_show(struct seq_file *seq, void *v)
 {
     struct cdp_neighbor *neighbor = (struct cdp_neighbor *)v;
 
-    if(neighbor == cdp_neighbors->head)
+    if(neighbor != NULL && neighbor->prev == NULL)
         seq_printf(seq, "\"cdpNeighbors\": [\n");
 
     if(neighbor == NULL)
@@ -404,6 +405,7 @@ int cdp_seq_json_show(struct seq_file *seq, void *v)
         else
         {
             struct cdp_packet *packet;
+            char interface_name[IFNAMSIZ];
             struct stream_reader *reader;
             int parse_result;
             struct timespec now;
@@ -416,7 +418,7 @@ int cdp_seq_json_show(struct seq_file *seq, void *v)
             reader = stream_reader_new(neighbor->frame_buffer, neighbor->frame_buffer_length);
             if(reader == NULL)
             {
-                printk("cdp_seq_summary_show: failed to allocate stream reader\n");                
+                printk_ratelimited(KERN_ERR "cdp_seq_summary_show: failed to allocate stream reader\n");                
                 return 0;
             }
 
@@ -431,7 +433,7 @@ int cdp_seq_json_show(struct seq_file *seq, void *v)
             }
 
             seq_puts(seq, "  {\n");
-            json_string_out(seq, neighbor->device_name, "localInterface");
+            json_string_out(seq, cdp_proc_interface_name(seq, neighbor, interface_name), "localInterface");
             json_int_out(seq, packet->cdp_proto_ver, "cdpVersion");
             json_int_out(seq, packet->cdp_ttl, "holdTime");
             json_int_out(seq, packet->cdp_ttl - seconds_since_receive, "holdTimeRemaining");
@@ -452,7 +454,7 @@ int cdp_seq_json_show(struct seq_file *seq, void *v)
             json_string_out(seq, packet->startup_native_vlan, "startupNativeVlan");
             json_address_array_out(seq, packet->management_addresses, "managementAddresses", true, true);
 
-            if(neighbor == cdp_neighbors->tail)
+            if(neighbor->next == NULL)
                 seq_puts(seq, "  }\n");
             else
                 seq_puts(seq, "  },\n");
@@ -461,7 +463,7 @@ int cdp_seq_json_show(struct seq_file *seq, void *v)
         }
     }
 
-    if(neighbor == cdp_neighbors->tail)
+    if(neighbor != NULL && neighbor->next == NULL)
         seq_printf(seq, "]\n");
 
     return 0;
@@ -1,22 +1,19 @@
 #include <linux/in.h>
 #include <linux/in6.h>
+#include <linux/string.h>
 
 #include "cdp_proc.h"
+#include "../libcdp/ip_address_array.h"
 
-int seq_print_sockaddr(struct seq_file *seq, const struct sockaddr *address)
+int seq_print_ip_address(struct seq_file *seq, const struct ip_address *address)
 {
-	if (address->sa_family == AF_INET)
+	if (address->family == AF_INET)
 	{
-		uint32_t n;
-		const struct sockaddr_in *address4 = (const struct sockaddr_in *)address;
-		
-		n = address4->sin_addr.s_addr;
-		seq_printf(seq, "%d.%d.%d.%d", (n & 0xFF), ((n >> 8) & 0xFF), ((n >> 16) & 0xFF), ((n >> 24) & 0xFF));
+		seq_printf(seq, "%d.%d.%d.%d", address->octets[0], address->octets[1], address->octets[2], address->octets[3]);
 	}
-	else if (address->sa_family == AF_INET6)
+	else if (address->family == AF_INET6)
 	{
 		int i;
-		const struct sockaddr_in6 *address6 = (const struct sockaddr_in6 *)address;
         int hextets[8];
         int longestIndex = -1;
         int longest = 0;
@@ -25,8 +22,8 @@ int seq_print_sockaddr(struct seq_file *seq, const struct sockaddr *address)
 		for (i = 0; i < 8; i++)
         {
             hextets[i] =
-                (((int)address6->sin6_addr.in6_u.u6_addr8[i << 1]) << 8) |
-                ((int)address6->sin6_addr.in6_u.u6_addr8[(i << 1) + 1]);
+                (((int)address->octets[i << 1]) << 8) |
+                ((int)address->octets[(i << 1) + 1]);
         }
 
         /* Identify the longest run of zeros in the list of hextets */
@@ -86,3 +83,16 @@ int seq_print_sockaddr(struct seq_file *seq, const struct sockaddr *address)
 
     return 0;
 }
+
+int seq_print_sockaddr(struct seq_file *seq, const struct sockaddr *address)
+{
+	struct ip_address value;
+
+	value.family = (uint8_t)address->sa_family;
+	if (address->sa_family == AF_INET)
+		memcpy(value.octets, &((const struct sockaddr_in *)address)->sin_addr, 4);
+	else if (address->sa_family == AF_INET6)
+		memcpy(value.octets, ((const struct sockaddr_in6 *)address)->sin6_addr.in6_u.u6_addr8, 16);
+
+	return seq_print_ip_address(seq, &value);
+}
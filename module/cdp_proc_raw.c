@@ -0,0 +1,161 @@
+#include <asm/unaligned.h>
+#include <net/net_namespace.h>
+
+#include "cdp_proc.h"
+#include "cdp_module.h"
+#include "cdp_netlink.h"
+#include "cdp_stats.h"
+
+#include "../libcdp/cdp_neighbor_record.h"
+#include "../libcdp/stream_reader.h"
+
+int cdp_seq_raw_show(struct seq_file *seq, void *v)
+{
+    struct cdp_neighbor *neighbor = (struct cdp_neighbor *)v;
+    uint8_t header[CDP_NEIGHBOR_RECORD_HEADER_LENGTH];
+    ssize_t header_length;
+
+    if(neighbor == NULL)
+        return 0;
+
+    /* Entries which have not received a frame yet have nothing to export */
+    if(neighbor->frame_buffer == NULL || neighbor->frame_buffer_length == 0)
+        return 0;
+
+    header_length = cdp_neighbor_record_write_header(neighbor, header, sizeof(header));
+    if(header_length < 0)
+    {
+        printk_ratelimited(KERN_ERR "cdp_seq_raw_show: failed to write neighbor record header\n");
+        return 0;
+    }
+
+    /* If the record doesn't fit, seq_file will grow the buffer and show this entry again */
+    seq_write(seq, header, (size_t)header_length);
+    seq_write(seq, neighbor->frame_buffer, neighbor->frame_buffer_length);
+
+    return 0;
+}
+
+/** Restores a neighbor loaded from a record into the neighbor table. The interface is looked up
+  *  by index since the record doesn't carry its name. A neighbor already in the table is only
+  *  replaced if it was received before the record.
+  *  @param cdp the namespace whose table the neighbor is restored into.
+  *  @param loaded the neighbor parsed from the record, it is deleted.
+  *  @param now the current time, records which would have expired by now are dropped.
+  */
+static void cdp_seq_raw_restore(struct cdp_net *cdp, struct cdp_neighbor *loaded, struct timespec now)
+{
+    struct cdp_neighbor *neighbor;
+    struct net_device *dev;
+    struct sk_buff *event = NULL;
+    struct cdp_stats_lock_timer timer;
+    unsigned long flags;
+
+    if(cdp_neighbor_is_expired(loaded, now))
+    {
+        cdp_neighbor_delete(loaded);
+        return;
+    }
+
+    dev = dev_get_by_index(cdp->net, loaded->device_index);
+    if(dev == NULL || dev->type != ARPHRD_ETHER)
+    {
+        if(dev != NULL)
+            dev_put(dev);
+
+        cdp_neighbor_delete(loaded);
+        return;
+    }
+
+    cdp_stats_lock_requested(&timer);
+    write_lock_irqsave(&cdp->neighbors_rw_lock, flags);
+    cdp_stats_lock_acquired(&timer);
+
+    neighbor = cdp_neighbor_list_get_or_create_by_identity(
+        cdp->neighbors,
+        dev->type,
+        dev->ifindex,
+        loaded->remote_mac);
+
+    if(neighbor == NULL)
+    {
+        cdp_stats_inc(CDP_STAT_DROPPED_NO_MEMORY);
+    }
+    else if(neighbor->frame_buffer_length == 0 || timespec_compare(&neighbor->received_at, &loaded->received_at) < 0)
+    {
+        bool is_new = (neighbor->frame_buffer_length == 0);
+
+        /* An existing neighbor keeps its previous frame, a new one can't stay in the table without one */
+        if(cdp_neighbor_set_frame_buffer(neighbor, loaded->frame_buffer, loaded->frame_buffer_length) < 0)
+        {
+            cdp_stats_inc(CDP_STAT_DROPPED_NO_MEMORY);
+
+            if(is_new)
+            {
+                cdp_neighbor_list_remove_item(cdp->neighbors, neighbor);
+                cdp_neighbor_delete(neighbor);
+            }
+        }
+        else
+        {
+            cdp_neighbor_set_received_at(neighbor, loaded->received_at);
+
+            cdp_stats_inc(CDP_STAT_NEIGHBORS_RESTORED);
+            cdp_neighbors_changed(cdp);
+            event = cdp_netlink_build_event(cdp->net, neighbor, is_new ? CDP_CMD_NEIGHBOR_ADDED : CDP_CMD_NEIGHBOR_CHANGED);
+        }
+    }
+
+    write_unlock_irqrestore(&cdp->neighbors_rw_lock, flags);
+    cdp_stats_lock_released(&timer, true);
+
+    cdp_netlink_send_event(cdp->net, event);
+
+    dev_put(dev);
+    cdp_neighbor_delete(loaded);
+}
+
+ssize_t cdp_seq_raw_load(struct cdp_net *cdp, const uint8_t *data, size_t length)
+{
+    struct cdp_neighbor *loaded;
+    struct stream_reader *reader;
+    struct timespec now;
+    size_t consumed = 0;
+    uint32_t record_length;
+    int rc;
+
+    getnstimeofday(&now);
+
+    /* The record length follows the version and the header length */
+    while(length - consumed >= 8)
+    {
+        record_length = get_unaligned_be32(data + consumed + 4);
+        if(record_length <= CDP_NEIGHBOR_RECORD_HEADER_LENGTH || record_length > CDP_PROC_MAX_RECORD_LENGTH)
+        {
+            printk_ratelimited(KERN_ERR "cdp_seq_raw_load: invalid record length %u\n", record_length);
+            return -1;
+        }
+
+        /* The rest of the record arrives with the next write */
+        if(record_length > length - consumed)
+            break;
+
+        reader = stream_reader_new(data + consumed, record_length);
+        if(reader == NULL)
+            return -1;
+
+        rc = cdp_neighbor_record_parse(reader, &loaded);
+        stream_reader_delete(reader);
+
+        if(rc < 0)
+        {
+            printk_ratelimited(KERN_ERR "cdp_seq_raw_load: failed to parse a neighbor record\n");
+            return -1;
+        }
+
+        cdp_seq_raw_restore(cdp, loaded, now);
+        consumed += record_length;
+    }
+
+    return (ssize_t)consumed;
+}
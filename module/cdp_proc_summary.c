@@ -1,3 +1,4 @@
+#include <linux/netdevice.h>
 #include <linux/time.h>
 
 #include "cdp_proc.h"
@@ -34,7 +35,7 @@ int cdp_seq_summary_show(struct seq_file *seq, void *v)
 {
     struct cdp_neighbor *neighbor = (struct cdp_neighbor *)v;
 
-    if(neighbor == cdp_neighbors->head)
+    if(neighbor != NULL && neighbor->prev == NULL)
         seq_printf(seq, "Device ID        Local Intrfce     Holdtme    Capability  Platform  Port ID\n");
 
     if(neighbor == NULL)
@@ -52,6 +53,7 @@ int cdp_seq_summary_show(struct seq_file *seq, void *v)
         else
         {
             char formatting_buffer[32];
+            char interface_name[IFNAMSIZ];
             struct cdp_packet *packet;
             struct stream_reader *reader;
             int parse_result;
@@ -65,7 +67,7 @@ int cdp_seq_summary_show(struct seq_file *seq, void *v)
             reader = stream_reader_new(neighbor->frame_buffer, neighbor->frame_buffer_length);
             if(reader == NULL)
             {
-                printk("cdp_seq_summary_show: failed to allocate stream reader\n");                
+                printk_ratelimited(KERN_ERR "cdp_seq_summary_show: failed to allocate stream reader\n");                
                 return 0;
             }
 
@@ -80,7 +82,7 @@ int cdp_seq_summary_show(struct seq_file *seq, void *v)
             }
 
             seq_printf(seq, "%s\n", (packet->device_id == NULL) ? "<device-id is null>" : packet->device_id);
-            seq_printf(seq, "                 %-17s ", (neighbor->device_name == NULL) ? "<local port null>" : neighbor->device_name);
+            seq_printf(seq, "                 %-17s ", cdp_proc_interface_name(seq, neighbor, interface_name));
             seq_printf(seq, "%-3d ", packet->cdp_ttl - seconds_since_receive);
             seq_printf(seq, "%17s  ", format_capabilities_brief(packet->capabilities, formatting_buffer));
             seq_printf(seq, "%10s ", (packet->platform == NULL) ? "<null>" : packet->platform);
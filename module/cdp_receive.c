@@ -1,64 +1,200 @@
 #include "cdp_module.h"
+#include "cdp_netlink.h"
 #include "cdp_receive.h"
+#include "cdp_stats.h"
 
-int cdp_receive(struct sk_buff *skb, struct net_device *dev, struct packet_type *pt, struct net_device *orig_dev)
+#include "../libcdp/cdp_packet_parser.h"
+
+#include <linux/moduleparam.h>
+
+/** The number of frames each CPU accepts per second, 0 for no limit */
+static unsigned int receive_rate_limit = 0;
+module_param(receive_rate_limit, uint, 0644);
+MODULE_PARM_DESC(receive_rate_limit, "The number of CDP frames accepted per second on each CPU, 0 for no limit");
+
+/** The receive rate window of a CPU */
+struct cdp_receive_rate
+{
+    /** The jiffies at which the current one second window started */
+    unsigned long window_start;
+
+    /** The number of frames accepted in the current window */
+    unsigned int frames;
+};
+
+static DEFINE_PER_CPU(struct cdp_receive_rate, cdp_receive_rates);
+
+/** Checks whether the current CPU may accept another frame under receive_rate_limit.
+  *  PSNAP calls the receive handler in softirq context, so the CPU can't change underneath.
+  *  @return true if the frame is over the limit.
+  */
+static bool cdp_receive_rate_limited(void)
+{
+    unsigned int limit = READ_ONCE(receive_rate_limit);
+    struct cdp_receive_rate *rate;
+
+    if(limit == 0)
+        return false;
+
+    rate = this_cpu_ptr(&cdp_receive_rates);
+
+    if(time_after_eq(jiffies, rate->window_start + HZ))
+    {
+        rate->window_start = jiffies;
+        rate->frames = 0;
+    }
+
+    if(rate->frames >= limit)
+        return true;
+
+    rate->frames++;
+
+    return false;
+}
+
+/** Drops a received frame and counts the reason.
+  *  @param skb the frame.
+  *  @param reason the counter of the reason.
+  *  @return NET_RX_DROP.
+  */
+static int cdp_receive_drop(struct sk_buff *skb, enum cdp_stat reason)
+{
+    cdp_stats_inc(reason);
+    kfree_skb(skb);
+
+    return NET_RX_DROP;
+}
+
+/** Validates a received frame and stores it in the neighbor table.
+  *  @param skb the frame, which is always consumed.
+  *  @param dev the interface the frame was received on, whose namespace holds the table.
+  *  @return NET_RX_SUCCESS if the frame was stored or NET_RX_DROP if it was dropped.
+  */
+static int cdp_receive_frame(struct sk_buff *skb, struct net_device *dev)
 {
+    struct cdp_net *cdp = cdp_net(dev_net(dev));
     struct cdp_neighbor *neighbor;
+    struct ethhdr *mac_header;
+    struct sk_buff *event = NULL;
+    struct cdp_stats_lock_timer timer;
+    unsigned long flags;
+    size_t length;
+    int rc = NET_RX_SUCCESS;
+    u64 lookup_start;
+    u64 lookup_ns;
+
+    if(dev->type != ARPHRD_ETHER)
+        return cdp_receive_drop(skb, CDP_STAT_DROPPED_NOT_ETHERNET);
+
+    if(cdp_receive_rate_limited())
+        return cdp_receive_drop(skb, CDP_STAT_DROPPED_RATE_LIMITED);
+
+    /* The checksum covers the whole frame, which must be in the linear part of the buffer */
+    if(skb_linearize(skb) != 0)
+        return cdp_receive_drop(skb, CDP_STAT_DROPPED_NO_MEMORY);
+
+    length = (size_t)(skb_tail_pointer(skb) - skb->data);
+
+    if(!cdp_frame_is_well_formed(skb->data, length))
+        return cdp_receive_drop(skb, CDP_STAT_DROPPED_MALFORMED);
 
-    if(dev->type == ARPHRD_ETHER)
+    if(!cdp_frame_checksum_is_valid(skb->data, length))
+        return cdp_receive_drop(skb, CDP_STAT_DROPPED_BAD_CHECKSUM);
+
+    mac_header = eth_hdr(skb);
+
+    cdp_stats_lock_requested(&timer);
+    write_lock_irqsave(&cdp->neighbors_rw_lock, flags);
+    cdp_stats_lock_acquired(&timer);
+
+    lookup_start = ktime_get_ns();
+    neighbor = cdp_neighbor_list_get_or_create_by_identity(
+        cdp->neighbors,
+        dev->type,
+        dev->ifindex,
+        cdp_neighbor_pack_mac(mac_header->h_source));
+    lookup_ns = ktime_get_ns() - lookup_start;
+
+    cdp_stats_latency(CDP_LATENCY_LOOKUP, lookup_ns);
+
+    if(neighbor == NULL)
+    {
+        cdp_stats_inc(CDP_STAT_DROPPED_NO_MEMORY);
+        rc = NET_RX_DROP;
+    }
+    else
     {
-        struct ethhdr *mac_header = eth_hdr(skb);
-        unsigned long flags;
-
-        /*
-        printk(
-            "Received from : %02X:%02X:%02X:%02X:%02X:%02X on interface %s with %d bytes, device type Ethernet\n",
-            mac_header->h_source[0],
-            mac_header->h_source[1],
-            mac_header->h_source[2],
-            mac_header->h_source[3],
-            mac_header->h_source[4],
-            mac_header->h_source[5],
-            dev->name,
-            (int)(skb_tail_pointer(skb) - skb->data)
-            );
-        */
-
-        write_lock_irqsave(&cdp_neighbors_rw_lock, flags);
-        neighbor = cdp_neighbor_list_get_or_create_by_identity(
-            cdp_neighbors,
-            dev->type,
-            dev->name,
-            mac_header->h_source,
-            ETH_ALEN);
-
-        if(neighbor == NULL)
+        struct timespec now;
+        bool is_new = (neighbor->frame_buffer_length == 0);
+        uint32_t previous_hash = neighbor->frame_hash;
+
+        trace_cdp_neighbor_lookup(dev, mac_header->h_source, is_new, lookup_ns);
+
+        getnstimeofday(&now);
+
+        /* An existing neighbor keeps its previous frame, a new one can't stay in the table without one */
+        if(cdp_neighbor_set_frame_buffer(neighbor, skb->data, length) < 0)
         {
-            printk(KERN_CRIT "Failed to find or create a new CDP neighbor entry record\n");
+            cdp_stats_inc(CDP_STAT_DROPPED_NO_MEMORY);
+            rc = NET_RX_DROP;
+
+            if(is_new)
+            {
+                cdp_neighbor_list_remove_item(cdp->neighbors, neighbor);
+                cdp_neighbor_delete(neighbor);
+            }
         }
         else
         {
-            struct timespec now;
-            getnstimeofday(&now);
-
             cdp_neighbor_set_received_at(neighbor, now);
-            cdp_neighbor_set_frame_buffer(neighbor, skb->data, (size_t)(skb_tail_pointer(skb) - skb->data));
-        }
 
-        write_unlock_irqrestore(&cdp_neighbors_rw_lock, flags);
+            /* The event is built under the lock but sent after releasing it */
+            if(is_new)
+            {
+                cdp_stats_inc(CDP_STAT_NEIGHBORS_CREATED);
+                cdp_neighbors_changed(cdp);
+                event = cdp_netlink_build_event(cdp->net, neighbor, CDP_CMD_NEIGHBOR_ADDED);
+            }
+            else if(neighbor->frame_hash != previous_hash)
+            {
+                cdp_stats_inc(CDP_STAT_NEIGHBORS_UPDATED);
+                cdp_neighbors_changed(cdp);
+                event = cdp_netlink_build_event(cdp->net, neighbor, CDP_CMD_NEIGHBOR_CHANGED);
+            }
+            else
+            {
+                cdp_stats_inc(CDP_STAT_NEIGHBORS_REFRESHED);
+            }
+        }
     }
-    /*
+
+    write_unlock_irqrestore(&cdp->neighbors_rw_lock, flags);
+    cdp_stats_lock_released(&timer, true);
+
+    cdp_netlink_send_event(cdp->net, event);
+
+    if(rc == NET_RX_SUCCESS)
+        consume_skb(skb);
     else
-    {
-        printk(
-            "Received from interface %s with %d bytes, device type %d (unknown, ignoring)\n",
-            dev->name,
-            (int)(skb_tail_pointer(skb) - skb->data),
-            dev->type
-            );
+        kfree_skb(skb);
 
-    }
-    */
+    return rc;
+}
+
+int cdp_receive(struct sk_buff *skb, struct net_device *dev, struct packet_type *pt, struct net_device *orig_dev)
+{
+    u64 start = ktime_get_ns();
+    u64 duration_ns;
+    int rc;
+
+    cdp_stats_inc(CDP_STAT_FRAMES_RECEIVED);
+    trace_cdp_receive_entry(dev, skb->len);
+
+    rc = cdp_receive_frame(skb, dev);
+
+    duration_ns = ktime_get_ns() - start;
+    cdp_stats_latency(CDP_LATENCY_RECEIVE, duration_ns);
+    trace_cdp_receive_exit(dev, rc, duration_ns);
 
-    return 0;
+    return rc;
 }
@@ -8,11 +8,13 @@
 
 /** Called by PSNAP to process incoming CDP packets received on any interface
   *  This function stores the packet data and the information necessary to identify who sent it.
+  *  Frames from interfaces other than Ethernet, over the receive rate limit, malformed or with a
+  *  bad checksum are dropped and counted in /proc/net/cdp/stats. The buffer is always consumed.
   *  @param skb The kernel packet buffer containing all the headers and data that's been parse so far.
   *  @param dev The network device upon which the frame was received.
   *  @param pt The packet type
   *  @param orig_dev TODO: Not really sure.
-  *  @return 0 on success or a negative value on error
+  *  @return NET_RX_SUCCESS if the frame was stored or NET_RX_DROP if it was dropped
   */
 int cdp_receive(struct sk_buff *skb, struct net_device *dev, struct packet_type *pt, struct net_device *orig_dev);
 
@@ -0,0 +1,344 @@
+#include <linux/hashtable.h>
+#include <linux/math64.h>
+#include <linux/rtnetlink.h>
+#include <linux/slab.h>
+#include <net/net_namespace.h>
+
+#include "cdp_module.h"
+#include "cdp_stats.h"
+
+DEFINE_PER_CPU(struct cdp_stats, cdp_stats);
+
+/** The names of the counters in /proc/net/cdp/stats, in the order of enum cdp_stat */
+static const char * const cdp_stats_names[CDP_STAT_COUNT] = {
+    [CDP_STAT_FRAMES_RECEIVED] = "frames_received",
+    [CDP_STAT_DROPPED_NOT_ETHERNET] = "dropped_not_ethernet",
+    [CDP_STAT_DROPPED_BAD_CHECKSUM] = "dropped_bad_checksum",
+    [CDP_STAT_DROPPED_MALFORMED] = "dropped_malformed",
+    [CDP_STAT_DROPPED_RATE_LIMITED] = "dropped_rate_limited",
+    [CDP_STAT_DROPPED_NO_MEMORY] = "dropped_no_memory",
+    [CDP_STAT_NEIGHBORS_CREATED] = "neighbors_created",
+    [CDP_STAT_NEIGHBORS_UPDATED] = "neighbors_updated",
+    [CDP_STAT_NEIGHBORS_REFRESHED] = "neighbors_refreshed",
+    [CDP_STAT_NEIGHBORS_EXPIRED] = "neighbors_expired",
+    [CDP_STAT_NEIGHBORS_RESTORED] = "neighbors_restored",
+    [CDP_STAT_LOCK_WRITE_ACQUISITIONS] = "lock_write_acquisitions",
+    [CDP_STAT_LOCK_WRITE_WAIT_NS] = "lock_write_wait_ns",
+    [CDP_STAT_LOCK_WRITE_HOLD_NS] = "lock_write_hold_ns",
+    [CDP_STAT_LOCK_READ_ACQUISITIONS] = "lock_read_acquisitions",
+    [CDP_STAT_LOCK_READ_WAIT_NS] = "lock_read_wait_ns",
+    [CDP_STAT_LOCK_READ_HOLD_NS] = "lock_read_hold_ns",
+};
+
+/** The names of the stages in /proc/net/cdp/latency, in the order of enum cdp_latency */
+static const char * const cdp_latency_names[CDP_LATENCY_COUNT] = {
+    [CDP_LATENCY_RECEIVE] = "receive",
+    [CDP_LATENCY_LOOKUP] = "lookup",
+    [CDP_LATENCY_LOCK_WAIT] = "lock_wait",
+    [CDP_LATENCY_LOCK_HOLD] = "lock_hold",
+    [CDP_LATENCY_PURGE] = "purge",
+    [CDP_LATENCY_TRANSMIT] = "transmit",
+};
+
+/** The transmit counters of an interface on a CPU */
+struct cdp_stats_interface_counters
+{
+    /** Frames handed to the interface */
+    u64 transmitted;
+
+    /** Frames which couldn't be built or sent */
+    u64 failed;
+
+    /** Transmissions skipped as the interface has no address */
+    u64 skipped;
+};
+
+/** The counters of an Ethernet interface, in the interfaces of its namespace's struct cdp_net */
+struct cdp_stats_interface
+{
+    /** The entry in the hash of the namespace */
+    struct hlist_node node;
+
+    /** The index of the interface */
+    int ifindex;
+
+    /** The counters of each CPU */
+    struct cdp_stats_interface_counters __percpu *counters;
+
+    /** Defers freeing the interface until the readers are done with it */
+    struct rcu_head rcu;
+};
+
+/** Finds the counters of an interface, must be called under rcu_read_lock().
+  *  @param cdp the namespace of the interface.
+  *  @param ifindex the index of the interface.
+  *  @return the interface or NULL if it has no counters.
+  */
+static struct cdp_stats_interface *cdp_stats_find_interface(struct cdp_net *cdp, int ifindex)
+{
+    struct cdp_stats_interface *interface;
+
+    hash_for_each_possible_rcu(cdp->interfaces, interface, node, ifindex)
+    {
+        if(interface->ifindex == ifindex)
+            return interface;
+    }
+
+    return NULL;
+}
+
+/** Frees the counters of an interface once no reader can see them anymore.
+  *  @param head the rcu member of the interface.
+  */
+static void cdp_stats_free_interface(struct rcu_head *head)
+{
+    struct cdp_stats_interface *interface = container_of(head, struct cdp_stats_interface, rcu);
+
+    free_percpu(interface->counters);
+    kfree(interface);
+}
+
+int cdp_stats_interface_add(const struct net_device *dev)
+{
+    struct cdp_net *cdp = cdp_net(dev_net(dev));
+    struct cdp_stats_interface *interface;
+
+    ASSERT_RTNL();
+
+    rcu_read_lock();
+    interface = cdp_stats_find_interface(cdp, dev->ifindex);
+    rcu_read_unlock();
+
+    if(interface != NULL)
+        return 0;
+
+    interface = kzalloc(sizeof(struct cdp_stats_interface), GFP_KERNEL);
+    if(interface == NULL)
+        return -ENOMEM;
+
+    interface->counters = alloc_percpu(struct cdp_stats_interface_counters);
+    if(interface->counters == NULL)
+    {
+        kfree(interface);
+        return -ENOMEM;
+    }
+
+    interface->ifindex = dev->ifindex;
+    hash_add_rcu(cdp->interfaces, &interface->node, interface->ifindex);
+
+    return 0;
+}
+
+void cdp_stats_interface_remove(const struct net_device *dev)
+{
+    struct cdp_stats_interface *interface;
+
+    ASSERT_RTNL();
+
+    rcu_read_lock();
+    interface = cdp_stats_find_interface(cdp_net(dev_net(dev)), dev->ifindex);
+    rcu_read_unlock();
+
+    if(interface == NULL)
+        return;
+
+    hash_del_rcu(&interface->node);
+    call_rcu(&interface->rcu, cdp_stats_free_interface);
+}
+
+void cdp_stats_transmitted(const struct net_device *dev, int rc)
+{
+    struct cdp_stats_interface *interface;
+
+    interface = cdp_stats_find_interface(cdp_net(dev_net(dev)), dev->ifindex);
+    if(interface == NULL)
+        return;
+
+    if(rc == 0)
+        this_cpu_inc(interface->counters->transmitted);
+    else if(rc < 0)
+        this_cpu_inc(interface->counters->failed);
+    else
+        this_cpu_inc(interface->counters->skipped);
+}
+
+int cdp_stats_show(struct seq_file *seq, void *v)
+{
+    struct cdp_stats_interface_counters totals;
+    const struct cdp_stats_interface_counters *counters;
+    struct cdp_stats_interface *interface;
+    struct net_device *dev;
+    struct net *net;
+    char name[IFNAMSIZ];
+    u64 value;
+    int bucket;
+    int cpu;
+    int i;
+
+    for(i = 0; i < CDP_STAT_COUNT; i++)
+    {
+        value = 0;
+        for_each_possible_cpu(cpu)
+            value += per_cpu(cdp_stats, cpu).counters[i];
+
+        seq_printf(seq, "%-24s %llu\n", cdp_stats_names[i], (unsigned long long)value);
+    }
+
+    seq_printf(seq, "\n%-16s %10s %8s %12s %12s %12s\n", "interface", "netns", "ifindex", "transmitted", "failed", "skipped");
+
+    /* A namespace leaves the list before its state is released */
+    rcu_read_lock();
+
+    for_each_net_rcu(net)
+    {
+        hash_for_each_rcu(cdp_net(net)->interfaces, bucket, interface, node)
+        {
+            memset(&totals, 0, sizeof(totals));
+            for_each_possible_cpu(cpu)
+            {
+                counters = per_cpu_ptr(interface->counters, cpu);
+                totals.transmitted += counters->transmitted;
+                totals.failed += counters->failed;
+                totals.skipped += counters->skipped;
+            }
+
+            dev = dev_get_by_index_rcu(net, interface->ifindex);
+            if(dev != NULL)
+                memcpy(name, dev->name, IFNAMSIZ);
+            else
+                snprintf(name, IFNAMSIZ, "if%d", interface->ifindex);
+
+            seq_printf(
+                seq,
+                "%-16s %10u %8d %12llu %12llu %12llu\n",
+                name,
+                net->ns.inum,
+                interface->ifindex,
+                (unsigned long long)totals.transmitted,
+                (unsigned long long)totals.failed,
+                (unsigned long long)totals.skipped
+            );
+        }
+    }
+
+    rcu_read_unlock();
+
+    return 0;
+}
+
+/** Gets the upper bound of a latency bucket.
+  *  @param bucket the bucket.
+  *  @return the first duration in nanoseconds which is counted in the next bucket.
+  */
+static u64 cdp_stats_latency_bucket_end(unsigned int bucket)
+{
+    return 1ULL << bucket;
+}
+
+/** Finds the bucket holding a percentile of a histogram.
+  *  @param buckets the histogram.
+  *  @param count the number of durations in the histogram.
+  *  @param per_mille the percentile in tenths of a percent.
+  *  @return the bucket.
+  */
+static unsigned int cdp_stats_latency_percentile(const u64 *buckets, u64 count, unsigned int per_mille)
+{
+    u64 rank = div_u64(count * per_mille + 999, 1000);
+    u64 seen = 0;
+    unsigned int bucket;
+
+    for(bucket = 0; bucket < CDP_LATENCY_BUCKETS - 1; bucket++)
+    {
+        seen += buckets[bucket];
+        if(seen >= rank)
+            break;
+    }
+
+    return bucket;
+}
+
+int cdp_stats_latency_show(struct seq_file *seq, void *v)
+{
+    u64 buckets[CDP_LATENCY_BUCKETS];
+    u64 count;
+    unsigned int bucket;
+    unsigned int first;
+    unsigned int last;
+    int cpu;
+    int i;
+
+    for(i = 0; i < CDP_LATENCY_COUNT; i++)
+    {
+        memset(buckets, 0, sizeof(buckets));
+        for_each_possible_cpu(cpu)
+        {
+            for(bucket = 0; bucket < CDP_LATENCY_BUCKETS; bucket++)
+                buckets[bucket] += per_cpu(cdp_stats, cpu).latency[i][bucket];
+        }
+
+        count = 0;
+        first = 0;
+        last = 0;
+        for(bucket = 0; bucket < CDP_LATENCY_BUCKETS; bucket++)
+        {
+            if(buckets[bucket] == 0)
+                continue;
+
+            if(count == 0)
+                first = bucket;
+            last = bucket;
+            count += buckets[bucket];
+        }
+
+        seq_printf(seq, "%s count %llu", cdp_latency_names[i], (unsigned long long)count);
+        if(count != 0)
+        {
+            seq_printf(
+                seq,
+                " p50_ns < %llu p99_ns < %llu p999_ns < %llu",
+                (unsigned long long)cdp_stats_latency_bucket_end(cdp_stats_latency_percentile(buckets, count, 500)),
+                (unsigned long long)cdp_stats_latency_bucket_end(cdp_stats_latency_percentile(buckets, count, 990)),
+                (unsigned long long)cdp_stats_latency_bucket_end(cdp_stats_latency_percentile(buckets, count, 999))
+            );
+        }
+        seq_putc(seq, '\n');
+
+        /* Only the range of buckets which were ever hit is listed */
+        for(bucket = first; count != 0 && bucket <= last; bucket++)
+        {
+            if(bucket == CDP_LATENCY_BUCKETS - 1)
+                seq_printf(seq, "    %12llu ns and up        %12llu\n", (unsigned long long)(cdp_stats_latency_bucket_end(bucket) >> 1), (unsigned long long)buckets[bucket]);
+            else
+                seq_printf(seq, "    %12llu .. %-12llu ns %12llu\n", (unsigned long long)(cdp_stats_latency_bucket_end(bucket) >> 1), (unsigned long long)(cdp_stats_latency_bucket_end(bucket) - 1), (unsigned long long)buckets[bucket]);
+        }
+
+        seq_putc(seq, '\n');
+    }
+
+    return 0;
+}
+
+void cdp_stats_net_init(struct cdp_net *cdp)
+{
+    hash_init(cdp->interfaces);
+}
+
+void cdp_stats_net_exit(struct cdp_net *cdp)
+{
+    struct cdp_stats_interface *interface;
+    struct hlist_node *next;
+    int bucket;
+
+    /* The interfaces are gone by now and so are the readers, which find the namespace through its list */
+    hash_for_each_safe(cdp->interfaces, bucket, next, interface, node)
+    {
+        hash_del(&interface->node);
+        cdp_stats_free_interface(&interface->rcu);
+    }
+}
+
+void cdp_stats_exit(void)
+{
+    /* Wait for the interfaces removed by the netdevice notifier to be freed */
+    rcu_barrier();
+}
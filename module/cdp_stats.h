@@ -0,0 +1,235 @@
+#ifndef CDP_STATS_H
+#define CDP_STATS_H
+
+#include <linux/netdevice.h>
+#include <linux/percpu.h>
+#include <linux/seq_file.h>
+#include <linux/timekeeping.h>
+
+#include "cdp_trace.h"
+
+struct cdp_net;
+
+/** The counters kept by the module. Each CPU counts into its own copy without any locking or
+  *  atomic operation and the copies are folded together when /proc/net/cdp/stats is read.
+  */
+enum cdp_stat
+{
+    /** Frames delivered to the module by PSNAP */
+    CDP_STAT_FRAMES_RECEIVED,
+
+    /** Frames received on an interface which isn't Ethernet */
+    CDP_STAT_DROPPED_NOT_ETHERNET,
+
+    /** Frames whose CDP checksum is wrong */
+    CDP_STAT_DROPPED_BAD_CHECKSUM,
+
+    /** Frames whose header or TLVs are incomplete */
+    CDP_STAT_DROPPED_MALFORMED,
+
+    /** Frames over the receive rate limit of the CPU */
+    CDP_STAT_DROPPED_RATE_LIMITED,
+
+    /** Frames which couldn't be stored for lack of memory */
+    CDP_STAT_DROPPED_NO_MEMORY,
+
+    /** Neighbors heard from for the first time */
+    CDP_STAT_NEIGHBORS_CREATED,
+
+    /** Neighbors which sent a frame different from their last */
+    CDP_STAT_NEIGHBORS_UPDATED,
+
+    /** Neighbors which repeated their last frame */
+    CDP_STAT_NEIGHBORS_REFRESHED,
+
+    /** Neighbors whose hold time ran out */
+    CDP_STAT_NEIGHBORS_EXPIRED,
+
+    /** Neighbors restored through /proc/net/cdp/raw */
+    CDP_STAT_NEIGHBORS_RESTORED,
+
+    /** Times a neighbors_rw_lock was taken for writing */
+    CDP_STAT_LOCK_WRITE_ACQUISITIONS,
+
+    /** Nanoseconds spent waiting to take a neighbors_rw_lock for writing */
+    CDP_STAT_LOCK_WRITE_WAIT_NS,
+
+    /** Nanoseconds a neighbors_rw_lock was held for writing */
+    CDP_STAT_LOCK_WRITE_HOLD_NS,
+
+    /** Times a neighbors_rw_lock was taken for reading */
+    CDP_STAT_LOCK_READ_ACQUISITIONS,
+
+    /** Nanoseconds spent waiting to take a neighbors_rw_lock for reading */
+    CDP_STAT_LOCK_READ_WAIT_NS,
+
+    /** Nanoseconds a neighbors_rw_lock was held for reading */
+    CDP_STAT_LOCK_READ_HOLD_NS,
+
+    CDP_STAT_COUNT
+};
+
+/** The stages whose latency is kept in the histograms of /proc/net/cdp/latency */
+enum cdp_latency
+{
+    /** A frame from entering cdp_receive() until it was stored or dropped */
+    CDP_LATENCY_RECEIVE,
+
+    /** Finding or creating the neighbor of a received frame */
+    CDP_LATENCY_LOOKUP,
+
+    /** Waiting to take a neighbors_rw_lock, for reading or writing */
+    CDP_LATENCY_LOCK_WAIT,
+
+    /** Holding a neighbors_rw_lock, for reading or writing */
+    CDP_LATENCY_LOCK_HOLD,
+
+    /** Taking the expired neighbors out of the table */
+    CDP_LATENCY_PURGE,
+
+    /** Building and sending the frame of one interface */
+    CDP_LATENCY_TRANSMIT,
+
+    CDP_LATENCY_COUNT
+};
+
+/** The number of log2 buckets of a latency histogram. Bucket 0 counts 0ns, bucket n counts
+  *  [2^(n-1), 2^n) nanoseconds and the last bucket everything from about a second up.
+  */
+#define CDP_LATENCY_BUCKETS 32
+
+/** The counters of a CPU */
+struct cdp_stats
+{
+    u64 counters[CDP_STAT_COUNT];
+
+    u64 latency[CDP_LATENCY_COUNT][CDP_LATENCY_BUCKETS];
+};
+
+DECLARE_PER_CPU(struct cdp_stats, cdp_stats);
+
+/** The times of a critical section under a neighbors_rw_lock */
+struct cdp_stats_lock_timer
+{
+    /** When the lock was asked for */
+    u64 requested;
+
+    /** When the lock was granted */
+    u64 acquired;
+};
+
+/** Increments a counter of the current CPU.
+  *  @param stat the counter.
+  */
+static inline void cdp_stats_inc(enum cdp_stat stat)
+{
+    this_cpu_inc(cdp_stats.counters[stat]);
+}
+
+/** Adds to a counter of the current CPU.
+  *  @param stat the counter.
+  *  @param value the value to add.
+  */
+static inline void cdp_stats_add(enum cdp_stat stat, u64 value)
+{
+    this_cpu_add(cdp_stats.counters[stat], value);
+}
+
+/** Counts a duration in the latency histogram of a stage on the current CPU.
+  *  @param stage the stage.
+  *  @param duration_ns the duration in nanoseconds.
+  */
+static inline void cdp_stats_latency(enum cdp_latency stage, u64 duration_ns)
+{
+    unsigned int bucket = fls64(duration_ns);
+
+    if(bucket >= CDP_LATENCY_BUCKETS)
+        bucket = CDP_LATENCY_BUCKETS - 1;
+
+    this_cpu_inc(cdp_stats.latency[stage][bucket]);
+}
+
+/** Records the time just before taking a neighbors_rw_lock.
+  *  @param timer the timer of the critical section.
+  */
+static inline void cdp_stats_lock_requested(struct cdp_stats_lock_timer *timer)
+{
+    timer->requested = ktime_get_ns();
+}
+
+/** Records the time just after taking a neighbors_rw_lock.
+  *  @param timer the timer of the critical section.
+  */
+static inline void cdp_stats_lock_acquired(struct cdp_stats_lock_timer *timer)
+{
+    timer->acquired = ktime_get_ns();
+}
+
+/** Accounts the wait and hold times of a critical section just after releasing a neighbors_rw_lock.
+  *  @param timer the timer of the critical section.
+  *  @param write true if the lock was held for writing.
+  */
+static inline void cdp_stats_lock_released(const struct cdp_stats_lock_timer *timer, bool write)
+{
+    u64 wait_ns = timer->acquired - timer->requested;
+    u64 hold_ns = ktime_get_ns() - timer->acquired;
+
+    cdp_stats_inc(write ? CDP_STAT_LOCK_WRITE_ACQUISITIONS : CDP_STAT_LOCK_READ_ACQUISITIONS);
+    cdp_stats_add(write ? CDP_STAT_LOCK_WRITE_WAIT_NS : CDP_STAT_LOCK_READ_WAIT_NS, wait_ns);
+    cdp_stats_add(write ? CDP_STAT_LOCK_WRITE_HOLD_NS : CDP_STAT_LOCK_READ_HOLD_NS, hold_ns);
+
+    cdp_stats_latency(CDP_LATENCY_LOCK_WAIT, wait_ns);
+    cdp_stats_latency(CDP_LATENCY_LOCK_HOLD, hold_ns);
+
+    trace_cdp_lock(write, wait_ns, hold_ns);
+}
+
+/** Adds the transmit counters of an Ethernet interface to its namespace, called by the netdevice
+  *  notifier under RTNL when the interface appears in the namespace.
+  *  @param dev the interface.
+  *  @return 0 on success or a negative value on error.
+  */
+int cdp_stats_interface_add(const struct net_device *dev);
+
+/** Removes the transmit counters of an interface from its namespace, called by the netdevice
+  *  notifier under RTNL when the interface leaves the namespace. The counters are freed once the
+  *  readers which may still see them are done.
+  *  @param dev the interface.
+  */
+void cdp_stats_interface_remove(const struct net_device *dev);
+
+/** Counts a transmission attempt on an interface, must be called under rcu_read_lock().
+  *  @param dev the interface.
+  *  @param rc 0 if the frame was sent, a negative value if it failed or a positive value if the
+  *  interface was skipped for having no address to advertise.
+  */
+void cdp_stats_transmitted(const struct net_device *dev, int rc);
+
+/** Function to be called to produce the content of /proc/net/cdp/stats
+  *  @param seq The handle to the sequential file structure.
+  *  @param v Unused.
+  *  @return 0 on success or a negative value on failure.
+  */
+int cdp_stats_show(struct seq_file *seq, void *v);
+
+/** Function to be called to produce the content of /proc/net/cdp/latency
+  *  @param seq The handle to the sequential file structure.
+  *  @param v Unused.
+  *  @return 0 on success or a negative value on failure.
+  */
+int cdp_stats_latency_show(struct seq_file *seq, void *v);
+
+/** Prepares the interface counters of a namespace.
+  *  @param cdp the namespace.
+  */
+void cdp_stats_net_init(struct cdp_net *cdp);
+
+/** Releases the interface counters left in a namespace when it goes away.
+  *  @param cdp the namespace.
+  */
+void cdp_stats_net_exit(struct cdp_net *cdp);
+
+/** Waits for the removed interface counters to be released, called when the module is unloaded. */
+void cdp_stats_exit(void);
+
+#endif
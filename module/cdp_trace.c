@@ -0,0 +1,3 @@
+/* Instantiates the tracepoints declared in cdp_trace.h, this must be done in exactly one file */
+#define CREATE_TRACE_POINTS
+#include "cdp_trace.h"
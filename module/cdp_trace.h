@@ -0,0 +1,183 @@
+#undef TRACE_SYSTEM
+#define TRACE_SYSTEM cdp
+
+#if !defined(CDP_TRACE_H) || defined(TRACE_HEADER_MULTI_READ)
+#define CDP_TRACE_H
+
+#include <linux/if_ether.h>
+#include <linux/netdevice.h>
+#include <linux/tracepoint.h>
+
+/** Tracepoints of the module, enabled under /sys/kernel/debug/tracing/events/cdp or through
+  *  perf and trace-cmd as cdp:<name>. They cost a single branch while disabled.
+  */
+
+TRACE_EVENT(cdp_receive_entry,
+
+    TP_PROTO(const struct net_device *dev, unsigned int length),
+
+    TP_ARGS(dev, length),
+
+    TP_STRUCT__entry(
+        __field(int, ifindex)
+        __string(name, dev->name)
+        __field(unsigned int, length)
+    ),
+
+    TP_fast_assign(
+        __entry->ifindex = dev->ifindex;
+        __assign_str(name, dev->name);
+        __entry->length = length;
+    ),
+
+    TP_printk("dev=%s ifindex=%d length=%u", __get_str(name), __entry->ifindex, __entry->length)
+);
+
+TRACE_EVENT(cdp_receive_exit,
+
+    TP_PROTO(const struct net_device *dev, int result, u64 duration_ns),
+
+    TP_ARGS(dev, result, duration_ns),
+
+    TP_STRUCT__entry(
+        __field(int, ifindex)
+        __string(name, dev->name)
+        __field(int, result)
+        __field(u64, duration_ns)
+    ),
+
+    TP_fast_assign(
+        __entry->ifindex = dev->ifindex;
+        __assign_str(name, dev->name);
+        __entry->result = result;
+        __entry->duration_ns = duration_ns;
+    ),
+
+    TP_printk(
+        "dev=%s ifindex=%d result=%s duration_ns=%llu",
+        __get_str(name),
+        __entry->ifindex,
+        __entry->result == NET_RX_SUCCESS ? "success" : "drop",
+        (unsigned long long)__entry->duration_ns
+    )
+);
+
+TRACE_EVENT(cdp_neighbor_lookup,
+
+    TP_PROTO(const struct net_device *dev, const uint8_t *mac, bool created, u64 duration_ns),
+
+    TP_ARGS(dev, mac, created, duration_ns),
+
+    TP_STRUCT__entry(
+        __field(int, ifindex)
+        __array(u8, mac, ETH_ALEN)
+        __field(bool, created)
+        __field(u64, duration_ns)
+    ),
+
+    TP_fast_assign(
+        __entry->ifindex = dev->ifindex;
+        memcpy(__entry->mac, mac, ETH_ALEN);
+        __entry->created = created;
+        __entry->duration_ns = duration_ns;
+    ),
+
+    TP_printk(
+        "ifindex=%d mac=%pM created=%d duration_ns=%llu",
+        __entry->ifindex,
+        __entry->mac,
+        __entry->created,
+        (unsigned long long)__entry->duration_ns
+    )
+);
+
+TRACE_EVENT(cdp_lock,
+
+    TP_PROTO(bool write, u64 wait_ns, u64 hold_ns),
+
+    TP_ARGS(write, wait_ns, hold_ns),
+
+    TP_STRUCT__entry(
+        __field(bool, write)
+        __field(u64, wait_ns)
+        __field(u64, hold_ns)
+    ),
+
+    TP_fast_assign(
+        __entry->write = write;
+        __entry->wait_ns = wait_ns;
+        __entry->hold_ns = hold_ns;
+    ),
+
+    TP_printk(
+        "mode=%s wait_ns=%llu hold_ns=%llu",
+        __entry->write ? "write" : "read",
+        (unsigned long long)__entry->wait_ns,
+        (unsigned long long)__entry->hold_ns
+    )
+);
+
+TRACE_EVENT(cdp_purge,
+
+    TP_PROTO(unsigned int table_size, int expired, u64 duration_ns),
+
+    TP_ARGS(table_size, expired, duration_ns),
+
+    TP_STRUCT__entry(
+        __field(unsigned int, table_size)
+        __field(int, expired)
+        __field(u64, duration_ns)
+    ),
+
+    TP_fast_assign(
+        __entry->table_size = table_size;
+        __entry->expired = expired;
+        __entry->duration_ns = duration_ns;
+    ),
+
+    TP_printk(
+        "table_size=%u expired=%d duration_ns=%llu",
+        __entry->table_size,
+        __entry->expired,
+        (unsigned long long)__entry->duration_ns
+    )
+);
+
+TRACE_EVENT(cdp_transmit,
+
+    TP_PROTO(const struct net_device *dev, int result, u64 duration_ns),
+
+    TP_ARGS(dev, result, duration_ns),
+
+    TP_STRUCT__entry(
+        __field(int, ifindex)
+        __string(name, dev->name)
+        __field(int, result)
+        __field(u64, duration_ns)
+    ),
+
+    TP_fast_assign(
+        __entry->ifindex = dev->ifindex;
+        __assign_str(name, dev->name);
+        __entry->result = result;
+        __entry->duration_ns = duration_ns;
+    ),
+
+    TP_printk(
+        "dev=%s ifindex=%d result=%s duration_ns=%llu",
+        __get_str(name),
+        __entry->ifindex,
+        __entry->result == 0 ? "sent" : (__entry->result < 0 ? "failed" : "skipped"),
+        (unsigned long long)__entry->duration_ns
+    )
+);
+
+#endif
+
+/* The module is built out of tree, so the header is found relative to the module directory */
+#undef TRACE_INCLUDE_PATH
+#define TRACE_INCLUDE_PATH .
+#undef TRACE_INCLUDE_FILE
+#define TRACE_INCLUDE_FILE cdp_trace
+
+#include <trace/define_trace.h>
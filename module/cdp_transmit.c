@@ -1,4 +1,5 @@
 #include "cdp_module.h"
+#include "cdp_stats.h"
 #include "cdp_transmit.h"
 #include "../libcdp/cdp_packet.h"
 #include "../libcdp/cdp_software_version_string.h"
@@ -40,16 +41,14 @@ static ssize_t get_ip_address_list_from_net_device(const struct net_device *netw
 	    }
     }
 
+    /* Interfaces without addresses are common and counted as skipped by the caller */
     if(address_count == 0)
-    {
-        printk(KERN_INFO "Failed to enumerate IP addresses on this interface\n");
-		return -1;
-    }
+		return 0;
 
     *result = ip_address_array_new(address_count);
     if(*result == NULL)
 	{
-		printk(KERN_CRIT "Failed to provision storage for addresses\n");
+		printk_ratelimited(KERN_CRIT "Failed to provision storage for addresses\n");
 		return -1;
 	}
 
@@ -61,7 +60,7 @@ static ssize_t get_ip_address_list_from_net_device(const struct net_device *netw
         {
             if(ip_address_array_set_into_ipv4_uint32(*result, index, current_address->ifa_local) < 0)
             {
-                printk(KERN_CRIT "Failed to set address\n");
+                printk_ratelimited(KERN_CRIT "Failed to set address\n");
                 ip_address_array_delete(*result);
                 *result = NULL;
                 return -1;
@@ -80,7 +79,7 @@ static ssize_t get_ip_address_list_from_net_device(const struct net_device *netw
         list_for_each_entry(current_address, &idev->addr_list, if_list) {
             if(ip_address_array_set_into_ipv6_raw(*result, index, current_address->addr.in6_u.u6_addr8) < 0)
             {
-                printk(KERN_CRIT "Failed to set ipv6 address\n");
+                printk_ratelimited(KERN_CRIT "Failed to set ipv6 address\n");
                 ip_address_array_delete(*result);
                 *result = NULL;
                 return -1;
@@ -93,92 +92,125 @@ static ssize_t get_ip_address_list_from_net_device(const struct net_device *netw
     return (ssize_t)address_count;
 }
 
-static int cdp_transmit_packet(struct net_device *network_device)
+/** Builds and transmits the CDP frame advertising this device on an interface.
+  *  @param snap the datalink protocol to send through.
+  *  @param network_device the interface.
+  *  @return 0 on success, 1 if the interface has no address to advertise or -1 on failure.
+  */
+static int cdp_transmit_packet(struct datalink_proto *snap, struct net_device *network_device)
 {
     struct sk_buff *skb;
     struct ip_address_array *addresses;
-    size_t len = 1536;
+    struct cdp_packet *packet;
+    ssize_t frame_length;
     ssize_t consumed;
     uint8_t *buffer;
+    ssize_t address_count;
     int rc;    
 
-    printk(KERN_INFO "cdp: Transmit on interface %s\n", network_device->name);
+    address_count = get_ip_address_list_from_net_device(network_device, &addresses);
+    if(address_count < 0)
+        return -1;
 
-    skb = netdev_alloc_skb(network_device, len);
-    if(skb == NULL)
+    if(address_count == 0)
+        return 1;
+
+    packet = cdp_packet_new_advertisement(
+        network_device->name,
+        cdp_device_id_string,
+        cdp_platform_string,
+        cdp_software_version_string,
+        addresses
+    );
+
+    ip_address_array_clear_and_delete(addresses);
+
+    if(packet == NULL)
     {
-        printk(KERN_CRIT "cdp_transmit_packet: failed to allocated a packet buffer for transmission\n");
+        printk_ratelimited(KERN_CRIT "cdp_transmit_packet: failed to generate frame\n");
         return -1;
     }
 
-    skb_reserve(skb, ethernet_header_length + snap_header_length);
+    /* Size the buffer to the frame so that only the headroom for the link-layer headers is added */
+    frame_length = cdp_packet_serialized_size(packet);
+    if(frame_length < 1)
+    {
+        printk_ratelimited(KERN_CRIT "cdp_transmit_packet: failed to calculate the frame length\n");
+        cdp_packet_delete(packet);
+        return -1;
+    }
 
-    if(get_ip_address_list_from_net_device(network_device, &addresses) < 0)
+    skb = netdev_alloc_skb(network_device, ethernet_header_length + snap_header_length + frame_length);
+    if(skb == NULL)
     {
-        printk(KERN_INFO "cdp_transmit_packet: there seems to be no IP addresses on this interface. skipping\n");
-        kfree_skb(skb);
+        printk_ratelimited(KERN_CRIT "cdp_transmit_packet: failed to allocated a packet buffer for transmission\n");
+        cdp_packet_delete(packet);
         return -1;
     }
 
-    buffer = skb_put(skb, 0);
-    consumed = cdp_create_packet(
-        network_device->name,
-        cdp_device_id_string,
-        cdp_platform_string,
-        cdp_software_version_string,
-        addresses,
-        buffer, 
-        len
-    );
+    skb_reserve(skb, ethernet_header_length + snap_header_length);
 
-    ip_address_array_delete(addresses);
+    buffer = skb_put(skb, frame_length);
+    consumed = cdp_packet_serialize(packet, buffer, frame_length);
 
-    if(consumed < 1)
+    cdp_packet_delete(packet);
+
+    if(consumed != frame_length)
     {
-        printk(KERN_CRIT "cdp_transmit_packet: failed to generate frame\n");
+        printk_ratelimited(KERN_CRIT "cdp_transmit_packet: failed to generate frame\n");
         kfree_skb(skb);
         return -1;
     }
 
-    skb_put(skb, consumed);
-
-    rc = cdp_snap_datalink_protocol->request(cdp_snap_datalink_protocol, skb, cdp_multicast_address);
+    rc = snap->request(snap, skb, cdp_multicast_address);
 
     if(rc < 0)
     {
-        printk(KERN_CRIT "cdp_packet_transmit: failed to transmit frame\n");
+        printk_ratelimited(KERN_CRIT "cdp_packet_transmit: failed to transmit frame\n");
         return -1;
     }
 
     return 0;
 }
 
-int cdp_transmit_packets(void)
+int cdp_transmit_packets(struct net *net)
 {
+    struct datalink_proto *snap;
     struct net_device *dev;
+    int result = 0;
+    u64 start;
+    u64 duration_ns;
 
-    read_lock(&dev_base_lock);
+    /* unregister_snap_client() waits for this section to end before freeing the protocol */
+    rcu_read_lock();
 
-    dev = first_net_device(&init_net);
-    while (dev) {
+    snap = rcu_dereference(cdp_snap_datalink_protocol);
+    if(snap == NULL)
+    {
+        rcu_read_unlock();
+        return 0;
+    }
+
+    for_each_netdev_rcu(net, dev) {
         int rc;
 
-        if(netif_carrier_ok(dev))
+        /* A failure on one interface doesn't hold back the others, it's counted in /proc/net/cdp/stats */
+        if(netif_carrier_ok(dev) && dev->type == ARPHRD_ETHER)
         {
-            if(dev->type == ARPHRD_ETHER)
-                rc = cdp_transmit_packet(dev);
+            start = ktime_get_ns();
+            rc = cdp_transmit_packet(snap, dev);
+            duration_ns = ktime_get_ns() - start;
+
+            cdp_stats_transmitted(dev, rc);
+            cdp_stats_latency(CDP_LATENCY_TRANSMIT, duration_ns);
+            trace_cdp_transmit(dev, rc, duration_ns);
 
             if(rc < 0)
-            {
-                printk(KERN_CRIT "cdp: Failed to transmit frame on %s\n", dev->name);
-                return -1;
-            }
+                result = -1;
         }
-
-        dev = next_net_device(dev);
     }
 
-    read_unlock(&dev_base_lock);
+    rcu_read_unlock();
 
-    return 0;
+    return result;
 }
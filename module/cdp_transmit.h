@@ -1,9 +1,14 @@
 #ifndef CDP_TRANSMIT_H
 #define CDP_TRANSMIT_H
 
-/** Transmits a CDP packet to each interface recognized by CDP.
-  *  @return 0 on success, -1 on failure.
+#include <net/net_namespace.h>
+
+/** Transmits a CDP packet to each interface of a namespace recognized by CDP. The outcome on each
+  *  interface is counted in /proc/net/cdp/stats. Nothing is sent while the module is being loaded
+  *  or unloaded.
+  *  @param net the namespace.
+  *  @return 0 on success, -1 if transmitting failed on any interface.
   */
-int cdp_transmit_packets(void);
+int cdp_transmit_packets(struct net *net);
 
 #endif